@@ -0,0 +1,276 @@
+// Roboat telemetry bridge: reads the Pilot's updates from its serial link
+// (see link.h) and writes them to InfluxDB in batches, spooling them to disk
+// while the database cannot be reached.
+//
+// usage: roboat_bridge [options]
+//
+//   --device PATH          serial device (default /dev/ttyAMA3)
+//   --baud N               115200 (default), 57600, 38400, 19200 or 9600
+//   --input PATH           read a capture (or - for stdin) instead, then exit
+//   --url URL              InfluxDB (default http://localhost:8086)
+//   --org NAME             organization (default CSO)
+//   --bucket NAME          bucket (default roboat_01)
+//   --udp HOST:PORT        send by UDP instead of HTTP
+//   --file PATH            append to a file (- for stdout) instead
+//   --spool DIR            spool directory (default /var/spool/roboat-bridge)
+//   --spool-mb N           spool limit, oldest dropped first (default 64)
+//   --batch-bytes N        send once a batch has N bytes (default 16384)
+//   --batch-ms N           or once it is N ms old (default 10000)
+//   --stats-s N            print counters to stderr every N s (default 0, never)
+//
+// The InfluxDB token is taken from the INFLUX_TOKEN environment variable.
+
+#include "line_protocol.h"
+#include "link.h"
+#include "sinks.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace Roboat::Bridge;
+
+namespace {
+
+    const int REOPEN_DELAY = 5000;     // ms between attempts to open the serial device
+
+    volatile sig_atomic_t stopping = 0;
+
+    void stop(int) {
+        stopping = 1;
+    }
+
+    int64_t monotonicMillis() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return int64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    int64_t realtimeNanos() {
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    speed_t toSpeed(long baud) {
+        switch (baud) {
+            case 9600:
+                return B9600;
+            case 19200:
+                return B19200;
+            case 38400:
+                return B38400;
+            case 57600:
+                return B57600;
+            case 115200:
+                return B115200;
+            default:
+                return 0;
+        }
+    }
+
+    // The serial device, raw and non-blocking, or -1.
+    int openSerial(const std::string& path, speed_t speed) {
+        int fd = open(path.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0) {
+            return -1;
+        }
+        termios tio;
+        if (tcgetattr(fd, &tio) != 0) {
+            close(fd);
+            return -1;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+        return fd;
+    }
+
+    struct Options {
+        std::string device = "/dev/ttyAMA3";
+        long baud = 115200;
+        std::string input;
+        std::string url = "http://localhost:8086";
+        std::string org = "CSO";
+        std::string bucket = "roboat_01";
+        std::string udp;
+        std::string file;
+        std::string spool = "/var/spool/roboat-bridge";
+        long spoolMegabytes = 64;
+        BatchPolicy batch;
+        long statsInterval = 0;
+    };
+
+    bool parseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string name(argv[i]);
+            if (i + 1 >= argc) {
+                return false;
+            }
+            const char* value = argv[++i];
+            if (name == "--device") {
+                options.device = value;
+            } else if (name == "--baud") {
+                options.baud = strtol(value, NULL, 10);
+            } else if (name == "--input") {
+                options.input = value;
+            } else if (name == "--url") {
+                options.url = value;
+            } else if (name == "--org") {
+                options.org = value;
+            } else if (name == "--bucket") {
+                options.bucket = value;
+            } else if (name == "--udp") {
+                options.udp = value;
+            } else if (name == "--file") {
+                options.file = value;
+            } else if (name == "--spool") {
+                options.spool = value;
+            } else if (name == "--spool-mb") {
+                options.spoolMegabytes = strtol(value, NULL, 10);
+            } else if (name == "--batch-bytes") {
+                options.batch.maxBytes = strtoul(value, NULL, 10);
+            } else if (name == "--batch-ms") {
+                options.batch.maxAge = strtol(value, NULL, 10);
+            } else if (name == "--stats-s") {
+                options.statsInterval = strtol(value, NULL, 10);
+            } else {
+                return false;
+            }
+        }
+        return toSpeed(options.baud) != 0;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s [--device PATH] [--baud N] [--input PATH] [--url URL] [--org NAME] "
+                "[--bucket NAME] [--udp HOST:PORT] [--file PATH] [--spool DIR] [--spool-mb N] "
+                "[--batch-bytes N] [--batch-ms N] [--stats-s N]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<Sink> sink;
+    if (!options.file.empty()) {
+        sink.reset(new FileSink(options.file));
+    } else if (!options.udp.empty()) {
+        sink.reset(new UdpSink(options.udp));
+    } else {
+        const char* token = getenv("INFLUX_TOKEN");
+        sink.reset(new HttpSink(options.url, options.org, options.bucket, token ? token : ""));
+    }
+    std::unique_ptr<Spool> spool;
+    if (!options.spool.empty() && options.file.empty()) {
+        spool.reset(new Spool(options.spool, uint64_t(options.spoolMegabytes) << 20));
+    }
+    Forwarder forwarder(*sink, spool.get());
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+
+    const bool replaying = !options.input.empty();
+    int fd = -1;
+    if (replaying) {
+        fd = options.input == "-" ? STDIN_FILENO : open(options.input.c_str(), O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "bridge: cannot open %s: %s\n", options.input.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+
+    LineReader reader;
+    Update update;
+    Batch batch(options.batch.maxBytes + 1024);
+    uint64_t lines = 0;
+    uint64_t records = 0;
+    uint64_t rejected = 0;
+    int64_t nextOpen = 0;
+    int64_t nextStats = monotonicMillis() + options.statsInterval * 1000;
+
+    while (!stopping) {
+        int64_t now = monotonicMillis();
+        if (fd < 0 && now >= nextOpen) {
+            fd = openSerial(options.device, toSpeed(options.baud));
+            if (fd < 0) {
+                fprintf(stderr, "bridge: cannot open %s: %s\n", options.device.c_str(), strerror(errno));
+                nextOpen = now + REOPEN_DELAY;
+            }
+        }
+
+        // sleep until there is something to read, a batch is due, or it is time to retry the device
+        int64_t wait = batch.getTimeToDue(options.batch, now);
+        if (wait < 0 || wait > 1000) {
+            wait = 1000;
+        }
+        bool eof = false;
+        pollfd polled = {fd, POLLIN, 0};
+        if (replaying || (fd >= 0 && poll(&polled, 1, int(wait)) > 0)) {
+            ssize_t count = reader.readFrom(fd);
+            if (count == 0 && replaying) {
+                eof = true;
+            } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+                fprintf(stderr, "bridge: read failed: %s\n", strerror(errno));
+                close(fd);
+                fd = -1;
+                nextOpen = now + REOPEN_DELAY;
+            }
+        } else if (fd < 0) {
+            usleep(wait * 1000);
+        }
+
+        int64_t received = realtimeNanos();
+        now = monotonicMillis();
+        std::string_view line;
+        while (reader.nextLine(line)) {
+            lines++;
+            if (!parseUpdate(line, update) || !batch.add(update, received, now)) {
+                rejected++;
+                continue;
+            }
+            records++;
+            if (batch.isDue(options.batch, now)) {
+                forwarder.send(batch.getText(), now);
+                batch.clear();
+            }
+        }
+        if (batch.isDue(options.batch, now)) {
+            forwarder.send(batch.getText(), now);
+            batch.clear();
+        }
+
+        if (options.statsInterval > 0 && now >= nextStats) {
+            fprintf(stderr, "bridge: %llu lines, %llu records, %llu rejected, %llu bytes discarded, "
+                    "%llu batches sent, %llu spooled (%zu waiting)\n",
+                    (unsigned long long) lines, (unsigned long long) records, (unsigned long long) rejected,
+                    (unsigned long long) reader.getDiscarded(), (unsigned long long) forwarder.getSent(),
+                    (unsigned long long) forwarder.getFailed(), spool ? spool->getCount() : size_t(0));
+            nextStats = now + options.statsInterval * 1000;
+        }
+        if (eof) {
+            break;
+        }
+    }
+
+    if (!batch.isEmpty()) {
+        forwarder.send(batch.getText(), monotonicMillis());
+    }
+    if (replaying) {
+        fprintf(stderr, "bridge: %llu lines, %llu records, %llu rejected\n",
+                (unsigned long long) lines, (unsigned long long) records, (unsigned long long) rejected);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Throughput benchmark for the bridge: a seeded stream of Pilot updates
+// (mppt and ina260 readings, as src/micro/main.py sends them) is passed
+// through the line reader, parser and batcher in UART-sized chunks, and the
+// batches to a sink that only counts them. Reports records/s and the
+// bridge's share of one core at the link's full rate.
+//
+// usage: bridge_bench [records] [chunk bytes]
+
+#include "line_protocol.h"
+#include "link.h"
+#include "sinks.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+using namespace Roboat::Bridge;
+
+namespace {
+
+    const double LINK_BYTES_PER_SECOND = 115200 / 10.0;
+
+    class CountingSink : public Sink {
+    public:
+        uint64_t batches = 0;
+        uint64_t bytes = 0;
+
+        bool write(const std::string& batch) {
+            batches++;
+            bytes += batch.size();
+            return true;
+        }
+
+        const char * getName() const {
+            return "count";
+        }
+    };
+
+    std::string makeStream(size_t records) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> unit(0, 1);
+        std::string stream;
+        char line[256];
+        double energy = 12.0;
+        double charge = 0;
+        for (size_t i = 0; i < records; i++) {
+            int length;
+            if (i % 3 == 0) {
+                energy += 0.01;
+                length = snprintf(line, sizeof(line),
+                    "{\"offset_s\": 0, \"src\": \"mppt\", \"sol_v\": %.2f, \"sol_p\": %d, \"mppt_mode\": %d, "
+                    "\"mppt_epoch\": %zu, \"load_i\": %.1f, \"batt_v\": %.2f, \"batt_i\": %.1f, "
+                    "\"mppt_total_kwh\": %.2f}\r\n",
+                    18 + 4 * unit(rng), int(60 * unit(rng)), 2 + int(2 * unit(rng)), i / 3,
+                    2 * unit(rng), 12.5 + unit(rng), 5 * unit(rng) - 1, energy);
+            } else {
+                charge += 0.0003;
+                length = snprintf(line, sizeof(line),
+                    "{\"offset_s\": 0, \"src\": \"ina260\", \"logic_p\": %.5f, \"logic_i\": %.5f, "
+                    "\"batt_v\": %.5f, \"logic_total_ah\": %.6f}\r\n",
+                    1 + unit(rng), 0.1 + 0.05 * unit(rng), 12.5 + unit(rng), charge);
+            }
+            stream.append(line, length);
+        }
+        return stream;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoul(argv[1], NULL, 10) : 300000;
+    size_t chunk = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+    if (records == 0 || chunk == 0) {
+        fprintf(stderr, "usage: %s [records] [chunk bytes]\n", argv[0]);
+        return 2;
+    }
+
+    std::string stream = makeStream(records);
+
+    CountingSink sink;
+    Forwarder forwarder(sink, NULL);
+    BatchPolicy policy;
+    LineReader reader;
+    Update update;
+    Batch batch(policy.maxBytes + 1024);
+    size_t parsed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t position = 0;
+    int64_t received = 1700000000000000000LL;
+    while (position < stream.size()) {
+        position += reader.append(stream.data() + position, std::min(chunk, stream.size() - position));
+        std::string_view line;
+        while (reader.nextLine(line)) {
+            if (parseUpdate(line, update) && batch.add(update, received, 0)) {
+                parsed++;
+                if (batch.isDue(policy, 0)) {
+                    forwarder.send(batch.getText(), 0);
+                    batch.clear();
+                }
+            }
+        }
+        received += 1000;
+    }
+    if (!batch.isEmpty()) {
+        forwarder.send(batch.getText(), 0);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (parsed != records) {
+        fprintf(stderr, "parsed %zu of %zu records\n", parsed, records);
+        return 1;
+    }
+    double rate = parsed / seconds;
+    double linkRate = LINK_BYTES_PER_SECOND * records / stream.size();
+    printf("%zu records (%.1f MB) in %zu-byte reads: %.3f s, %.0f records/s, %.1f MB/s in, %.1f MB/s out\n",
+           records, stream.size() / 1e6, chunk, seconds, rate, stream.size() / seconds / 1e6,
+           sink.bytes / seconds / 1e6);
+    printf("%llu batches, %.0f bytes average\n", (unsigned long long) sink.batches,
+           double(sink.bytes) / sink.batches);
+    printf("at 115200 baud the link carries at most %.0f records/s: %.3f%% of this core\n",
+           linkRate, 100 * linkRate / rate);
+    return 0;
+}
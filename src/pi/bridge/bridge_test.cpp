@@ -0,0 +1,192 @@
+// Checks for the bridge's parser, batcher and spool, using the file sink as
+// a stand-in for the database.
+//
+// usage: bridge_test [scratch directory]
+
+#include "line_protocol.h"
+#include "link.h"
+#include "sinks.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+using namespace Roboat::Bridge;
+
+namespace {
+
+    int failures = 0;
+
+    void check(bool condition, const char* what, int line) {
+        if (!condition) {
+            fprintf(stderr, "line %d: %s\n", line, what);
+            failures++;
+        }
+    }
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+    // Line protocol for one line of the link, or "" if it is rejected.
+    std::string convert(const std::string& line, int64_t received = 1000000000) {
+        Update update;
+        Batch batch;
+        if (!parseUpdate(line, update) || !batch.add(update, received, 0)) {
+            return "";
+        }
+        return batch.getText();
+    }
+
+    std::string readFile(const std::string& path) {
+        std::ifstream in(path);
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    // A sink that can be switched off.
+    class FlakySink : public Sink {
+    public:
+        bool up = false;
+        std::string received;
+
+        bool write(const std::string& batch) {
+            if (up) {
+                received += batch;
+            }
+            return up;
+        }
+
+        const char * getName() const {
+            return "flaky";
+        }
+    };
+
+    void testParse() {
+        CHECK(convert("{\"offset_s\": 0, \"src\": \"ina260\", \"logic_p\": 1.25, \"batt_v\": 13}") ==
+              "ina260 logic_p=1.25,batt_v=13i 1000000000\n");
+        CHECK(convert("{\"src\": \"gps\", \"error\": 1, \"error_msg\": \"no \\\"fix\\\"\", \"ok\": false}") ==
+              "gps error=1i,error_msg=\"no \\\"fix\\\"\",ok=false 1000000000\n");
+        // offset moves the timestamp back
+        CHECK(convert("{\"offset_s\": 0.5, \"src\": \"a\", \"x\": -2.5e-3}") == "a x=-2.5e-3 500000000\n");
+        // names are escaped, nulls dropped
+        CHECK(convert("{\"src\": \"my sensor\", \"a,b\": 1.0, \"c\": null, \"d\": nan}") ==
+              "my\\ sensor a\\,b=1.0 1000000000\n");
+        // noise from a reset before the object
+        CHECK(convert("\xff\xff{\"src\": \"a\", \"x\": 1}") == "a x=1i 1000000000\n");
+
+        CHECK(convert("{\"src\": \"a\", \"x\": [1, 2]}").empty());
+        CHECK(convert("{\"src\": \"a\", \"x\": {\"y\": 1}}").empty());
+        CHECK(convert("{\"x\": 1}").empty());
+        CHECK(convert("{\"src\": \"a\"}").empty());
+        CHECK(convert("{\"src\": \"a\", \"x\": 1").empty());
+        CHECK(convert("{\"src\": \"a\", \"x\": 01.}").empty());
+        CHECK(convert("").empty());
+    }
+
+    void testReader() {
+        LineReader reader(32);
+        std::string_view line;
+
+        // a line split across reads
+        CHECK(reader.append("abc\r\nde", 7) == 7);
+        CHECK(reader.nextLine(line) && line == "abc");
+        CHECK(!reader.nextLine(line));
+        reader.append("f\n", 2);
+        CHECK(reader.nextLine(line) && line == "def");
+
+        // a line longer than the buffer is dropped, and the next one kept
+        std::string longLine(40, 'x');
+        size_t position = 0;
+        while (position < longLine.size()) {
+            position += reader.append(longLine.data() + position, longLine.size() - position);
+            CHECK(!reader.nextLine(line));
+        }
+        reader.append("\nok\n", 4);
+        CHECK(reader.nextLine(line) && line == "ok");
+        CHECK(reader.getDiscarded() == 41);
+    }
+
+    void testBatch() {
+        BatchPolicy policy;
+        policy.maxBytes = 64;
+        policy.maxAge = 100;
+        Batch batch;
+        Update update;
+        CHECK(parseUpdate("{\"src\": \"a\", \"x\": 1}", update));
+
+        CHECK(!batch.isDue(policy, 0));
+        CHECK(batch.getTimeToDue(policy, 0) == -1);
+        batch.add(update, 0, 10);
+        CHECK(!batch.isDue(policy, 50));
+        CHECK(batch.getTimeToDue(policy, 50) == 60);
+        CHECK(batch.isDue(policy, 110));
+        while (batch.getText().size() < policy.maxBytes) {
+            batch.add(update, 0, 10);
+        }
+        CHECK(batch.isDue(policy, 10));
+        batch.clear();
+        CHECK(batch.isEmpty() && batch.getText().empty());
+    }
+
+    void testSpool(const std::string& scratch) {
+        std::string directory = scratch + "/spool";
+        FlakySink sink;
+        {
+            Spool spool(directory, 1 << 20);
+            Forwarder forwarder(sink, &spool, 1000);
+            CHECK(forwarder.send("a x=1i 1\n", 0));
+            CHECK(forwarder.send("a x=2i 2\n", 500));
+            CHECK(spool.getCount() == 2 && sink.received.empty());
+        }
+
+        // a later run picks the spool up, and sends it first
+        Spool spool(directory, 1 << 20);
+        CHECK(spool.getCount() == 2);
+        Forwarder forwarder(sink, &spool, 1000);
+        sink.up = true;
+        CHECK(forwarder.send("a x=3i 3\n", 0));
+        CHECK(sink.received == "a x=1i 1\na x=2i 2\na x=3i 3\n");
+        CHECK(spool.getCount() == 0 && spool.getBytes() == 0);
+
+        // over the limit the oldest go
+        Spool small(directory, 20);
+        CHECK(small.store("a x=1i 1\n") && small.store("a x=2i 2\n") && small.store("a x=3i 3\n"));
+        CHECK(small.getCount() == 2 && small.getDropped() == 1);
+        sink.received.clear();
+        CHECK(small.replay(sink) == 2);
+        CHECK(sink.received == "a x=2i 2\na x=3i 3\n");
+        rmdir(directory.c_str());
+    }
+
+    void testFileSink(const std::string& scratch) {
+        std::string path = scratch + "/out.lp";
+        unlink(path.c_str());
+        {
+            FileSink sink(path);
+            CHECK(sink.write("a x=1i 1\n") && sink.write("a x=2i 2\n"));
+        }
+        CHECK(readFile(path) == "a x=1i 1\na x=2i 2\n");
+        unlink(path.c_str());
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::string scratch = argc > 1 ? argv[1] : "/tmp";
+
+    testParse();
+    testReader();
+    testBatch();
+    testSpool(scratch);
+    testFileSink(scratch);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "line_protocol.h"
+
+#include <cstdio>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        namespace {
+
+            // Append a name, backslash-escaping the characters in `special`.
+            void appendEscaped(std::string& out, std::string_view name, const char* special) {
+                for (char c : name) {
+                    for (const char* s = special; *s; s++) {
+                        if (c == *s) {
+                            out += '\\';
+                            break;
+                        }
+                    }
+                    out += c;
+                }
+            }
+
+        }
+
+        Batch::Batch(size_t reserve) :
+            lineCount(0),
+            firstTime(0)
+        {
+            text.reserve(reserve);
+        }
+
+        bool Batch::add(const Update& update, int64_t received, int64_t now) {
+            size_t mark = text.size();
+            appendEscaped(text, update.source, ", ");
+
+            char separator = ' ';
+            for (size_t i = 0; i < update.count; i++) {
+                const Field& field = update.fields[i];
+                if (field.type == VALUE_NULL) {
+                    continue;
+                }
+                text += separator;
+                separator = ',';
+                appendEscaped(text, field.key, ",= ");
+                text += '=';
+                switch (field.type) {
+                    case VALUE_STRING:
+                        // JSON escapes \" and \\ are also line protocol's; others pass as text
+                        text += '"';
+                        text.append(field.value.data(), field.value.size());
+                        text += '"';
+                        break;
+                    case VALUE_INTEGER:
+                        text.append(field.value.data(), field.value.size());
+                        text += 'i';
+                        break;
+                    default:
+                        text.append(field.value.data(), field.value.size());
+                }
+            }
+            if (separator == ' ') {
+                text.resize(mark);
+                return false;
+            }
+
+            char timestamp[24];
+            int length = snprintf(timestamp, sizeof(timestamp), " %lld\n",
+                                  static_cast<long long>(received - int64_t(update.offset * 1e9)));
+            text.append(timestamp, length);
+
+            if (lineCount++ == 0) {
+                firstTime = now;
+            }
+            return true;
+        }
+
+        bool Batch::isDue(const BatchPolicy& policy, int64_t now) const {
+            return lineCount > 0 && (text.size() >= policy.maxBytes || now - firstTime >= policy.maxAge);
+        }
+
+        int64_t Batch::getTimeToDue(const BatchPolicy& policy, int64_t now) const {
+            if (lineCount == 0) {
+                return -1;
+            }
+            int64_t age = now - firstTime;
+            return age >= policy.maxAge ? 0 : policy.maxAge - age;
+        }
+
+        const std::string& Batch::getText() const {
+            return text;
+        }
+
+        size_t Batch::getLineCount() const {
+            return lineCount;
+        }
+
+        bool Batch::isEmpty() const {
+            return lineCount == 0;
+        }
+
+        void Batch::clear() {
+            text.clear();
+            lineCount = 0;
+        }
+
+    }
+
+}
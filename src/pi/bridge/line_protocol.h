@@ -0,0 +1,60 @@
+#ifndef ROBOAT_BRIDGE_LINE_PROTOCOL_H
+#define ROBOAT_BRIDGE_LINE_PROTOCOL_H
+
+// Batches of updates in InfluxDB line protocol, one line per update:
+//
+//   ina260 logic_p=1.25,batt_v=13.1,count=4i 1718035200123456789
+//
+// The measurement is the update's "src", and the timestamp (ns since 1970)
+// the time it was received less its "offset_s". Integers keep their type
+// ("i" suffix) as the Python monitor wrote them, so the two can share a
+// bucket; null, nan and inf values are left out.
+
+#include "link.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        // When a batch is sent: once it has maxBytes, or its first update is
+        // maxAge (ms) old.
+        struct BatchPolicy {
+            size_t maxBytes = 16384;
+            int64_t maxAge = 10000;
+        };
+
+        class Batch {
+
+            std::string text;
+            size_t lineCount;
+            int64_t firstTime;      // ms, on the caller's clock
+
+        public:
+            explicit Batch(size_t reserve = 32768);
+
+            // Append an update received at `received` (ns since 1970) at
+            // `now` (ms, any monotonic clock). False if it has no values to
+            // write, in which case nothing is added.
+            bool add(const Update& update, int64_t received, int64_t now);
+
+            // True if the batch should be sent now.
+            bool isDue(const BatchPolicy& policy, int64_t now) const;
+
+            // Time (ms) until the batch is due by age, or -1 if it is empty.
+            int64_t getTimeToDue(const BatchPolicy& policy, int64_t now) const;
+
+            const std::string& getText() const;
+            size_t getLineCount() const;
+            bool isEmpty() const;
+            void clear();
+
+        };
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,253 @@
+#include "link.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        namespace {
+
+            // A cursor over a line, for the parser.
+            struct Cursor {
+                const char* p;
+                const char* end;
+
+                void skipSpace() {
+                    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+                        p++;
+                    }
+                }
+
+                bool take(char c) {
+                    skipSpace();
+                    if (p < end && *p == c) {
+                        p++;
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool takeWord(const char* word) {
+                    size_t length = strlen(word);
+                    if (size_t(end - p) >= length && memcmp(p, word, length) == 0) {
+                        p += length;
+                        return true;
+                    }
+                    return false;
+                }
+            };
+
+            // A quoted string, after its opening quote; the view excludes the quotes.
+            bool parseString(Cursor& c, std::string_view& text) {
+                const char* first = c.p;
+                while (c.p < c.end && *c.p != '"') {
+                    if (*c.p == '\\') {
+                        c.p++;
+                    }
+                    c.p++;
+                }
+                if (c.p >= c.end) {
+                    return false;
+                }
+                text = std::string_view(first, c.p - first);
+                c.p++;
+                return true;
+            }
+
+            bool isDigit(char c) {
+                return c >= '0' && c <= '9';
+            }
+
+            // A JSON number; integer is set if it has no fraction or exponent.
+            bool parseNumber(Cursor& c, std::string_view& text, bool& integer) {
+                const char* first = c.p;
+                integer = true;
+                if (c.p < c.end && *c.p == '-') {
+                    c.p++;
+                }
+                const char* digits = c.p;
+                while (c.p < c.end && isDigit(*c.p)) {
+                    c.p++;
+                }
+                if (c.p == digits) {
+                    return false;
+                }
+                if (c.p < c.end && *c.p == '.') {
+                    integer = false;
+                    digits = ++c.p;
+                    while (c.p < c.end && isDigit(*c.p)) {
+                        c.p++;
+                    }
+                    if (c.p == digits) {
+                        return false;
+                    }
+                }
+                if (c.p < c.end && (*c.p == 'e' || *c.p == 'E')) {
+                    integer = false;
+                    c.p++;
+                    if (c.p < c.end && (*c.p == '+' || *c.p == '-')) {
+                        c.p++;
+                    }
+                    digits = c.p;
+                    while (c.p < c.end && isDigit(*c.p)) {
+                        c.p++;
+                    }
+                    if (c.p == digits) {
+                        return false;
+                    }
+                }
+                text = std::string_view(first, c.p - first);
+                return true;
+            }
+
+            bool parseValue(Cursor& c, Field& field) {
+                c.skipSpace();
+                if (c.p >= c.end) {
+                    return false;
+                }
+                const char* first = c.p;
+                if (*c.p == '"') {
+                    c.p++;
+                    field.type = VALUE_STRING;
+                    return parseString(c, field.value);
+                } else if (c.takeWord("true") || c.takeWord("false")) {
+                    field.type = VALUE_BOOL;
+                } else if (c.takeWord("null") || c.takeWord("nan") || c.takeWord("NaN") ||
+                           c.takeWord("inf") || c.takeWord("-inf") ||
+                           c.takeWord("Infinity") || c.takeWord("-Infinity")) {
+                    field.type = VALUE_NULL;
+                } else {
+                    bool integer;
+                    if (!parseNumber(c, field.value, integer)) {
+                        return false;
+                    }
+                    field.type = integer ? VALUE_INTEGER : VALUE_NUMBER;
+                    return true;
+                }
+                field.value = std::string_view(first, c.p - first);
+                return true;
+            }
+
+        }
+
+        bool parseUpdate(std::string_view line, Update& update) {
+            update.source = std::string_view();
+            update.offset = 0;
+            update.count = 0;
+
+            size_t open = line.find('{');
+            if (open == std::string_view::npos) {
+                return false;
+            }
+            Cursor c = {line.data() + open + 1, line.data() + line.size()};
+
+            if (!c.take('}')) {
+                do {
+                    Field field;
+                    if (!c.take('"') || !parseString(c, field.key) || !c.take(':') || !parseValue(c, field)) {
+                        return false;
+                    }
+                    if (field.key == "src") {
+                        if (field.type != VALUE_STRING) {
+                            return false;
+                        }
+                        update.source = field.value;
+                    } else if (field.key == "offset_s") {
+                        if (field.type == VALUE_INTEGER || field.type == VALUE_NUMBER) {
+                            char number[32];
+                            size_t length = std::min(field.value.size(), sizeof(number) - 1);
+                            memcpy(number, field.value.data(), length);
+                            number[length] = '\0';
+                            update.offset = strtod(number, NULL);
+                        }
+                    } else if (update.count < Update::MAX_FIELDS) {
+                        update.fields[update.count++] = field;
+                    } else {
+                        return false;
+                    }
+                } while (c.take(','));
+                if (!c.take('}')) {
+                    return false;
+                }
+            }
+            c.skipSpace();
+            return c.p == c.end && !update.source.empty();
+        }
+
+
+        LineReader::LineReader(size_t capacity) :
+            buffer(capacity),
+            start(0),
+            end(0),
+            scan(0),
+            discarding(false),
+            discarded(0)
+        {}
+
+        void LineReader::compact() {
+            if (start > 0) {
+                memmove(buffer.data(), buffer.data() + start, end - start);
+                end -= start;
+                scan -= start;
+                start = 0;
+            }
+            if (end == buffer.size()) {
+                // one line fills the buffer: drop it, and the rest of it when it comes
+                discarded += end;
+                discarding = true;
+                start = end = scan = 0;
+            }
+        }
+
+        ssize_t LineReader::readFrom(int fd) {
+            compact();
+            ssize_t count = read(fd, buffer.data() + end, buffer.size() - end);
+            if (count > 0) {
+                end += count;
+            }
+            return count;
+        }
+
+        size_t LineReader::append(const char* data, size_t length) {
+            compact();
+            length = std::min(length, buffer.size() - end);
+            memcpy(buffer.data() + end, data, length);
+            end += length;
+            return length;
+        }
+
+        bool LineReader::nextLine(std::string_view& line) {
+            while (scan < end) {
+                const char* newline = static_cast<const char*>(memchr(buffer.data() + scan, '\n', end - scan));
+                if (!newline) {
+                    scan = end;
+                    return false;
+                }
+                size_t first = start;
+                size_t last = newline - buffer.data();
+                start = scan = last + 1;
+                if (discarding) {
+                    discarded += last + 1 - first;
+                    discarding = false;
+                    continue;
+                }
+                if (last > first && buffer[last - 1] == '\r') {
+                    last--;
+                }
+                line = std::string_view(buffer.data() + first, last - first);
+                return true;
+            }
+            return false;
+        }
+
+        uint64_t LineReader::getDiscarded() const {
+            return discarded;
+        }
+
+    }
+
+}
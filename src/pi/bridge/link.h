@@ -0,0 +1,91 @@
+#ifndef ROBOAT_BRIDGE_LINK_H
+#define ROBOAT_BRIDGE_LINK_H
+
+// The Pilot's serial link to the Pi (see src/micro/pi_link.py): one flat JSON
+// object per line, CRLF terminated, such as
+//
+//   {"offset_s": 0, "src": "ina260", "logic_p": 1.25, "batt_v": 13.1}
+//
+// "src" names the reading and "offset_s" is how long (s) before sending it
+// was taken; the rest are its values.
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        typedef enum {
+            VALUE_INTEGER,      // a JSON number without a fraction or exponent
+            VALUE_NUMBER,
+            VALUE_STRING,       // the text between the quotes, escapes as sent
+            VALUE_BOOL,
+            VALUE_NULL          // also nan and inf, which MicroPython writes unquoted
+        } ValueType;
+
+        struct Field {
+            std::string_view key;
+            std::string_view value;
+            ValueType type;
+        };
+
+        // One update from the Pilot. Its views point into the line it was
+        // parsed from, so it is only good until that line is.
+        struct Update {
+            static const size_t MAX_FIELDS = 32;
+
+            std::string_view source;
+            double offset = 0;
+            Field fields[MAX_FIELDS];
+            size_t count = 0;
+        };
+
+        // Parse a line (anything before its first '{' is skipped, as the
+        // Pilot can leave noise on the link when it resets). False if it is
+        // not a flat JSON object with a "src", or has more than MAX_FIELDS.
+        bool parseUpdate(std::string_view line, Update& update);
+
+
+        // Splits a byte stream into lines without copying them: bytes are read
+        // straight into a fixed buffer, and lines are handed out as views of
+        // it, which are good until the next read. A line longer than the
+        // buffer is dropped.
+        class LineReader {
+
+            std::vector<char> buffer;
+            size_t start;           // first byte of the current line
+            size_t end;             // end of the bytes read
+            size_t scan;            // searched for a newline up to here
+            bool discarding;        // dropping the rest of an over-long line
+            uint64_t discarded;
+
+            // Make room at the end of the buffer, dropping a line that fills it.
+            void compact();
+
+        public:
+            explicit LineReader(size_t capacity = 4096);
+
+            // Read whatever `fd` has (one read()); returns the bytes read, 0 at
+            // the end of the file and -1 on error, as read() does.
+            ssize_t readFrom(int fd);
+
+            // Copy bytes in, as much as fits; returns how many did.
+            size_t append(const char* data, size_t length);
+
+            // The next complete line, without its line ending.
+            bool nextLine(std::string_view& line);
+
+            // Bytes dropped with over-long lines.
+            uint64_t getDiscarded() const;
+
+        };
+
+    }
+
+}
+
+#endif
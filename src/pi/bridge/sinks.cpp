@@ -0,0 +1,333 @@
+#include "sinks.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        namespace {
+
+            bool splitHostPort(const std::string& address, std::string& host, std::string& port) {
+                size_t colon = address.rfind(':');
+                if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+                    return false;
+                }
+                host = address.substr(0, colon);
+                port = address.substr(colon + 1);
+                return true;
+            }
+
+            // Connected socket of `type` to host:port, or -1.
+            int connectTo(const std::string& host, const std::string& port, int type, int timeout) {
+                addrinfo hints;
+                memset(&hints, 0, sizeof(hints));
+                hints.ai_family = AF_UNSPEC;
+                hints.ai_socktype = type;
+                addrinfo* addresses;
+                if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0) {
+                    return -1;
+                }
+                int fd = -1;
+                for (addrinfo* a = addresses; a && fd < 0; a = a->ai_next) {
+                    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+                    if (fd < 0) {
+                        continue;
+                    }
+                    if (timeout > 0) {
+                        timeval tv = {timeout, 0};
+                        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+                        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                    }
+                    if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+                        close(fd);
+                        fd = -1;
+                    }
+                }
+                freeaddrinfo(addresses);
+                return fd;
+            }
+
+            bool sendAll(int fd, const char* data, size_t length) {
+                while (length > 0) {
+                    ssize_t count = send(fd, data, length, MSG_NOSIGNAL);
+                    if (count < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (count <= 0) {
+                        return false;
+                    }
+                    data += count;
+                    length -= count;
+                }
+                return true;
+            }
+
+        }
+
+
+        FileSink::FileSink(const std::string& filePath) :
+            path(filePath),
+            file(filePath == "-" ? stdout : fopen(filePath.c_str(), "a"))
+        {}
+
+        FileSink::~FileSink() {
+            if (file && file != stdout) {
+                fclose(file);
+            }
+        }
+
+        bool FileSink::write(const std::string& batch) {
+            return file && fwrite(batch.data(), 1, batch.size(), file) == batch.size() && fflush(file) == 0;
+        }
+
+        const char * FileSink::getName() const {
+            return path.c_str();
+        }
+
+
+        UdpSink::UdpSink(const std::string& address) :
+            socketFd(-1)
+        {
+            std::string host, port;
+            if (splitHostPort(address, host, port)) {
+                socketFd = connectTo(host, port, SOCK_DGRAM, 0);
+            }
+        }
+
+        UdpSink::~UdpSink() {
+            if (socketFd >= 0) {
+                close(socketFd);
+            }
+        }
+
+        bool UdpSink::write(const std::string& batch) {
+            if (socketFd < 0) {
+                return false;
+            }
+            // whole lines per datagram (a single longer line goes alone)
+            size_t start = 0;
+            while (start < batch.size()) {
+                size_t end = start;
+                while (end < batch.size()) {
+                    size_t next = batch.find('\n', end);
+                    next = next == std::string::npos ? batch.size() : next + 1;
+                    if (next - start > MAX_DATAGRAM && end > start) {
+                        break;
+                    }
+                    end = next;
+                }
+                if (send(socketFd, batch.data() + start, end - start, 0) < 0) {
+                    return false;
+                }
+                start = end;
+            }
+            return true;
+        }
+
+        const char * UdpSink::getName() const {
+            return "udp";
+        }
+
+
+        HttpSink::HttpSink(const std::string& url, const std::string& org, const std::string& bucket,
+                           const std::string& token, int timeoutSeconds) :
+            port("80"),
+            timeout(timeoutSeconds)
+        {
+            std::string address = url.compare(0, 7, "http://") == 0 ? url.substr(7) : url;
+            address = address.substr(0, address.find('/'));
+            if (!splitHostPort(address, host, port)) {
+                host = address;
+            }
+            request = "POST /api/v2/write?org=" + org + "&bucket=" + bucket + "&precision=ns HTTP/1.1\r\n"
+                "Host: " + address + "\r\n"
+                "Authorization: Token " + token + "\r\n"
+                "Content-Type: text/plain; charset=utf-8\r\n"
+                "Connection: close\r\n";
+        }
+
+        bool HttpSink::write(const std::string& batch) {
+            int fd = connectTo(host, port, SOCK_STREAM, timeout);
+            if (fd < 0) {
+                return false;
+            }
+            std::string head = request + "Content-Length: " + std::to_string(batch.size()) + "\r\n\r\n";
+            bool ok = sendAll(fd, head.data(), head.size()) && sendAll(fd, batch.data(), batch.size());
+
+            // the status line is all we need: 204 when written
+            char status[64];
+            size_t length = 0;
+            while (ok && length < sizeof(status) - 1 && !memchr(status, '\n', length)) {
+                ssize_t count = recv(fd, status + length, sizeof(status) - 1 - length, 0);
+                if (count <= 0) {
+                    ok = false;
+                } else {
+                    length += count;
+                }
+            }
+            close(fd);
+            status[length] = '\0';
+            int code = 0;
+            if (ok && sscanf(status, "HTTP/%*s %d", &code) != 1) {
+                ok = false;
+            }
+            if (ok && (code < 200 || code >= 300)) {
+                fprintf(stderr, "bridge: InfluxDB answered %d\n", code);
+                // a malformed batch will not be accepted later either, so
+                // drop it; anything else (auth, missing bucket, overload)
+                // may clear up, so it is spooled
+                return code == 400 || code == 422;
+            }
+            return ok;
+        }
+
+        const char * HttpSink::getName() const {
+            return "http";
+        }
+
+
+        Spool::Spool(const std::string& spoolDirectory, uint64_t maxSpoolBytes) :
+            directory(spoolDirectory),
+            maxBytes(maxSpoolBytes),
+            bytes(0),
+            sequence(0),
+            dropped(0)
+        {
+            mkdir(directory.c_str(), 0755);
+            std::vector<std::string> names;
+            if (DIR* dir = opendir(directory.c_str())) {
+                while (dirent* entry = readdir(dir)) {
+                    std::string name(entry->d_name);
+                    if (name.size() == 19 && name.compare(16, 3, ".lp") == 0) {
+                        names.push_back(name);
+                    }
+                }
+                closedir(dir);
+            }
+            // names are zero-padded sequence numbers, so they sort oldest first
+            std::sort(names.begin(), names.end());
+            for (const std::string& name : names) {
+                files.push_back(directory + "/" + name);
+                bytes += fileSize(files.back());
+                sequence = std::max<uint64_t>(sequence, strtoull(name.c_str(), NULL, 16) + 1);
+            }
+        }
+
+        uint64_t Spool::fileSize(const std::string& path) {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0 ? info.st_size : 0;
+        }
+
+        bool Spool::store(const std::string& batch) {
+            while (!files.empty() && bytes + batch.size() > maxBytes) {
+                bytes -= std::min(bytes, fileSize(files.front()));
+                unlink(files.front().c_str());
+                files.pop_front();
+                dropped++;
+            }
+            char name[24];
+            snprintf(name, sizeof(name), "/%016llx.lp", static_cast<unsigned long long>(sequence++));
+            std::string path = directory + name;
+            std::string temporary = path + ".tmp";
+
+            // written aside and renamed, so a power cut never leaves half a batch
+            FILE* file = fopen(temporary.c_str(), "w");
+            if (!file) {
+                return false;
+            }
+            bool ok = fwrite(batch.data(), 1, batch.size(), file) == batch.size();
+            ok = fclose(file) == 0 && ok && rename(temporary.c_str(), path.c_str()) == 0;
+            if (!ok) {
+                unlink(temporary.c_str());
+                return false;
+            }
+            files.push_back(path);
+            bytes += batch.size();
+            return true;
+        }
+
+        size_t Spool::replay(Sink& sink) {
+            size_t count = 0;
+            std::string batch;
+            while (!files.empty()) {
+                const std::string& path = files.front();
+                batch.clear();
+                if (FILE* file = fopen(path.c_str(), "r")) {
+                    char chunk[4096];
+                    size_t length;
+                    while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+                        batch.append(chunk, length);
+                    }
+                    fclose(file);
+                }
+                if (!batch.empty() && !sink.write(batch)) {
+                    break;
+                }
+                bytes -= std::min<uint64_t>(bytes, batch.size());
+                unlink(path.c_str());
+                files.pop_front();
+                count++;
+            }
+            return count;
+        }
+
+        size_t Spool::getCount() const {
+            return files.size();
+        }
+
+        uint64_t Spool::getBytes() const {
+            return bytes;
+        }
+
+        uint64_t Spool::getDropped() const {
+            return dropped;
+        }
+
+
+        Forwarder::Forwarder(Sink& destination, Spool* spoolOrNull, int64_t retryDelayMs) :
+            sink(destination),
+            spool(spoolOrNull),
+            retryDelay(retryDelayMs),
+            retryTime(0),
+            sent(0),
+            failed(0)
+        {}
+
+        bool Forwarder::send(const std::string& batch, int64_t now) {
+            if (now >= retryTime) {
+                // catch up first, so the database sees batches in order
+                if (spool) {
+                    spool->replay(sink);
+                }
+                if ((!spool || spool->getCount() == 0) && sink.write(batch)) {
+                    sent++;
+                    return true;
+                }
+                retryTime = now + retryDelay;
+            }
+            failed++;
+            return spool && spool->store(batch);
+        }
+
+        uint64_t Forwarder::getSent() const {
+            return sent;
+        }
+
+        uint64_t Forwarder::getFailed() const {
+            return failed;
+        }
+
+    }
+
+}
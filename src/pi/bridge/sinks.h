@@ -0,0 +1,135 @@
+#ifndef ROBOAT_BRIDGE_SINKS_H
+#define ROBOAT_BRIDGE_SINKS_H
+
+// Where batches of line protocol go: InfluxDB's HTTP write API, a UDP
+// listener (InfluxDB 1.x, or Telegraf's socket_listener), or a file. Batches
+// that cannot be sent are kept in a spool directory and sent, oldest first,
+// once the sink is back.
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+
+namespace Roboat {
+
+    namespace Bridge {
+
+        class Sink {
+        public:
+            virtual ~Sink() {}
+
+            // Send a batch (complete lines); false if it did not get there.
+            virtual bool write(const std::string& batch) = 0;
+
+            virtual const char * getName() const = 0;
+        };
+
+
+        // Appends to a file, or stdout for "-". Also the stand-in for a
+        // database when testing.
+        class FileSink : public Sink {
+
+            const std::string path;
+            FILE* file;
+
+        public:
+            explicit FileSink(const std::string& filePath);
+            ~FileSink();
+
+            bool write(const std::string& batch);
+            const char * getName() const;
+        };
+
+
+        // Datagrams of whole lines, each within MAX_DATAGRAM bytes.
+        class UdpSink : public Sink {
+
+            int socketFd;
+
+        public:
+            static const size_t MAX_DATAGRAM = 1400;
+
+            // `address` is host:port.
+            explicit UdpSink(const std::string& address);
+            ~UdpSink();
+
+            bool write(const std::string& batch);
+            const char * getName() const;
+        };
+
+
+        // InfluxDB 2.x write API, over plain HTTP.
+        class HttpSink : public Sink {
+
+            std::string host;
+            std::string port;
+            std::string request;    // request line and headers, less Content-Length
+            int timeout;            // s
+
+        public:
+            // `url` is http://host[:port]; the token is sent as is.
+            HttpSink(const std::string& url, const std::string& org, const std::string& bucket,
+                     const std::string& token, int timeoutSeconds = 5);
+
+            bool write(const std::string& batch);
+            const char * getName() const;
+        };
+
+
+        // Batches waiting for the sink, one file each, kept to maxBytes by
+        // dropping the oldest.
+        class Spool {
+
+            const std::string directory;
+            const uint64_t maxBytes;
+            std::deque<std::string> files;      // oldest first
+            uint64_t bytes;
+            uint64_t sequence;
+            uint64_t dropped;
+
+            static uint64_t fileSize(const std::string& path);
+
+        public:
+            // Picks up what an earlier run left in `spoolDirectory`.
+            Spool(const std::string& spoolDirectory, uint64_t maxSpoolBytes);
+
+            bool store(const std::string& batch);
+
+            // Send spooled batches, oldest first, until one fails; returns
+            // how many were sent.
+            size_t replay(Sink& sink);
+
+            size_t getCount() const;
+            uint64_t getBytes() const;
+            uint64_t getDropped() const;
+        };
+
+
+        // Sends batches, spooling them while the sink is down. After a
+        // failure the sink is left alone for retryDelay (ms).
+        class Forwarder {
+
+            Sink& sink;
+            Spool* spool;
+            const int64_t retryDelay;
+            int64_t retryTime;
+            uint64_t sent;
+            uint64_t failed;
+
+        public:
+            Forwarder(Sink& destination, Spool* spoolOrNull, int64_t retryDelayMs = 30000);
+
+            // Send (or spool) a batch at `now` (ms, monotonic). False if it
+            // was neither sent nor spooled.
+            bool send(const std::string& batch, int64_t now);
+
+            uint64_t getSent() const;
+            uint64_t getFailed() const;
+        };
+
+    }
+
+}
+
+#endif
@@ -4,6 +4,12 @@
 #include <RoboatLogManager.h>
 #include <RoboatAHRS.h>
 #include <RoboatGPSManager.h>
+#include <RoboatNavigator.h>
+#include <RoboatBlackBox.h>
+#include <RoboatStore.h>
+#include <RoboatDebug.h>
+#include <RoboatMemory.h>
+#include <RoboatWatchdog.h>
 
 #include <SafetyPin.h>
 #include <SPI.h>
@@ -15,10 +21,11 @@
 // Pin and Interface Assignments
 ///////////////////////////////////////////////////////////////////
 
-// Debug (USB) serial connection
+// Debug (USB) serial connection. Output goes through the non-blocking
+// debug channel (RoboatDebug.h), which drains to the port from loop().
 auto &debugSerial(Serial);
 const int DEBUG_SERIAL_BAUD = 115200;
-ArduinoOutStream debugOut(debugSerial);
+ArduinoOutStream debugOut(Roboat::Debug::out);
 
 DigitalOut onboardLed(LED_BUILTIN);
 
@@ -29,6 +36,7 @@ DigitalOut navLightCommsEnable(39);   // enable communications to the navigation
 
 // Power monitor (via I2C on the "Wire1" interface)
 auto &powerSenseI2CWire(Wire1);
+Roboat::I2C::Bus powerSenseBus(powerSenseI2CWire, "Power bus");
 
 // Battery Charger
 // (all three of the charger status inputs are open-drain, so enable pullups to differentiate between low and hi-Z states)
@@ -39,12 +47,21 @@ PwmOut rightDrive1(30), rightDrive2(29), leftDrive1(35), leftDrive2(36);
 
 // IMU (via I2C on the "Wire" interface, plus reset and interrupts)
 auto &imuI2CWire(Wire);
+Roboat::I2C::Bus imuBus(imuI2CWire, "IMU bus");
 DigitalOut imuReset(17);
 DigitalIn imuAI1(6), imuAI2(5), imuGI1(8), imuGI2(7);
 
-// Serial connection to Raspberry Pi
+// GPS (NMEA on Serial1). The MTK3339's PPS output is not wired on this
+// board; set its pin here if it is, to time the clock to the microsecond.
+const int GPS_PPS_PIN = -1;
+
+// Serial connection to Raspberry Pi. Log output is buffered, like debug
+// output, so a burst of it never waits on the UART. What does not fit is
+// dropped a whole log line, frame or slice chunk at a time (Log::Manager
+// reserves room for each first).
 auto &rpiSerial(Serial2);
-ArduinoOutStream rpiOut(rpiSerial);
+uint8_t rpiOutBuffer[2048];
+Roboat::Debug::Channel rpiChannel(rpiSerial, rpiOutBuffer, sizeof(rpiOutBuffer), Roboat::Debug::DROP_NEWEST);
 DigitalOut rpiBootTrigger(26);  // trigger for triggering RPi boot when it is idle
 
 
@@ -53,25 +70,26 @@ DigitalOut rpiBootTrigger(26);  // trigger for triggering RPi boot when it is id
 ///////////////////////////////////////////////////////////////////
 
 
+// Persistent settings and counters (in EEPROM)
+Roboat::Persist::Store store;
+
+
 // --------------
 // The Conn
 // --------------
 
 // Operations and status logging
-Roboat::Log::Manager logManager(rpiOut);
+Roboat::Log::Manager logManager(rpiChannel, store);
 
 // Helm
 Roboat::Conn::Helm helm;
 
-// Captain
-Roboat::Conn::Captain captain(rpiSerial, rpiBootTrigger);
-
 
 // ----------------
 // Power Management
 // ----------------
 
-Roboat::Power::Manager powerManager(chargerPG, chargerStat1, chargerStat2, powerSenseI2CWire, INA219_ADDRESS);
+Roboat::Power::Manager powerManager(chargerPG, chargerStat1, chargerStat2, powerSenseBus, INA219_ADDRESS);
 
 
 // ----------
@@ -79,10 +97,35 @@ Roboat::Power::Manager powerManager(chargerPG, chargerStat1, chargerStat2, power
 // ----------
 
 // Attitude and heading reference
-Roboat::IMU::AHRS ahrs(imuReset);
+Roboat::IMU::AHRS ahrs(imuReset, imuBus, store);
 
-// GPS manager state machine, communicating with GPS hardware on Serial1
-Roboat::GPS::Manager gpsManager(Serial1);
+// GPS manager state machine, communicating with GPS hardware on Serial1;
+// it also disciplines the clock (RoboatClock.h) to GPS time
+Roboat::GPS::Manager gpsManager(Serial1, GPS_PPS_PIN);
+
+// Route following, steering the Helm; also corrects the AHRS heading to true
+Roboat::Nav::Navigator navigator(gpsManager, ahrs, helm);
+
+// Raw IMU capture, triggered by capsize or power faults
+Roboat::BlackBox::Recorder blackBox(ahrs, logManager);
+const float CAPSIZE_ROLL_LIMIT = 60.0;  // degrees of roll beyond which we assume a capsize
+
+
+// -------
+// Captain
+// -------
+
+// Commands from the RPI (log slices, route) reach the log and the navigator.
+// The RPI is kept halted between uploads (see RoboatCaptain.h).
+Roboat::Conn::Captain captain(rpiSerial, rpiChannel, rpiBootTrigger, logManager, navigator);
+
+
+// --------
+// Watchdog
+// --------
+
+// Resets the Pilot if the departments stop advancing (see RoboatWatchdog.h)
+Roboat::Watchdog::Supervisor supervisor(logManager, store);
 
 
 // ----------------
@@ -97,9 +140,18 @@ Roboat::GPS::Manager gpsManager(Serial1);
 
 uint32_t nextLogTime;
 static uint32_t logInterval = 1e6;  // 1 full second
+uint32_t nextBusLogTime;
+static uint32_t busLogInterval = 60e6;  // I2C recovery time histograms once a minute
 uint32_t statusBlinkEndTime = 0;
 uint32_t lastLoopStartTime;
 uint32_t maxLoopTime = 0;
+bool bootReported = false;
+bool alarmRaised = false;
+
+// A department's time to ready (ms since reset), or -1 if it is not ready yet.
+template <typename Machine> int32_t readyMillis(const Machine& machine) {
+  return machine.getReadyTime() ? machine.getReadyTime() / 1000 : -1;
+}
 
 
 ///////////////////////////////////////////////////////////////////
@@ -107,36 +159,54 @@ uint32_t maxLoopTime = 0;
 ///////////////////////////////////////////////////////////////////
 
 void setup() {
+  // Paint the free stack before anything else runs, to measure its depth later.
+  Roboat::Memory::paintStack();
+
   // Turn on the orange LED for the duration of setup, then go to normal diagnostic blink mode.
   onboardLed.high();
 
-  // Set up debug serial output first
+  // Debug output is buffered (RoboatDebug.h) and passed on from loop(), so
+  // nothing here waits for the USB host to connect.
   debugSerial.begin(DEBUG_SERIAL_BAUD);
-
-  delay(1000);
   debugOut << F("Beginning Roboat startup...") << endl;
-  delay(100);
   debugOut << F("Epoch Number: ") << logManager.getEpoch() << endl;
 
-  // Start by turning off everything that can be turned off.
-  // Will bring it up gradually while doing system checks.
-  debugOut << F("Disabling drive, nav sensor, and nav light subsystems.") << endl;
+  // Boot plan. setup() only sets the outputs; every department then comes
+  // up on its own from loop(), so independent bring-ups overlap:
+  //
+  //   Log         SD card mount
+  //   Captain     RPI UART
+  //   Power       INA219 on Wire1
+  //   AHRS        IMU on Wire, once nav power is up (below)
+  //   GPS         Serial1, once nav power is up; ready at the first fix
+  //   Navigator   waits for a GPS fix before following a route
+  //   BlackBox    waits for the log's card, then opens (or allocates) its file
+  //   Watchdog    arms at once, with a longer timeout until BlackBox is ready
+  //
+  // Each department marks itself ready (StateMachine::markReady), and the
+  // times go into every log record.
+  debugOut << F("Disabling drive and nav light subsystems; enabling nav power.") << endl;
   drivePowerEnable.low();
-  navPowerEnable.low();
   navLightCommsEnable.low();
-
-  debugOut << F("Enabling nav power...") << endl;
   navPowerEnable.high();
-  
-  debugOut << F("Connecting to IMU...") << endl;
-  imuI2CWire.begin();
 
   ahrs.setActive(true);
+
+  // Each department is watched against the deadline it declares.
+  supervisor.watch(logManager, Roboat::Log::WATCHDOG_DEADLINE);
+  supervisor.watch(captain, Roboat::Conn::WATCHDOG_DEADLINE);
+  supervisor.watch(powerManager, Roboat::Power::WATCHDOG_DEADLINE);
+  supervisor.watch(ahrs, Roboat::IMU::WATCHDOG_DEADLINE);
+  supervisor.watch(gpsManager, Roboat::GPS::WATCHDOG_DEADLINE);
+  supervisor.watch(navigator, Roboat::Nav::WATCHDOG_DEADLINE);
+  // pre-allocating its file may block for longer than Watchdog::TIMEOUT
+  supervisor.watchSlowStart(blackBox, Roboat::BlackBox::WATCHDOG_DEADLINE);
   
   nextLogTime = micros();
+  nextBusLogTime = nextLogTime + busLogInterval;
   lastLoopStartTime = nextLogTime;
 
-  debugOut << F("Startup complete.") << endl;
+  debugOut << F("Setup complete; departments starting.") << endl;
   debugOut << F("===============================") << endl;
 
   onboardLed.low();
@@ -152,37 +222,105 @@ void loop() {
   }
   lastLoopStartTime = currentMicros;
 
+  // Pass on buffered output, as much as the ports will take.
+  Roboat::Debug::out.drain();
+  rpiChannel.drain();
+
   // Advance all subsystem state machines.
   logManager.advance(currentMicros);
   captain.advance(currentMicros);
   powerManager.advance(currentMicros);
   ahrs.advance(currentMicros);
   gpsManager.advance(currentMicros);
+  navigator.advance(currentMicros);
+  blackBox.advance(currentMicros);
+  supervisor.advance(currentMicros);
+
+  // The AHRS slows its sampling when the boat is still, but not while
+  // steering or capturing.
+  if (blackBox.getState() == Roboat::BlackBox::CAPTURING) {
+    ahrs.setMinimumRate(Roboat::IMU::RATE_100HZ);
+  } else if (helm.hasCourse()) {
+    ahrs.setMinimumRate(Roboat::IMU::RATE_50HZ);
+  } else {
+    ahrs.setMinimumRate(Roboat::IMU::RATE_25HZ);
+  }
 
-  if (currentMicros >= nextLogTime) {
-    onboardLed.high();
-
-    String logLine = lastLoopDuration;
-
-    logLine.concat(",");
-    logLine.concat(int(navPowerEnable.read()));
-    
-    logLine.concat(",");
-    logLine.concat(logManager.getLogString());
-
-    logLine.concat(",");
-    logLine.concat(captain.getLogString());
-
-    logLine.concat(",");
-    logLine.concat(powerManager.getLogString());
+  Roboat::IMU::Attitude attitude;
+  ahrs.getAttitude(attitude);
+  bool capsized = ahrs.getState() == Roboat::IMU::RUNNING && fabs(attitude.roll) > CAPSIZE_ROLL_LIMIT;
+  bool powerFault = powerManager.getState() == Roboat::Power::ERROR;
+  if (capsized) {
+    blackBox.trigger(Roboat::BlackBox::TRIGGER_CAPSIZE);
+  } else if (powerFault) {
+    blackBox.trigger(Roboat::BlackBox::TRIGGER_POWER_FAULT);
+  }
 
-    logLine.concat(",");
-    logLine.concat(gpsManager.getLogString());
+  // Wake the RPI to report either, once each time one starts.
+  if ((capsized || powerFault) && !alarmRaised) {
+    captain.requestWake();
+  }
+  alarmRaised = capsized || powerFault;
 
-    logLine.concat(",");
-    logLine.concat(ahrs.getLogString());
+  if (currentMicros >= nextLogTime) {
+    onboardLed.high();
 
-    logManager.writeln(logLine);
+    Roboat::Log::Record record;
+    record.add(lastLoopDuration);
+    record.add(navPowerEnable.read());
+    record.add(Roboat::Debug::out.getDroppedBytes());
+    record.add(rpiChannel.getDroppedBytes());
+    Roboat::Memory::addLogFields(record);
+    logManager.addLogFields(record);
+    captain.addLogFields(record);
+    powerManager.addLogFields(record);
+    gpsManager.addLogFields(record);
+    ahrs.addLogFields(record);
+    navigator.addLogFields(record);
+    blackBox.addLogFields(record);
+    supervisor.addLogFields(record);
+    imuBus.addLogFields(record);
+    powerSenseBus.addLogFields(record);
+    record.add(readyMillis(logManager));
+    record.add(readyMillis(captain));
+    record.add(readyMillis(powerManager));
+    record.add(readyMillis(ahrs));
+    record.add(readyMillis(gpsManager));
+    record.add(readyMillis(navigator));
+    record.add(readyMillis(blackBox));
+    record.add(readyMillis(supervisor));
+
+    logManager.writeRecord(record);
+
+    // Boot is complete when every department but the GPS (whose first fix
+    // depends on the sky) is ready.
+    if (!bootReported && logManager.isReady()) {
+      const uint32_t readyTimes[] = {
+        logManager.getReadyTime(), captain.getReadyTime(), powerManager.getReadyTime(), ahrs.getReadyTime(),
+        navigator.getReadyTime(), blackBox.getReadyTime(), supervisor.getReadyTime()
+      };
+      uint32_t bootTime = 0;
+      bool booted = true;
+      for (uint32_t readyTime : readyTimes) {
+        booted = booted && readyTime != 0;
+        bootTime = max(bootTime, readyTime);
+      }
+      if (booted) {
+        logManager.writeln(String("BOOT,") + (bootTime / 1000));
+        debugOut << F("Boot complete in ") << (bootTime / 1000) << F("ms") << endl;
+        bootReported = true;
+      }
+    }
+
+    if (currentMicros >= nextBusLogTime) {
+      if (imuBus.getFaultCount() > 0) {
+        logManager.writeln(String("I2C,") + imuBus.getLogString());
+      }
+      if (powerSenseBus.getFaultCount() > 0) {
+        logManager.writeln(String("I2C,") + powerSenseBus.getLogString());
+      }
+      nextBusLogTime += busLogInterval;
+    }
 
     nextLogTime += logInterval;
     statusBlinkEndTime = currentMicros + 1000;
@@ -11,40 +11,97 @@ namespace Roboat {
     
     namespace IMU {
 
-        // allow the AHRS to settle for 5s before using data
+        // The filter has settled once its attitude holds within 1 degree
+        // over a 0.5s window while the IMU is still (all rates under 3
+        // deg/s); Madgwick's correction moves it several degrees per second
+        // while it converges. If the boat is moving, allow it 5s instead.
         const uint32_t SETTLING_DELAY = 5e6;
+        const uint32_t SETTLING_WINDOW = 5e5;
+        const float SETTLING_TOLERANCE = 1.0F;
+        const float SETTLING_MAX_RATE = 3.0F;
 
-        // reset after 10s on error
-        const uint32_t ERROR_RESET_DELAY = 10e6;
+        // retry after faults from 2ms, backing off to 10s; a run of 10s
+        // without faults starts the backoff again from the shortest delay
+        const uint32_t RETRY_INITIAL_DELAY = 2e3;
+        const uint32_t RETRY_MAX_DELAY = 10e6;
+        const uint32_t BACKOFF_RESET_TIME = 10e6;
+
+        // online mag calibration: attempt a solution every 250 used samples,
+        // install it only if its error is small and clearly below that of the
+        // calibration in use, and at most every 10 minutes (each one is
+        // written to the EEPROM)
+        const uint32_t MAG_SOLVE_INTERVAL = 250;
+        const float MAG_MAX_FIT_ERROR = 0.03F;
+        const float MAG_MIN_IMPROVEMENT = 0.7F;
+        const uint32_t MAG_UPDATE_INTERVAL = 600000;
+
+        const float RAD_PER_DEG = (float)M_PI / 180.0F;
+
+        // Sensor registers for changing output data rates (the Adafruit
+        // drivers configure both sensors for 100Hz and offer no way to
+        // change it). Each sensor must leave active mode to change its rate.
+        const uint8_t GYRO_ADDRESS = 0x21;          // FXAS21002C
+        const uint8_t GYRO_CTRL_REG1 = 0x13;
+        const uint8_t GYRO_READY = 0x01;
+        const uint8_t GYRO_ACTIVE = 0x02;
+        const uint8_t GYRO_DATA_RATES[RATE_COUNT] = { 5, 4, 3 };  // DR for 25, 50, 100Hz
+
+        const uint8_t ACCELMAG_ADDRESS = 0x1F;      // FXOS8700
+        const uint8_t ACCELMAG_CTRL_REG1 = 0x2A;
+        const uint8_t ACCELMAG_CTRL_REG2 = 0x2B;
+        const uint8_t ACCELMAG_STANDBY = 0x00;
+        const uint8_t ACCELMAG_ACTIVE = 0x01;
+        const uint8_t ACCELMAG_LOW_NOISE = 0x04;    // valid in the 2g range used here
+        const uint8_t ACCELMAG_DATA_RATES[RATE_COUNT] = { 4, 3, 2 };  // hybrid mode DR for 25, 50, 100Hz
+        // oversampling mode: low-noise low-power at the slowest rate, where
+        // the boat is barely moving, high resolution (the driver's) otherwise
+        const uint8_t ACCELMAG_MODES[RATE_COUNT] = { 0x01, 0x02, 0x02 };
 
         // degrees per radian for conversion
         const float DEG_PER_RAD = 57.2958F;
 
+        // Default calibration, used until one has been saved in the store.
         // Mag calibration values are calculated via ahrs_calibration.
         // These values must be determined for each baord/environment.
         // See the image in this sketch folder for the values used
         // below.
+        const Calibration DEFAULT_CALIBRATION = {
+            // Offsets applied to raw x/y/z mag values
+            { 0.93F, -7.47F, -35.23F },
 
-        // Offsets applied to raw x/y/z mag values
-        const float mag_offsets[3]            = { 0.93F, -7.47F, -35.23F };
-
-        // Soft iron error compensation matrix
-        const float mag_softiron_matrix[3][3] = { {  0.943,  0.011,  0.020 },
-                                                {  0.022,  0.918, -0.008 },
-                                                {  0.020, -0.008,  1.156 } };
+            // Soft iron error compensation matrix
+            { {  0.943,  0.011,  0.020 },
+              {  0.022,  0.918, -0.008 },
+              {  0.020, -0.008,  1.156 } },
 
-        const float mag_field_strength        = 50.23F;
+            // Field strength
+            50.23F,
 
-        // Offsets applied to compensate for gyro zero-drift error for x/y/z
-        const float gyro_zero_offsets[3]      = { 0.0F, 0.0F, 0.0F };
+            // Offsets applied to compensate for gyro zero-drift error for x/y/z
+            { 0.0F, 0.0F, 0.0F }
+        };
 
 
-        AHRS::AHRS(DigitalOut& imuResetPin) :
+        AHRS::AHRS(DigitalOut& imuResetPin, I2C::Bus& imuBus, Persist::Store& persistentStore) :
             StateMachine(STARTUP, "AHRS"),
             imuReset(imuResetPin),
+            bus(imuBus),
+            store(persistentStore),
             gyro(Adafruit_FXAS21002C(0x0021002C)),
             accelmag(Adafruit_FXOS8700(0x8700A, 0x8700B)),
-            requestedActive(false)
+            requestedActive(false),
+            backoff(RETRY_INITIAL_DELAY, RETRY_MAX_DELAY),
+            filterSettled(false),
+            settleWindowStart(0),
+            settleStill(false),
+            settleRoll(0),
+            settlePitch(0),
+            settleHeading(0),
+            activeCalibration(0),
+            magSolveCount(0),
+            lastMagUpdate(0),
+            magCalibrationUpdates(0),
+            rawSampleCount(0)
         {}
 
         void AHRS::setActive(bool active) {
@@ -55,11 +112,13 @@ namespace Roboat {
             switch (getState()) {
                 case STARTUP:
                     imuReset.low();
+                    bus.begin();
+                    loadCalibration();
                     goToState(DISABLED, 10);
                     break;
 
                 case ERROR:
-                    goToState(DISABLED, ERROR_RESET_DELAY);
+                    goToState(DISABLED, backoff.next());
                     break;
 
                 case DISABLED:
@@ -76,25 +135,35 @@ namespace Roboat {
                     if (gyro.begin()) {
                         goToState(ACTIVATING_2);
                     } else {
-                        Serial.println("Gyro begin failed. Will retry.");
-                        goToState(ACTIVATING_1, 5e6);
+                        Debug::out.println("Gyro begin failed. Will retry.");
+                        bus.check();
+                        goToState(RECOVERING);
                     }
                     break;
 
                 case ACTIVATING_2:
                     if (accelmag.begin(ACCEL_RANGE_2G)) {
-                        // start the AHRS filter, then give it time to settle
-                        filter.begin(100);
-                        goToState(SETTLING);
+                        // start the AHRS filter at the drivers' 100Hz, then
+                        // give it time to settle; the governor takes over
+                        // once it is running
+                        filter.begin(getFrequency(RATE_100HZ));
+                        governor.reset(RATE_100HZ);
+                        settleWindowStart = micros();
+                        settleStill = false;
+                        goToState(filterSettled ? RUNNING : SETTLING);
                     } else {
-                        Serial.println("Accel/Mag begin failed. Will retry.");
-                        goToState(ACTIVATING_2, 5e6);
+                        Debug::out.println("Accel/Mag begin failed. Will retry.");
+                        bus.check();
+                        goToState(RECOVERING);
                     }
                     break;
 
                 case SETTLING:
-                    updateFilter();
-                    if (getTimeInState() >= SETTLING_DELAY) {
+                    if (!updateFilter()) {
+                        goToState(RECOVERING);
+                    } else if (hasSettled() || getTimeInState() >= SETTLING_DELAY) {
+                        filterSettled = true;
+                        markReady();
                         goToState(RUNNING);
                     }
                     break;
@@ -102,47 +171,164 @@ namespace Roboat {
                 case RUNNING:
                     if (!requestedActive) {
                         goToState(DEACTIVATING);
+                    } else if (!updateFilter()) {
+                        goToState(RECOVERING);
                     } else {
-                        updateFilter();
-                        goToState(RUNNING, 1e4);    // 10ms period for 100Hz IMU updates
+                        if (getTimeInState() >= BACKOFF_RESET_TIME) {
+                            backoff.reset();
+                        }
+                        goToState(RUNNING, getPeriod(governor.getRate()));
                     }
                     break;
                     
                 case DEACTIVATING:
+                    filterSettled = false;
                     goToState(DISABLED);
                     break;
 
+                case RECOVERING:
+                    // free the bus, then hold the sensors in reset until the retry
+                    if (!bus.recover()) {
+                        Debug::out.println("IMU bus still stuck after recovery.");
+                    }
+                    imuReset.low();
+                    goToState(DISABLED, backoff.next());
+                    break;
+
                 default:
-                    Serial.println("Unexpected state encountered!");
+                    Debug::out.println("Unexpected state encountered!");
                     goToState(ERROR);
             }
 
             return false;
         }
 
-        void AHRS::updateFilter() {
+        static MagCalibration magPart(const Calibration& cal) {
+            MagCalibration mag;
+            memcpy(mag.offsets, cal.magOffsets, sizeof(mag.offsets));
+            memcpy(mag.softIron, cal.magSoftIron, sizeof(mag.softIron));
+            mag.fieldStrength = cal.magFieldStrength;
+            return mag;
+        }
+
+        void AHRS::loadCalibration() {
+            Calibration& calibration = calibrations[activeCalibration];
+            if (!store.get(Persist::KEY_IMU_CALIBRATION, calibration)) {
+                calibration = DEFAULT_CALIBRATION;
+                store.put(Persist::KEY_IMU_CALIBRATION, calibration);
+            }
+            magCalibrator.reset(magPart(calibration));
+            magSolveCount = 0;
+        }
+
+        bool AHRS::hasSettled() {
+            if (fabsf(rates[0]) > SETTLING_MAX_RATE || fabsf(rates[1]) > SETTLING_MAX_RATE ||
+                fabsf(rates[2]) > SETTLING_MAX_RATE) {
+                settleStill = false;
+            }
+            if (micros() - settleWindowStart < SETTLING_WINDOW) {
+                return false;
+            }
+
+            float headingChange = fabsf(heading - settleHeading);
+            if (headingChange > 180) {
+                headingChange = 360 - headingChange;
+            }
+            bool settled = settleStill &&
+                fabsf(roll - settleRoll) < SETTLING_TOLERANCE &&
+                fabsf(pitch - settlePitch) < SETTLING_TOLERANCE &&
+                headingChange < SETTLING_TOLERANCE;
+
+            // start the next window from here
+            settleWindowStart = micros();
+            settleStill = true;
+            settleRoll = roll;
+            settlePitch = pitch;
+            settleHeading = heading;
+            return settled;
+        }
+
+        void AHRS::updateMagCalibration(float x, float y, float z) {
+            if (!magCalibrator.addSample(x, y, z)) {
+                return;
+            }
+            if (magCalibrator.getSampleCount() < magSolveCount + MAG_SOLVE_INTERVAL) {
+                return;
+            }
+            magSolveCount = magCalibrator.getSampleCount();
+
+            if (!magCalibrator.solve() ||
+                magCalibrator.getFitQuality() > MAG_MAX_FIT_ERROR ||
+                magCalibrator.getFitQuality() > MAG_MIN_IMPROVEMENT * magCalibrator.getReferenceQuality()) {
+                return;
+            }
+            if (magCalibrationUpdates > 0 && millis() - lastMagUpdate < MAG_UPDATE_INTERVAL) {
+                return;
+            }
+
+            // fill in the inactive slot, then switch to it
+            const uint8_t next = activeCalibration ^ 1;
+            const MagCalibration& mag = magCalibrator.getSolution();
+            calibrations[next] = calibrations[activeCalibration];
+            memcpy(calibrations[next].magOffsets, mag.offsets, sizeof(mag.offsets));
+            memcpy(calibrations[next].magSoftIron, mag.softIron, sizeof(mag.softIron));
+            calibrations[next].magFieldStrength = mag.fieldStrength;
+            activeCalibration = next;
+
+            store.put(Persist::KEY_IMU_CALIBRATION, calibrations[next]);
+            lastMagUpdate = millis();
+            magCalibrationUpdates++;
+
+            // continue fitting relative to the new calibration
+            magCalibrator.reset(mag);
+            magSolveCount = 0;
+        }
+
+        bool AHRS::updateFilter() {
             sensors_event_t gyro_event;
             sensors_event_t accel_event;
             sensors_event_t mag_event;
         
-            // Get new data samples
+            // Get new data samples, discarding them if the bus failed
             gyro.getEvent(&gyro_event);
             accelmag.getEvent(&accel_event, &mag_event);
+            if (!bus.check()) {
+                return false;
+            }
+
+            // Keep the unscaled readings for anyone interested in raw data
+            rawSample.time = micros();
+            rawSample.gyro[0] = gyro.raw.x;
+            rawSample.gyro[1] = gyro.raw.y;
+            rawSample.gyro[2] = gyro.raw.z;
+            rawSample.accel[0] = accelmag.accel_raw.x;
+            rawSample.accel[1] = accelmag.accel_raw.y;
+            rawSample.accel[2] = accelmag.accel_raw.z;
+            rawSample.mag[0] = accelmag.mag_raw.x;
+            rawSample.mag[1] = accelmag.mag_raw.y;
+            rawSample.mag[2] = accelmag.mag_raw.z;
+            rawSampleCount++;
         
+            if (getState() == RUNNING) {
+                updateMagCalibration(mag_event.magnetic.x, mag_event.magnetic.y, mag_event.magnetic.z);
+            }
+
+            const Calibration& cal = calibrations[activeCalibration];
+
             // Apply mag offset compensation (base values in uTesla)
-            float x = mag_event.magnetic.x - mag_offsets[0];
-            float y = mag_event.magnetic.y - mag_offsets[1];
-            float z = mag_event.magnetic.z - mag_offsets[2];
+            float x = mag_event.magnetic.x - cal.magOffsets[0];
+            float y = mag_event.magnetic.y - cal.magOffsets[1];
+            float z = mag_event.magnetic.z - cal.magOffsets[2];
         
             // Apply mag soft iron error compensation
-            float mx = x * mag_softiron_matrix[0][0] + y * mag_softiron_matrix[0][1] + z * mag_softiron_matrix[0][2];
-            float my = x * mag_softiron_matrix[1][0] + y * mag_softiron_matrix[1][1] + z * mag_softiron_matrix[1][2];
-            float mz = x * mag_softiron_matrix[2][0] + y * mag_softiron_matrix[2][1] + z * mag_softiron_matrix[2][2];
+            float mx = x * cal.magSoftIron[0][0] + y * cal.magSoftIron[0][1] + z * cal.magSoftIron[0][2];
+            float my = x * cal.magSoftIron[1][0] + y * cal.magSoftIron[1][1] + z * cal.magSoftIron[1][2];
+            float mz = x * cal.magSoftIron[2][0] + y * cal.magSoftIron[2][1] + z * cal.magSoftIron[2][2];
         
             // Apply gyro zero-rate error compensation
-            float gx = gyro_event.gyro.x + gyro_zero_offsets[0];
-            float gy = gyro_event.gyro.y + gyro_zero_offsets[1];
-            float gz = gyro_event.gyro.z + gyro_zero_offsets[2];
+            float gx = gyro_event.gyro.x + cal.gyroZeroOffsets[0];
+            float gy = gyro_event.gyro.y + cal.gyroZeroOffsets[1];
+            float gz = gyro_event.gyro.z + cal.gyroZeroOffsets[2];
         
             // The filter library expects gyro data in degrees/s, but adafruit sensor
             // uses rad/s so we need to convert them first (or adapt the filter lib
@@ -150,6 +336,9 @@ namespace Roboat {
             gx *= DEG_PER_RAD;
             gy *= DEG_PER_RAD;
             gz *= DEG_PER_RAD;
+            rates[0] = gx;
+            rates[1] = gy;
+            rates[2] = gz;
         
             // Update the filter
             filter.update(gx, gy, gz,
@@ -158,6 +347,43 @@ namespace Roboat {
             roll = filter.getRoll();
             pitch = filter.getPitch();
             heading = filter.getYaw();
+
+            // Pick the rate for the samples to come (this one was taken, and
+            // integrated, at the old rate).
+            if (getState() == RUNNING) {
+                float accel[3] = {
+                    accel_event.acceleration.x, accel_event.acceleration.y, accel_event.acceleration.z
+                };
+                if (governor.addSample(rawSample.time, rates, accel) && !applyRate(governor.getRate())) {
+                    return false;
+                }
+            }
+
+            // Publish the whole update for other departments. The filter does
+            // not expose its quaternion, so it is rebuilt from the Euler
+            // angles (ZYX order), with the heading published rather than the
+            // filter's yaw in radians (getYaw() adds 180 degrees to it).
+            Attitude sample;
+            sample.time = rawSample.time;
+            sample.count = attitude.getSequence() + 1;
+            float cr = cosf(filter.getRollRadians() / 2), sr = sinf(filter.getRollRadians() / 2);
+            float cp = cosf(filter.getPitchRadians() / 2), sp = sinf(filter.getPitchRadians() / 2);
+            float cy = cosf(heading * RAD_PER_DEG / 2), sy = sinf(heading * RAD_PER_DEG / 2);
+            sample.quaternion[0] = cr * cp * cy + sr * sp * sy;
+            sample.quaternion[1] = sr * cp * cy - cr * sp * sy;
+            sample.quaternion[2] = cr * sp * cy + sr * cp * sy;
+            sample.quaternion[3] = cr * cp * sy - sr * sp * cy;
+            sample.roll = roll;
+            sample.pitch = pitch;
+            sample.heading = heading;
+            sample.rates[0] = gx;
+            sample.rates[1] = gy;
+            sample.rates[2] = gz;
+            sample.accel[0] = accel_event.acceleration.x;
+            sample.accel[1] = accel_event.acceleration.y;
+            sample.accel[2] = accel_event.acceleration.z;
+            attitude.publish(sample);
+            return true;
         }
 
         const char* AHRS::getStateName(const State aState) const {
@@ -178,26 +404,123 @@ namespace Roboat {
                     return "RUNNING";
                 case DEACTIVATING:
                     return "DEACTIVATING";
+                case RECOVERING:
+                    return "RECOVERING";
 
                 default:
                     return "<INVALID>";
             }
         }
 
+        const Calibration& AHRS::getCalibration() const {
+            return calibrations[activeCalibration];
+        }
+
+        float AHRS::getMagFitQuality() const {
+            return magCalibrator.getFitQuality();
+        }
+
+        float AHRS::getMagReferenceQuality() const {
+            return magCalibrator.getReferenceQuality();
+        }
+
+        uint16_t AHRS::getMagCalibrationUpdates() const {
+            return magCalibrationUpdates;
+        }
+
+        float AHRS::getRoll() const {
+            return roll;
+        }
+
+        float AHRS::getPitch() const {
+            return pitch;
+        }
+
         float AHRS::getHeading() const {
             return heading;
         }
+
+        const RawSample& AHRS::getRawSample() const {
+            return rawSample;
+        }
+
+        uint32_t AHRS::getRawSampleCount() const {
+            return rawSampleCount;
+        }
  
+        bool AHRS::applyRate(Rate rate) {
+            bool ok =
+                writeRegister(GYRO_ADDRESS, GYRO_CTRL_REG1, GYRO_READY) &&
+                writeRegister(GYRO_ADDRESS, GYRO_CTRL_REG1, (GYRO_DATA_RATES[rate] << 2) | GYRO_ACTIVE) &&
+                writeRegister(ACCELMAG_ADDRESS, ACCELMAG_CTRL_REG1, ACCELMAG_STANDBY) &&
+                writeRegister(ACCELMAG_ADDRESS, ACCELMAG_CTRL_REG2, ACCELMAG_MODES[rate]) &&
+                writeRegister(ACCELMAG_ADDRESS, ACCELMAG_CTRL_REG1,
+                              (ACCELMAG_DATA_RATES[rate] << 3) | ACCELMAG_LOW_NOISE | ACCELMAG_ACTIVE);
+            if (ok) {
+                filter.begin(getFrequency(rate));
+            }
+            return ok;
+        }
+
+        bool AHRS::writeRegister(uint8_t address, uint8_t reg, uint8_t value) {
+            i2c_t3& wire = bus.getWire();
+            wire.beginTransmission(address);
+            wire.write(reg);
+            wire.write(value);
+            wire.endTransmission();
+            return bus.check();
+        }
+
+        void AHRS::setMinimumRate(Rate rate) {
+            governor.setMinimumRate(rate);
+        }
+
+        Rate AHRS::getRate() const {
+            return governor.getRate();
+        }
+
+        const RateGovernor& AHRS::getGovernor() const {
+            return governor;
+        }
+
+        uint32_t AHRS::getAttitude(Attitude& sample) const {
+            return attitude.read(sample);
+        }
+
         String AHRS::getLogString() const {
+            Attitude sample;
+            getAttitude(sample);
 
             String logStr(getState());
             logStr.concat(",");
             if (getState() == Roboat::IMU::State::RUNNING) {
-              logStr.concat(getHeading());
+              logStr.concat(sample.heading);
+              logStr.concat(",");
+              logStr.concat(sample.roll);
+              logStr.concat(",");
+              logStr.concat(sample.pitch);
             } else {
-              logStr.concat("-");
+              logStr.concat("-,-,-");
             }
             return logStr;
         }
+
+        void AHRS::addLogFields(Log::Record& record) const {
+            Attitude sample;
+            getAttitude(sample);
+
+            record.add(getState());
+            if (getState() == RUNNING) {
+                record.add(lroundf(sample.heading * 100));
+            } else {
+                record.add(-1);
+            }
+            record.add(lroundf(sample.roll * 100));
+            record.add(lroundf(sample.pitch * 100));
+            record.add(lroundf(getMagFitQuality() * 1000));
+            record.add(magCalibrationUpdates);
+            record.add(lroundf(getFrequency(governor.getRate())));
+            record.add(governor.getChangeCount());
+        }
     }
 }
\ No newline at end of file
@@ -9,6 +9,12 @@
 #include <Adafruit_FXAS21002C.h>
 #include <Adafruit_FXOS8700.h>
 #include <Madgwick.h>
+#include <RoboatLogCodec.h>
+#include <RoboatMagCalibrator.h>
+#include <RoboatStore.h>
+#include <RoboatI2CBus.h>
+#include <RoboatSnapshot.h>
+#include <RoboatRateGovernor.h>
 
 
 namespace Roboat {
@@ -23,30 +29,142 @@ namespace Roboat {
             ACTIVATING_2,
             SETTLING,
             RUNNING,
-            DEACTIVATING
+            DEACTIVATING,
+            RECOVERING          // releasing the bus and resetting the sensors after a fault
         } State;
 
+        // Longest the AHRS may go between advances before the watchdog
+        // supervisor (RoboatWatchdog.h) counts a miss (us): the loop's worst
+        // card writes (Log::WORST_WRITE_TIME) and ten IMU samples at the full
+        // rate. Samples missed in a long write show as black box gaps.
+        const uint32_t WATCHDOG_DEADLINE = 6e5;
+
+
+        // Sensor calibration, kept in the persistent store under
+        // Persist::KEY_IMU_CALIBRATION so that all of it is updated at once.
+        typedef struct {
+            float magOffsets[3];            // offsets applied to raw x/y/z mag values (uT)
+            float magSoftIron[3][3];        // soft iron error compensation matrix
+            float magFieldStrength;         // expected field magnitude (uT)
+            float gyroZeroOffsets[3];       // gyro zero-drift compensation for x/y/z (rad/s)
+        } Calibration;
+
+
+        // One raw reading from the FXAS21002C/FXOS8700 pair, in sensor counts
+        // (i.e. before any scaling or calibration is applied).
+        typedef struct {
+            uint32_t time;      // micros() at which the sample was read
+            int16_t gyro[3];
+            int16_t accel[3];
+            int16_t mag[3];
+        } RawSample;
+
+
+        // The filter's state after one update, published as a whole (see
+        // RoboatSnapshot.h) so that readers in the main loop or in interrupt
+        // handlers always see a single consistent sample.
+        typedef struct {
+            uint32_t time;          // micros() at which the sensors were read
+            uint32_t count;         // filter updates since startup
+            float quaternion[4];    // body to earth rotation (w, x, y, z), yaw = heading
+            float roll;             // degrees
+            float pitch;            // degrees
+            float heading;          // degrees
+            float rates[3];         // calibrated body rates (deg/s)
+            float accel[3];         // body accelerations (m/s^2)
+        } Attitude;
+
 
         class AHRS : public StateMachine<State, AHRS> {
             DigitalOut& imuReset;
+            I2C::Bus& bus;
+            Persist::Store& store;
             Adafruit_FXAS21002C gyro;
             Adafruit_FXOS8700 accelmag;
             Madgwick filter;
 
             bool requestedActive;
 
+            // retries after sensor or bus faults
+            I2C::Backoff backoff;
+
+            // True once the filter has settled. After a brief fault the
+            // attitude it holds is still good, so it is not settled again.
+            bool filterSettled;
+
+            // the attitude at the start of the current settling window, and
+            // whether the IMU has been still since
+            uint32_t settleWindowStart;
+            bool settleStill;
+            float settleRoll;
+            float settlePitch;
+            float settleHeading;
+
+            // The filter reads calibrations[activeCalibration]. A new
+            // calibration is written to the other slot and then made active
+            // with a single store to the index, so the filter never sees a
+            // half-updated calibration and is never restarted.
+            Calibration calibrations[2];
+            uint8_t activeCalibration;
+
+            // online magnetometer calibration, fed while RUNNING
+            MagCalibrator magCalibrator;
+            uint32_t magSolveCount;
+            uint32_t lastMagUpdate;
+            uint16_t magCalibrationUpdates;
+
             float roll;
             float pitch;
             float heading;
+            float rates[3];     // body rates of the last sample (deg/s)
+
+            // the attitude after each filter update, for other departments
+            Snapshot<Attitude> attitude;
+
+            // sample rate, following the boat's motion while RUNNING
+            RateGovernor governor;
+
+            // Set the sensors' output data rates, and the filter's, to match
+            // the governor. Returns false if the bus failed.
+            bool applyRate(Rate rate);
+
+            // Write one sensor register. Returns false if the bus failed.
+            bool writeRegister(uint8_t address, uint8_t reg, uint8_t value);
+
+            // most recent raw sensor reading, and the number taken since startup
+            RawSample rawSample;
+            uint32_t rawSampleCount;
+
+            // Read the sensors and update the filter. Returns false, without
+            // updating, if the bus failed.
+            bool updateFilter();
+
+            // Call after each update while SETTLING: true once the filter's
+            // attitude has stopped converging.
+            bool hasSettled();
 
-            void updateFilter();
+            // Load the calibration from the store, seeding the store with the
+            // built-in defaults if it has none.
+            void loadCalibration();
+
+            // Feed a mag sample (uT) to the online calibration, and install its
+            // solution if it is clearly better than the calibration in use.
+            void updateMagCalibration(float x, float y, float z);
             
         public:
-            AHRS(DigitalOut& imuResetPin);
+            AHRS(DigitalOut& imuResetPin, I2C::Bus& imuBus, Persist::Store& persistentStore);
 
             // Set to true to enable AHRS functions, false to disable.
             void setActive(bool active);
 
+            // Keep the sample rate at or above `rate`, whatever the motion
+            // (e.g. while the Helm is steering or the black box is capturing).
+            void setMinimumRate(Rate rate);
+
+            // Current sample rate, and the governor choosing it.
+            Rate getRate() const;
+            const RateGovernor& getGovernor() const;
+
             // Advance the state machine. Returns true if the update results in any
             // change in external state, false if the update is a noop or affects only
             // state internal to the RoboatAHRS instance.
@@ -54,9 +172,36 @@ namespace Roboat {
 
             const char * getStateName(const State aState) const;
             
+            const Calibration& getCalibration() const;
+
+            // RMS radius error of recent mag samples under the online fit and
+            // under the calibration in use, as a fraction of the field strength.
+            float getMagFitQuality() const;
+            float getMagReferenceQuality() const;
+
+            // number of online mag calibrations installed since startup
+            uint16_t getMagCalibrationUpdates() const;
+
+            float getRoll() const;
+            float getPitch() const;
             float getHeading() const;
 
+            // Copy the attitude after the most recent filter update. Safe to
+            // call from an interrupt handler. Returns the number of updates
+            // published so far, 0 if there has been none.
+            uint32_t getAttitude(Attitude& sample) const;
+
+            // The most recent raw sensor reading. Poll getRawSampleCount() to
+            // detect new samples (and any that were missed between polls).
+            const RawSample& getRawSample() const;
+            uint32_t getRawSampleCount() const;
+
             String getLogString() const;
+
+            // heading, roll and pitch in hundredths of a degree (heading -1
+            // when not running); mag fit error in thousandths; online
+            // calibration updates; sample rate (Hz); rate changes
+            void addLogFields(Log::Record& record) const;
         };
 
     }
@@ -0,0 +1,375 @@
+#include "RoboatBlackBox.h"
+
+namespace Roboat {
+
+    namespace BlackBox {
+
+        static_assert(sizeof(FileHeader) == BLOCK_SIZE, "file header must fill one block");
+        static_assert(sizeof(Block) == BLOCK_SIZE, "sample blocks must fill one block");
+
+        // reset after 10s on error
+        const uint32_t ERROR_RESET_DELAY = 10e6;
+
+        // recheck for a mounted card once a second
+        const uint32_t ALLOCATING_RETRY_PERIOD = 1e6;
+
+        // poll for new IMU samples several times per 10ms sample period
+        const uint32_t SAMPLE_POLL_PERIOD = 2e3;
+
+        // keep recording for 30s after a trigger
+        const uint32_t POST_TRIGGER_TIME = 30e6;
+
+        // bound on SD writes per update, so that a capture never stalls the loop
+        const uint8_t MAX_BLOCKS_PER_UPDATE = 2;
+
+        // full IMU output rate (see IMU::AHRS)
+        const uint16_t SAMPLE_RATE = 100;
+
+        Recorder::Recorder(const IMU::AHRS& ahrsSource, Log::Manager& log) :
+            StateMachine(STARTUP, "BlackBox"),
+            ahrs(ahrsSource),
+            logManager(log),
+            fileId(0),
+            nextFileBlock(0),
+            head(0), tail(0),
+            lastSampleCount(0),
+            gapPending(false),
+            capture(1),
+            captureSequence(0),
+            triggerTime(0),
+            triggerUtc(0),
+            triggerCause(TRIGGER_MANUAL),
+            triggerRequested(false),
+            droppedSamples(0)
+        {}
+
+        bool Recorder::update() {
+            switch (getState()) {
+                case STARTUP:
+                    goToState(ALLOCATING, 10);
+                    break;
+
+                case ERROR:
+                    if (file.isOpen()) {
+                        file.close();
+                    }
+                    goToState(STARTUP, ERROR_RESET_DELAY);
+                    break;
+
+                case ALLOCATING:
+                    if (!logManager.isReady()) {
+                        remain(ALLOCATING_RETRY_PERIOD);
+                    } else if (openCaptureFile()) {
+                        head = tail = 0;
+                        captureSequence = 0;
+                        lastSampleCount = ahrs.getRawSampleCount();
+                        startBlock();
+                        markReady();
+                        if (nextFileBlock >= CAPTURE_FILE_SIZE / BLOCK_SIZE) {
+                            Debug::out.println(F("Black box capture file is full."));
+                            goToState(FULL);
+                        } else {
+                            goToState(ARMED);
+                        }
+                    } else {
+                        Debug::out.println(F("Failed to open black box capture file."));
+                        goToState(ERROR);
+                    }
+                    break;
+
+                case ARMED:
+                    collectSamples();
+                    if (triggerRequested) {
+                        triggerRequested = false;
+                        triggerTime = micros();
+                        triggerUtc = Clock::isSynced() ? Clock::toUtc(triggerTime) : 0;
+
+                        // stamp the history we are about to write with this event
+                        for (uint8_t i = tail; ; i = (i + 1) % RING_BLOCKS) {
+                            ring[i].triggerTime = triggerTime;
+                            ring[i].triggerUtc = triggerUtc;
+                            ring[i].cause = triggerCause;
+                            if (i == head) {
+                                break;
+                            }
+                        }
+                        ring[head].flags |= BLOCK_TRIGGER;
+                        goToState(CAPTURING);
+                    } else {
+                        remain(SAMPLE_POLL_PERIOD);
+                    }
+                    break;
+
+                case CAPTURING:
+                    collectSamples();
+                    if (!writeQueuedBlocks(MAX_BLOCKS_PER_UPDATE)) {
+                        break;
+                    }
+                    if (getTimeInState() >= POST_TRIGGER_TIME) {
+                        goToState(FLUSHING);
+                    } else {
+                        remain(SAMPLE_POLL_PERIOD);
+                    }
+                    break;
+
+                case FLUSHING:
+                    finishBlock();
+                    if (!writeQueuedBlocks(MAX_BLOCKS_PER_UPDATE)) {
+                        break;
+                    }
+                    if (queuedBlocks() == 0 && ring[head].count == 0) {
+                        if (!writeHeaderMarks()) {
+                            Debug::out.println(F("Black box write failed."));
+                            goToState(ERROR);
+                            break;
+                        }
+                        capture++;
+                        captureSequence = 0;
+                        head = tail = 0;
+                        lastSampleCount = ahrs.getRawSampleCount();
+                        startBlock();
+                        goToState(ARMED);
+                    } else {
+                        remain(SAMPLE_POLL_PERIOD);
+                    }
+                    break;
+
+                case FULL:
+                    // nowhere left to write; stay here until the file is removed
+                    remain(ALLOCATING_RETRY_PERIOD);
+                    break;
+
+                default:
+                    Debug::out.println("Unexpected state encountered!");
+                    goToState(ERROR);
+            }
+
+            return false;
+        }
+
+        bool Recorder::openCaptureFile() {
+            if (!file.open(CAPTURE_FILE_NAME, O_RDWR)) {
+                return createCaptureFile();
+            }
+
+            FileHeader header;
+            if (!file.seekSet(0) || file.read(&header, BLOCK_SIZE) != int(BLOCK_SIZE) ||
+                memcmp(header.magic, "RBBX", 4) != 0 || header.version != FORMAT_VERSION ||
+                header.blockCount != CAPTURE_FILE_SIZE / BLOCK_SIZE ||
+                file.fileSize() != CAPTURE_FILE_SIZE || header.usedBlocks == 0)
+            {
+                // never reuse (or delete) a file we cannot account for
+                Debug::out.print(CAPTURE_FILE_NAME);
+                Debug::out.println(F(" is not a capture file of this version; copy it off the card and remove it."));
+                file.close();
+                return false;
+            }
+            fileId = header.fileId;
+            nextFileBlock = header.usedBlocks;
+            capture = header.captureCount + 1;
+
+            // Skip any blocks written after the header was last updated, i.e.
+            // a capture cut short by a reset or a write error.
+            Block block;
+            while (nextFileBlock < header.blockCount) {
+                if (!file.seekSet(nextFileBlock * BLOCK_SIZE) || file.read(&block, BLOCK_SIZE) != int(BLOCK_SIZE)) {
+                    file.close();
+                    return false;
+                }
+                if (block.fileId != fileId || block.capture < capture) {
+                    break;
+                }
+                capture = block.capture + 1;
+                nextFileBlock++;
+            }
+            return true;
+        }
+
+        bool Recorder::createCaptureFile() {
+            if (!file.createContiguous(CAPTURE_FILE_NAME, CAPTURE_FILE_SIZE)) {
+                return false;
+            }
+
+            // anything that tells this file apart from what was on the card before
+            fileId = (uint32_t(logManager.getEpoch()) << 16) ^ micros() ^ ARM_DWT_CYCCNT;
+            if (fileId == 0) {
+                fileId = 1;
+            }
+
+            FileHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, "RBBX", 4);
+            header.version = FORMAT_VERSION;
+            header.epoch = logManager.getEpoch();
+            header.sampleRate = SAMPLE_RATE;
+            header.samplesPerBlock = SAMPLES_PER_BLOCK;
+            header.gyroScale = GYRO_SENSITIVITY_250DPS;
+            header.accelScale = ACCEL_MG_LSB_2G;
+            header.magScale = MAG_UT_LSB;
+            header.blockCount = CAPTURE_FILE_SIZE / BLOCK_SIZE;
+            header.fileId = fileId;
+            header.usedBlocks = 1;
+            header.captureCount = 0;
+
+            if (!file.seekSet(0) || file.write(&header, BLOCK_SIZE) != int(BLOCK_SIZE) || !file.sync()) {
+                file.close();
+                return false;
+            }
+            nextFileBlock = 1;
+            capture = 1;
+            return true;
+        }
+
+        bool Recorder::writeHeaderMarks() {
+            uint32_t marks[2] = { nextFileBlock, capture };
+            return file.seekSet(offsetof(FileHeader, usedBlocks)) &&
+                   file.write(marks, sizeof(marks)) == int(sizeof(marks)) &&
+                   file.sync();
+        }
+
+        void Recorder::collectSamples() {
+            uint32_t sampleCount = ahrs.getRawSampleCount();
+            if (sampleCount == lastSampleCount) {
+                return;
+            }
+            if (sampleCount - lastSampleCount > 1) {
+                // polled too slowly to see every sample
+                droppedSamples += sampleCount - lastSampleCount - 1;
+                gapPending = true;
+            }
+            lastSampleCount = sampleCount;
+            appendSample(ahrs.getRawSample());
+        }
+
+        void Recorder::appendSample(const IMU::RawSample& raw) {
+            if (ring[head].count == SAMPLES_PER_BLOCK) {
+                uint8_t next = (head + 1) % RING_BLOCKS;
+                if (next == tail) {
+                    if (getState() == ARMED) {
+                        // history is full; forget the oldest block
+                        tail = (tail + 1) % RING_BLOCKS;
+                    } else {
+                        // the card is behind; drop the sample rather than unwritten data
+                        droppedSamples++;
+                        gapPending = true;
+                        return;
+                    }
+                }
+                head = next;
+                startBlock();
+            }
+
+            Block& block = ring[head];
+            Sample& sample = block.samples[block.count++];
+            sample.time = raw.time;
+            for (uint8_t i = 0; i < 3; i++) {
+                sample.gyro[i] = raw.gyro[i];
+                sample.accel[i] = raw.accel[i];
+                sample.mag[i] = raw.mag[i];
+            }
+        }
+
+        void Recorder::startBlock() {
+            Block& block = ring[head];
+            memset(&block, 0, sizeof(block));
+            block.sequence = captureSequence++;
+            block.capture = capture;
+            block.epoch = logManager.getEpoch();
+            block.sampleRate = uint8_t(IMU::getFrequency(ahrs.getRate()));
+            block.fileId = fileId;
+            if (getState() == CAPTURING) {
+                block.triggerTime = triggerTime;
+                block.triggerUtc = triggerUtc;
+                block.cause = triggerCause;
+            }
+            if (gapPending) {
+                block.flags |= BLOCK_GAP;
+                gapPending = false;
+            }
+        }
+
+        void Recorder::finishBlock() {
+            // Used at the end of a capture to queue the (possibly partial) head
+            // block for writing, once there is room for it.
+            uint8_t next = (head + 1) % RING_BLOCKS;
+            if (ring[head].count > 0 && next != tail) {
+                head = next;
+                ring[head].count = 0;
+            }
+        }
+
+        uint8_t Recorder::queuedBlocks() const {
+            return (head + RING_BLOCKS - tail) % RING_BLOCKS;
+        }
+
+        bool Recorder::writeQueuedBlocks(uint8_t maxBlocks) {
+            while (maxBlocks-- > 0 && queuedBlocks() > 0) {
+                if (nextFileBlock >= CAPTURE_FILE_SIZE / BLOCK_SIZE) {
+                    file.sync();
+                    goToState(FULL);
+                    return false;
+                }
+                if (!file.seekSet(nextFileBlock * BLOCK_SIZE) ||
+                    file.write(&ring[tail], BLOCK_SIZE) != int(BLOCK_SIZE))
+                {
+                    Debug::out.println(F("Black box write failed."));
+                    goToState(ERROR);
+                    return false;
+                }
+                nextFileBlock++;
+                tail = (tail + 1) % RING_BLOCKS;
+            }
+            return true;
+        }
+
+        void Recorder::trigger(TriggerCause cause) {
+            if (getState() == ARMED && !triggerRequested) {
+                triggerCause = cause;
+                triggerRequested = true;
+            }
+        }
+
+        uint32_t Recorder::getDroppedSamples() const {
+            return droppedSamples;
+        }
+
+        const char * Recorder::getStateName(const State aState) const {
+            switch (aState) {
+                case STARTUP:
+                    return "STARTUP";
+                case ERROR:
+                    return "ERROR";
+                case ALLOCATING:
+                    return "ALLOCATING";
+                case ARMED:
+                    return "ARMED";
+                case CAPTURING:
+                    return "CAPTURING";
+                case FLUSHING:
+                    return "FLUSHING";
+                case FULL:
+                    return "FULL";
+
+                default:
+                    return "<INVALID>";
+            }
+        }
+
+        String Recorder::getLogString() const {
+            String logStr(getState());
+            logStr.concat(",");
+            logStr.concat(capture);
+            logStr.concat(",");
+            logStr.concat(droppedSamples);
+            return logStr;
+        }
+
+        void Recorder::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            record.add(capture);
+            record.add(droppedSamples);
+        }
+
+    }
+
+}
@@ -0,0 +1,191 @@
+#ifndef ROBOAT_BLACKBOX_H
+#define ROBOAT_BLACKBOX_H
+
+#include "Arduino.h"
+#include <RoboatStateMachine.h>
+#include <RoboatAHRS.h>
+#include <RoboatLogManager.h>
+#include <RoboatClock.h>
+
+#include "SdFat.h"
+
+namespace Roboat {
+
+    namespace BlackBox {
+
+        // The capture file, pre-allocated once per card and reused by every
+        // boot: captures are appended after the last block written, and none
+        // is ever deleted or overwritten. Once the file is full the recorder
+        // stops until it is copied off the card and removed. (Files named
+        // BBox_<epoch>.bin were written by earlier firmware, one per boot.)
+        const char * const CAPTURE_FILE_NAME = "BBox.bin";
+
+        // Size of the capture file. At the IMU's full 100Hz output rate this
+        // holds about four hours of samples.
+        const uint32_t CAPTURE_FILE_SIZE = 32UL * 1024 * 1024;
+
+        // The capture file is written in whole SD blocks.
+        const uint16_t BLOCK_SIZE = 512;
+        const uint16_t FORMAT_VERSION = 3;
+
+        typedef enum {
+            STARTUP,
+            ERROR,
+            ALLOCATING,     // waiting for the card, then opening (or creating) the capture file
+            ARMED,          // keeping the pre-trigger history, waiting for a trigger
+            CAPTURING,      // streaming history and live samples to the card
+            FLUSHING,       // writing out the remainder of a finished capture
+            FULL            // the capture file has no room left
+        } State;
+
+        // Longest the recorder may go between advances before the watchdog
+        // supervisor (RoboatWatchdog.h) counts a miss (us), allowing for the
+        // loop's worst card writes (Log::WORST_WRITE_TIME). The block ring
+        // holds a few seconds of samples, so this leaves plenty of margin.
+        const uint32_t WATCHDOG_DEADLINE = 1e6;
+
+        typedef enum {
+            TRIGGER_MANUAL = 1,
+            TRIGGER_CAPSIZE = 2,
+            TRIGGER_POWER_FAULT = 3
+        } TriggerCause;
+
+        // Block flags
+        const uint8_t BLOCK_TRIGGER = 0x01;     // the trigger fired while this block was being filled
+        const uint8_t BLOCK_GAP = 0x02;         // samples were lost immediately before this block
+
+        // A raw IMU sample as stored on the card.
+        typedef struct __attribute__((packed)) {
+            uint32_t time;      // micros() at which the sample was read
+            int16_t gyro[3];
+            int16_t accel[3];
+            int16_t mag[3];
+        } Sample;
+
+        const uint8_t SAMPLES_PER_BLOCK = 22;
+
+        // Block 0 of the capture file, describing everything that follows.
+        typedef struct __attribute__((packed)) {
+            char magic[4];              // "RBBX"
+            uint16_t version;
+            uint16_t epoch;             // log epoch of the boot that created the file
+            uint16_t sampleRate;        // full samples per second (blocks may be slower)
+            uint8_t samplesPerBlock;
+            uint8_t reserved0;
+            float gyroScale;            // deg/s per count
+            float accelScale;           // g per count
+            float magScale;             // uT per count
+            uint32_t blockCount;        // size of the file in blocks, including this one
+            uint32_t fileId;            // marks the blocks written to this file (see Block)
+            // Blocks written, including this one, and the last capture
+            // number, as of the end of the last complete capture. Blocks
+            // after it may hold a capture cut short by a reset.
+            uint32_t usedBlocks;
+            uint32_t captureCount;
+            uint8_t reserved[BLOCK_SIZE - 40];
+        } FileHeader;
+
+        // Every subsequent block holds up to SAMPLES_PER_BLOCK samples of one
+        // capture. The blocks after the last one written still hold whatever
+        // was on the card, so a block belongs to the file only if its fileId
+        // matches the header's.
+        typedef struct __attribute__((packed)) {
+            uint32_t sequence;          // block counter, consecutive within a capture
+            uint16_t capture;           // capture number within the file, from 1
+            uint8_t count;              // number of valid samples
+            uint8_t flags;
+            uint32_t triggerTime;       // micros() at which the capture was triggered
+            uint8_t cause;              // TriggerCause
+            uint8_t sampleRate;         // IMU rate (Hz) when the block was started
+            uint16_t epoch;             // log epoch of the boot that wrote the block
+            Sample samples[SAMPLES_PER_BLOCK];
+            uint64_t triggerUtc;        // UTC (us since 1970) at triggerTime, 0 if the clock was not synchronized
+            uint32_t fileId;
+        } Block;
+
+
+        // The black box records raw IMU samples into a pre-allocated file on the
+        // SD card. While armed it keeps the last few seconds of samples in a ring
+        // of blocks in RAM; when triggered, it writes that history out followed
+        // by live samples until the post-trigger period has elapsed.
+        //
+        // The ring doubles as the write queue: samples always go into the block
+        // at the head, and completed blocks are written from the tail a bounded
+        // number per update, so a slow card never holds up the control loop. If
+        // the card falls so far behind that the ring fills, the oldest unwritten
+        // block is kept and new samples are dropped (and the gap flagged).
+        //
+        // The recorder takes samples at whatever rate the AHRS runs. While
+        // armed that may be as low as 25Hz (the boat is still and not
+        // steering; see Pilot.ino), so the pre-trigger history covers about
+        // 13s rather than 3.3s, at a quarter of the resolution; the rate
+        // goes back to 100Hz within a loop of the trigger. Each block records
+        // the rate it was started at, and every sample carries its own time.
+        class Recorder : public StateMachine<State, Recorder> {
+
+            const IMU::AHRS& ahrs;
+            Log::Manager& logManager;
+
+            FatFile file;
+            uint32_t fileId;
+            uint32_t nextFileBlock;     // next block to be written in the capture file
+
+            // Ring of blocks; the block at `head` is being filled, completed blocks
+            // from `tail` up to (but not including) `head` are waiting to be written.
+            static const uint8_t RING_BLOCKS = 16;
+            Block ring[RING_BLOCKS];
+            uint8_t head;
+            uint8_t tail;
+
+            uint32_t lastSampleCount;
+            bool gapPending;
+
+            uint16_t capture;
+            uint32_t captureSequence;
+            uint32_t triggerTime;
+            uint64_t triggerUtc;
+            TriggerCause triggerCause;
+            bool triggerRequested;
+
+            uint32_t droppedSamples;
+
+            // Open the capture file and find the end of what has been written
+            // to it, or create it if there is none.
+            bool openCaptureFile();
+            bool createCaptureFile();
+
+            // Record the end of a complete capture in the file header.
+            bool writeHeaderMarks();
+
+            void collectSamples();
+            void appendSample(const IMU::RawSample& raw);
+            void startBlock();
+            void finishBlock();
+            bool writeQueuedBlocks(uint8_t maxBlocks);
+            uint8_t queuedBlocks() const;
+
+        public:
+            Recorder(const IMU::AHRS& ahrsSource, Log::Manager& log);
+
+            // Advance the state machine.
+            bool update();
+
+            const char * getStateName(const State aState) const;
+
+            // Request a capture. Ignored unless the recorder is armed (an event
+            // during an ongoing capture is already being recorded).
+            void trigger(TriggerCause cause);
+
+            // Number of samples lost because the card could not keep up.
+            uint32_t getDroppedSamples() const;
+
+            String getLogString() const;
+
+            void addLogFields(Log::Record& record) const;
+        };
+
+    }
+
+}
+
+#endif
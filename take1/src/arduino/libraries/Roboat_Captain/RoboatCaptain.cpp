@@ -7,14 +7,73 @@ namespace Roboat {
         const uint32_t ERROR_RESET_DELAY = 10e6;
                 
         const int RPI_SERIAL_BAUD = 115200;
+
+        // Wake policy (ms, except where noted). The RPI is woken at least
+        // every WAKE_INTERVAL, and sooner once UPLOAD_THRESHOLD bytes of
+        // records (about an hour's worth, ten seconds to send) or
+        // BACKLOG_THRESHOLD bytes of log lines are waiting for it.
+        const uint32_t WAKE_INTERVAL = 4UL * 3600 * 1000;
+        const uint32_t UPLOAD_THRESHOLD = 128UL * 1024;
+        const size_t BACKLOG_THRESHOLD = Log::BACKLOG_SIZE * 3 / 4;
+        const uint32_t WAKE_PULSE = 100e3;          // us
+        const uint32_t BOOT_TIMEOUT = 120e3;        // an answer is expected within this
+        const uint32_t WAKE_RETRY_DELAY = 600e3;    // then try again after this
+        const uint32_t AWAKE_LINGER = 60e3;         // halt after this long without a command
+        const uint32_t HALT_GRACE = 20e3;           // the RPI's shutdown takes about this long
+
+        // Typical draw of a Pi Zero W at 5V, running idle and halted (mW),
+        // for the energy saved estimate.
+        const uint32_t RPI_RUNNING_POWER = 600;
+        const uint32_t RPI_HALTED_POWER = 150;
+
+        static const char * getWakeReasonName(WakeReason reason) {
+            switch (reason) {
+                case WAKE_POWER_ON:
+                    return "POWER_ON";
+                case WAKE_SCHEDULE:
+                    return "SCHEDULE";
+                case WAKE_BACKLOG:
+                    return "BACKLOG";
+                case WAKE_URGENT:
+                    return "URGENT";
+                case WAKE_UNPROMPTED:
+                    return "UNPROMPTED";
+                default:
+                    return "NONE";
+            }
+        }
         
-        Captain::Captain(HardwareSerial& serialPort, DigitalOut& wakeSignalPin) :
+        Captain::Captain(HardwareSerial& serialPort, Print& output, DigitalOut& wakeSignalPin,
+                         Log::Manager& log, Nav::Navigator& nav) :
             StateMachine(STARTUP, "Captain"),
             port(serialPort),
-            wakeSignal(wakeSignalPin)
+            out(output),
+            wakeSignal(wakeSignalPin),
+            logManager(log),
+            navigator(nav),
+            wakeReason(WAKE_NONE),
+            wakeRequested(false),
+            stayAwake(false),
+            haltRequested(false),
+            helloReceived(false),
+            haltAcknowledged(false),
+            rpiHalted(false),
+            lastWakeTime(0),
+            lastActivityTime(0),
+            unansweredWakes(0),
+            lastUploadTime(0),
+            uploadedSize(0),
+            uploadStarted(false),
+            lastDutyTime(0),
+            awakeTime(0),
+            asleepTime(0),
+            wakeCount(0),
+            commandLength(0)
         {}
 
         bool Captain::update() {
+            updateDuty();
+
             switch (getState()) {
                 case STARTUP:
                     goToState(ACTIVATING, 10);
@@ -25,54 +84,309 @@ namespace Roboat {
                     break;
 
                 case ACTIVATING:
-                    Serial.print(F("Configuring RPI serial port for "));
-                    Serial.print(RPI_SERIAL_BAUD);
-                    Serial.println(F(" baud."));
+                    Debug::out.print(F("Configuring RPI serial port for "));
+                    Debug::out.print(RPI_SERIAL_BAUD);
+                    Debug::out.println(F(" baud."));
                     port.begin(RPI_SERIAL_BAUD);
+                    wakeSignal.high();
 
                     // The captain should start the cruise awake (and as it happens the
                     // RPI will boot when the system powers up whether we like it or not).
+                    markReady();
+                    wakeReason = WAKE_POWER_ON;
+                    lastWakeTime = millis();
+                    wakeCount++;
                     goToState(WAKING);
                     break;
 
                 case ASLEEP:
-                    if (port.available() > 0) {
-                        // this is unexpected
-                        Serial.println("Found data on RPI serial channel, but RPI expected to be asleep.");
-                        goToState(ERROR);
+                    readCommands();
+                    if (helloReceived) {
+                        // woken by someone else (or never halted); treat it as a wake
+                        rpiHalted = false;
+                        wakeReason = WAKE_UNPROMPTED;
+                        lastWakeTime = millis();
+                        wakeCount++;
+                        board();
                     } else {
-                        // TODO: see if captain should be awakened
+                        WakeReason reason = checkWake();
+                        if (reason != WAKE_NONE) {
+                            wake(reason);
+                        } else {
+                            remain(1e5);
+                        }
                     }
                     break;
                 
                 case WAKING:
-                    // driving wake signal pin low to trigger RPI boot
-                    wakeSignal.low();
-                    // TODO: wait for ready signal on serial port indicating
-                    // RPI is up and running
-                    if (port.available() > 0) {
-                        // captain is awake
+                    // end of the wake pulse; now wait for the RPI to say HELLO
+                    wakeSignal.high();
+                    readCommands();
+                    if (helloReceived) {
+                        unansweredWakes = 0;
+                        board();
+                    } else if (millis() - lastWakeTime >= BOOT_TIMEOUT) {
+                        unansweredWakes++;
+                        logManager.writeln(String("CAPTAIN,NO_ANSWER,") + unansweredWakes);
+                        goToState(ASLEEP);
+                    } else {
+                        remain(1e4);
+                    }
+                    break;
+
+                case UPLOADING:
+                    readCommands();
+                    if (logManager.getBacklogPending() > 0) {
+                        // log lines first
+                        remain();
+                    } else if (!uploadStarted) {
+                        if (logManager.isTransferring()) {
+                            // a slice the RPI asked for; ours can follow it
+                            remain();
+                        } else {
+                            uploadStarted = logManager.requestRange(lastUploadTime, millis());
+                            if (!uploadStarted) {
+                                // nothing to send (or no card)
+                                lastActivityTime = millis();
+                                goToState(ONDECK);
+                            }
+                        }
+                    } else if (!logManager.isTransferring()) {
+                        uploadStarted = false;
+                        lastActivityTime = millis();
                         goToState(ONDECK);
                     }
                     break;
                 
                 case ONDECK:
-                    // TODO
+                    readCommands();
+                    if (wakeRequested || logManager.isTransferring()) {
+                        wakeRequested = false;
+                        lastActivityTime = millis();
+                    }
+                    if (haltRequested || (!stayAwake && millis() - lastActivityTime >= AWAKE_LINGER)) {
+                        halt();
+                    }
+                    break;
+
+                case HALTING:
+                    readCommands();
+                    if (getTimeInState() < uint32_t(HALT_GRACE) * 1000) {
+                        remain(1e5);
+                        break;
+                    }
+                    {
+                        // without HALTING the RPI is assumed to be still running
+                        rpiHalted = haltAcknowledged;
+                        String report(rpiHalted ? "CAPTAIN,SLEEP," : "CAPTAIN,NO_HALT,");
+                        report.concat(getWakeReasonName(wakeReason));
+                        report.concat(",");
+                        report.concat((millis() - lastWakeTime) / 1000);
+                        report.concat(",");
+                        report.concat(getDutyCycle());
+                        report.concat(",");
+                        report.concat(getEnergySaved());
+                        logManager.writeln(report);
+                    }
+                    helloReceived = false;
+                    goToState(ASLEEP);
                     break;
                 
                 default:
-                    Serial.println("Unexpected state encountered!");
+                    Debug::out.println("Unexpected state encountered!");
                     goToState(ERROR);
             }
 
             return false;
         }
 
+        void Captain::updateDuty() {
+            uint32_t now = millis();
+            if (isAwake()) {
+                awakeTime += now - lastDutyTime;
+            } else {
+                asleepTime += now - lastDutyTime;
+            }
+            lastDutyTime = now;
+        }
+
+        WakeReason Captain::checkWake() const {
+            if (wakeRequested) {
+                return WAKE_URGENT;
+            }
+            uint32_t now = millis();
+            if (unansweredWakes > 0 && now - lastWakeTime < WAKE_RETRY_DELAY) {
+                return WAKE_NONE;
+            }
+            if (now - lastWakeTime >= WAKE_INTERVAL) {
+                return WAKE_SCHEDULE;
+            }
+            uint32_t recordSize = logManager.getRecordFileSize();
+            if ((recordSize > uploadedSize && recordSize - uploadedSize >= UPLOAD_THRESHOLD) ||
+                logManager.getBacklogPending() >= BACKLOG_THRESHOLD)
+            {
+                return WAKE_BACKLOG;
+            }
+            return WAKE_NONE;
+        }
+
+        void Captain::wake(WakeReason reason) {
+            wakeReason = reason;
+            wakeRequested = false;
+            lastWakeTime = millis();
+            wakeCount++;
+            rpiHalted = false;
+            logManager.writeln(String("CAPTAIN,WAKE,") + getWakeReasonName(reason));
+
+            // driving wake signal pin low to trigger RPI boot
+            wakeSignal.low();
+            goToState(WAKING, WAKE_PULSE);
+        }
+
+        void Captain::board() {
+            helloReceived = false;
+            logManager.setEcho(true);
+            uploadStarted = false;
+            goToState(UPLOADING);
+        }
+
+        void Captain::halt() {
+            out.print(F("#HALT\n"));
+            haltAcknowledged = false;
+            logManager.setEcho(false);
+            // records from here on wait for the next upload
+            lastUploadTime = millis();
+            uploadedSize = logManager.getRecordFileSize();
+            haltRequested = false;
+            goToState(HALTING);
+        }
+
+        void Captain::requestWake() {
+            wakeRequested = true;
+        }
+
+        bool Captain::isAwake() const {
+            return !rpiHalted;
+        }
+
+        uint16_t Captain::getDutyCycle() const {
+            uint64_t total = awakeTime + asleepTime;
+            return total ? awakeTime * 1000 / total : 1000;
+        }
+
+        uint32_t Captain::getWakeCount() const {
+            return wakeCount;
+        }
+
+        uint32_t Captain::getEnergySaved() const {
+            return asleepTime * (RPI_RUNNING_POWER - RPI_HALTED_POWER) / 3600000;
+        }
+
+        void Captain::readCommands() {
+            while (port.available() > 0) {
+                char c = port.read();
+                if (c == '\r') {
+                    continue;
+                } else if (c == '\n') {
+                    command[commandLength] = '\0';
+                    handleCommand(command);
+                    commandLength = 0;
+                } else if (commandLength < MAX_COMMAND_LENGTH) {
+                    command[commandLength++] = c;
+                }
+            }
+        }
+
+        // Commands from the RPI, one per line:
+        //   RANGE,<start ms>,<end ms>   send back the records logged in that interval
+        //   LATEST,<count>              send back the most recent records
+        //   CANCEL                      stop sending the current slice
+        //   WAYPOINT,<lat>,<lon>        append a waypoint (decimal degrees) to the route
+        //   ROUTE_START                 follow the route from its first waypoint
+        //   ROUTE_STOP                  stop following the route
+        //   ROUTE_CLEAR                 stop and remove all waypoints
+        //   STAY_AWAKE                  do not halt the RPI until SLEEP
+        //   SLEEP                       halt the RPI now (after any upload)
+        //   HELLO                       the RPI has booted
+        //   HALTING                     the RPI is shutting down, on #HALT
+        void Captain::handleCommand(char* line) {
+            char* args = strchr(line, ',');
+            if (args) {
+                *args++ = '\0';
+            }
+
+            bool accepted = false;
+            if (strcmp(line, "RANGE") == 0 && args) {
+                char* end;
+                uint32_t startTime = strtoul(args, &end, 10);
+                if (*end == ',') {
+                    accepted = logManager.requestRange(startTime, strtoul(end + 1, NULL, 10));
+                }
+            } else if (strcmp(line, "LATEST") == 0 && args) {
+                accepted = logManager.requestLatest(strtoul(args, NULL, 10));
+            } else if (strcmp(line, "CANCEL") == 0) {
+                logManager.cancelTransfer();
+                accepted = true;
+            } else if (strcmp(line, "WAYPOINT") == 0 && args) {
+                int32_t lat;
+                int32_t lon;
+                const char* end = Nav::parseDegrees(args, lat);
+                if (end && *end == ',' && abs(lat) <= 90 * Nav::UNITS_PER_DEGREE) {
+                    end = Nav::parseDegrees(end + 1, lon);
+                    if (end && *end == '\0') {
+                        accepted = navigator.addWaypoint(lat, lon);
+                    }
+                }
+            } else if (strcmp(line, "ROUTE_START") == 0) {
+                navigator.setActive(true);
+                accepted = true;
+            } else if (strcmp(line, "ROUTE_STOP") == 0) {
+                navigator.setActive(false);
+                accepted = true;
+            } else if (strcmp(line, "ROUTE_CLEAR") == 0) {
+                navigator.clearRoute();
+                accepted = true;
+            } else if (strcmp(line, "STAY_AWAKE") == 0) {
+                stayAwake = true;
+                accepted = true;
+            } else if (strcmp(line, "SLEEP") == 0) {
+                stayAwake = false;
+                haltRequested = true;
+                accepted = true;
+            } else if (strcmp(line, "HELLO") == 0) {
+                helloReceived = true;
+                accepted = true;
+            } else if (strcmp(line, "HALTING") == 0) {
+                if (getState() == HALTING) {
+                    haltAcknowledged = true;
+                }
+                accepted = true;
+            }
+
+            if (accepted) {
+                lastActivityTime = millis();
+            } else {
+                Debug::out.print(F("Captain command rejected: "));
+                Debug::out.println(line);
+            }
+        }
+
         String Captain::getLogString() const {
             String logStr(getState());
+            logStr.concat(",");
+            logStr.concat(getDutyCycle());
+            logStr.concat(",");
+            logStr.concat(wakeCount);
             return logStr;
         }
 
+        void Captain::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            record.add(getDutyCycle());
+            record.add(wakeCount);
+            record.add(getEnergySaved());
+        }
+
         const char * Captain::getStateName(const State aState) const {
             switch (aState) {
                 case STARTUP:
@@ -87,6 +401,10 @@ namespace Roboat {
                     return "WAKING";
                 case ONDECK:
                     return "ONDECK";                    
+                case UPLOADING:
+                    return "UPLOADING";
+                case HALTING:
+                    return "HALTING";
                 default:
                     return "<INVALID>";
             }
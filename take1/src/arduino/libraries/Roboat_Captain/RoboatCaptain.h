@@ -4,6 +4,9 @@
 #include "Arduino.h"
 #include <RoboatStateMachine.h>
 #include <SafetyPin.h>
+#include <RoboatLogCodec.h>
+#include <RoboatLogManager.h>
+#include <RoboatNavigator.h>
 
 namespace Roboat {
     namespace Conn {
@@ -14,25 +17,137 @@ namespace Roboat {
             ACTIVATING,
             ASLEEP,
             WAKING,
-            ONDECK
+            ONDECK,
+            UPLOADING,      // awake, passing on what was logged while it slept
+            HALTING         // the RPI has been told to halt, waiting for it to shut down
         } State;
+
+        // Longest the Captain may go between advances before the watchdog
+        // supervisor (RoboatWatchdog.h) counts a miss (us): the loop's worst
+        // card writes (Log::WORST_WRITE_TIME) and a little more. The RPI's
+        // commands are short, and it resends any left unanswered.
+        const uint32_t WATCHDOG_DEADLINE = 6e5;
+
+        // Why the RPI was last woken.
+        typedef enum {
+            WAKE_NONE,
+            WAKE_POWER_ON,      // it boots with the Pilot
+            WAKE_SCHEDULE,      // the regular upload
+            WAKE_BACKLOG,       // records or log lines piling up
+            WAKE_URGENT,        // requestWake()
+            WAKE_UNPROMPTED     // it said HELLO while asleep
+        } WakeReason;
         
 
+        // Keeps the RPI (Captain) halted most of the time to save power.
+        //
+        // While it is asleep the log's echo is off: records go only to the
+        // card, and log lines are also kept in a RAM backlog (see
+        // Log::Manager::setEcho). The RPI is woken, by pulsing its wake pin,
+        // on a schedule, when either of those has built up, or on an urgent
+        // event. Once it has booted it says HELLO (a HELLO while it is
+        // thought to be asleep counts as an unprompted wake; anything else,
+        // such as its boot console, is ignored). Then the backlog is passed
+        // on and the records logged since the last upload are sent as a log
+        // slice; then, once the RPI has been quiet for a while, it is sent
+        //
+        //   #HALT\n
+        //
+        // which it should answer with HALTING before shutting down (it is
+        // given HALT_GRACE). Besides the commands in RoboatCaptain.cpp the
+        // RPI may send STAY_AWAKE to be left running (e.g. for someone logged
+        // in) and SLEEP to be halted at once. The RPI's side is
+        // src/pi/captain/captain.py.
+        //
+        // Only halts the RPI has acknowledged count as time asleep in the
+        // duty cycle and energy saved.
         class Captain : public StateMachine<State, Captain> {
 
             HardwareSerial& port;
+            Print& out;
             DigitalOut& wakeSignal;
+            Log::Manager& logManager;
+            Nav::Navigator& navigator;
+
+            // wake policy
+            WakeReason wakeReason;
+            bool wakeRequested;
+            bool stayAwake;                 // STAY_AWAKE from the RPI
+            bool haltRequested;             // SLEEP from the RPI
+            bool helloReceived;             // HELLO from the RPI, not yet acted on
+            bool haltAcknowledged;          // HALTING from the RPI, since the last #HALT
+            bool rpiHalted;                 // it acknowledged the last #HALT, and has not been woken since
+            uint32_t lastWakeTime;          // ms
+            uint32_t lastActivityTime;      // ms; last command, or slice sent
+            uint8_t unansweredWakes;
+
+            // Records logged before lastUploadTime (ms) have reached the RPI,
+            // and the record file was uploadedSize bytes then.
+            uint32_t lastUploadTime;
+            uint32_t uploadedSize;
+            bool uploadStarted;
+
+            // RPI duty cycle: time (ms) running and halted since startup
+            uint32_t lastDutyTime;
+            uint64_t awakeTime;
+            uint64_t asleepTime;
+            uint32_t wakeCount;
+
+            // Add the time since the last call to the running or halted total.
+            void updateDuty();
+
+            // The reason to wake the RPI now, or WAKE_NONE.
+            WakeReason checkWake() const;
+
+            // Pulse the wake pin, for `reason`.
+            void wake(WakeReason reason);
+
+            // The RPI has answered: turn the echo back on and start the upload.
+            void board();
+
+            // Tell the RPI to halt, and stop echoing to it.
+            void halt();
+
+            // partial command line received from the RPI
+            static const uint8_t MAX_COMMAND_LENGTH = 64;
+            char command[MAX_COMMAND_LENGTH + 1];
+            uint8_t commandLength;
+
+            // Read whatever the RPI has sent, handling each complete line.
+            void readCommands();
+            void handleCommand(char* line);
 
         public:
-            Captain(HardwareSerial& serialPort, DigitalOut& wakeSignalPin);
+            // Commands are read from `serialPort`; anything for the RPI goes
+            // through `output` (the buffered channel the log also echoes to).
+            Captain(HardwareSerial& serialPort, Print& output, DigitalOut& wakeSignalPin,
+                    Log::Manager& log, Nav::Navigator& nav);
 
             // Advance the state machine.
             bool update();
                         
             const char * getStateName(const State aState) const;
+
+            // Wake the RPI as soon as possible (or keep it awake a while longer).
+            void requestWake();
+
+            // True unless the RPI has acknowledged a halt and not been woken since.
+            bool isAwake() const;
+
+            // Fraction of the time since startup (thousandths) the RPI has been
+            // running, and the number of times it has been woken.
+            uint16_t getDutyCycle() const;
+            uint32_t getWakeCount() const;
+
+            // Energy saved (mWh) by halting the RPI, from typical figures for
+            // its draw running and halted, over the time it was halted.
+            uint32_t getEnergySaved() const;
             
             String getLogString() const;
 
+            // state; RPI duty cycle (thousandths); wakes; energy saved (mWh)
+            void addLogFields(Log::Record& record) const;
+
         };
 
     }
@@ -0,0 +1,147 @@
+#include "RoboatClock.h"
+
+namespace Roboat {
+
+    namespace Clock {
+
+        // A reference further than this from the prediction is taken as it is,
+        // rather than slewed towards (us). This also covers the first one.
+        const int64_t STEP_LIMIT = 100000;
+
+        // Loop gains: the fraction of each phase error corrected at once, and
+        // of the implied rate error added to the rate estimate. Both pairs give
+        // a well-damped loop; PPS edges (jitter of a few us) are followed
+        // within a few tens of seconds, while NMEA arrival times (jitter of
+        // milliseconds) are averaged over several minutes.
+        const float PRECISE_PHASE_GAIN = 0.25F;
+        const float PRECISE_FREQUENCY_GAIN = 0.05F;
+        const float COARSE_PHASE_GAIN = 0.02F;
+        const float COARSE_FREQUENCY_GAIN = 0.0001F;
+
+        // crystals are good to far better than this
+        const float MAX_RATE_CORRECTION = 500e-6F;
+
+        static uint32_t lastMicros = 0;
+        static uint32_t wraps = 0;
+
+        // UTC time was utcReference at local time localReference, and runs
+        // (1 + rate) times as fast as the local clock
+        static bool synced = false;
+        static uint64_t localReference = 0;
+        static uint64_t utcReference = 0;
+        static float rate = 0;
+
+        static int32_t lastError = 0;
+        static uint32_t syncCount = 0;
+
+        uint64_t localMicros() {
+            uint32_t current = micros();
+            if (current < lastMicros) {
+                wraps++;
+            }
+            lastMicros = current;
+            return (uint64_t(wraps) << 32) | current;
+        }
+
+        uint64_t toLocal(uint32_t microsStamp) {
+            uint64_t local = localMicros();
+            return local - int32_t(uint32_t(local) - microsStamp);
+        }
+
+        static uint64_t map(uint64_t local) {
+            if (!synced) {
+                return local;
+            }
+            int64_t elapsed = int64_t(local - localReference);
+            return utcReference + elapsed + int64_t(float(elapsed) * rate);
+        }
+
+        uint64_t now() {
+            return map(localMicros());
+        }
+
+        uint64_t toUtc(uint32_t microsStamp) {
+            return map(toLocal(microsStamp));
+        }
+
+        bool isSynced() {
+            return synced;
+        }
+
+        void synchronize(uint64_t local, uint64_t utc, bool precise) {
+            syncCount++;
+            int64_t error = synced ? int64_t(utc - map(local)) : STEP_LIMIT + 1;
+            if (error > STEP_LIMIT || error < -STEP_LIMIT) {
+                // too far out to slew; start again from this reference
+                localReference = local;
+                utcReference = utc;
+                synced = true;
+                lastError = 0;
+                return;
+            }
+            lastError = int32_t(error);
+
+            const float phaseGain = precise ? PRECISE_PHASE_GAIN : COARSE_PHASE_GAIN;
+            const float frequencyGain = precise ? PRECISE_FREQUENCY_GAIN : COARSE_FREQUENCY_GAIN;
+            int64_t interval = int64_t(local - localReference);
+            if (interval > 0) {
+                rate += frequencyGain * float(error) / float(interval);
+                rate = constrain(rate, -MAX_RATE_CORRECTION, MAX_RATE_CORRECTION);
+            }
+            utcReference = map(local) + int64_t(phaseGain * float(error));
+            localReference = local;
+        }
+
+        int32_t getLastError() {
+            return lastError;
+        }
+
+        int32_t getRateCorrection() {
+            return lroundf(rate * 1e9F);
+        }
+
+        uint32_t getSyncCount() {
+            return syncCount;
+        }
+
+        uint32_t unixTime(uint16_t year, uint8_t month, uint8_t day,
+                          uint8_t hour, uint8_t minute, uint8_t second) {
+            // days since 1970-01-01 in the proleptic Gregorian calendar, counting
+            // years from March so that the leap day comes last
+            int32_t y = int32_t(year) - (month <= 2 ? 1 : 0);
+            int32_t era = y / 400;
+            uint32_t yearOfEra = uint32_t(y - era * 400);
+            uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+            int32_t days = era * 146097 + int32_t(dayOfEra) - 719468;
+            return uint32_t(days) * 86400UL + hour * 3600UL + minute * 60UL + second;
+        }
+
+        size_t formatTime(uint64_t time, char* out) {
+            uint64_t seconds = time / 1000000;
+            uint32_t fraction = time % 1000000;
+
+            char digits[20];
+            uint8_t count = 0;
+            do {
+                digits[count++] = '0' + seconds % 10;
+                seconds /= 10;
+            } while (seconds > 0);
+
+            size_t n = 0;
+            while (count > 0) {
+                out[n++] = digits[--count];
+            }
+            out[n++] = '.';
+            for (int8_t i = 5; i >= 0; i--) {
+                out[n + i] = '0' + fraction % 10;
+                fraction /= 10;
+            }
+            n += 6;
+            out[n] = '\0';
+            return n;
+        }
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef ROBOAT_CLOCK_H
+#define ROBOAT_CLOCK_H
+
+#include "Arduino.h"
+
+namespace Roboat {
+
+    // GPS-disciplined timekeeping.
+    //
+    // The local timebase is micros() extended to 64 bits. Whenever the GPS
+    // supplies a UTC second (marked by the PPS edge if it is wired, otherwise
+    // by the arrival of the NMEA sentence), synchronize() compares it with
+    // the local clock and steers a linear mapping from local to UTC time: a
+    // phase-locked loop that corrects the offset and estimates the rate error
+    // of the crystal. Between fixes, and after the GPS is lost, the mapping
+    // keeps running at the estimated rate.
+    //
+    // Converting a time is a subtraction, a single-precision multiply and an
+    // addition, cheap enough to stamp every sample. All functions are for the
+    // main loop only (not interrupt handlers).
+    namespace Clock {
+
+        // micros() extended to 64 bits. Must be called at least once every 71
+        // minutes (now() and toUtc() call it) to notice every wrap.
+        uint64_t localMicros();
+
+        // The 64-bit local time of a micros() reading taken in the last 35 minutes.
+        uint64_t toLocal(uint32_t microsStamp);
+
+        // UTC in microseconds since 1970 once synchronized; until then the
+        // local time since startup.
+        uint64_t now();
+
+        // now() as of a micros() reading taken in the last 35 minutes.
+        uint64_t toUtc(uint32_t microsStamp);
+
+        // True once a UTC time has been received.
+        bool isSynced();
+
+        // Feed a reference: the local time at which UTC was `utc`. Precise
+        // references (PPS edges) are trusted to a few microseconds; others
+        // (NMEA arrival times) only to milliseconds and are weighted less.
+        void synchronize(uint64_t local, uint64_t utc, bool precise);
+
+        // Difference between the last reference and the time predicted for
+        // it (us), and the estimated rate correction (parts per billion).
+        int32_t getLastError();
+        int32_t getRateCorrection();
+
+        uint32_t getSyncCount();
+
+        // Seconds since 1970 of a UTC calendar date and time.
+        uint32_t unixTime(uint16_t year, uint8_t month, uint8_t day,
+                          uint8_t hour, uint8_t minute, uint8_t second);
+
+        // Write a time as "<seconds>.<microseconds>", NUL-terminated. `out`
+        // needs room for 28 characters. Returns the length written.
+        size_t formatTime(uint64_t time, char* out);
+
+    }
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "RoboatDebug.h"
+
+namespace Roboat {
+
+    namespace Debug {
+
+        // Enough for a burst of state transitions (or the startup messages)
+        // while the USB host is slow to read.
+        static const size_t CONSOLE_BUFFER_SIZE = 4096;
+        static uint8_t consoleBuffer[CONSOLE_BUFFER_SIZE];
+
+        Channel out(Serial, consoleBuffer, CONSOLE_BUFFER_SIZE);
+
+
+        Channel::Channel(Print& output, uint8_t* buffer, size_t size, OverflowPolicy overflowPolicy) :
+            port(output),
+            ring(buffer),
+            capacity(size),
+            head(0),
+            tail(0),
+            used(0),
+            policy(overflowPolicy),
+            droppedBytes(0)
+        {}
+
+        size_t Channel::write(uint8_t byte) {
+            return write(&byte, 1);
+        }
+
+        size_t Channel::write(const uint8_t* buffer, size_t size) {
+            if (size > capacity - used) {
+                if (policy == DROP_OLDEST && size <= capacity) {
+                    dropOldest(size);
+                } else {
+                    droppedBytes += size;
+                    return 0;
+                }
+            }
+
+            size_t first = min(size, capacity - head);
+            memcpy(ring + head, buffer, first);
+            memcpy(ring, buffer + first, size - first);
+            head = (head + size) % capacity;
+            used += size;
+            return size;
+        }
+
+        void Channel::dropOldest(size_t needed) {
+            while (used > 0 && capacity - used < needed) {
+                // one line at a time, through its newline (or all of it if there is none)
+                uint8_t byte;
+                do {
+                    byte = ring[tail];
+                    tail = (tail + 1) % capacity;
+                    used--;
+                    droppedBytes++;
+                } while (used > 0 && byte != '\n');
+            }
+        }
+
+        int Channel::availableForWrite() {
+            return capacity - used;
+        }
+
+        bool Channel::reserve(size_t length) {
+            if (length > capacity - used && policy == DROP_OLDEST && length <= capacity) {
+                dropOldest(length);
+            }
+            if (length > capacity - used) {
+                droppedBytes += length;
+                return false;
+            }
+            return true;
+        }
+
+        size_t Channel::drain() {
+            size_t drained = 0;
+            int space = port.availableForWrite();
+            while (space > 0 && used > 0) {
+                size_t chunk = min(min(used, capacity - tail), size_t(space));
+                size_t written = port.write(ring + tail, chunk);
+                tail = (tail + written) % capacity;
+                used -= written;
+                drained += written;
+                if (written < chunk) {
+                    break;
+                }
+                space -= written;
+            }
+            return drained;
+        }
+
+        void Channel::setPolicy(OverflowPolicy overflowPolicy) {
+            policy = overflowPolicy;
+        }
+
+        size_t Channel::getPending() const {
+            return used;
+        }
+
+        uint32_t Channel::getDroppedBytes() const {
+            return droppedBytes;
+        }
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef ROBOAT_DEBUG_H
+#define ROBOAT_DEBUG_H
+
+#include "Arduino.h"
+
+namespace Roboat {
+
+    namespace Debug {
+
+        // What to do with output that does not fit in the ring.
+        typedef enum {
+            DROP_NEWEST,        // discard the new output
+            DROP_OLDEST         // discard the oldest whole lines to make room
+        } OverflowPolicy;
+
+
+        // Non-blocking output channel.
+        //
+        // Print calls (including F() strings, and ArduinoOutStream wrapped
+        // around the channel) only copy into a preallocated ring; drain()
+        // then passes on as much as the port will accept without blocking,
+        // as reported by availableForWrite(). The USB serial port has no DMA
+        // to hand the ring to, so drain() is called from the main loop
+        // instead. If the port is not keeping up (e.g. no USB host is
+        // reading) the ring fills and output is dropped according to the
+        // policy, and counted, but the caller never waits.
+        //
+        // The policy applies to each write() on its own, so a message made of
+        // several writes (e.g. through a stream) may be cut short. To send
+        // one whole or not at all, reserve() room for it first.
+        //
+        // For use from the main loop only, not from interrupt handlers.
+        class Channel : public Print {
+            Print& port;
+            uint8_t* const ring;
+            const size_t capacity;
+            size_t head;            // next byte to be written
+            size_t tail;            // next byte to be drained
+            size_t used;
+            OverflowPolicy policy;
+            uint32_t droppedBytes;
+
+            // Discard the oldest complete line(s), until at least `needed`
+            // bytes are free.
+            void dropOldest(size_t needed);
+
+        public:
+            Channel(Print& output, uint8_t* buffer, size_t size, OverflowPolicy overflowPolicy = DROP_OLDEST);
+
+            virtual size_t write(uint8_t byte);
+            virtual size_t write(const uint8_t* buffer, size_t size);
+            using Print::write;
+
+            virtual int availableForWrite();
+
+            // Make room for a message of up to `length` bytes, to be written
+            // next. Returns false, and counts the message as dropped, if it
+            // does not fit (after dropping the oldest lines, under
+            // DROP_OLDEST); the caller should then not write it.
+            bool reserve(size_t length);
+
+            // Pass buffered output on to the port, as much as it can take
+            // without blocking. Returns the number of bytes passed on.
+            size_t drain();
+
+            void setPolicy(OverflowPolicy overflowPolicy);
+
+            // Bytes currently waiting in the ring.
+            size_t getPending() const;
+
+            // Bytes discarded since startup because the ring was full.
+            uint32_t getDroppedBytes() const;
+        };
+
+
+        // The debug console, draining to the USB serial port.
+        extern Channel out;
+
+    }
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "RoboatDeclination.h"
+#include "RoboatDeclinationGrid.h"
+
+#include <math.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        using namespace Declination;
+
+        // course over ground is only meaningful underway (m/s), and lags the
+        // heading in a turn (deg/s)
+        const float BIAS_MIN_SPEED = 0.8F;
+        const float BIAS_MAX_YAW_RATE = 5.0F;
+        const float BIAS_MAX_DIFFERENCE = 45.0F;
+
+        // weight of each new sample, and what it takes to trust the result
+        const float BIAS_WEIGHT = 0.01F;
+        const uint32_t BIAS_MIN_SAMPLES = 60;
+        const float BIAS_MAX_SPREAD = 15.0F;
+
+        const float SECONDS_PER_YEAR = 31556952.0F;
+
+        const float DEG_PER_RAD = 57.2958F;
+
+        // angle in degrees, to -180..180
+        static float wrap(float degrees) {
+            while (degrees > 180) {
+                degrees -= 360;
+            }
+            while (degrees < -180) {
+                degrees += 360;
+            }
+            return degrees;
+        }
+
+        // difference between two grid values (hundredths of a degree), the
+        // short way round
+        static int32_t gridDifference(int16_t a, int16_t b) {
+            int32_t difference = int32_t(a) - b;
+            if (difference > 18000) {
+                difference -= 36000;
+            } else if (difference < -18000) {
+                difference += 36000;
+            }
+            return difference;
+        }
+
+        static float interpolate(const int16_t grid[GRID_ROWS][GRID_COLUMNS], uint8_t row, uint8_t col,
+                                 float fy, float fx) {
+            // relative to one corner, so a cell spanning +-180 degrees near
+            // the magnetic poles does not average out to nonsense
+            int16_t base = grid[row][col];
+            float east = gridDifference(grid[row][col + 1], base);
+            float north = gridDifference(grid[row + 1][col], base);
+            float northEast = gridDifference(grid[row + 1][col + 1], base);
+            float value = base + east * fx * (1 - fy) + north * (1 - fx) * fy + northEast * fx * fy;
+            return value / 100;
+        }
+
+        float getDeclination(const Position& position, float year) {
+            float y = (position.lat / float(UNITS_PER_DEGREE) + 90) / GRID_STEP;
+            float x = (position.lon / float(UNITS_PER_DEGREE) + 180) / GRID_STEP;
+            y = y < 0 ? 0 : (y > GRID_ROWS - 1.001F ? GRID_ROWS - 1.001F : y);
+            x = x < 0 ? 0 : (x > GRID_COLUMNS - 1.001F ? GRID_COLUMNS - 1.001F : x);
+            uint8_t row = uint8_t(y);
+            uint8_t col = uint8_t(x);
+            float fy = y - row;
+            float fx = x - col;
+
+            float declination = interpolate(DECLINATION, row, col, fy, fx);
+            float change = interpolate(ANNUAL_CHANGE, row, col, fy, fx);
+            return wrap(declination + change * (year - GRID_EPOCH));
+        }
+
+        float getDeclinationEpoch() {
+            return GRID_EPOCH;
+        }
+
+        bool isDeclinationCurrent(float year) {
+            return year < MODEL_VALID_UNTIL;
+        }
+
+        float toYear(uint64_t utc) {
+            return 1970 + float(utc / 1000000) / SECONDS_PER_YEAR;
+        }
+
+
+        HeadingBias::HeadingBias() {
+            reset();
+        }
+
+        void HeadingBias::reset() {
+            sinMean = 0;
+            cosMean = 0;
+            sampleCount = 0;
+            rejectCount = 0;
+        }
+
+        bool HeadingBias::addSample(float heading, float course, float speed, float yawRate) {
+            if (speed < BIAS_MIN_SPEED || fabsf(yawRate) > BIAS_MAX_YAW_RATE) {
+                return false;
+            }
+            float difference = wrap(course - heading);
+            if (fabsf(difference) > BIAS_MAX_DIFFERENCE) {
+                rejectCount++;
+                return false;
+            }
+
+            // the mean of the first samples, then an exponential average
+            sampleCount++;
+            float weight = 1.0F / sampleCount;
+            if (weight < BIAS_WEIGHT) {
+                weight = BIAS_WEIGHT;
+            }
+            sinMean += weight * (sinf(difference / DEG_PER_RAD) - sinMean);
+            cosMean += weight * (cosf(difference / DEG_PER_RAD) - cosMean);
+            return true;
+        }
+
+        float HeadingBias::getBias() const {
+            if (sampleCount == 0) {
+                return 0;
+            }
+            return atan2f(sinMean, cosMean) * DEG_PER_RAD;
+        }
+
+        float HeadingBias::getSpread() const {
+            float length = sqrtf(sinMean * sinMean + cosMean * cosMean);
+            if (sampleCount == 0 || length <= 0) {
+                return 180;
+            }
+            if (length >= 1) {
+                return 0;
+            }
+            return sqrtf(-2 * logf(length)) * DEG_PER_RAD;
+        }
+
+        bool HeadingBias::isTrusted() const {
+            return sampleCount >= BIAS_MIN_SAMPLES && getSpread() < BIAS_MAX_SPREAD;
+        }
+
+        uint32_t HeadingBias::getSampleCount() const {
+            return sampleCount;
+        }
+
+        uint32_t HeadingBias::getRejectCount() const {
+            return rejectCount;
+        }
+
+    }
+
+}
@@ -0,0 +1,85 @@
+#ifndef ROBOAT_DECLINATION_H
+#define ROBOAT_DECLINATION_H
+
+#include <stdint.h>
+#include <RoboatRoute.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        // Magnetic declination (degrees east of true north, -180 to 180) at a
+        // position in a decimal year: magnetic heading + declination = true
+        // heading.
+        //
+        // Interpolated bilinearly from a 5 degree grid of the World Magnetic
+        // Model at sea level (RoboatDeclinationGrid.h, generated by
+        // tools/wmm_grid.py), with the model's annual change applied for the
+        // year. Agrees with the model to about 0.2 degrees (95%) away from
+        // the magnetic poles, within which no grid is of much use. The grid
+        // is a constant table in flash, and a lookup is a few dozen float
+        // operations.
+        float getDeclination(const Position& position, float year);
+
+        // The grid's epoch (decimal year): a fair guess at the year until
+        // the clock has been set.
+        float getDeclinationEpoch();
+
+        // False once `year` is past the validity of the model the grid was
+        // generated from; the grid should then be regenerated from a newer
+        // one (tools/wmm_grid.py).
+        bool isDeclinationCurrent(float year);
+
+        // Decimal year of a UTC time (microseconds since 1970, as
+        // Clock::now()), to the nearest day or so.
+        float toYear(uint64_t utc);
+
+
+        // Estimates the difference between the boat's course over ground
+        // from the GPS and its true heading from the AHRS.
+        //
+        // Fed with both whenever a new GPS course arrives. Only samples taken
+        // underway and not turning are used, since the course is noise at
+        // low speeds and lags the heading in a turn; differences over 45
+        // degrees are outliers and dropped. The bias is the circular mean of
+        // the rest, weighted to the last hundred or so.
+        //
+        // What it measures is everything between heading and course: compass
+        // error left after calibration and declination, and also leeway and
+        // the set of any current. It is a correction for steering a course
+        // over ground, not a compass calibration.
+        class HeadingBias {
+            float sinMean;
+            float cosMean;
+            uint32_t sampleCount;
+            uint32_t rejectCount;
+
+        public:
+            HeadingBias();
+
+            // Forget all samples.
+            void reset();
+
+            // Add a sample: true heading and course over ground (degrees),
+            // speed over ground (m/s) and yaw rate (deg/s). Returns true if it
+            // was used.
+            bool addSample(float heading, float course, float speed, float yawRate);
+
+            // Course minus heading (degrees, -180 to 180), 0 with no samples.
+            float getBias() const;
+
+            // Circular standard deviation of the samples about the bias (degrees).
+            float getSpread() const;
+
+            // True once enough consistent samples have been seen to apply the bias.
+            bool isTrusted() const;
+
+            uint32_t getSampleCount() const;
+            uint32_t getRejectCount() const;
+        };
+
+    }
+
+}
+
+#endif
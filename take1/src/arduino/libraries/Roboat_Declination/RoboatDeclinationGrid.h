@@ -0,0 +1,563 @@
+#ifndef ROBOAT_DECLINATIONGRID_H
+#define ROBOAT_DECLINATIONGRID_H
+
+// Generated by tools/wmm_grid.py from WMM-2020 (WMM2020.COF) at epoch 2025.0; do not edit.
+// Regenerate with that script from a newer model when this one expires.
+//
+// Provisional: WMM2020.COF was transcribed rather than taken from NOAA, and
+// the model expired at the end of 2024, so the Navigator does not apply this
+// grid (Nav::isDeclinationCurrent is false). Replace it with a grid generated
+// from NOAA's WMM2025.COF (see tools/wmm/README.md).
+
+#include <stdint.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        namespace Declination {
+
+            // Grid epoch (decimal year), spacing (degrees) and size. Rows run
+            // from 90S to 90N and columns from 180W to 180E, both inclusive.
+            constexpr float GRID_EPOCH = 2025.0F;
+            constexpr float GRID_STEP = 5.0F;
+            constexpr uint8_t GRID_ROWS = 37;
+            constexpr uint8_t GRID_COLUMNS = 73;
+
+            // End of the model's validity (decimal year), after which the
+            // grid is extrapolated further than the model is meant to be.
+            constexpr float MODEL_VALID_UNTIL = 2025.0F;
+
+            // declination at the epoch, hundredths of a degree east of true north
+            constexpr int16_t DECLINATION[GRID_ROWS][GRID_COLUMNS] = {
+                {  14853,  14353,  13853,  13353,  12853,  12353,  11853,  11353,  10853,  10353,   9853,   9353,
+                    8853,   8353,   7853,   7353,   6853,   6353,   5853,   5353,   4853,   4353,   3853,   3354,
+                    2854,   2354,   1854,   1354,    854,    354,   -145,   -645,  -1145,  -1645,  -2145,  -2645,
+                   -3145,  -3644,  -4144,  -4644,  -5144,  -5644,  -6144,  -6644,  -7144,  -7644,  -8144,  -8644,
+                   -9144,  -9644, -10144, -10644, -11144, -11644, -12144, -12644, -13145, -13645, -14145, -14645,
+                  -15145, -15645, -16145, -16646, -17146, -17646,  17854,  17354,  16854,  16354,  15853,  15353,
+                   14853 },
+                {  14100,  13536,  12981,  12435,  11898,  11369,  10850,  10339,   9837,   9342,   8855,   8376,
+                    7902,   7435,   6974,   6517,   6066,   5618,   5174,   4732,   4294,   3858,   3424,   2991,
+                    2560,   2129,   1699,   1268,    837,    405,    -28,   -463,   -899,  -1338,  -1779,  -2223,
+                   -2671,  -3121,  -3575,  -4033,  -4494,  -4960,  -5430,  -5904,  -6383,  -6867,  -7356,  -7851,
+                   -8350,  -8856,  -9367,  -9885, -10409, -10939, -11477, -12021, -12573, -13131, -13696, -14267,
+                  -14845, -15428, -16015, -16607, -17201, -17796,  17608,  17013,  16421,  15832,  15248,  14670,
+                   14100 },
+                {  12883,  12261,  11667,  11100,  10559,  10041,   9545,   9068,   8607,   8161,   7727,   7303,
+                    6889,   6482,   6081,   5686,   5294,   4906,   4521,   4139,   3759,   3380,   3004,   2628,
+                    2254,   1880,   1506,   1132,    757,    379,      0,   -383,   -770,  -1162,  -1558,  -1961,
+                   -2369,  -2783,  -3203,  -3630,  -4062,  -4501,  -4945,  -5396,  -5852,  -6314,  -6782,  -7256,
+                   -7738,  -8227,  -8724,  -9232,  -9750, -10280, -10825, -11385, -11963, -12561, -13179, -13820,
+                  -14484, -15171, -15880, -16608, -17351,  17896,  17139,  16386,  15644,  14918,  14213,  13534,
+                   12883 },
+                {  10999,  10394,   9845,   9344,   8881,   8451,   8048,   7665,   7300,   6947,   6604,   6267,
+                    5935,   5604,   5275,   4944,   4613,   4280,   3946,   3611,   3275,   2939,   2604,   2270,
+                    1937,   1607,   1277,    949,    620,    290,    -43,   -380,   -724,  -1075,  -1434,  -1803,
+                   -2181,  -2569,  -2967,  -3373,  -3787,  -4207,  -4634,  -5066,  -5501,  -5941,  -6384,  -6830,
+                   -7280,  -7736,  -8198,  -8668,  -9149,  -9644, -10157, -10692, -11256, -11854, -12496, -13189,
+                  -13944, -14768, -15667, -16639, -17672,  17258,  16182,  15136,  14150,  13240,  12414,  11669,
+                   10999 },
+                {   8591,   8165,   7788,   7449,   7139,   6853,   6584,   6329,   6082,   5842,   5603,   5362,
+                    5118,   4867,   4607,   4338,   4060,   3772,   3475,   3171,   2862,   2550,   2237,   1925,
+                    1617,   1313,   1015,    721,    431,    142,   -147,   -441,   -743,  -1056,  -1381,  -1720,
+                   -2075,  -2444,  -2826,  -3220,  -3623,  -4033,  -4447,  -4864,  -5281,  -5696,  -6110,  -6520,
+                   -6929,  -7336,  -7742,  -8150,  -8563,  -8984,  -9419,  -9873, -10356, -10880, -11465, -12135,
+                  -12929, -13905, -15135, -16683,  17475,  15536,  13781,  12353,  11238,  10364,   9662,   9083,
+                    8591 },
+                {   6399,   6196,   6006,   5826,   5657,   5497,   5345,   5198,   5055,   4912,   4766,   4613,
+                    4449,   4271,   4076,   3862,   3629,   3377,   3106,   2820,   2522,   2216,   1906,   1597,
+                    1294,   1000,    718,    447,    188,    -64,   -312,   -563,   -821,  -1094,  -1384,  -1694,
+                   -2027,  -2380,  -2752,  -3139,  -3536,  -3939,  -4344,  -4746,  -5143,  -5532,  -5910,  -6278,
+                   -6633,  -6977,  -7311,  -7634,  -7948,  -8256,  -8559,  -8861,  -9166,  -9479,  -9810, -10179,
+                  -10624, -11251, -12443, -16606,  11319,   9124,   8286,   7787,   7419,   7118,   6855,   6618,
+                    6399 },
+                {   4863,   4794,   4715,   4631,   4546,   4463,   4382,   4305,   4230,   4156,   4079,   3995,
+                    3898,   3783,   3645,   3481,   3289,   3067,   2816,   2539,   2240,   1926,   1603,   1280,
+                     965,    664,    382,    123,   -115,   -334,   -542,   -747,   -959,  -1186,  -1436,  -1714,
+                   -2022,  -2359,  -2721,  -3102,  -3494,  -3892,  -4287,  -4674,  -5048,  -5405,  -5742,  -6058,
+                   -6351,  -6619,  -6863,  -7081,  -7271,  -7430,  -7553,  -7632,  -7651,  -7588,  -7395,  -6986,
+                   -6178,  -4602,  -1892,   1061,   2953,   3950,   4474,   4752,   4891,   4947,   4950,   4918,
+                    4863 },
+                {   3858,   3849,   3824,   3787,   3743,   3698,   3653,   3612,   3574,   3541,   3508,   3471,
+                    3424,   3360,   3272,   3153,   2997,   2803,   2569,   2296,   1991,   1659,   1312,    961,
+                     619,    296,      3,   -256,   -480,   -673,   -842,  -1000,  -1159,  -1333,  -1534,  -1770,
+                   -2046,  -2361,  -2709,  -3082,  -3468,  -3858,  -4241,  -4608,  -4955,  -5275,  -5564,  -5821,
+                   -6042,  -6225,  -6367,  -6465,  -6513,  -6501,  -6418,  -6244,  -5952,  -5503,  -4849,  -3945,
+                   -2784,  -1453,   -135,   1001,   1888,   2542,   3010,   3337,   3561,   3708,   3797,   3844,
+                    3858 },
+                {   3173,   3191,   3190,   3176,   3153,   3125,   3096,   3069,   3048,   3033,   3022,   3013,
+                    2998,   2970,   2921,   2840,   2719,   2551,   2333,   2064,   1748,   1395,   1016,    629,
+                     251,   -101,   -414,   -680,   -896,  -1068,  -1204,  -1317,  -1422,  -1537,  -1678,  -1859,
+                   -2089,  -2369,  -2694,  -3051,  -3426,  -3804,  -4169,  -4512,  -4825,  -5102,  -5337,  -5528,
+                   -5671,  -5762,  -5796,  -5769,  -5672,  -5495,  -5225,  -4848,  -4350,  -3726,  -2988,  -2168,
+                   -1318,   -494,    259,    915,   1469,   1923,   2286,   2571,   2787,   2947,   3058,   3131,
+                    3173 },
+                {   2673,   2703,   2715,   2713,   2701,   2682,   2660,   2638,   2620,   2609,   2604,   2604,
+                    2605,   2598,   2575,   2523,   2431,   2288,   2085,   1819,   1494,   1118,    707,    283,
+                    -130,   -511,   -843,  -1115,  -1326,  -1482,  -1593,  -1671,  -1731,  -1790,  -1865,  -1976,
+                   -2140,  -2366,  -2650,  -2979,  -3333,  -3689,  -4030,  -4342,  -4615,  -4842,  -5019,  -5140,
+                   -5202,  -5201,  -5131,  -4989,  -4768,  -4464,  -4072,  -3596,  -3047,  -2447,  -1827,  -1216,
+                    -636,   -100,    387,    825,   1212,   1550,   1839,   2081,   2276,   2428,   2541,   2621,
+                    2673 },
+                {   2288,   2322,   2340,   2345,   2340,   2327,   2308,   2288,   2269,   2254,   2245,   2243,
+                    2245,   2245,   2235,   2202,   2131,   2007,   1817,   1555,   1221,    825,    388,    -66,
+                    -506,   -905,  -1244,  -1515,  -1718,  -1861,  -1955,  -2013,  -2044,  -2058,  -2070,  -2103,
+                   -2181,  -2326,  -2544,  -2823,  -3138,  -3462,  -3769,  -4043,  -4273,  -4450,  -4569,  -4624,
+                   -4612,  -4530,  -4376,  -4148,  -3848,  -3479,  -3047,  -2571,  -2071,  -1576,  -1105,   -671,
+                    -275,     88,    423,    734,   1023,   1288,   1525,   1731,   1905,   2046,   2154,   2234,
+                    2288 },
+                {   1979,   2013,   2032,   2041,   2041,   2033,   2019,   1999,   1978,   1958,   1941,   1930,
+                    1924,   1921,   1914,   1890,   1832,   1720,   1539,   1279,    938,    528,     72,   -398,
+                    -849,  -1250,  -1583,  -1841,  -2028,  -2157,  -2241,  -2287,  -2301,  -2284,  -2242,  -2194,
+                   -2171,  -2208,  -2327,  -2525,  -2778,  -3055,  -3324,  -3562,  -3755,  -3893,  -3967,  -3974,
+                   -3909,  -3775,  -3572,  -3306,  -2981,  -2608,  -2201,  -1779,  -1366,   -982,   -641,   -340,
+                     -71,    178,    416,    647,    873,   1087,   1287,   1466,   1622,   1751,   1852,   1927,
+                    1979 },
+                {   1728,   1758,   1776,   1786,   1789,   1785,   1774,   1757,   1735,   1710,   1686,   1664,
+                    1648,   1637,   1626,   1604,   1551,   1446,   1269,   1007,    661,    243,   -221,   -694,
+                   -1140,  -1528,  -1841,  -2077,  -2243,  -2353,  -2421,  -2453,  -2447,  -2398,  -2305,  -2179,
+                   -2052,  -1967,  -1962,  -2051,  -2219,  -2437,  -2668,  -2883,  -3060,  -3183,  -3242,  -3231,
+                   -3149,  -3001,  -2793,  -2534,  -2232,  -1897,  -1544,  -1192,   -865,   -578,   -337,   -134,
+                      44,    214,    386,    565,    748,    928,   1100,   1259,   1399,   1517,   1611,   1681,
+                    1728 },
+                {   1524,   1548,   1562,   1570,   1573,   1571,   1564,   1550,   1529,   1502,   1472,   1442,
+                    1416,   1397,   1381,   1356,   1303,   1199,   1020,    756,    405,    -15,   -476,   -939,
+                   -1366,  -1730,  -2016,  -2224,  -2362,  -2445,  -2486,  -2488,  -2447,  -2355,  -2207,  -2012,
+                   -1799,  -1611,  -1491,  -1467,  -1540,  -1689,  -1883,  -2087,  -2268,  -2403,  -2476,  -2479,
+                   -2413,  -2287,  -2108,  -1888,  -1633,  -1352,  -1060,   -775,   -518,   -306,   -140,    -10,
+                     103,    216,    343,    487,    642,    799,    952,   1095,   1223,   1332,   1419,   1482,
+                    1524 },
+                {   1360,   1377,   1385,   1388,   1389,   1388,   1382,   1371,   1352,   1325,   1293,   1258,
+                    1226,   1201,   1180,   1152,   1096,    987,    804,    535,    182,   -234,   -683,  -1125,
+                   -1526,  -1860,  -2114,  -2290,  -2394,  -2440,  -2439,  -2394,  -2302,  -2158,  -1960,  -1719,
+                   -1459,  -1215,  -1026,   -920,   -909,   -990,  -1141,  -1328,  -1516,  -1670,  -1770,  -1804,
+                   -1773,  -1685,  -1553,  -1383,  -1182,   -956,   -719,   -489,   -288,   -131,    -20,     57,
+                     122,    196,    292,    413,    550,    693,    834,    965,   1084,   1187,   1268,   1325,
+                    1360 },
+                {   1231,   1241,   1241,   1238,   1235,   1232,   1228,   1218,   1202,   1176,   1144,   1108,
+                    1074,   1046,   1021,    989,    927,    811,    621,    348,     -3,   -410,   -839,  -1255,
+                   -1624,  -1925,  -2146,  -2286,  -2351,  -2351,  -2297,  -2196,  -2049,  -1860,  -1631,  -1376,
+                   -1112,   -863,   -654,   -508,   -443,   -466,   -569,   -728,   -907,  -1071,  -1191,  -1254,
+                   -1258,  -1211,  -1124,  -1004,   -854,   -678,   -488,   -302,   -143,    -27,     43,     82,
+                     113,    159,    234,    340,    467,    603,    736,    861,    975,   1073,   1150,   1203,
+                    1231 },
+                {   1134,   1138,   1130,   1119,   1111,   1105,   1101,   1093,   1079,   1055,   1024,    989,
+                     954,    925,    898,    861,    791,    667,    469,    193,   -153,   -545,   -950,  -1335,
+                   -1671,  -1938,  -2124,  -2226,  -2249,  -2201,  -2094,  -1940,  -1749,  -1530,  -1293,  -1049,
+                    -810,   -586,   -390,   -237,   -144,   -126,   -187,   -311,   -469,   -627,   -754,   -834,
+                    -864,   -851,   -803,   -725,   -619,   -487,   -337,   -188,    -63,     23,     64,     76,
+                      82,    109,    170,    267,    389,    521,    651,    775,    888,    985,   1061,   1111,
+                    1134 },
+                {   1063,   1062,   1047,   1030,   1017,   1009,   1004,    998,    986,    965,    936,    901,
+                     867,    837,    806,    761,    682,    547,    342,     65,   -273,   -646,  -1024,  -1378,
+                   -1681,  -1914,  -2064,  -2128,  -2109,  -2017,  -1866,  -1673,  -1454,  -1224,   -995,   -775,
+                    -570,   -380,   -209,    -65,     36,     78,     51,    -41,   -174,   -316,   -440,   -526,
+                    -572,   -582,   -564,   -521,   -452,   -356,   -242,   -125,    -28,     33,     53,     45,
+                      34,     47,     99,    189,    308,    440,    571,    697,    812,    912,    991,   1042,
+                    1063 },
+                {   1011,   1009,    991,    969,    952,    943,    940,    936,    927,    909,    881,    847,
+                     813,    779,    741,    686,    594,    447,    234,    -43,   -370,   -723,  -1074,  -1397,
+                   -1667,  -1865,  -1980,  -2007,  -1952,  -1825,  -1645,  -1429,  -1198,   -968,   -752,   -558,
+                    -385,   -228,    -84,     44,    145,    199,    193,    128,     20,   -105,   -219,   -305,
+                    -358,   -383,   -386,   -369,   -329,   -266,   -183,    -96,    -24,     15,     17,     -5,
+                     -28,    -26,     18,    104,    220,    352,    487,    617,    739,    847,    932,    987,
+                    1011 },
+                {    970,    972,    955,    933,    916,    908,    908,    909,    904,    889,    863,    829,
+                     791,    751,    702,    632,    524,    362,    140,   -137,   -453,   -786,  -1111,  -1402,
+                   -1637,  -1800,  -1880,  -1875,  -1790,  -1641,  -1445,  -1221,   -989,   -766,   -565,   -392,
+                    -245,   -114,      6,    119,    213,    271,    280,    235,    146,     38,    -65,   -146,
+                    -201,   -234,   -251,   -253,   -237,   -200,   -146,    -87,    -41,    -22,    -36,    -70,
+                    -103,   -109,    -73,      6,    120,    252,    390,    528,    659,    777,    873,    939,
+                     970 },
+                {    930,    942,    933,    916,    903,    901,    906,    914,    916,    905,    881,    845,
+                     802,    752,    688,    599,    471,    292,     59,   -220,   -528,   -843,  -1141,  -1400,
+                   -1601,  -1728,  -1774,  -1740,  -1635,  -1474,  -1274,  -1052,   -827,   -613,   -424,   -267,
+                    -137,    -26,     77,    174,    260,    319,    336,    305,    233,    139,     47,    -29,
+                     -83,   -119,   -144,   -159,   -162,   -149,   -121,    -89,    -68,    -70,    -99,   -146,
+                    -188,   -203,   -176,   -105,      3,    134,    276,    420,    562,    693,    804,    885,
+                     930 },
+                {    881,    911,    917,    913,    911,    917,    932,    949,    958,    953,    931,    894,
+                     844,    781,    699,    588,    436,    236,    -12,   -296,   -599,   -898,  -1171,  -1398,
+                   -1563,  -1654,  -1668,  -1611,  -1493,  -1328,  -1132,   -918,   -702,   -499,   -319,   -171,
+                     -53,     46,    135,    220,    298,    354,    376,    355,    297,    216,    134,     64,
+                      13,    -25,    -54,    -79,    -95,   -102,    -99,    -94,    -98,   -122,   -169,   -229,
+                    -282,   -308,   -292,   -231,   -131,     -3,    141,    292,    444,    590,    717,    817,
+                     881 },
+                {    816,    871,    900,    916,    931,    953,    980,   1007,   1025,   1027,   1008,    969,
+                     911,    834,    732,    597,    419,    195,    -71,   -364,   -665,   -952,  -1202,  -1398,
+                   -1528,  -1586,  -1573,  -1497,  -1370,  -1207,  -1018,   -815,   -610,   -415,   -242,    -99,
+                      14,    106,    187,    263,    333,    386,    411,    398,    351,    283,    210,    148,
+                      99,     62,     30,     -1,    -30,    -54,    -75,    -96,   -127,   -176,   -242,   -318,
+                    -384,   -423,   -419,   -370,   -279,   -157,    -13,    144,    305,    464,    608,    728,
+                     816 },
+                {    732,    816,    876,    920,    959,   1001,   1043,   1083,   1110,   1118,   1103,   1063,
+                     998,    906,    784,    623,    418,    168,   -118,   -424,   -728,  -1005,  -1236,  -1405,
+                   -1505,  -1533,  -1497,  -1407,  -1275,  -1114,   -933,   -739,   -543,   -356,   -187,    -46,
+                      67,    158,    235,    305,    369,    419,    446,    441,    405,    350,    289,    235,
+                     190,    154,    120,     83,     42,      0,    -45,    -94,   -154,   -229,   -318,   -412,
+                    -493,   -546,   -556,   -519,   -438,   -322,   -180,    -20,    149,    318,    478,    619,
+                     732 },
+                {    631,    747,    841,    919,    988,   1054,   1115,   1168,   1205,   1219,   1207,   1166,
+                    1095,    990,    848,    663,    430,    154,   -156,   -478,   -788,  -1061,  -1277,  -1424,
+                   -1499,  -1504,  -1450,  -1349,  -1214,  -1054,   -878,   -692,   -502,   -319,   -151,     -8,
+                     108,    201,    278,    347,    408,    457,    487,    491,    469,    429,    382,    337,
+                     298,    263,    225,    180,    126,     64,     -6,    -86,   -177,   -282,   -396,   -511,
+                    -610,   -677,   -700,   -675,   -603,   -493,   -352,   -191,    -18,    160,    333,    492,
+                     631 },
+                {    522,    667,    796,    910,   1013,   1106,   1188,   1256,   1303,   1324,   1315,   1273,
+                    1196,   1080,    919,    710,    450,    146,   -188,   -529,   -849,  -1122,  -1329,  -1461,
+                   -1518,  -1508,  -1441,  -1332,  -1192,  -1032,   -857,   -673,   -486,   -304,   -135,     12,
+                     135,    235,    317,    389,    451,    503,    539,    555,    550,    528,    498,    466,
+                     433,    398,    354,    298,    228,    142,     42,    -71,   -197,   -336,   -479,   -617,
+                    -734,   -815,   -849,   -833,   -768,   -662,   -523,   -362,   -185,     -1,    183,    359,
+                     522 },
+                {    413,    586,    747,    896,   1031,   1152,   1257,   1341,   1400,   1429,   1425,   1382,
+                    1300,   1171,    993,    760,    472,    138,   -224,   -586,   -919,  -1196,  -1399,  -1523,
+                   -1570,  -1549,  -1475,  -1359,  -1215,  -1052,   -874,   -688,   -500,   -315,   -141,     14,
+                     146,    257,    351,    431,    502,    562,    610,    642,    658,    659,    649,    631,
+                     605,    569,    517,    446,    353,    238,    103,    -49,   -217,   -392,   -568,   -731,
+                    -865,   -958,  -1000,   -989,   -928,   -824,   -686,   -523,   -343,   -154,     39,    229,
+                     413 },
+                {    314,    510,    699,    877,   1042,   1190,   1318,   1421,   1495,   1534,   1535,   1494,
+                    1406,   1266,   1069,    810,    491,    123,   -270,   -659,  -1009,  -1295,  -1500,  -1620,
+                   -1662,  -1636,  -1556,  -1436,  -1286,  -1116,   -933,   -741,   -546,   -355,   -173,     -7,
+                     140,    268,    378,    476,    562,    640,    706,    761,    802,    828,    841,    839,
+                     821,    783,    721,    630,    509,    358,    180,    -19,   -233,   -452,   -663,   -852,
+                   -1003,  -1104,  -1151,  -1141,  -1079,   -974,   -835,   -669,   -486,   -291,    -90,    113,
+                     314 },
+                {    230,    445,    655,    857,   1047,   1220,   1370,   1494,   1584,   1638,   1649,   1611,
+                    1520,   1368,   1149,    859,    503,     94,   -340,   -761,  -1135,  -1433,  -1643,  -1763,
+                   -1802,  -1773,  -1689,  -1563,  -1407,  -1229,  -1037,   -835,   -630,   -428,   -233,    -51,
+                     116,    267,    402,    525,    637,    741,    835,    919,    990,   1045,   1083,   1099,
+                    1089,   1050,    975,    861,    706,    511,    282,     27,   -243,   -511,   -762,   -977,
+                   -1143,  -1251,  -1298,  -1286,  -1221,  -1112,   -969,   -799,   -611,   -410,   -200,     14,
+                     230 },
+                {    159,    389,    616,    837,   1047,   1241,   1413,   1558,   1668,   1739,   1763,   1733,
+                    1641,   1476,   1233,    906,    501,     38,   -448,   -912,  -1315,  -1630,  -1846,  -1967,
+                   -2003,  -1968,  -1878,  -1745,  -1580,  -1391,  -1187,   -972,   -753,   -535,   -321,   -117,
+                      76,    257,    425,    583,    731,    871,   1001,   1121,   1226,   1313,   1378,   1415,
+                    1417,   1378,   1292,   1154,    961,    716,    425,    102,   -234,   -562,   -857,  -1102,
+                   -1284,  -1398,  -1443,  -1426,  -1356,  -1241,  -1092,   -916,   -722,   -513,   -294,    -69,
+                     159 },
+                {     94,    336,    577,    814,   1040,   1252,   1444,   1609,   1741,   1832,   1872,   1852,
+                    1760,   1583,   1310,    936,    467,    -67,   -622,  -1142,  -1580,  -1911,  -2131,  -2247,
+                   -2274,  -2230,  -2128,  -1982,  -1803,  -1600,  -1379,  -1147,   -909,   -669,   -430,   -197,
+                      29,    246,    455,    656,    848,   1032,   1205,   1366,   1510,   1634,   1730,   1792,
+                    1812,   1781,   1691,   1533,   1304,   1003,    640,    234,   -185,   -585,   -937,  -1220,
+                   -1421,  -1542,  -1587,  -1566,  -1490,  -1369,  -1213,  -1030,   -827,   -610,   -382,   -146,
+                      94 },
+                {     20,    274,    527,    776,   1017,   1245,   1454,   1638,   1789,   1898,   1954,   1944,
+                    1851,   1657,   1346,    909,    355,   -275,   -916,  -1498,  -1968,  -2306,  -2517,  -2616,
+                   -2623,  -2557,  -2434,  -2267,  -2067,  -1843,  -1600,  -1345,  -1081,   -813,   -544,   -277,
+                     -12,    248,    502,    750,    990,   1222,   1443,   1649,   1838,   2003,   2139,   2236,
+                    2286,   2278,   2199,   2037,   1781,   1429,    987,    482,    -46,   -546,   -977,  -1313,
+                   -1548,  -1684,  -1735,  -1713,  -1633,  -1506,  -1344,  -1154,   -943,   -716,   -478,   -232,
+                      20 },
+                {    -85,    180,    444,    704,    957,   1196,   1418,   1615,   1778,   1898,   1960,   1949,
+                    1841,   1613,   1242,    714,     47,   -698,  -1426,  -2051,  -2523,  -2837,  -3010,  -3068,
+                   -3035,  -2932,  -2775,  -2576,  -2347,  -2093,  -1821,  -1536,  -1242,   -941,   -637,   -332,
+                     -26,    277,    577,    872,   1160,   1440,   1710,   1965,   2202,   2417,   2601,   2748,
+                    2847,   2886,   2848,   2716,   2470,   2094,   1585,    967,    295,   -355,   -915,  -1347,
+                   -1644,  -1818,  -1889,  -1876,  -1799,  -1670,  -1503,  -1307,  -1088,   -852,   -604,   -347,
+                     -85 },
+                {   -260,     12,    282,    548,    804,   1046,   1268,   1462,   1619,   1725,   1765,   1715,
+                    1549,   1235,    745,     76,   -725,  -1555,  -2296,  -2871,  -3261,  -3484,  -3573,  -3557,
+                   -3460,  -3303,  -3099,  -2858,  -2590,  -2301,  -1996,  -1677,  -1349,  -1015,   -675,   -333,
+                      10,    354,    695,   1033,   1366,   1692,   2009,   2314,   2604,   2875,   3120,   3334,
+                    3506,   3626,   3677,   3637,   3478,   3167,   2672,   1982,   1139,    249,   -560,  -1197,
+                   -1640,  -1909,  -2038,  -2059,  -2000,  -1880,  -1715,  -1517,  -1293,  -1051,   -795,   -530,
+                    -260 },
+                {   -632,   -367,   -107,    143,    378,    591,    774,    917,   1005,   1021,    942,    738,
+                     380,   -154,   -854,  -1656,  -2449,  -3126,  -3631,  -3958,  -4130,  -4176,  -4126,  -4002,
+                   -3820,  -3593,  -3333,  -3044,  -2735,  -2408,  -2068,  -1717,  -1357,   -991,   -620,   -246,
+                     131,    509,    886,   1262,   1635,   2004,   2368,   2724,   3070,   3404,   3723,   4022,
+                    4296,   4536,   4733,   4871,   4927,   4869,   4648,   4196,   3436,   2343,   1043,   -187,
+                   -1126,  -1736,  -2080,  -2232,  -2251,  -2179,  -2042,  -1860,  -1646,  -1410,  -1158,   -897,
+                    -632 },
+                {  -2461,  -2293,  -2153,  -2053,  -2004,  -2019,  -2110,  -2290,  -2566,  -2935,  -3377,  -3855,
+                   -4321,  -4728,  -5048,  -5268,  -5389,  -5421,  -5376,  -5268,  -5106,  -4900,  -4658,  -4386,
+                   -4090,  -3773,  -3439,  -3091,  -2730,  -2359,  -1979,  -1593,  -1199,   -801,   -398,      8,
+                     418,    830,   1243,   1658,   2073,   2489,   2904,   3319,   3732,   4143,   4552,   4957,
+                    5358,   5755,   6144,   6526,   6896,   7253,   7592,   7905,   8182,   8401,   8525,   8472,
+                    8033,   6569,   2639,  -1334,  -2842,  -3321,  -3424,  -3363,  -3222,  -3043,  -2847,  -2649,
+                   -2461 },
+                { -16548, -16048, -15547, -15047, -14547, -14046, -13546, -13046, -12546, -12046, -11546, -11046,
+                  -10546, -10046,  -9547,  -9047,  -8547,  -8048,  -7548,  -7048,  -6549,  -6049,  -5550,  -5051,
+                   -4551,  -4052,  -3552,  -3053,  -2554,  -2054,  -1555,  -1055,   -556,    -56,    443,    943,
+                    1442,   1942,   2441,   2941,   3441,   3940,   4440,   4940,   5440,   5940,   6440,   6940,
+                    7440,   7940,   8441,   8941,   9441,   9942,  10442,  10942,  11443,  11943,  12444,  12945,
+                   13445,  13946,  14446,  14947,  15448,  15948,  16449,  16949,  17450,  17950, -17549, -17049,
+                  -16548 },
+            };
+
+            // annual change in declination, hundredths of a degree per year
+            constexpr int16_t ANNUAL_CHANGE[GRID_ROWS][GRID_COLUMNS] = {
+                {    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,    -14,
+                     -14 },
+                {    -16,    -15,    -15,    -15,    -14,    -14,    -14,    -13,    -13,    -13,    -12,    -12,
+                     -12,    -12,    -12,    -11,    -11,    -11,    -11,    -11,    -11,    -11,    -11,    -11,
+                     -11,    -11,    -11,    -11,    -11,    -11,    -11,    -11,    -12,    -12,    -12,    -12,
+                     -13,    -13,    -13,    -13,    -14,    -14,    -14,    -15,    -15,    -15,    -16,    -16,
+                     -16,    -16,    -17,    -17,    -17,    -17,    -18,    -18,    -18,    -18,    -18,    -18,
+                     -18,    -18,    -18,    -18,    -18,    -18,    -18,    -18,    -17,    -17,    -17,    -16,
+                     -16 },
+                {    -16,    -15,    -14,    -13,    -12,    -12,    -11,    -11,    -10,    -10,    -10,    -10,
+                      -9,     -9,     -9,     -9,     -9,     -9,     -8,     -8,     -8,     -8,     -8,     -8,
+                      -8,     -8,     -8,     -8,     -8,     -8,     -8,     -9,     -9,    -10,    -10,    -11,
+                     -11,    -12,    -12,    -13,    -13,    -14,    -15,    -15,    -16,    -16,    -17,    -17,
+                     -18,    -18,    -19,    -19,    -19,    -20,    -20,    -21,    -22,    -22,    -23,    -23,
+                     -23,    -24,    -24,    -24,    -23,    -23,    -22,    -21,    -20,    -19,    -18,    -17,
+                     -16 },
+                {     -9,     -8,     -7,     -7,     -6,     -6,     -6,     -6,     -6,     -6,     -6,     -7,
+                      -7,     -7,     -7,     -7,     -7,     -7,     -7,     -7,     -7,     -6,     -6,     -6,
+                      -6,     -6,     -6,     -5,     -5,     -6,     -6,     -6,     -7,     -7,     -8,     -9,
+                     -10,    -10,    -11,    -12,    -13,    -14,    -15,    -16,    -16,    -17,    -17,    -18,
+                     -18,    -19,    -20,    -20,    -21,    -21,    -22,    -23,    -24,    -26,    -27,    -28,
+                     -30,    -31,    -32,    -33,    -32,    -30,    -27,    -24,    -20,    -17,    -14,    -11,
+                      -9 },
+                {      4,      4,      3,      3,      2,      1,      0,     -1,     -2,     -2,     -3,     -4,
+                      -4,     -5,     -5,     -5,     -6,     -6,     -6,     -6,     -6,     -6,     -6,     -5,
+                      -5,     -4,     -4,     -3,     -3,     -3,     -3,     -3,     -4,     -4,     -5,     -7,
+                      -8,     -9,    -11,    -12,    -13,    -14,    -15,    -16,    -17,    -17,    -18,    -18,
+                     -19,    -19,    -20,    -20,    -21,    -22,    -23,    -24,    -25,    -28,    -31,    -34,
+                     -39,    -45,    -51,    -55,    -50,    -37,    -22,    -10,     -2,      2,      4,      4,
+                       4 },
+                {     15,     13,     11,      9,      8,      6,      5,      3,      2,      1,      0,     -1,
+                      -2,     -3,     -4,     -4,     -5,     -5,     -6,     -6,     -6,     -6,     -6,     -5,
+                      -5,     -4,     -3,     -2,     -1,      0,      0,      0,      0,     -1,     -2,     -4,
+                      -6,     -8,    -10,    -11,    -13,    -14,    -16,    -17,    -17,    -18,    -18,    -18,
+                     -19,    -19,    -19,    -19,    -19,    -20,    -20,    -21,    -23,    -26,    -29,    -36,
+                     -46,    -67,   -120,   -262,     33,     50,     39,     31,     26,     22,     19,     17,
+                      15 },
+                {     17,     15,     14,     12,     10,      9,      7,      6,      4,      3,      2,      1,
+                       0,     -1,     -2,     -3,     -4,     -5,     -6,     -6,     -7,     -7,     -7,     -6,
+                      -5,     -4,     -3,     -1,      1,      2,      3,      4,      4,      3,      1,     -1,
+                      -3,     -6,     -9,    -11,    -13,    -15,    -16,    -17,    -18,    -18,    -18,    -18,
+                     -18,    -17,    -17,    -16,    -16,    -15,    -15,    -15,    -15,    -15,    -16,    -15,
+                     -10,      9,     49,     71,     60,     47,     37,     31,     27,     24,     21,     19,
+                      17 },
+                {     16,     14,     13,     12,     10,      9,      7,      6,      5,      4,      2,      1,
+                       0,     -1,     -2,     -3,     -4,     -5,     -6,     -7,     -8,     -8,     -8,     -8,
+                      -7,     -5,     -3,     -1,      2,      5,      7,      8,      9,      8,      6,      3,
+                       0,     -4,     -7,    -11,    -14,    -16,    -17,    -18,    -19,    -19,    -18,    -17,
+                     -16,    -15,    -13,    -12,    -10,     -9,     -7,     -5,     -3,     -1,      3,      8,
+                      15,     21,     25,     27,     26,     24,     23,     21,     20,     19,     18,     17,
+                      16 },
+                {     13,     13,     12,     11,      9,      8,      7,      6,      4,      3,      2,      1,
+                       0,     -1,     -2,     -3,     -4,     -5,     -7,     -8,     -9,    -10,    -10,    -10,
+                      -9,     -7,     -4,     -1,      3,      6,      9,     12,     13,     13,     11,      8,
+                       4,     -1,     -6,    -11,    -14,    -17,    -19,    -20,    -20,    -19,    -18,    -16,
+                     -14,    -12,     -9,     -6,     -3,     -1,      2,      4,      6,      8,     10,     12,
+                      13,     13,     14,     14,     14,     14,     15,     15,     15,     15,     14,     14,
+                      13 },
+                {     11,     11,     10,      9,      8,      7,      6,      5,      3,      2,      2,      1,
+                       0,     -1,     -2,     -3,     -4,     -6,     -7,     -9,    -11,    -12,    -13,    -13,
+                     -12,     -9,     -6,     -2,      2,      6,     10,     14,     16,     17,     16,     13,
+                       8,      2,     -4,    -11,    -15,    -19,    -20,    -21,    -20,    -19,    -16,    -14,
+                     -11,     -7,     -4,      0,      3,      6,      9,     10,     10,     10,      9,      9,
+                       8,      7,      7,      8,      8,      9,     10,     10,     11,     11,     11,     11,
+                      11 },
+                {     10,     10,      9,      8,      7,      6,      5,      3,      2,      1,      1,      0,
+                      -1,     -2,     -2,     -3,     -4,     -6,     -8,    -10,    -12,    -14,    -15,    -16,
+                     -14,    -12,     -8,     -4,      1,      5,      9,     13,     16,     19,     19,     18,
+                      13,      7,     -2,     -9,    -16,    -19,    -21,    -21,    -19,    -17,    -14,    -11,
+                      -7,     -3,      2,      6,      9,     11,     12,     12,     10,      8,      7,      5,
+                       4,      3,      3,      4,      4,      5,      7,      8,      8,      9,      9,     10,
+                      10 },
+                {      9,      9,      8,      7,      6,      5,      4,      2,      1,      0,     -1,     -1,
+                      -2,     -3,     -3,     -4,     -5,     -6,     -9,    -11,    -14,    -17,    -18,    -18,
+                     -17,    -14,    -10,     -6,     -1,      3,      7,     11,     15,     19,     21,     22,
+                      19,     12,      3,     -7,    -14,    -19,    -21,    -20,    -18,    -15,    -11,     -7,
+                      -3,      2,      6,     10,     12,     13,     13,     11,      9,      6,      4,      2,
+                       1,      0,      0,      1,      2,      3,      4,      5,      7,      7,      8,      9,
+                       9 },
+                {      8,      8,      8,      7,      6,      4,      3,      1,      0,     -1,     -2,     -2,
+                      -3,     -4,     -4,     -5,     -5,     -7,     -9,    -12,    -15,    -18,    -20,    -21,
+                     -19,    -16,    -12,     -8,     -3,      1,      5,      9,     13,     18,     23,     25,
+                      24,     18,      9,     -2,    -11,    -17,    -19,    -18,    -16,    -12,     -8,     -4,
+                       1,      5,      9,     12,     13,     13,     12,     10,      7,      4,      2,      0,
+                      -1,     -2,     -2,     -1,      0,      1,      3,      4,      5,      6,      7,      8,
+                       8 },
+                {      8,      8,      8,      7,      5,      4,      2,      1,     -1,     -2,     -3,     -4,
+                      -4,     -5,     -5,     -6,     -6,     -8,    -10,    -13,    -17,    -20,    -22,    -22,
+                     -21,    -18,    -13,     -8,     -3,      1,      5,      9,     14,     19,     24,     27,
+                      28,     23,     15,      4,     -5,    -12,    -15,    -16,    -14,    -10,     -6,     -2,
+                       2,      6,      9,     11,     12,     12,     11,      8,      5,      2,      0,     -2,
+                      -3,     -4,     -4,     -3,     -2,     -1,      1,      3,      4,      6,      7,      8,
+                       8 },
+                {      8,      8,      8,      6,      5,      3,      2,      0,     -1,     -2,     -3,     -4,
+                      -5,     -6,     -6,     -7,     -7,     -8,    -11,    -14,    -18,    -21,    -23,    -23,
+                     -21,    -17,    -13,     -8,     -2,      3,      7,     11,     16,     20,     25,     28,
+                      28,     25,     18,     10,      1,     -6,    -10,    -12,    -11,     -9,     -5,     -2,
+                       2,      5,      8,     10,     11,     10,      9,      6,      3,      1,     -1,     -3,
+                      -5,     -6,     -6,     -5,     -4,     -2,      0,      2,      4,      5,      6,      8,
+                       8 },
+                {      8,      8,      8,      6,      5,      3,      1,      0,     -1,     -3,     -4,     -5,
+                      -6,     -7,     -8,     -8,     -8,     -9,    -12,    -15,    -18,    -21,    -23,    -22,
+                     -20,    -16,    -11,     -6,      0,      6,     10,     14,     18,     22,     25,     26,
+                      26,     23,     19,     13,      6,      0,     -5,     -8,     -9,     -7,     -5,     -2,
+                       1,      4,      6,      8,      9,      8,      7,      5,      2,      0,     -3,     -4,
+                      -6,     -7,     -7,     -7,     -5,     -3,     -1,      1,      3,      5,      6,      8,
+                       8 },
+                {      8,      8,      8,      6,      5,      3,      1,      0,     -2,     -3,     -4,     -6,
+                      -7,     -8,     -9,     -9,     -9,    -10,    -12,    -15,    -18,    -21,    -22,    -21,
+                     -18,    -14,     -9,     -3,      3,      9,     13,     17,     20,     22,     23,     23,
+                      23,     21,     18,     14,      9,      4,     -1,     -4,     -6,     -6,     -4,     -2,
+                       1,      3,      5,      6,      6,      6,      5,      3,      1,     -1,     -3,     -5,
+                      -7,     -8,     -9,     -8,     -6,     -4,     -1,      1,      3,      5,      6,      8,
+                       8 },
+                {      8,      8,      8,      6,      5,      3,      1,      0,     -2,     -3,     -4,     -6,
+                      -8,     -9,    -10,    -10,    -11,    -12,    -13,    -15,    -18,    -19,    -20,    -18,
+                     -15,    -11,     -6,      0,      6,     11,     16,     19,     20,     21,     21,     20,
+                      19,     18,     16,     13,     10,      7,      2,     -1,     -4,     -4,     -3,     -1,
+                       1,      3,      4,      5,      5,      4,      3,      2,      0,     -2,     -4,     -6,
+                      -8,     -9,    -10,     -9,     -7,     -5,     -2,      0,      2,      4,      6,      7,
+                       8 },
+                {      8,      8,      7,      6,      4,      3,      1,      0,     -2,     -3,     -4,     -6,
+                      -8,    -10,    -11,    -11,    -12,    -12,    -14,    -15,    -17,    -18,    -18,    -16,
+                     -13,     -8,     -3,      3,      8,     13,     17,     19,     20,     20,     19,     18,
+                      16,     15,     14,     12,     11,      8,      4,      1,     -2,     -2,     -2,      0,
+                       1,      3,      3,      3,      3,      3,      2,      1,     -1,     -3,     -5,     -7,
+                      -9,    -10,    -11,    -10,     -8,     -5,     -3,      0,      2,      4,      6,      7,
+                       8 },
+                {      7,      7,      7,      5,      4,      2,      1,      0,     -2,     -3,     -5,     -6,
+                      -8,    -10,    -11,    -12,    -12,    -13,    -14,    -15,    -16,    -16,    -15,    -13,
+                     -10,     -5,      0,      5,     10,     15,     18,     19,     19,     19,     17,     16,
+                      14,     13,     12,     11,     10,      8,      5,      2,      0,     -1,      0,      1,
+                       2,      3,      3,      3,      2,      1,      1,     -1,     -2,     -4,     -5,     -7,
+                      -9,    -11,    -11,    -10,     -8,     -6,     -3,     -1,      1,      3,      5,      7,
+                       7 },
+                {      6,      6,      6,      5,      3,      2,      1,     -1,     -2,     -3,     -5,     -7,
+                      -9,    -10,    -12,    -12,    -12,    -13,    -13,    -14,    -14,    -14,    -13,    -10,
+                      -7,     -2,      2,      7,     12,     15,     18,     19,     19,     18,     16,     15,
+                      13,     12,     11,     11,     10,      8,      6,      3,      1,      1,      1,      2,
+                       3,      3,      3,      2,      2,      0,     -1,     -2,     -3,     -4,     -6,     -8,
+                     -10,    -11,    -11,    -10,     -8,     -6,     -3,     -1,      1,      3,      4,      6,
+                       6 },
+                {      5,      5,      4,      3,      2,      1,      0,     -1,     -2,     -3,     -5,     -7,
+                      -9,    -10,    -12,    -12,    -12,    -12,    -13,    -13,    -13,    -12,    -10,     -7,
+                      -4,      0,      5,      9,     13,     15,     17,     18,     18,     17,     16,     14,
+                      12,     11,     10,     10,      9,      8,      6,      4,      3,      2,      2,      3,
+                       4,      4,      3,      2,      1,      0,     -2,     -3,     -4,     -5,     -7,     -8,
+                     -10,    -11,    -11,    -10,     -8,     -6,     -4,     -2,      0,      2,      3,      4,
+                       5 },
+                {      3,      3,      3,      2,      1,      0,     -1,     -2,     -3,     -4,     -5,     -7,
+                      -9,    -10,    -11,    -12,    -12,    -12,    -12,    -12,    -11,     -9,     -7,     -4,
+                      -1,      3,      7,     11,     13,     15,     17,     17,     17,     16,     15,     14,
+                      12,     11,     10,     10,      9,      8,      7,      5,      3,      3,      3,      4,
+                       4,      4,      4,      2,      1,     -1,     -2,     -4,     -5,     -6,     -7,     -9,
+                     -10,    -10,    -10,     -9,     -8,     -6,     -4,     -2,     -1,      1,      2,      3,
+                       3 },
+                {      1,      1,      0,      0,     -1,     -1,     -2,     -3,     -4,     -5,     -6,     -7,
+                      -9,    -10,    -11,    -12,    -12,    -12,    -11,    -10,     -9,     -7,     -4,     -1,
+                       3,      6,      9,     12,     14,     16,     17,     17,     17,     16,     15,     14,
+                      12,     11,     10,     10,      9,      8,      7,      5,      4,      4,      4,      4,
+                       5,      5,      4,      3,      1,     -1,     -3,     -5,     -6,     -7,     -8,     -9,
+                     -10,    -10,    -10,     -9,     -7,     -6,     -4,     -3,     -2,     -1,      0,      0,
+                       1 },
+                {     -2,     -2,     -2,     -3,     -3,     -3,     -4,     -4,     -5,     -5,     -6,     -7,
+                      -9,    -10,    -11,    -11,    -11,    -11,    -10,     -9,     -7,     -4,     -1,      2,
+                       6,      9,     11,     13,     15,     16,     17,     17,     17,     16,     16,     14,
+                      13,     12,     11,     10,     10,      9,      8,      6,      5,      4,      4,      5,
+                       5,      5,      4,      3,      1,     -1,     -4,     -5,     -7,     -8,     -9,     -9,
+                     -10,    -10,     -9,     -8,     -7,     -5,     -4,     -3,     -3,     -2,     -2,     -2,
+                      -2 },
+                {     -5,     -5,     -5,     -5,     -5,     -5,     -5,     -6,     -6,     -6,     -7,     -8,
+                      -9,     -9,    -10,    -10,    -10,    -10,     -8,     -7,     -4,     -1,      2,      6,
+                       9,     11,     13,     15,     16,     17,     17,     17,     17,     17,     16,     15,
+                      14,     13,     12,     11,     10,     10,      8,      7,      6,      5,      5,      5,
+                       5,      5,      4,      3,      1,     -2,     -4,     -6,     -8,     -9,    -10,    -10,
+                     -10,    -10,     -9,     -8,     -6,     -5,     -4,     -4,     -4,     -4,     -4,     -4,
+                      -5 },
+                {     -8,     -8,     -8,     -8,     -8,     -8,     -8,     -8,     -8,     -8,     -8,     -8,
+                      -9,     -9,    -10,    -10,     -9,     -8,     -6,     -4,     -1,      3,      6,      9,
+                      12,     14,     16,     17,     17,     18,     18,     18,     18,     18,     17,     16,
+                      15,     14,     13,     12,     12,     11,      9,      8,      7,      6,      5,      5,
+                       5,      5,      4,      3,      0,     -2,     -5,     -8,    -10,    -11,    -11,    -11,
+                     -11,    -10,     -8,     -7,     -6,     -5,     -5,     -4,     -5,     -5,     -6,     -7,
+                      -8 },
+                {    -11,    -11,    -12,    -11,    -11,    -11,    -10,    -10,     -9,     -9,     -9,     -9,
+                      -9,     -9,     -9,     -9,     -8,     -6,     -4,      0,      3,      7,     10,     13,
+                      15,     17,     18,     19,     19,     20,     20,     20,     20,     19,     19,     18,
+                      17,     16,     15,     14,     13,     12,     11,      9,      8,      7,      7,      6,
+                       6,      5,      4,      2,     -1,     -4,     -7,    -10,    -12,    -13,    -13,    -12,
+                     -11,    -10,     -8,     -7,     -6,     -5,     -5,     -5,     -6,     -7,     -8,    -10,
+                     -11 },
+                {    -14,    -15,    -15,    -15,    -15,    -14,    -13,    -13,    -12,    -11,    -11,    -10,
+                     -10,     -9,     -9,     -8,     -6,     -3,      0,      4,      8,     12,     15,     18,
+                      19,     20,     21,     21,     22,     22,     22,     22,     22,     21,     21,     20,
+                      19,     18,     17,     16,     15,     14,     13,     11,     10,      9,      8,      7,
+                       6,      5,      3,      1,     -2,     -6,     -9,    -12,    -14,    -15,    -15,    -13,
+                     -12,    -10,     -8,     -6,     -5,     -5,     -5,     -6,     -8,     -9,    -11,    -13,
+                     -14 },
+                {    -18,    -19,    -20,    -20,    -19,    -19,    -18,    -16,    -15,    -14,    -13,    -12,
+                     -11,    -10,     -8,     -6,     -3,      1,      6,     11,     15,     19,     21,     23,
+                      24,     25,     25,     25,     25,     25,     25,     24,     24,     23,     23,     22,
+                      21,     20,     19,     18,     17,     16,     15,     14,     13,     12,     10,      9,
+                       7,      6,      3,      0,     -4,     -8,    -12,    -15,    -17,    -17,    -16,    -14,
+                     -12,    -10,     -8,     -6,     -6,     -6,     -7,     -8,    -10,    -12,    -15,    -17,
+                     -18 },
+                {    -24,    -25,    -26,    -26,    -25,    -25,    -23,    -22,    -20,    -19,    -17,    -15,
+                     -13,    -11,     -7,     -3,      2,      8,     15,     21,     26,     29,     30,     31,
+                      31,     31,     31,     30,     29,     29,     28,     28,     27,     26,     25,     24,
+                      24,     23,     22,     21,     20,     19,     18,     17,     16,     15,     13,     11,
+                       9,      7,      3,     -1,     -5,    -10,    -15,    -19,    -21,    -20,    -19,    -16,
+                     -13,    -10,     -8,     -7,     -7,     -8,     -9,    -12,    -14,    -17,    -19,    -22,
+                     -24 },
+                {    -31,    -33,    -33,    -34,    -34,    -33,    -32,    -30,    -28,    -26,    -24,    -21,
+                     -17,    -13,     -7,      1,     10,     21,     30,     37,     42,     43,     43,     43,
+                      41,     40,     38,     37,     35,     34,     33,     32,     31,     30,     29,     28,
+                      27,     26,     25,     24,     24,     23,     22,     21,     20,     18,     17,     15,
+                      12,      9,      5,      0,     -6,    -12,    -18,    -23,    -25,    -25,    -23,    -20,
+                     -16,    -14,    -12,    -11,    -12,    -13,    -15,    -18,    -20,    -23,    -26,    -29,
+                     -31 },
+                {    -42,    -43,    -44,    -45,    -45,    -45,    -44,    -42,    -41,    -38,    -35,    -31,
+                     -26,    -18,     -7,      8,     26,     43,     57,     65,     67,     65,     62,     59,
+                      55,     52,     49,     46,     44,     42,     40,     38,     36,     35,     34,     33,
+                      32,     31,     30,     29,     28,     27,     26,     25,     24,     23,     22,     20,
+                      17,     14,     10,      5,     -2,    -10,    -19,    -27,    -32,    -33,    -32,    -29,
+                     -26,    -23,    -22,    -21,    -22,    -24,    -26,    -28,    -31,    -34,    -37,    -39,
+                     -42 },
+                {    -59,    -61,    -62,    -63,    -63,    -63,    -63,    -62,    -60,    -58,    -54,    -47,
+                     -38,    -22,      0,     30,     62,     88,    103,    106,    102,     95,     88,     80,
+                      74,     68,     63,     59,     55,     52,     50,     47,     45,     43,     42,     40,
+                      39,     38,     37,     36,     35,     34,     33,     33,     32,     31,     30,     29,
+                      27,     25,     22,     18,     12,      3,    -10,    -25,    -40,    -51,    -56,    -56,
+                     -53,    -50,    -47,    -46,    -46,    -46,    -47,    -49,    -51,    -53,    -55,    -57,
+                     -59 },
+                {    -98,    -98,    -99,    -99,    -99,    -99,    -98,    -97,    -93,    -87,    -76,    -59,
+                     -31,      9,     59,    110,    148,    166,    166,    158,    145,    132,    119,    109,
+                      99,     91,     85,     79,     74,     70,     66,     63,     60,     58,     56,     54,
+                      52,     51,     50,     49,     48,     48,     47,     47,     47,     47,     47,     48,
+                      48,     48,     49,     49,     48,     45,     37,     22,     -9,    -56,   -107,   -138,
+                    -145,   -139,   -129,   -119,   -112,   -106,   -102,   -100,    -98,    -97,    -97,    -97,
+                     -98 },
+                {   -248,   -230,   -213,   -194,   -172,   -145,   -110,    -65,     -9,     57,    126,    188,
+                     236,    264,    273,    268,    255,    238,    220,    203,    187,    173,    160,    148,
+                     139,    130,    122,    116,    110,    105,    101,     97,     93,     91,     88,     86,
+                      85,     84,     83,     82,     82,     82,     83,     83,     85,     87,     89,     92,
+                      96,    101,    107,    114,    123,    134,    148,    167,    190,    221,    262,    313,
+                     351,    172,  -1056,  -1328,   -898,   -645,   -504,   -418,   -361,   -321,   -291,   -267,
+                    -248 },
+                {    227,    227,    227,    227,    227,    226,    226,    226,    226,    226,    226,    226,
+                     226,    226,    226,    226,    226,    226,    226,    226,    226,    226,    226,    226,
+                     226,    225,    225,    225,    225,    225,    225,    225,    225,    225,    225,    225,
+                     225,    225,    225,    225,    225,    225,    225,    225,    225,    225,    225,    225,
+                     225,    225,    226,    226,    226,    226,    226,    226,    226,    226,    226,    226,
+                     226,    226,    226,    226,    226,    226,    226,    226,    226,    226,    227,    227,
+                     227 },
+            };
+
+        }
+
+    }
+
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "RoboatGPSManager.h"
+#include <RoboatRoute.h>
 
 namespace Roboat {
 
@@ -11,10 +12,32 @@ namespace Roboat {
         const uint32_t MAX_FIX_AGE = 3000;     // three seconds
 
         const int GPS_SERIAL_BAUD = 9600;
+
+        // Rough delay from the start of a UTC second to the end of the first
+        // NMEA sentence reporting it, used to time the clock without PPS.
+        const uint32_t NMEA_DELAY = 150000;
+
+        volatile uint32_t Manager::ppsTime = 0;
+        volatile uint32_t Manager::ppsCount = 0;
+
+        // TinyGPS++ keeps the NMEA digits as whole degrees plus billionths;
+        // round those to degrees x 1e7 without going through a double.
+        static int32_t toFixedPoint(const RawDegrees& raw) {
+            int32_t value = int32_t(raw.deg) * Nav::UNITS_PER_DEGREE + (raw.billionths + 50) / 100;
+            return raw.negative ? -value : value;
+        }
                 
-        Manager::Manager(HardwareSerial& serialPort):
+        Manager::Manager(HardwareSerial& serialPort, int ppsInputPin):
             StateMachine(STARTUP, "GPS"),    
-            port(serialPort)
+            port(serialPort),
+            ppsPin(ppsInputPin),
+            lastPpsCount(0),
+            lastUtcSecond(0),
+            lat(0),
+            lon(0),
+            course(0),
+            speed(0),
+            courseCount(0)
         {}
 
         bool Manager::update() {
@@ -28,16 +51,22 @@ namespace Roboat {
                     break;
 
                 case ACTIVATING:
-                    Serial.print(F("Configuring GPS serial port for "));
-                    Serial.print(GPS_SERIAL_BAUD);
-                    Serial.println(F(" baud."));
+                    Debug::out.print(F("Configuring GPS serial port for "));
+                    Debug::out.print(GPS_SERIAL_BAUD);
+                    Debug::out.println(F(" baud."));
                     port.begin(GPS_SERIAL_BAUD);
+                    if (ppsPin >= 0) {
+                        pinMode(ppsPin, INPUT);
+                        attachInterrupt(digitalPinToInterrupt(ppsPin), onPps, RISING);
+                    }
                     goToState(SEARCHING);
                     break;
 
                 case SEARCHING:
                     readAndParse();
                     if (parser.location.isValid()) {
+                        // ready at the first fix
+                        markReady();
                         goToState(RUNNING);
                     }
                     break;
@@ -60,7 +89,7 @@ namespace Roboat {
                     break;
                 
                 default:
-                    Serial.println("Unexpected state encountered!");
+                    Debug::out.println("Unexpected state encountered!");
                     goToState(ERROR);
             }
 
@@ -71,12 +100,22 @@ namespace Roboat {
             if (port.available() > 0) {
                 // Ooh look, data. Read it and update state.
                 while (port.available() > 0) {
-                  parser.encode(port.read());
+                  // Sync on RMC only, the sentence that carries the date. The
+                  // MTK3339 sends GGA first in each second, and its new time
+                  // with the last RMC's date is a day out at midnight.
+                  if (parser.encode(port.read()) && parser.date.isUpdated() && parser.time.isUpdated()) {
+                      synchronizeClock(micros());
+                  }
                 }
-                lat = parser.location.lat();
-                lon = parser.location.lng();
+                lat = toFixedPoint(parser.location.rawLat());
+                lon = toFixedPoint(parser.location.rawLng());
                 satsUsed = parser.satellites.value();
                 fixAge = parser.location.age();
+                if (parser.course.isUpdated() && parser.course.isValid()) {
+                    course = parser.course.deg();
+                    speed = parser.speed.mps();
+                    courseCount++;
+                }
                 return true;
             } else {
                 // nothing this time around
@@ -84,14 +123,82 @@ namespace Roboat {
             }
         }
 
+        void Manager::onPps() {
+            ppsTime = micros();
+            ppsCount++;
+        }
+
+        void Manager::synchronizeClock(uint32_t receivedAt) {
+            // mark the date and time read, so that only the next RMC syncs again
+            parser.date.value();
+            parser.time.value();
+
+            // the receiver reports time from its RTC before it has a fix
+            if (!parser.location.isValid() || parser.location.age() > MAX_FIX_AGE ||
+                !parser.date.isValid() || !parser.time.isValid()) {
+                return;
+            }
+            uint32_t second = Clock::unixTime(parser.date.year(), parser.date.month(), parser.date.day(),
+                                              parser.time.hour(), parser.time.minute(), parser.time.second());
+            if (second == lastUtcSecond) {
+                // another sentence about the same fix
+                return;
+            }
+            lastUtcSecond = second;
+
+            // the edge that started this second, if there is one
+            uint32_t edgeCount;
+            uint32_t edgeTime;
+            do {
+                edgeCount = ppsCount;
+                edgeTime = ppsTime;
+            } while (edgeCount != ppsCount);
+
+            uint64_t utc = uint64_t(second) * 1000000;
+            if (edgeCount != lastPpsCount && receivedAt - edgeTime < 1000000) {
+                lastPpsCount = edgeCount;
+                Clock::synchronize(Clock::toLocal(edgeTime), utc, true);
+            } else {
+                utc += parser.time.centisecond() * 10000UL;
+                Clock::synchronize(Clock::toLocal(receivedAt) - NMEA_DELAY, utc, false);
+            }
+        }
+
+        bool Manager::hasFix() const {
+            return getState() == RUNNING;
+        }
+
+        int32_t Manager::getLatitude() const {
+            return lat;
+        }
+
+        int32_t Manager::getLongitude() const {
+            return lon;
+        }
+
+        float Manager::getCourse() const {
+            return course;
+        }
+
+        float Manager::getSpeed() const {
+            return speed;
+        }
+
+        uint32_t Manager::getCourseCount() const {
+            return courseCount;
+        }
+
         String Manager::getLogString() const {
             String logStr(getState());
             logStr.concat(",");
 
             if (getState() == RUNNING) {
-                logStr.concat(String(lat, 12));
+                char degrees[13];
+                Nav::formatDegrees(lat, degrees);
+                logStr.concat(degrees);
                 logStr.concat(",");
-                logStr.concat(String(lon, 12));
+                Nav::formatDegrees(lon, degrees);
+                logStr.concat(degrees);
                 logStr.concat(",");
             } else {
                 logStr.concat("0,0,");
@@ -103,6 +210,21 @@ namespace Roboat {
             return logStr;
         }
 
+        void Manager::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            if (getState() == RUNNING) {
+                record.add(lat);
+                record.add(lon);
+            } else {
+                record.add(0);
+                record.add(0);
+            }
+            record.add(int(satsUsed));
+            record.add(fixAge < 1e9 ? int32_t(fixAge) : -1);   // age is "infinite" with no fix
+            record.add(Clock::getLastError());
+            record.add(Clock::getRateCorrection());
+        }
+
         const char * Manager::getStateName(const State aState) const {
             switch (aState) {
                 case STARTUP:
@@ -4,6 +4,8 @@
 #include "Arduino.h"
 #include "RoboatStateMachine.h"
 #include <TinyGPS++.h>
+#include <RoboatLogCodec.h>
+#include <RoboatClock.h>
 
 namespace Roboat {
 
@@ -17,6 +19,13 @@ namespace Roboat {
             REACQUIRING,
             RUNNING
         } State;
+
+        // Longest the GPS manager may go between advances before the
+        // watchdog supervisor (RoboatWatchdog.h) counts a miss (us): the
+        // loop's worst card writes (Log::WORST_WRITE_TIME) and a little
+        // more. The 64-byte UART buffer fills in about 67ms at 9600 baud, so
+        // a long write costs a sentence, which TinyGPS++ rejects by checksum.
+        const uint32_t WATCHDOG_DEADLINE = 6e5;
         
 
         class Manager : public StateMachine<State, Manager> {
@@ -27,25 +36,62 @@ namespace Roboat {
             // GPS Parser
             TinyGPSPlus parser;
 
+            // PPS input (-1 if not wired), and the micros() of the latest edge
+            const int ppsPin;
+            static volatile uint32_t ppsTime;
+            static volatile uint32_t ppsCount;
+            static void onPps();
+            uint32_t lastPpsCount;
+
+            // UTC second (since 1970) last passed to the clock
+            uint32_t lastUtcSecond;
+
+            // Synchronize the clock with the date and time of an RMC sentence
+            // that has just been received, if it carries a new UTC second.
+            void synchronizeClock(uint32_t receivedAt);
+
             // Read and parse any new serial data and update state variables.
             // Returns true if new data was incorporated (if not, then the state
             // will be unchanged). 
             bool readAndParse();
 
-            float lat;
-            float lon;
+            // position of the last fix, in degrees x 1e7
+            int32_t lat;
+            int32_t lon;
             float satsUsed;
             float fixAge;
 
+            // course (degrees true) and speed (m/s) over ground of the last
+            // sentence carrying them, and the number received
+            float course;
+            float speed;
+            uint32_t courseCount;
+
         public:
-            Manager(HardwareSerial& serialPort);
+            Manager(HardwareSerial& serialPort, int ppsInputPin = -1);
 
             // Advance the state machine.
             bool update();
                         
             const char * getStateName(const State aState) const;
+
+            // True while there is a current fix (i.e. in the RUNNING state).
+            bool hasFix() const;
+
+            // Position of the last fix, in degrees x 1e7.
+            int32_t getLatitude() const;
+            int32_t getLongitude() const;
+
+            // Course (degrees true) and speed (m/s) over ground. Poll
+            // getCourseCount() to detect new values.
+            float getCourse() const;
+            float getSpeed() const;
+            uint32_t getCourseCount() const;
             
             String getLogString() const;
+
+            // position in degrees x 1e7; clock error (us) and rate correction (ppb)
+            void addLogFields(Log::Record& record) const;
             
         };
 
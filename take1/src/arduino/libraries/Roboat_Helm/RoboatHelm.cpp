@@ -1 +1,29 @@
 #include "RoboatHelm.h"
+
+namespace Roboat {
+    namespace Conn {
+
+        Helm::Helm() :
+            courseSet(false),
+            desiredHeading(0)
+        {}
+
+        void Helm::setCourse(float heading) {
+            desiredHeading = heading;
+            courseSet = true;
+        }
+
+        void Helm::clearCourse() {
+            courseSet = false;
+        }
+
+        bool Helm::hasCourse() const {
+            return courseSet;
+        }
+
+        float Helm::getDesiredHeading() const {
+            return desiredHeading;
+        }
+
+    }
+}
\ No newline at end of file
@@ -8,6 +8,20 @@ namespace Roboat {
         
         class Helm {
 
+            bool courseSet;
+            float desiredHeading;
+
+        public:
+            Helm();
+
+            // Steer for the given heading (degrees true).
+            void setCourse(float heading);
+
+            // Stop steering for any particular heading.
+            void clearCourse();
+
+            bool hasCourse() const;
+            float getDesiredHeading() const;
         };
 
     }
@@ -0,0 +1,165 @@
+#include "RoboatI2CBus.h"
+
+#include <RoboatDebug.h>
+
+namespace Roboat {
+
+    namespace I2C {
+
+        static const char * getFaultName(Fault fault) {
+            switch (fault) {
+                case FAULT_NONE:
+                    return "NONE";
+                case FAULT_TIMEOUT:
+                    return "TIMEOUT";
+                case FAULT_NAK:
+                    return "NAK";
+                case FAULT_ARBITRATION:
+                    return "ARBITRATION";
+                case FAULT_SDA_STUCK:
+                    return "SDA_STUCK";
+                default:
+                    return "<INVALID>";
+            }
+        }
+
+        // histogram bucket of a recovery time (us)
+        static uint8_t bucketOf(uint32_t time) {
+            uint32_t ms = time / 1000;
+            uint8_t bucket = 0;
+            while (ms > 0 && bucket < HISTOGRAM_BUCKETS - 1) {
+                ms >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+
+
+        Bus::Bus(i2c_t3& busWire, const char * busName) :
+            wire(busWire),
+            name(busName),
+            fault(FAULT_NONE),
+            faultTime(0),
+            faultCount(0),
+            recoveryCount(0),
+            lastRecoveryTime(0)
+        {
+            memset(histogram, 0, sizeof(histogram));
+        }
+
+        void Bus::begin() {
+            wire.begin();
+            wire.setDefaultTimeout(TRANSACTION_TIMEOUT);
+        }
+
+        i2c_t3& Bus::getWire() {
+            return wire;
+        }
+
+        bool Bus::check() {
+            Fault found = FAULT_NONE;
+            switch (wire.status()) {
+                case I2C_TIMEOUT:
+                    found = FAULT_TIMEOUT;
+                    break;
+                case I2C_ADDR_NAK:
+                case I2C_DATA_NAK:
+                    found = FAULT_NAK;
+                    break;
+                case I2C_ARB_LOST:
+                    found = FAULT_ARBITRATION;
+                    break;
+                default:
+                    if (!wire.getSDA()) {
+                        found = FAULT_SDA_STUCK;
+                    }
+            }
+
+            if (found != FAULT_NONE) {
+                if (fault == FAULT_NONE) {
+                    faultTime = micros();
+                    faultCount++;
+                    Debug::out.print(name);
+                    Debug::out.print(" fault: ");
+                    Debug::out.println(getFaultName(found));
+                }
+                fault = found;
+                return false;
+            }
+
+            if (fault != FAULT_NONE) {
+                lastRecoveryTime = micros() - faultTime;
+                recoveryCount++;
+                histogram[bucketOf(lastRecoveryTime)]++;
+                fault = FAULT_NONE;
+                Debug::out.print(name);
+                Debug::out.print(" recovered in ");
+                Debug::out.print(lastRecoveryTime / 1000);
+                Debug::out.println("ms");
+            }
+            return true;
+        }
+
+        bool Bus::recover() {
+            wire.resetBus();
+            return wire.getSDA();
+        }
+
+        Fault Bus::getFault() const {
+            return fault;
+        }
+
+        uint32_t Bus::getFaultCount() const {
+            return faultCount;
+        }
+
+        uint32_t Bus::getRecoveryCount() const {
+            return recoveryCount;
+        }
+
+        uint32_t Bus::getLastRecoveryTime() const {
+            return lastRecoveryTime;
+        }
+
+        uint16_t Bus::getHistogramCount(uint8_t bucket) const {
+            return bucket < HISTOGRAM_BUCKETS ? histogram[bucket] : 0;
+        }
+
+        String Bus::getLogString() const {
+            String logStr(name);
+            logStr.concat(",");
+            logStr.concat(faultCount);
+            logStr.concat(",");
+            logStr.concat(recoveryCount);
+            for (uint8_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+                logStr.concat(",");
+                logStr.concat(histogram[i]);
+            }
+            return logStr;
+        }
+
+        void Bus::addLogFields(Log::Record& record) const {
+            record.add(faultCount);
+            record.add(lastRecoveryTime / 1000);
+        }
+
+
+        Backoff::Backoff(uint32_t initial, uint32_t maximum) :
+            initialDelay(initial),
+            maxDelay(maximum),
+            delay(initial)
+        {}
+
+        uint32_t Backoff::next() {
+            uint32_t current = delay;
+            delay = delay > maxDelay / 2 ? maxDelay : delay * 2;
+            return current;
+        }
+
+        void Backoff::reset() {
+            delay = initialDelay;
+        }
+
+    }
+
+}
@@ -0,0 +1,107 @@
+#ifndef ROBOAT_I2CBUS_H
+#define ROBOAT_I2CBUS_H
+
+#include "Arduino.h"
+#include <i2c_t3.h>
+#include <RoboatLogCodec.h>
+
+namespace Roboat {
+
+    namespace I2C {
+
+        // Longest a single transaction may take before i2c_t3 gives up on it
+        // (us), instead of waiting forever on a device holding the bus.
+        const uint32_t TRANSACTION_TIMEOUT = 2000;
+
+        // Recovery times are counted in buckets of doubling width: bucket 0
+        // is under 1ms, bucket i is [2^(i-1), 2^i) ms, and the last bucket
+        // holds everything longer.
+        const uint8_t HISTOGRAM_BUCKETS = 16;
+
+        typedef enum {
+            FAULT_NONE,
+            FAULT_TIMEOUT,      // a transaction timed out
+            FAULT_NAK,          // the device did not acknowledge
+            FAULT_ARBITRATION,  // arbitration lost, i.e. something else drove SDA
+            FAULT_SDA_STUCK     // SDA held low with the bus idle
+        } Fault;
+
+
+        // Health monitoring and recovery for one i2c_t3 bus.
+        //
+        // Departments call check() after each batch of transactions with
+        // their devices. A failed transaction, or SDA held low by a device
+        // that lost track of a transfer (typically after a reset or glitch
+        // mid-byte), marks the bus faulty; recover() then clocks SCL until
+        // the device lets go of SDA and sends a STOP. The department resets
+        // its device and retries, and the time from the fault to the next
+        // good check() is counted in a histogram of recovery times.
+        class Bus {
+            i2c_t3& wire;
+            const char * name;
+
+            Fault fault;
+            uint32_t faultTime;
+            uint32_t faultCount;
+            uint32_t recoveryCount;
+            uint32_t lastRecoveryTime;
+            uint16_t histogram[HISTOGRAM_BUCKETS];
+
+        public:
+            Bus(i2c_t3& busWire, const char * busName);
+
+            // Start the bus as a master, with the transaction timeout.
+            void begin();
+
+            i2c_t3& getWire();
+
+            // Check the outcome of the transactions since the last check.
+            // Returns true if the bus is healthy.
+            bool check();
+
+            // Release a stuck bus: clock out whatever a device is holding SDA
+            // for, then send a STOP. Returns true if SDA is free afterwards.
+            bool recover();
+
+            // The fault found by the last check, or FAULT_NONE.
+            Fault getFault() const;
+
+            uint32_t getFaultCount() const;
+            uint32_t getRecoveryCount() const;
+
+            // Time from the last fault to the first good check after it (us).
+            uint32_t getLastRecoveryTime() const;
+
+            uint16_t getHistogramCount(uint8_t bucket) const;
+
+            // name, faults, recoveries, then the recovery time histogram
+            String getLogString() const;
+
+            // faults, and the last recovery time (ms)
+            void addLogFields(Log::Record& record) const;
+        };
+
+
+        // Exponential backoff between retries: starts short, so a glitch
+        // costs milliseconds, and doubles up to a limit, so a device that
+        // is really gone is not hammered.
+        class Backoff {
+            const uint32_t initialDelay;
+            const uint32_t maxDelay;
+            uint32_t delay;
+
+        public:
+            Backoff(uint32_t initial, uint32_t maximum);
+
+            // The delay before the next retry (us); each call doubles the next.
+            uint32_t next();
+
+            // Start again from the initial delay, after a success.
+            void reset();
+        };
+
+    }
+
+}
+
+#endif
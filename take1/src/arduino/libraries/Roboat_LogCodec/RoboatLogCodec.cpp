@@ -0,0 +1,333 @@
+#include "RoboatLogCodec.h"
+
+#include <string.h>
+
+namespace Roboat {
+
+    namespace Log {
+
+        // CRC-8 (polynomial 0x07), a nibble at a time from a 16-entry table
+        static const uint8_t CRC8_TABLE[16] = {
+            0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+            0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+        };
+
+        uint8_t crc8(const uint8_t* data, size_t length) {
+            uint8_t crc = 0;
+            while (length--) {
+                crc ^= *data++;
+                crc = (crc << 4) ^ CRC8_TABLE[crc >> 4];
+                crc = (crc << 4) ^ CRC8_TABLE[crc >> 4];
+            }
+            return crc;
+        }
+
+        size_t putVarint(uint32_t value, uint8_t* out) {
+            size_t n = 0;
+            while (value >= 0x80) {
+                out[n++] = static_cast<uint8_t>(value) | 0x80;
+                value >>= 7;
+            }
+            out[n++] = static_cast<uint8_t>(value);
+            return n;
+        }
+
+        size_t getVarint(const uint8_t* in, size_t length, uint32_t& value) {
+            value = 0;
+            for (size_t n = 0; n < length && n < 5; n++) {
+                value |= static_cast<uint32_t>(in[n] & 0x7F) << (7 * n);
+                if ((in[n] & 0x80) == 0) {
+                    return n + 1;
+                }
+            }
+            return 0;
+        }
+
+
+        Record::Record() :
+            count(0),
+            dropped(0)
+        {}
+
+        void Record::clear() {
+            count = 0;
+            dropped = 0;
+        }
+
+        void Record::add(int32_t value) {
+            if (count < MAX_FIELDS) {
+                fields[count++] = value;
+            } else if (dropped < 255) {
+                dropped++;
+            }
+        }
+
+        uint8_t Record::size() const {
+            return count;
+        }
+
+        uint8_t Record::getDropped() const {
+            return dropped;
+        }
+
+        int32_t Record::operator[](uint8_t index) const {
+            return fields[index];
+        }
+
+        const int32_t* Record::data() const {
+            return fields;
+        }
+
+
+        Encoder::Encoder() :
+            fieldCount(0),
+            sinceKeyframe(0),
+            sequence(0)
+        {}
+
+        void Encoder::reset() {
+            fieldCount = 0;
+        }
+
+        bool Encoder::nextIsKeyframe() const {
+            return fieldCount == 0 || sinceKeyframe >= KEYFRAME_INTERVAL;
+        }
+
+        uint32_t Encoder::getSequence() const {
+            return sequence;
+        }
+
+        size_t Encoder::encode(const Record& record, uint8_t* out) {
+            const uint8_t count = record.size();
+            const int32_t* fields = record.data();
+            size_t n = 0;
+
+            out[n++] = FRAME_SYNC;
+            if (nextIsKeyframe() || count != fieldCount) {
+                out[n++] = FRAME_KEY;
+                out[n++] = count;
+                n += putVarint(sequence, out + n);
+                for (uint8_t i = 0; i < count; i++) {
+                    n += putVarint(zigzag(fields[i]), out + n);
+                    previous[i] = fields[i];
+                }
+                fieldCount = count;
+                sinceKeyframe = 1;
+            } else {
+                out[n++] = FRAME_DELTA;
+                out[n++] = static_cast<uint8_t>(sequence);
+                for (uint8_t i = 0; i < count; i++) {
+                    // wrapping difference, so any pair of values round-trips
+                    int32_t delta = static_cast<int32_t>(
+                        static_cast<uint32_t>(fields[i]) - static_cast<uint32_t>(previous[i]));
+                    n += putVarint(zigzag(delta), out + n);
+                    previous[i] = fields[i];
+                }
+                sinceKeyframe++;
+            }
+            out[n] = crc8(out, n);
+            n++;
+
+            sequence++;
+            return n;
+        }
+
+
+        Decoder::Decoder() :
+            frameLength(0),
+            fieldCount(0),
+            varintsRemaining(0),
+            varintLength(0),
+            synced(false),
+            sequence(0),
+            errors(0),
+            gaps(0)
+        {}
+
+        void Decoder::restart() {
+            frameLength = 0;
+            varintLength = 0;
+        }
+
+        bool Decoder::feed(uint8_t byte) {
+            if (frameLength == 0) {
+                // waiting for the start of a frame; anything else is skipped
+                if (byte == FRAME_SYNC) {
+                    frame[frameLength++] = byte;
+                }
+                return false;
+            }
+
+            frame[frameLength++] = byte;
+
+            if (frameLength == 2) {
+                if (byte == FRAME_KEY) {
+                    return false;
+                } else if (byte == FRAME_DELTA && synced) {
+                    return false;
+                }
+                // not a frame we can use; resynchronize on this byte
+                restart();
+                return byte == FRAME_SYNC ? feed(byte) : false;
+            }
+
+            if (frameLength == 3 && frame[1] == FRAME_KEY) {
+                if (byte > MAX_FIELDS) {
+                    errors++;
+                    restart();
+                    return false;
+                }
+                // the sequence number, then one varint per field
+                varintsRemaining = byte + 1;
+                return false;
+            }
+
+            if (frameLength == 3 && frame[1] == FRAME_DELTA) {
+                // after the sequence byte, one varint per field
+                varintsRemaining = fieldCount;
+                return false;
+            }
+
+            if (varintsRemaining > 0) {
+                varintLength++;
+                if ((byte & 0x80) == 0) {
+                    varintsRemaining--;
+                    varintLength = 0;
+                } else if (varintLength >= 5) {
+                    errors++;
+                    restart();
+                }
+                return false;
+            }
+
+            // this is the CRC byte, so the frame is complete
+            bool decoded = decodeFrame();
+            restart();
+            return decoded;
+        }
+
+        bool Decoder::decodeFrame() {
+            size_t length = frameLength - 1;
+            if (crc8(frame, length) != frame[length]) {
+                errors++;
+                synced = false;
+                return false;
+            }
+
+            size_t n = 2;
+            uint32_t value;
+            if (frame[1] == FRAME_KEY) {
+                fieldCount = frame[n++];
+                n += getVarint(frame + n, length - n, value);
+                sequence = value;
+                for (uint8_t i = 0; i < fieldCount; i++) {
+                    n += getVarint(frame + n, length - n, value);
+                    values[i] = unzigzag(value);
+                }
+                synced = true;
+            } else {
+                if (frame[n++] != static_cast<uint8_t>(sequence + 1)) {
+                    // the deltas are from a record we never saw
+                    gaps++;
+                    synced = false;
+                    return false;
+                }
+                for (uint8_t i = 0; i < fieldCount; i++) {
+                    n += getVarint(frame + n, length - n, value);
+                    values[i] = static_cast<int32_t>(
+                        static_cast<uint32_t>(values[i]) + static_cast<uint32_t>(unzigzag(value)));
+                }
+                sequence++;
+            }
+            return true;
+        }
+
+        void Decoder::getRecord(Record& record) const {
+            record.clear();
+            for (uint8_t i = 0; i < fieldCount; i++) {
+                record.add(values[i]);
+            }
+        }
+
+        uint32_t Decoder::getSequence() const {
+            return sequence;
+        }
+
+        uint32_t Decoder::getErrors() const {
+            return errors;
+        }
+
+        uint32_t Decoder::getGaps() const {
+            return gaps;
+        }
+
+
+        LinkSplitter::LinkSplitter() :
+            lineLength(0),
+            sliceRemaining(0),
+            sliceId(0)
+        {}
+
+        LinkSplitter::Stream LinkSplitter::feed(uint8_t byte) {
+            if (sliceRemaining > 0) {
+                sliceRemaining--;
+                return SLICE;
+            }
+
+            // a header may follow a frame on the same line (frames have no
+            // line endings), so start afresh at every '#'
+            if (byte == '#') {
+                line[0] = byte;
+                lineLength = 1;
+            } else if (byte == '\n') {
+                // after a chunk header, the chunk starts with the next byte
+                if (lineLength > 0) {
+                    parseHeader();
+                }
+                lineLength = 0;
+            } else if (lineLength > 0 && byte != '\r') {
+                if (lineLength < LINE_SIZE) {
+                    line[lineLength++] = byte;
+                } else {
+                    // too long for a chunk header
+                    lineLength = 0;
+                }
+            }
+            return LIVE;
+        }
+
+        void LinkSplitter::parseHeader() {
+            static const char PREFIX[] = "#SLICE,";
+            const uint8_t prefixLength = sizeof(PREFIX) - 1;
+            if (lineLength <= prefixLength || memcmp(line, PREFIX, prefixLength) != 0) {
+                return;
+            }
+            // <id>,<offset>,<length>
+            uint32_t numbers[3] = { 0, 0, 0 };
+            uint8_t field = 0;
+            bool digits = false;
+            for (uint8_t i = prefixLength; i < lineLength; i++) {
+                if (line[i] == ',' && digits && field < 2) {
+                    field++;
+                    digits = false;
+                } else if (line[i] >= '0' && line[i] <= '9') {
+                    numbers[field] = numbers[field] * 10 + (line[i] - '0');
+                    digits = true;
+                } else {
+                    return;
+                }
+            }
+            if (field != 2 || !digits) {
+                return;
+            }
+            sliceId = numbers[0];
+            sliceRemaining = numbers[2];
+        }
+
+        uint16_t LinkSplitter::getSliceId() const {
+            return sliceId;
+        }
+
+    }
+
+}
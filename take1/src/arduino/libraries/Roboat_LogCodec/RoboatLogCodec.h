@@ -0,0 +1,185 @@
+#ifndef ROBOAT_LOGCODEC_H
+#define ROBOAT_LOGCODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Roboat {
+
+    namespace Log {
+
+        // Upper bound on the number of fields in a telemetry record.
+        const uint8_t MAX_FIELDS = 80;
+
+        // A keyframe is emitted every KEYFRAME_INTERVAL records, so a decoder
+        // joining mid-stream never has to skip more than this many records.
+        const uint8_t KEYFRAME_INTERVAL = 16;
+
+        // Every frame starts with FRAME_SYNC followed by a frame type byte.
+        // FRAME_SYNC is never part of an ASCII log line, so frames can share
+        // the Pi link with plain text.
+        const uint8_t FRAME_SYNC = 0xA5;
+        const uint8_t FRAME_KEY = 'K';
+        const uint8_t FRAME_DELTA = 'D';
+
+        // Worst case frame size (a keyframe): sync, type, field count,
+        // sequence number, five bytes per field and the trailing CRC.
+        const size_t MAX_FRAME_SIZE = 3 + 5 + 5 * MAX_FIELDS + 1;
+
+
+        // A fixed-size record of integer telemetry fields. Values that are
+        // naturally fractional are stored scaled (mV, centidegrees, ...).
+        class Record {
+            int32_t fields[MAX_FIELDS];
+            uint8_t count;
+            uint8_t dropped;
+
+        public:
+            Record();
+
+            void clear();
+
+            // Append a field. Fields beyond MAX_FIELDS are dropped, and counted.
+            void add(int32_t value);
+
+            uint8_t size() const;
+
+            // Number of fields dropped since the last clear() (at most 255).
+            uint8_t getDropped() const;
+            int32_t operator[](uint8_t index) const;
+            const int32_t* data() const;
+        };
+
+
+        // Streaming telemetry encoder. Each record is encoded as the
+        // difference of each field from the previous record, as zig-zag
+        // varints; every KEYFRAME_INTERVAL records (and whenever the field
+        // count changes, or after reset()) absolute values are sent instead.
+        //
+        //   keyframe: A5 'K' <count> <varint sequence> <zig-zag field>... <crc8>
+        //   delta:    A5 'D' <sequence & 0xFF> <zig-zag delta>... <crc8>
+        //
+        // A delta is only meaningful after the frame before it, so the low
+        // byte of its sequence number lets a decoder notice a lost frame.
+        //
+        // The encoder keeps only the previous record, and the work per record
+        // is bounded by the field count, so encoding time is predictable.
+        class Encoder {
+            int32_t previous[MAX_FIELDS];
+            uint8_t fieldCount;
+            uint8_t sinceKeyframe;
+            uint32_t sequence;
+
+        public:
+            Encoder();
+
+            // Force the next record to be encoded as a keyframe.
+            void reset();
+
+            // Encode a record into `out`, which must hold MAX_FRAME_SIZE
+            // bytes. Returns the number of bytes written.
+            size_t encode(const Record& record, uint8_t* out);
+
+            // True if the next encoded record will be a keyframe.
+            bool nextIsKeyframe() const;
+
+            // Number of records encoded so far.
+            uint32_t getSequence() const;
+        };
+
+
+        // Decoder for the frame format above. Bytes can be fed one at a time
+        // from any point in a stream: frames are ignored until a keyframe is
+        // seen, and any CRC or framing error, or a delta that does not follow
+        // the last record decoded, drops back to waiting for the next
+        // keyframe.
+        class Decoder {
+            int32_t values[MAX_FIELDS];
+            uint8_t frame[MAX_FRAME_SIZE];
+            size_t frameLength;
+            uint8_t fieldCount;
+            uint8_t varintsRemaining;   // varints still expected in the current frame
+            uint8_t varintLength;       // bytes so far of the current varint
+            bool synced;
+            uint32_t sequence;
+            uint32_t errors;
+            uint32_t gaps;
+
+            bool decodeFrame();
+            void restart();
+
+        public:
+            Decoder();
+
+            // Feed one byte. Returns true when a complete record has been
+            // decoded, after which getRecord() returns it.
+            bool feed(uint8_t byte);
+
+            void getRecord(Record& record) const;
+            uint32_t getSequence() const;
+            uint32_t getErrors() const;
+
+            // Number of times frames were missing from the stream.
+            uint32_t getGaps() const;
+        };
+
+
+        // Separates log slices from the live stream on the RPI link. A slice
+        // (see Log::Manager::requestRange) arrives as chunks, each a line
+        //
+        //   #SLICE,<id>,<offset>,<length>
+        //
+        // followed by exactly <length> bytes of the record file. Those bytes
+        // are frames too, but old ones: fed to the live stream's Decoder, a
+        // keyframe among them would move its delta base back, and a chunk
+        // may start or end part way through a frame. Feed every byte of the
+        // link to the splitter first, then to the decoder of the stream it
+        // belongs to. Everything else (live frames, text lines, including
+        // the #SLICE lines themselves) is the live stream.
+        class LinkSplitter {
+        public:
+            typedef enum {
+                LIVE,
+                SLICE
+            } Stream;
+
+        private:
+            static const uint8_t LINE_SIZE = 40;
+            char line[LINE_SIZE];       // since the last '#', if it may be a chunk header
+            uint8_t lineLength;
+            uint32_t sliceRemaining;    // bytes of the current chunk still to come
+            uint16_t sliceId;
+
+            // If `line` is a chunk header, expect the chunk next.
+            void parseHeader();
+
+        public:
+            LinkSplitter();
+
+            // The stream that `byte`, the next byte of the link, belongs to.
+            Stream feed(uint8_t byte);
+
+            // Id of the slice the last SLICE byte belongs to.
+            uint16_t getSliceId() const;
+        };
+
+
+        // Zig-zag varint primitives, exposed for testing and host tools.
+        size_t putVarint(uint32_t value, uint8_t* out);
+        size_t getVarint(const uint8_t* in, size_t length, uint32_t& value);
+
+        inline uint32_t zigzag(int32_t value) {
+            return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+        }
+
+        inline int32_t unzigzag(uint32_t value) {
+            return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        uint8_t crc8(const uint8_t* data, size_t length);
+
+    }
+
+}
+
+#endif
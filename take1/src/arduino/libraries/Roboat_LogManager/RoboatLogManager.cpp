@@ -2,8 +2,6 @@
 #include <RoboatLogManager.h>
 // #include <iostream.h>
 
-#include <EEPROM.h>
-
 namespace Roboat {
 
     namespace Log {
@@ -12,21 +10,55 @@ namespace Roboat {
         const uint32_t ERROR_RESET_DELAY = 10e6;
     
         const uint32_t ERROR_LOOP_PERIOD = 1e6;  // recheck error conditions at 1Hz
+
+        const uint32_t ACTIVATING_RETRY_PERIOD = 5e5;  // retry a missing card twice a second
         
         const uint32_t READY_LOOP_PERIOD = 1e4;  // handle log ops at 100Hz
 
-        Manager::Manager(ostream &serialEcho) :
+        // Bytes of a log slice sent per update. At 115200 baud the Pi link drains
+        // about 115 bytes per 10ms update.
+        const uint32_t TRANSFER_CHUNK_SIZE = 96;
+
+        // Room for the longest #SLICE or #SLICE_END line.
+        const size_t SLICE_HEADER_SIZE = 40;
+
+        Manager::Manager(Debug::Channel& echo, Persist::Store& persistentStore) :
             StateMachine(STARTUP, "Log"),
+            store(persistentStore),
             cardSize(0),
             freeSpace(0),
             epoch(getAndIncrementEpoch()),
             enableEcho(true),
             linePrefix(String(getEpoch()) + ","),
             fileName(String("Log_").concat(getEpoch()).concat(".csv")),
-            serialEcho(serialEcho)            
-        {}
+            echoPort(echo),
+            serialEcho(echo),
+            backlog(echo, backlogBuffer, BACKLOG_SIZE, Debug::DROP_OLDEST),
+            backlogStream(backlog),
+            recordFileName(String("Log_").concat(getEpoch()).concat(".rtl")),
+            lastRecordBytes(0),
+            lastEncodeCycles(0),
+            maxEncodeCycles(0),
+            overflowReported(false),
+            indexFileName(String("Log_").concat(getEpoch()).concat(".idx")),
+            transferId(0),
+            transferStart(0),
+            transferPosition(0),
+            transferEnd(0)
+        {
+            // enable the cycle counter used to time record encoding
+            ARM_DEMCR |= ARM_DEMCR_TRCENA;
+            ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+        }
 
         bool Manager::update() {
+            // pass on the backlog only whole, so its lines are not split by
+            // records or slices
+            if (enableEcho && backlog.getPending() > 0 &&
+                size_t(echoPort.availableForWrite()) >= backlog.getPending()) {
+                backlog.drain();
+            }
+
             switch (getState()) {
                 case STARTUP:
                     goToState(ACTIVATING, 10);
@@ -41,10 +73,13 @@ namespace Roboat {
                         cardSize = sd.card()->cardSize();
                         if (sd.fsBegin()) {
                             measureFreeSpace();
+                            openFiles();
+                            markReady();
                             goToState(READY);
                         }
                     } else {
-                        Serial.println(F("Failed to initialize SD card. Will retry."));
+                        Debug::out.println(F("Failed to initialize SD card. Will retry."));
+                        remain(ACTIVATING_RETRY_PERIOD);
                     }
                     break;
                     
@@ -56,11 +91,12 @@ namespace Roboat {
                     
                 case READY:
                     // the normal loop, writing and reading
+                    continueTransfer();
                     remain(READY_LOOP_PERIOD);
                     break;
                 
                 default:
-                    Serial.println("Unexpected state encountered!");
+                    Debug::out.println("Unexpected state encountered!");
                     goToState(ERROR);
             }
 
@@ -72,6 +108,20 @@ namespace Roboat {
             freeSpace = 0.512 * volFree * sd.vol()->blocksPerCluster();
         }
 
+        void Manager::openFiles() {
+            if (!fileStream.is_open()) {
+                fileStream.open(fileName.c_str(), ios::out | ios::app);
+            }
+            if (!recordFile.isOpen()) {
+                recordFile.open(recordFileName.c_str(), O_WRITE | O_CREAT | O_APPEND);
+            }
+            if (!indexFile.isOpen()) {
+                indexFile.open(indexFileName.c_str(), O_RDWR | O_CREAT | O_AT_END);
+            }
+            // decoders of the new file (or the resumed one) start from a keyframe
+            encoder.reset();
+        }
+
         const char * Manager::getStateName(const State aState) const {
             switch (aState) {
                 case STARTUP:
@@ -100,34 +150,258 @@ namespace Roboat {
             return epoch;
         }
 
+        bool Manager::isReady() const {
+            return getState() == READY;
+        }
+
         void Manager::setEpoch(uint16_t newEpoch) {
-            uint8_t msb = (newEpoch & 0xFF00) >> 8;
-            uint8_t lsb = (newEpoch & 0x00FF);
-            EEPROM.write(EPOCH_ADDRESS_MSB, msb);
-            EEPROM.write(EPOCH_ADDRESS_LSB, lsb);
+            store.put(Persist::KEY_EPOCH, newEpoch);
         }
           
         uint16_t Manager::getAndIncrementEpoch() {
-            uint8_t msb = EEPROM.read(EPOCH_ADDRESS_MSB);
-            uint8_t lsb = EEPROM.read(EPOCH_ADDRESS_LSB);
-            uint32_t epoch_tmp = msb;
-            epoch_tmp <<= 8;
-            epoch_tmp += lsb;
+            uint16_t epoch_tmp = 0;
+            store.get(Persist::KEY_EPOCH, epoch_tmp);
             epoch_tmp += 1;
             setEpoch(epoch_tmp);
             return epoch_tmp;
         }
 
         void Manager::writeln(const String& line) {
+            // time since startup (ms), then UTC if known
+            uint32_t time = millis();
+            char utc[28] = "-";
+            if (Clock::isSynced()) {
+                Clock::formatTime(Clock::now(), utc);
+            }
+            // the line is echoed whole or not at all; the time takes up to
+            // 10 digits, and endl is \r\n
+            size_t length = 5 + linePrefix.length() + 10 + 1 + strlen(utc) + 1 + line.length() + 2;
             if (enableEcho) {
-                serialEcho << F("LOG: ") << linePrefix.c_str() << millis() << "," << line.c_str() << endl;
+                if (echoPort.reserve(length)) {
+                    serialEcho << F("LOG: ") << linePrefix.c_str() << time << "," << utc << "," << line.c_str() << endl;
+                }
+            } else if (backlog.reserve(length)) {
+                backlogStream << F("LOG: ") << linePrefix.c_str() << time << "," << utc << "," << line.c_str() << endl;
             }
             if (fileStream.is_open()) {
-                fileStream << linePrefix.c_str() << millis() << "," << line.c_str() << endl;
+                fileStream << linePrefix.c_str() << time << "," << utc << "," << line.c_str() << endl;
                 fileStream.flush();
             }
         }
       
+        void Manager::setEcho(bool enable) {
+            if (enable) {
+                // the RPI has missed frames (or just started), so give it a
+                // keyframe to decode the deltas from
+                encoder.reset();
+            }
+            enableEcho = enable;
+        }
+
+        bool Manager::isEchoing() const {
+            return enableEcho;
+        }
+
+        size_t Manager::getBacklogPending() const {
+            return backlog.getPending();
+        }
+
+        uint32_t Manager::getRecordFileSize() const {
+            return recordFile.isOpen() ? recordFile.fileSize() : 0;
+        }
+
+        void Manager::writeRecord(const Record& record) {
+            Record stamped;
+            stamped.add(epoch);
+            stamped.add(millis());
+            if (Clock::isSynced()) {
+                uint64_t utc = Clock::now();
+                stamped.add(int32_t(utc / 1000000));
+                stamped.add(int32_t(utc % 1000000));
+            } else {
+                stamped.add(0);
+                stamped.add(0);
+            }
+            for (uint8_t i = 0; i < record.size(); i++) {
+                stamped.add(record[i]);
+            }
+
+            // fields past MAX_FIELDS are lost from the end of every record;
+            // say so once, rather than let them go missing unnoticed
+            const uint16_t dropped = record.getDropped() + stamped.getDropped();
+            if (dropped > 0 && !overflowReported) {
+                overflowReported = true;
+                Debug::out.println(F("Record is wider than Log::MAX_FIELDS; its last fields are dropped."));
+                String line("LOG,RECORD_OVERFLOW,");
+                line.concat(MAX_FIELDS + dropped);
+                writeln(line);
+            }
+
+            uint8_t frame[MAX_FRAME_SIZE];
+            uint32_t startCycles = ARM_DWT_CYCCNT;
+            size_t frameLength = encoder.encode(stamped, frame);
+            lastEncodeCycles = ARM_DWT_CYCCNT - startCycles;
+            if (lastEncodeCycles > maxEncodeCycles) {
+                maxEncodeCycles = lastEncodeCycles;
+            }
+            lastRecordBytes = frameLength;
+
+            // a delta is no use to the RPI without the frame before it, so
+            // if the link drops one, start again from a keyframe
+            if (enableEcho && echoPort.write(frame, frameLength) == 0) {
+                encoder.reset();
+            }
+            if (recordFile.isOpen()) {
+                uint32_t offset = recordFile.fileSize();
+                recordFile.write(frame, frameLength);
+                recordFile.sync();
+                if (frame[1] == FRAME_KEY) {
+                    appendIndexEntry(stamped[1], offset, encoder.getSequence() - 1);
+                }
+            }
+        }
+
+        void Manager::appendIndexEntry(uint32_t time, uint32_t offset, uint32_t sequence) {
+            if (!indexFile.isOpen()) {
+                return;
+            }
+            IndexEntry entry = { time, offset, sequence };
+            indexFile.seekEnd();
+            indexFile.write(&entry, sizeof(entry));
+            indexFile.sync();
+        }
+
+        uint32_t Manager::indexEntryCount() {
+            return indexFile.isOpen() ? indexFile.fileSize() / sizeof(IndexEntry) : 0;
+        }
+
+        bool Manager::readIndexEntry(uint32_t index, IndexEntry& entry) {
+            return indexFile.seekSet(index * sizeof(IndexEntry)) &&
+                indexFile.read(&entry, sizeof(entry)) == int(sizeof(entry));
+        }
+
+        int32_t Manager::findIndexEntry(uint32_t value, bool bySequence) {
+            // binary search; entries are in increasing time and sequence order
+            int32_t low = 0;
+            int32_t high = indexEntryCount();
+            IndexEntry entry;
+            while (low < high) {
+                int32_t mid = low + (high - low) / 2;
+                if (!readIndexEntry(mid, entry)) {
+                    return -1;
+                }
+                if ((bySequence ? entry.sequence : entry.time) <= value) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            return low - 1;
+        }
+
+        bool Manager::requestRange(uint32_t startTime, uint32_t endTime) {
+            if (!isReady() || isTransferring() || endTime < startTime) {
+                return false;
+            }
+            // start at the keyframe before startTime (or the first one)...
+            int32_t first = findIndexEntry(startTime, false);
+            if (first < 0) {
+                first = 0;
+            }
+            IndexEntry entry;
+            if (!readIndexEntry(first, entry)) {
+                return false;
+            }
+            uint32_t startOffset = entry.offset;
+
+            // ...and stop at the first keyframe after endTime (or the end of the file)
+            uint32_t endOffset = recordFile.fileSize();
+            int32_t last = findIndexEntry(endTime, false);
+            if (last >= 0 && uint32_t(last + 1) < indexEntryCount() && readIndexEntry(last + 1, entry)) {
+                endOffset = entry.offset;
+            }
+            return startTransfer(startOffset, endOffset);
+        }
+
+        bool Manager::requestLatest(uint32_t count) {
+            if (!isReady() || isTransferring() || count == 0) {
+                return false;
+            }
+            uint32_t total = encoder.getSequence();
+            int32_t first = findIndexEntry(total > count ? total - count : 0, true);
+            IndexEntry entry;
+            if (first < 0 || !readIndexEntry(first, entry)) {
+                return false;
+            }
+            return startTransfer(entry.offset, recordFile.fileSize());
+        }
+
+        bool Manager::startTransfer(uint32_t startOffset, uint32_t endOffset) {
+            if (startOffset >= endOffset || !transferFile.open(recordFileName.c_str(), O_READ) ||
+                !transferFile.seekSet(startOffset))
+            {
+                transferFile.close();
+                return false;
+            }
+            transferId++;
+            transferStart = startOffset;
+            transferPosition = startOffset;
+            transferEnd = endOffset;
+            return true;
+        }
+
+        void Manager::continueTransfer() {
+            if (!isTransferring()) {
+                return;
+            }
+
+            // Send a chunk only once the link has room for all of it, its
+            // header and a #SLICE_END; otherwise try again next update, as a
+            // chunk cut short by a full link would corrupt the slice.
+            uint32_t length = min(TRANSFER_CHUNK_SIZE, transferEnd - transferPosition);
+            if (size_t(echoPort.availableForWrite()) < 2 * SLICE_HEADER_SIZE + length) {
+                return;
+            }
+
+            uint8_t chunk[TRANSFER_CHUNK_SIZE];
+            int bytesRead = transferFile.read(chunk, length);
+            if (bytesRead <= 0) {
+                // treat a read failure as the end of the slice
+                transferEnd = transferPosition;
+            } else {
+                serialEcho << F("#SLICE,") << transferId << "," << transferPosition << "," << bytesRead << "\n";
+                echoPort.write(chunk, bytesRead);
+                transferPosition += bytesRead;
+            }
+
+            if (transferPosition >= transferEnd) {
+                serialEcho << F("#SLICE_END,") << transferId << "," << (transferPosition - transferStart) << "\n";
+                transferFile.close();
+            }
+        }
+
+        bool Manager::isTransferring() const {
+            return transferFile.isOpen();
+        }
+
+        void Manager::cancelTransfer() {
+            if (isTransferring()) {
+                transferEnd = transferPosition;
+                if (echoPort.reserve(SLICE_HEADER_SIZE)) {
+                    serialEcho << F("#SLICE_END,") << transferId << "," << (transferPosition - transferStart) << "\n";
+                }
+                transferFile.close();
+            }
+        }
+
+        void Manager::addLogFields(Record& record) const {
+            record.add(getState());
+            record.add(getFreeSpace());
+            record.add(lastRecordBytes);
+            record.add(lastEncodeCycles);
+            record.add(maxEncodeCycles);
+        }
+
         String Manager::getLogString() const {
             String logStr(getState());
             logStr.concat(",");
@@ -3,6 +3,10 @@
 
 #include "Arduino.h"
 #include <RoboatStateMachine.h>
+#include <RoboatLogCodec.h>
+#include <RoboatStore.h>
+#include <RoboatClock.h>
+#include <RoboatDebug.h>
 
 #include "SdFat.h"
 
@@ -10,9 +14,14 @@ namespace Roboat {
     
     namespace Log {
 
-        static const int EPOCH_ADDRESS_LSB = 512;
-        static const int EPOCH_ADDRESS_MSB = 513;
-    
+        // One entry of the sparse time index kept alongside each record file,
+        // written for every keyframe (so every KEYFRAME_INTERVAL records).
+        typedef struct {
+            uint32_t time;          // record time (ms)
+            uint32_t offset;        // byte offset of the keyframe in the record file
+            uint32_t sequence;      // record number of the keyframe
+        } IndexEntry;
+
         typedef enum {
             STARTUP,
             ERROR,
@@ -21,10 +30,28 @@ namespace Roboat {
             ERROR_CARD_FULL,            
             READY
         } State;
+
+        // Longest the log may go between advances before the watchdog
+        // supervisor (RoboatWatchdog.h) counts a miss (us). Records are
+        // written from the loop, so the log itself only has slices to send.
+        const uint32_t WATCHDOG_DEADLINE = 2e6;
+
+        // Worst case of the card writes in one pass of the loop (us). Writing
+        // a record syncs the record file and its index, and a log line flushes
+        // the CSV log; the SD spec lets a card stay busy for up to 250ms on
+        // each write. Deadlines of departments advanced from the loop allow
+        // for two such waits.
+        const uint32_t WORST_WRITE_TIME = 5e5;
+
+        // Log lines held in RAM while the echo is off (the RPI is asleep),
+        // oldest dropped first. Small enough to pass on in one go once the
+        // RPI link's ring (2KB in Pilot.ino) has drained.
+        const size_t BACKLOG_SIZE = 1536;
         
 
         class Manager : public StateMachine<State, Manager> {
 
+            Persist::Store& store;
             SdFatSdioEX sd;
             uint32_t cardSize;
             uint32_t freeSpace;
@@ -35,16 +62,58 @@ namespace Roboat {
             const String fileName;
             ofstream fileStream;
             
-            ostream &serialEcho;
+            // Echo of the log to the RPI: text goes through the stream, binary
+            // frames straight to the port (the stream would expand \n to \r\n)
+            Debug::Channel& echoPort;
+            ArduinoOutStream serialEcho;
+
+            // log lines written while the echo is off, passed on when it is
+            // turned back on
+            uint8_t backlogBuffer[BACKLOG_SIZE];
+            Debug::Channel backlog;
+            ArduinoOutStream backlogStream;
+
+            // compressed telemetry records (see RoboatLogCodec.h)
+            const String recordFileName;
+            FatFile recordFile;
+            Encoder encoder;
+            uint32_t lastRecordBytes;
+            uint32_t lastEncodeCycles;
+            uint32_t maxEncodeCycles;
+            bool overflowReported;      // a record has been cut short by MAX_FIELDS
+
+            // sparse time index of the record file
+            const String indexFileName;
+            FatFile indexFile;
+
+            // log slice being sent back over the echo stream, if any
+            FatFile transferFile;
+            uint16_t transferId;
+            uint32_t transferStart;
+            uint32_t transferPosition;
+            uint32_t transferEnd;
             
             void measureFreeSpace();
 
+            void openFiles();
+
+            void appendIndexEntry(uint32_t time, uint32_t offset, uint32_t sequence);
+            uint32_t indexEntryCount();
+            bool readIndexEntry(uint32_t index, IndexEntry& entry);
+
+            // Index of the last entry whose time (or sequence) is <= value, or
+            // -1 if there is none.
+            int32_t findIndexEntry(uint32_t value, bool bySequence);
+
+            bool startTransfer(uint32_t startOffset, uint32_t endOffset);
+            void continueTransfer();
+
             void setEpoch(uint16_t newEpoch);
               
             uint16_t getAndIncrementEpoch();
 
         public:
-            Manager(ostream &serialEcho);
+            Manager(Debug::Channel& echo, Persist::Store& persistentStore);
 
             // Advance the state machine.
             bool update();
@@ -56,8 +125,53 @@ namespace Roboat {
 
             uint16_t getEpoch() const;
 
+            // True once the card is mounted and files can be created on it.
+            bool isReady() const;
+
             void writeln(const String& line);
 
+            // Turn the echo to the RPI on or off. While it is off, records
+            // only go to the card, and log lines are also kept in a RAM
+            // backlog which is passed on once the echo is back on. Turning it
+            // on makes the next record a keyframe.
+            void setEcho(bool enable);
+            bool isEchoing() const;
+
+            // Bytes of log lines waiting in the backlog.
+            size_t getBacklogPending() const;
+
+            // Size of this epoch's record file (bytes), 0 if it is not open.
+            uint32_t getRecordFileSize() const;
+
+            // Compress and write a telemetry record, prefixed with the epoch,
+            // the time since startup (ms) and UTC (seconds since 1970 and
+            // microseconds; both 0 until the clock is synchronized), to the
+            // record file and the echo stream.
+            void writeRecord(const Record& record);
+
+            void addLogFields(Record& record) const;
+
+            // Send back the records logged between two times (ms), or the
+            // latest `count` records, over the echo stream. The slice is
+            // aligned to keyframes, so it may include up to KEYFRAME_INTERVAL
+            // records either side of what was asked for. It goes out as a
+            // series of chunks, a bounded number of bytes per update:
+            //
+            //   #SLICE,<id>,<offset>,<length>\n<length bytes of the record file>
+            //   #SLICE_END,<id>,<total bytes>\n
+            //
+            // The chunks are record frames, mixed in with the live ones; a
+            // reader must set aside exactly <length> bytes after each #SLICE
+            // line (see Log::LinkSplitter).
+            //
+            // Returns false if the card is not ready, nothing matches, or
+            // another slice is still being sent.
+            bool requestRange(uint32_t startTime, uint32_t endTime);
+            bool requestLatest(uint32_t count);
+
+            bool isTransferring() const;
+            void cancelTransfer();
+
             String getLogString() const;
 
             // Manager& operator << (const String& str);
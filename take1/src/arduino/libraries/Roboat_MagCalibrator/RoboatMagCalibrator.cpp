@@ -0,0 +1,296 @@
+#include "RoboatMagCalibrator.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace Roboat {
+
+    namespace IMU {
+
+        // forgetting factor; the fit remembers roughly the last 1/(1-LAMBDA) samples
+        const float LAMBDA = 0.999F;
+
+        // initial covariance, and the bound above which forgetting is suspended
+        // so that directions the samples do not excite cannot wind up
+        const float INITIAL_COVARIANCE = 10.0F;
+        const float MAX_COVARIANCE_TRACE = 9 * INITIAL_COVARIANCE;
+
+        // a fit is trusted only once every parameter is this well determined
+        const float MAX_PARAMETER_VARIANCE = 0.5F;
+
+        // samples closer than this to the previous one (uT) add nothing
+        const float MIN_SAMPLE_SPACING = 2.0F;
+
+        // reject solutions with implausibly strong soft iron distortion
+        const float MAX_AXIS_RATIO = 2.0F;
+
+        // fixed number of Jacobi sweeps, ample for a 3x3 matrix
+        const uint8_t JACOBI_SWEEPS = 8;
+
+
+        // Eigendecomposition of a symmetric 3x3 matrix: A = V diag(d) V^T
+        static void eigenSymmetric3(const float A[3][3], float d[3], float V[3][3]) {
+            float a[3][3];
+            memcpy(a, A, sizeof(a));
+            for (uint8_t i = 0; i < 3; i++) {
+                for (uint8_t j = 0; j < 3; j++) {
+                    V[i][j] = (i == j) ? 1.0F : 0.0F;
+                }
+            }
+
+            for (uint8_t sweep = 0; sweep < JACOBI_SWEEPS; sweep++) {
+                for (uint8_t p = 0; p < 2; p++) {
+                    for (uint8_t q = p + 1; q < 3; q++) {
+                        if (fabsf(a[p][q]) < 1e-12F) {
+                            continue;
+                        }
+                        float theta = (a[q][q] - a[p][p]) / (2.0F * a[p][q]);
+                        float t = (theta >= 0 ? 1.0F : -1.0F) / (fabsf(theta) + sqrtf(theta * theta + 1.0F));
+                        float c = 1.0F / sqrtf(t * t + 1.0F);
+                        float s = t * c;
+                        for (uint8_t k = 0; k < 3; k++) {
+                            float akp = a[k][p];
+                            float akq = a[k][q];
+                            a[k][p] = c * akp - s * akq;
+                            a[k][q] = s * akp + c * akq;
+                        }
+                        for (uint8_t k = 0; k < 3; k++) {
+                            float apk = a[p][k];
+                            float aqk = a[q][k];
+                            a[p][k] = c * apk - s * aqk;
+                            a[q][k] = s * apk + c * aqk;
+                        }
+                        for (uint8_t k = 0; k < 3; k++) {
+                            float vkp = V[k][p];
+                            float vkq = V[k][q];
+                            V[k][p] = c * vkp - s * vkq;
+                            V[k][q] = s * vkp + c * vkq;
+                        }
+                    }
+                }
+            }
+            for (uint8_t i = 0; i < 3; i++) {
+                d[i] = a[i][i];
+            }
+        }
+
+
+        MagCalibrator::MagCalibrator() {
+            MagCalibration identity;
+            memset(&identity, 0, sizeof(identity));
+            for (uint8_t i = 0; i < 3; i++) {
+                identity.softIron[i][i] = 1.0F;
+            }
+            identity.fieldStrength = 50.0F;
+            reset(identity);
+        }
+
+        void MagCalibrator::reset(const MagCalibration& referenceCalibration) {
+            reference = referenceCalibration;
+            solution = referenceCalibration;
+
+            // start from a unit sphere around the reference offsets
+            memset(theta, 0, sizeof(theta));
+            theta[0] = theta[1] = theta[2] = 1.0F;
+            memset(P, 0, sizeof(P));
+            for (uint8_t i = 0; i < N; i++) {
+                P[i][i] = INITIAL_COVARIANCE;
+            }
+
+            lastSample[0] = lastSample[1] = lastSample[2] = 0;
+            sampleCount = 0;
+            recentCount = 0;
+            recentNext = 0;
+            solutionError = 1.0F;
+            referenceError = 1.0F;
+        }
+
+        bool MagCalibrator::addSample(float x, float y, float z) {
+            float dx = x - lastSample[0];
+            float dy = y - lastSample[1];
+            float dz = z - lastSample[2];
+            if (dx * dx + dy * dy + dz * dz < MIN_SAMPLE_SPACING * MIN_SAMPLE_SPACING) {
+                return false;
+            }
+            lastSample[0] = x;
+            lastSample[1] = y;
+            lastSample[2] = z;
+
+            recent[recentNext][0] = x;
+            recent[recentNext][1] = y;
+            recent[recentNext][2] = z;
+            recentNext = (recentNext + 1) % RECENT_SAMPLES;
+            if (recentCount < RECENT_SAMPLES) {
+                recentCount++;
+            }
+
+            // normalize against the reference hard iron offsets and field strength
+            float scale = 1.0F / reference.fieldStrength;
+            float ux = (x - reference.offsets[0]) * scale;
+            float uy = (y - reference.offsets[1]) * scale;
+            float uz = (z - reference.offsets[2]) * scale;
+
+            const float phi[N] = {
+                ux * ux, uy * uy, uz * uz,
+                2 * ux * uy, 2 * ux * uz, 2 * uy * uz,
+                2 * ux, 2 * uy, 2 * uz
+            };
+
+            // Pphi = P * phi, denominator = lambda + phi' * P * phi
+            float Pphi[N];
+            float trace = 0;
+            for (uint8_t i = 0; i < N; i++) {
+                float sum = 0;
+                for (uint8_t j = 0; j < N; j++) {
+                    sum += P[i][j] * phi[j];
+                }
+                Pphi[i] = sum;
+                trace += P[i][i];
+            }
+            float lambda = trace < MAX_COVARIANCE_TRACE ? LAMBDA : 1.0F;
+            float denominator = lambda;
+            float prediction = 0;
+            for (uint8_t i = 0; i < N; i++) {
+                denominator += phi[i] * Pphi[i];
+                prediction += phi[i] * theta[i];
+            }
+
+            // update the estimate, then the (symmetric) covariance
+            float error = 1.0F - prediction;
+            float invDenominator = 1.0F / denominator;
+            for (uint8_t i = 0; i < N; i++) {
+                theta[i] += Pphi[i] * invDenominator * error;
+            }
+            float invLambda = 1.0F / lambda;
+            for (uint8_t i = 0; i < N; i++) {
+                for (uint8_t j = i; j < N; j++) {
+                    float v = (P[i][j] - Pphi[i] * Pphi[j] * invDenominator) * invLambda;
+                    P[i][j] = v;
+                    P[j][i] = v;
+                }
+            }
+
+            sampleCount++;
+            return true;
+        }
+
+        uint32_t MagCalibrator::getSampleCount() const {
+            return sampleCount;
+        }
+
+        bool MagCalibrator::solve() {
+            for (uint8_t i = 0; i < N; i++) {
+                if (!(P[i][i] < MAX_PARAMETER_VARIANCE)) {
+                    return false;
+                }
+            }
+
+            // quadric matrix M and linear term v of the normalized ellipsoid
+            const float M[3][3] = {
+                { theta[0], theta[3], theta[4] },
+                { theta[3], theta[1], theta[5] },
+                { theta[4], theta[5], theta[2] }
+            };
+            const float v[3] = { theta[6], theta[7], theta[8] };
+
+            // center c = -M^-1 v, via the adjugate
+            float adj[3][3] = {
+                { M[1][1] * M[2][2] - M[1][2] * M[2][1], M[0][2] * M[2][1] - M[0][1] * M[2][2], M[0][1] * M[1][2] - M[0][2] * M[1][1] },
+                { M[1][2] * M[2][0] - M[1][0] * M[2][2], M[0][0] * M[2][2] - M[0][2] * M[2][0], M[0][2] * M[1][0] - M[0][0] * M[1][2] },
+                { M[1][0] * M[2][1] - M[1][1] * M[2][0], M[0][1] * M[2][0] - M[0][0] * M[2][1], M[0][0] * M[1][1] - M[0][1] * M[1][0] }
+            };
+            float det = M[0][0] * adj[0][0] + M[0][1] * adj[1][0] + M[0][2] * adj[2][0];
+            if (!(det > 1e-9F)) {
+                return false;
+            }
+            float c[3];
+            for (uint8_t i = 0; i < 3; i++) {
+                c[i] = -(adj[i][0] * v[0] + adj[i][1] * v[1] + adj[i][2] * v[2]) / det;
+            }
+
+            // (u - c)' M (u - c) = 1 + c' M c
+            float k = 1.0F;
+            for (uint8_t i = 0; i < 3; i++) {
+                for (uint8_t j = 0; j < 3; j++) {
+                    k += c[i] * M[i][j] * c[j];
+                }
+            }
+            if (!(k > 0)) {
+                return false;
+            }
+
+            float A[3][3];
+            for (uint8_t i = 0; i < 3; i++) {
+                for (uint8_t j = 0; j < 3; j++) {
+                    A[i][j] = M[i][j] / k;
+                }
+            }
+            float d[3];
+            float V[3][3];
+            eigenSymmetric3(A, d, V);
+            if (!(d[0] > 0 && d[1] > 0 && d[2] > 0)) {
+                return false;
+            }
+            float dMin = fminf(d[0], fminf(d[1], d[2]));
+            float dMax = fmaxf(d[0], fmaxf(d[1], d[2]));
+            if (dMax > MAX_AXIS_RATIO * MAX_AXIS_RATIO * dMin) {
+                return false;
+            }
+
+            // Map the ellipsoid onto a sphere with the same volume: the soft iron
+            // matrix is R * sqrt(A), R being the geometric mean of the radii.
+            float radius = powf(d[0] * d[1] * d[2], -1.0F / 6.0F);
+            float sqrtD[3] = { sqrtf(d[0]), sqrtf(d[1]), sqrtf(d[2]) };
+
+            MagCalibration candidate;
+            for (uint8_t i = 0; i < 3; i++) {
+                for (uint8_t j = 0; j < 3; j++) {
+                    float sum = 0;
+                    for (uint8_t e = 0; e < 3; e++) {
+                        sum += V[i][e] * sqrtD[e] * V[j][e];
+                    }
+                    candidate.softIron[i][j] = radius * sum;
+                }
+                candidate.offsets[i] = reference.offsets[i] + reference.fieldStrength * c[i];
+            }
+            candidate.fieldStrength = reference.fieldStrength * radius;
+
+            solution = candidate;
+            solutionError = score(solution);
+            referenceError = score(reference);
+            return true;
+        }
+
+        float MagCalibrator::score(const MagCalibration& cal) const {
+            if (recentCount == 0) {
+                return 1.0F;
+            }
+            float sum = 0;
+            for (uint8_t n = 0; n < recentCount; n++) {
+                float x = recent[n][0] - cal.offsets[0];
+                float y = recent[n][1] - cal.offsets[1];
+                float z = recent[n][2] - cal.offsets[2];
+                float mx = cal.softIron[0][0] * x + cal.softIron[0][1] * y + cal.softIron[0][2] * z;
+                float my = cal.softIron[1][0] * x + cal.softIron[1][1] * y + cal.softIron[1][2] * z;
+                float mz = cal.softIron[2][0] * x + cal.softIron[2][1] * y + cal.softIron[2][2] * z;
+                float e = sqrtf(mx * mx + my * my + mz * mz) / cal.fieldStrength - 1.0F;
+                sum += e * e;
+            }
+            return sqrtf(sum / recentCount);
+        }
+
+        const MagCalibration& MagCalibrator::getSolution() const {
+            return solution;
+        }
+
+        float MagCalibrator::getFitQuality() const {
+            return solutionError;
+        }
+
+        float MagCalibrator::getReferenceQuality() const {
+            return referenceError;
+        }
+
+    }
+
+}
@@ -0,0 +1,87 @@
+#ifndef ROBOAT_MAGCALIBRATOR_H
+#define ROBOAT_MAGCALIBRATOR_H
+
+#include <stdint.h>
+
+namespace Roboat {
+
+    namespace IMU {
+
+        // Hard and soft iron magnetometer calibration: calibrated values are
+        // softIron * (raw - offsets), which lie on a sphere of radius fieldStrength.
+        typedef struct {
+            float offsets[3];           // uT
+            float softIron[3][3];
+            float fieldStrength;        // uT
+        } MagCalibration;
+
+
+        // Incremental magnetometer calibration by recursive least squares.
+        //
+        // Each sample is fitted to a general ellipsoid
+        //
+        //   a x^2 + b y^2 + c z^2 + 2d xy + 2e xz + 2f yz + 2g x + 2h y + 2i z = 1
+        //
+        // with exponential forgetting, so the fit follows slow changes in the
+        // boat's magnetic environment. Samples are normalized against a
+        // reference calibration (usually the one in use) to keep the problem
+        // well scaled in single precision. The state is a fixed 9x9 covariance
+        // matrix, and each sample costs a few hundred multiply-adds. Turning
+        // the fit into a calibration (solve()) needs a 3x3 eigendecomposition
+        // and is meant to be run occasionally, not every sample.
+        class MagCalibrator {
+            static const uint8_t N = 9;
+
+            float theta[N];
+            float P[N][N];
+
+            MagCalibration reference;
+            float lastSample[3];
+            uint32_t sampleCount;
+
+            // the most recent samples, used to score solutions
+            static const uint8_t RECENT_SAMPLES = 32;
+            float recent[RECENT_SAMPLES][3];
+            uint8_t recentCount;
+            uint8_t recentNext;
+
+            MagCalibration solution;
+            float solutionError;
+            float referenceError;
+
+            // RMS relative radius error of the recent samples under a calibration
+            float score(const MagCalibration& cal) const;
+
+        public:
+            MagCalibrator();
+
+            // Restart the fit around a reference calibration.
+            void reset(const MagCalibration& referenceCalibration);
+
+            // Add a raw magnetometer sample (uT). Samples too close to the
+            // previous one add nothing to the fit and are skipped; returns true
+            // if the sample was used.
+            bool addSample(float x, float y, float z);
+
+            // Number of samples used since the last reset.
+            uint32_t getSampleCount() const;
+
+            // Compute a calibration from the current fit. Returns false if the
+            // fit is not (yet) a well-determined ellipsoid.
+            bool solve();
+
+            // The calibration found by the last successful solve().
+            const MagCalibration& getSolution() const;
+
+            // RMS radius error of recent samples, as a fraction of the field
+            // strength, under the last solution and under the reference.
+            // Lower is better; a good calibration is around 0.01-0.02.
+            float getFitQuality() const;
+            float getReferenceQuality() const;
+        };
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "RoboatMemory.h"
+
+// Memory layout symbols from the Teensy linker script and startup code
+// (mk20dx128.c): the end of .bss, the top of the stack, and the heap's
+// current break.
+extern "C" {
+    extern unsigned long _ebss;
+    extern unsigned long _estack;
+    extern char* __brkval;
+}
+
+// newlib-nano's allocator state (nano-mallocr.c). Free blocks form a list
+// of chunks, each starting with its size (including that header).
+struct NanoMallocChunk {
+    long size;
+    NanoMallocChunk* next;
+};
+
+extern "C" {
+    extern NanoMallocChunk* __malloc_free_list;
+
+    struct _reent;
+    void __malloc_lock(struct _reent*);
+    void __malloc_unlock(struct _reent*);
+}
+
+// Every malloc, free and realloc takes the allocator lock exactly once.
+// The firmware is single threaded and never allocates from interrupts, so
+// the lock itself can be a no-op; these replace newlib's versions (both
+// must be defined, as they share an object file in libc).
+static volatile uint32_t heapCalls = 0;
+
+void __malloc_lock(struct _reent*) {
+    heapCalls++;
+}
+
+void __malloc_unlock(struct _reent*) {
+}
+
+namespace Roboat {
+
+    namespace Memory {
+
+        // _sbrk() refuses to grow the heap closer than this to the stack
+        // pointer (STACK_MARGIN in mk20dx128.c for the MK66)
+        const size_t SBRK_STACK_MARGIN = 8192;
+
+        // bytes before the start of a chunk's user data
+        const size_t CHUNK_HEADER = sizeof(long);
+
+        const uint32_t PAINT = 0xC5C5C5C5;
+
+        // room left for paintStack()'s own frame
+        const size_t PAINT_CLEARANCE = 256;
+
+        static uint32_t* paintBottom = NULL;
+        static uint32_t* paintTop = NULL;
+
+        static uint32_t lastHeapCalls = 0;
+
+        static char* heapTop() {
+            return __brkval ? __brkval : reinterpret_cast<char*>(&_ebss);
+        }
+
+        static inline char* stackPointer() {
+            char* sp;
+            __asm__ volatile("mov %0, sp" : "=r" (sp));
+            return sp;
+        }
+
+        static uintptr_t alignUp(uintptr_t address) {
+            return (address + sizeof(uint32_t) - 1) & ~uintptr_t(sizeof(uint32_t) - 1);
+        }
+
+        // Room between the heap and the stack that _sbrk() would still hand out.
+        static uint32_t unclaimed() {
+            uintptr_t top = reinterpret_cast<uintptr_t>(heapTop());
+            uintptr_t limit = reinterpret_cast<uintptr_t>(stackPointer()) - SBRK_STACK_MARGIN;
+            return limit > top ? limit - top : 0;
+        }
+
+        void paintStack() {
+            uintptr_t top = (reinterpret_cast<uintptr_t>(stackPointer()) - PAINT_CLEARANCE) & ~uintptr_t(3);
+            uintptr_t bottom = alignUp(reinterpret_cast<uintptr_t>(heapTop()));
+            if (top - bottom > STACK_PAINT_DEPTH) {
+                bottom = top - STACK_PAINT_DEPTH;
+            }
+            paintBottom = reinterpret_cast<uint32_t*>(bottom);
+            paintTop = reinterpret_cast<uint32_t*>(top);
+            for (volatile uint32_t* p = paintBottom; p < paintTop; p++) {
+                *p = PAINT;
+            }
+        }
+
+        uint32_t getHeapSize() {
+            return heapTop() - reinterpret_cast<char*>(&_ebss);
+        }
+
+        uint32_t getFreeHeap() {
+            uint32_t free = unclaimed();
+            for (const NanoMallocChunk* chunk = __malloc_free_list; chunk; chunk = chunk->next) {
+                free += chunk->size - CHUNK_HEADER;
+            }
+            return free;
+        }
+
+        uint32_t getLargestFreeBlock() {
+            uint32_t largest = unclaimed();
+            largest = largest > CHUNK_HEADER ? largest - CHUNK_HEADER : 0;
+            for (const NanoMallocChunk* chunk = __malloc_free_list; chunk; chunk = chunk->next) {
+                if (uint32_t(chunk->size) - CHUNK_HEADER > largest) {
+                    largest = chunk->size - CHUNK_HEADER;
+                }
+            }
+            return largest;
+        }
+
+        uint32_t getHeapCalls() {
+            return heapCalls;
+        }
+
+        uint32_t getStackHighWater() {
+            if (!paintTop) {
+                return 0;
+            }
+            // the heap may since have grown over the bottom of the paint
+            const uint32_t* p = paintBottom;
+            const uint32_t* heap = reinterpret_cast<const uint32_t*>(alignUp(reinterpret_cast<uintptr_t>(heapTop())));
+            if (heap > p) {
+                p = heap;
+            }
+            while (p < paintTop && *p == PAINT) {
+                p++;
+            }
+            return reinterpret_cast<const char*>(&_estack) - reinterpret_cast<const char*>(p);
+        }
+
+        void addLogFields(Log::Record& record) {
+            uint32_t calls = heapCalls;
+            record.add(getFreeHeap());
+            record.add(getLargestFreeBlock());
+            record.add(calls - lastHeapCalls);
+            record.add(getStackHighWater());
+            lastHeapCalls = calls;
+        }
+
+    }
+
+}
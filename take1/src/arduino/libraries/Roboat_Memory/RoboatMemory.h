@@ -0,0 +1,58 @@
+#ifndef ROBOAT_MEMORY_H
+#define ROBOAT_MEMORY_H
+
+#include "Arduino.h"
+#include <RoboatLogCodec.h>
+
+namespace Roboat {
+
+    // Heap and stack instrumentation.
+    //
+    // The Teensy's RAM holds the static data, then the heap growing up from
+    // the end of .bss, then the stack growing down from the top. Nothing
+    // stops the two from meeting, so these functions report how close they
+    // get: the free heap (blocks on malloc's free list plus the unclaimed
+    // space between heap and stack), the largest block malloc could return
+    // (much smaller than the free heap means fragmentation), the number of
+    // heap calls, and the deepest the stack has reached.
+    //
+    // The stack depth is found by painting: paintStack() fills the RAM
+    // below the stack with a pattern, and getStackHighWater() looks for the
+    // lowest word that has been overwritten. Only STACK_PAINT_DEPTH bytes are
+    // painted, to keep the scan short; a high-water mark of that size means
+    // the stack has gone at least that deep.
+    //
+    // The heap functions read the state of newlib-nano's malloc (the
+    // allocator Teensyduino links), and heap calls are counted by replacing
+    // its lock hooks. All functions are for the main loop only.
+    namespace Memory {
+
+        const size_t STACK_PAINT_DEPTH = 32768;
+
+        // Paint the unused stack. Call first thing in setup(); the stack in
+        // use at that point counts as used.
+        void paintStack();
+
+        // Bytes the heap has taken from the system.
+        uint32_t getHeapSize();
+
+        // Bytes available to malloc, in total and in the largest single block.
+        uint32_t getFreeHeap();
+        uint32_t getLargestFreeBlock();
+
+        // Calls to malloc, free and realloc since startup.
+        uint32_t getHeapCalls();
+
+        // Deepest stack use since paintStack() (bytes), or 0 if not painted.
+        uint32_t getStackHighWater();
+
+        // Free heap and largest block (bytes), heap calls since the last
+        // call, and stack high-water mark (bytes). Meant to be called once
+        // per logging window.
+        void addLogFields(Log::Record& record);
+
+    }
+
+}
+
+#endif
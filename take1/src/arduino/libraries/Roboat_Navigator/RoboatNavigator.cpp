@@ -0,0 +1,254 @@
+#include "RoboatNavigator.h"
+#include <RoboatClock.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        // reset after 10s on error
+        const uint32_t ERROR_RESET_DELAY = 10e6;
+
+        // track the route five times a second, a little faster than fixes arrive
+        const uint32_t NAVIGATION_PERIOD = 2e5;
+
+        Navigator::Navigator(GPS::Manager& gpsManager, IMU::AHRS& theAHRS, Conn::Helm& theHelm) :
+            StateMachine(STARTUP, "Navigator"),
+            gps(gpsManager),
+            ahrs(theAHRS),
+            helm(theHelm),
+            declination(0),
+            declinationKnown(false),
+            declinationExpired(false),
+            lastCourseCount(0),
+            requestedActive(false)
+        {}
+
+        bool Navigator::update() {
+            updateHeadingReference();
+
+            switch (getState()) {
+                case STARTUP:
+                    markReady();
+                    goToState(IDLE, 10);
+                    break;
+
+                case ERROR:
+                    helm.clearCourse();
+                    publishGuidance(false, getFix());
+                    goToState(STARTUP, ERROR_RESET_DELAY);
+                    break;
+
+                case IDLE:
+                    if (requestedActive && route.size() > 0) {
+                        goToState(WAITING_FOR_FIX);
+                    } else {
+                        remain(1e5);
+                    }
+                    break;
+
+                case WAITING_FOR_FIX:
+                    if (!requestedActive) {
+                        goToState(IDLE);
+                    } else if (gps.hasFix()) {
+                        // the first leg runs from wherever we are when the route starts
+                        if (!route.isStarted()) {
+                            route.start(getFix());
+                        }
+                        goToState(NAVIGATING);
+                    } else {
+                        remain(1e5);
+                    }
+                    break;
+
+                case NAVIGATING:
+                    if (!requestedActive) {
+                        helm.clearCourse();
+                        publishGuidance(false, getFix());
+                        goToState(IDLE);
+                    } else if (!gps.hasFix()) {
+                        helm.clearCourse();
+                        publishGuidance(false, getFix());
+                        goToState(WAITING_FOR_FIX);
+                    } else {
+                        Position fix = getFix();
+                        if (route.update(fix)) {
+                            Debug::out.print(F("Reached waypoint "));
+                            Debug::out.println(route.getActiveWaypoint() - 1);
+                        }
+                        if (route.isComplete()) {
+                            helm.clearCourse();
+                            publishGuidance(false, fix);
+                            goToState(ARRIVED);
+                        } else {
+                            helm.setCourse(route.getDesiredHeading());
+                            publishGuidance(true, fix);
+                            remain(NAVIGATION_PERIOD);
+                        }
+                    }
+                    break;
+
+                case ARRIVED:
+                    if (!requestedActive) {
+                        goToState(IDLE);
+                    } else {
+                        remain(1e5);
+                    }
+                    break;
+
+                default:
+                    Debug::out.println("Unexpected state encountered!");
+                    goToState(ERROR);
+            }
+
+            return false;
+        }
+
+        Position Navigator::getFix() const {
+            Position fix = { gps.getLatitude(), gps.getLongitude() };
+            return fix;
+        }
+
+        void Navigator::updateHeadingReference() {
+            if (!gps.hasFix()) {
+                return;
+            }
+            // A grid past its model is not applied at all: the heading
+            // bias takes up the declination instead, once underway.
+            float year = Clock::isSynced() ? toYear(Clock::now()) : getDeclinationEpoch();
+            if (isDeclinationCurrent(year)) {
+                declination = Nav::getDeclination(getFix(), year);
+            } else {
+                declination = 0;
+                if (!declinationExpired) {
+                    declinationExpired = true;
+                    Debug::out.println(F("Declination grid is past its model's validity and not applied; regenerate it (tools/wmm_grid.py)."));
+                }
+            }
+            declinationKnown = true;
+
+            if (gps.getCourseCount() == lastCourseCount) {
+                return;
+            }
+            lastCourseCount = gps.getCourseCount();
+            IMU::Attitude attitude;
+            if (ahrs.getState() == IMU::RUNNING && ahrs.getAttitude(attitude)) {
+                float heading = attitude.heading + declination;
+                headingBias.addSample(heading, gps.getCourse(), gps.getSpeed(), attitude.rates[2]);
+            }
+        }
+
+        bool Navigator::getTrueHeading(float& heading) const {
+            IMU::Attitude attitude;
+            if (!declinationKnown || ahrs.getState() != IMU::RUNNING || !ahrs.getAttitude(attitude)) {
+                return false;
+            }
+            float trueHeading = attitude.heading + declination;
+            if (headingBias.isTrusted()) {
+                trueHeading += headingBias.getBias();
+            }
+            heading = fmodf(trueHeading + 360, 360);
+            return true;
+        }
+
+        float Navigator::getDeclination() const {
+            return declination;
+        }
+
+        const HeadingBias& Navigator::getHeadingBias() const {
+            return headingBias;
+        }
+
+        void Navigator::publishGuidance(bool navigating, const Position& fix) {
+            Guidance sample;
+            sample.time = micros();
+            sample.navigating = navigating;
+            sample.waypoint = route.getActiveWaypoint();
+            sample.fix = fix;
+            sample.track = route.getTrack();
+            sample.desiredHeading = navigating ? route.getDesiredHeading() : 0;
+            sample.heading = -1;
+            getTrueHeading(sample.heading);
+            guidance.publish(sample);
+        }
+
+        uint32_t Navigator::getGuidance(Guidance& sample) const {
+            return guidance.read(sample);
+        }
+
+        bool Navigator::addWaypoint(int32_t lat, int32_t lon) {
+            Position waypoint = { lat, lon };
+            return route.add(waypoint);
+        }
+
+        void Navigator::clearRoute() {
+            route.clear();
+            requestedActive = false;
+        }
+
+        void Navigator::setActive(bool active) {
+            if (active && !requestedActive) {
+                // (re)start from the first waypoint once there is a fix
+                route.stop();
+            }
+            requestedActive = active;
+        }
+
+        const Route& Navigator::getRoute() const {
+            return route;
+        }
+
+        String Navigator::getLogString() const {
+            String logStr(getState());
+            logStr.concat(",");
+            logStr.concat(route.getActiveWaypoint());
+            logStr.concat(",");
+            if (getState() == NAVIGATING) {
+                logStr.concat(route.getTrack().distance);
+                logStr.concat(",");
+                logStr.concat(route.getTrack().crossTrack);
+            } else {
+                logStr.concat("-,-");
+            }
+            return logStr;
+        }
+
+        void Navigator::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            record.add(route.getActiveWaypoint());
+            if (getState() == NAVIGATING) {
+                const Track& track = route.getTrack();
+                record.add(lroundf(track.distance));
+                record.add(lroundf(track.crossTrack * 10));
+                record.add(lroundf(route.getDesiredHeading() * 100));
+            } else {
+                record.add(-1);
+                record.add(-1);
+                record.add(-1);
+            }
+            record.add(lroundf(declination * 100));
+            record.add(lroundf(headingBias.getBias() * 100));
+            record.add(headingBias.getSampleCount());
+        }
+
+        const char * Navigator::getStateName(const State aState) const {
+            switch (aState) {
+                case STARTUP:
+                    return "STARTUP";
+                case ERROR:
+                    return "ERROR";
+                case IDLE:
+                    return "IDLE";
+                case WAITING_FOR_FIX:
+                    return "WAITING_FOR_FIX";
+                case NAVIGATING:
+                    return "NAVIGATING";
+                case ARRIVED:
+                    return "ARRIVED";
+                default:
+                    return "<INVALID>";
+            }
+        }
+
+    }
+
+}
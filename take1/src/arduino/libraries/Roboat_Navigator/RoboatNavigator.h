@@ -0,0 +1,128 @@
+#ifndef ROBOAT_NAVIGATOR_H
+#define ROBOAT_NAVIGATOR_H
+
+#include "Arduino.h"
+#include <RoboatStateMachine.h>
+#include <RoboatLogCodec.h>
+#include <RoboatRoute.h>
+#include <RoboatGPSManager.h>
+#include <RoboatHelm.h>
+#include <RoboatAHRS.h>
+#include <RoboatDeclination.h>
+#include <RoboatSnapshot.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        typedef enum {
+            STARTUP,
+            ERROR,
+            IDLE,
+            WAITING_FOR_FIX,
+            NAVIGATING,
+            ARRIVED
+        } State;
+
+        // Longest the Navigator may go between advances before the watchdog
+        // supervisor (RoboatWatchdog.h) counts a miss (us): the loop's worst
+        // card writes (Log::WORST_WRITE_TIME) and a couple of navigation
+        // periods.
+        const uint32_t WATCHDOG_DEADLINE = 1e6;
+
+
+        // The Navigator's latest guidance, published as a whole (see
+        // RoboatSnapshot.h) each time it tracks a fix or stops steering.
+        typedef struct {
+            uint32_t time;          // micros() when published
+            bool navigating;        // false when the Helm has no course from us
+            uint8_t waypoint;       // active waypoint
+            Position fix;           // position tracked
+            Track track;            // against the active leg
+            float desiredHeading;   // degrees
+            float heading;          // true heading (getTrueHeading()), -1 if unknown
+        } Guidance;
+
+
+        // Follows the route: tracks each GPS fix against the active leg and
+        // gives the Helm the heading to steer. Also turns the AHRS's magnetic
+        // heading into a true one, with the declination at the last fix and
+        // the bias learned against the GPS course (RoboatDeclination.h). The
+        // declination is 0 once the grid's model has expired, leaving it to
+        // the bias.
+        class Navigator : public StateMachine<State, Navigator> {
+
+            GPS::Manager& gps;
+            IMU::AHRS& ahrs;
+            Conn::Helm& helm;
+
+            // declination at the last fix (degrees), and the course over
+            // ground less the corrected heading
+            float declination;
+            bool declinationKnown;
+            bool declinationExpired;        // past the grid's model, so not applied (reported once)
+            HeadingBias headingBias;
+            uint32_t lastCourseCount;
+
+            Route route;
+            bool requestedActive;
+
+            Snapshot<Guidance> guidance;
+
+            Position getFix() const;
+
+            // Publish the guidance just given to the Helm.
+            void publishGuidance(bool navigating, const Position& fix);
+
+            // Look up the declination for the current fix, and feed a new GPS
+            // course to the heading bias estimate.
+            void updateHeadingReference();
+
+        public:
+            Navigator(GPS::Manager& gpsManager, IMU::AHRS& theAHRS, Conn::Helm& theHelm);
+
+            // Advance the state machine.
+            bool update();
+
+            const char * getStateName(const State aState) const;
+
+            // Append a waypoint (degrees x 1e7) to the route. Returns false if
+            // the route is full.
+            bool addWaypoint(int32_t lat, int32_t lon);
+
+            // Stop and remove all waypoints.
+            void clearRoute();
+
+            // Set to true to follow the route from the start, false to stop.
+            void setActive(bool active);
+
+            const Route& getRoute() const;
+
+            // The AHRS heading corrected to true: magnetic heading plus
+            // declination (if the grid is current), plus the GPS course bias
+            // once it is trusted.
+            // Returns false (and leaves `heading` alone) while the AHRS is not
+            // running or there has been no fix to look up the declination.
+            bool getTrueHeading(float& heading) const;
+
+            float getDeclination() const;
+            const HeadingBias& getHeadingBias() const;
+
+            // Copy the latest guidance. Safe to call from an interrupt handler.
+            // Returns the number published so far, 0 if there has been none.
+            uint32_t getGuidance(Guidance& sample) const;
+
+            String getLogString() const;
+
+            // active waypoint, distance to it (m), cross-track error (dm) and
+            // desired heading (hundredths of a degree), -1 when not navigating;
+            // declination and heading bias (hundredths of a degree) and the
+            // samples behind the bias
+            void addLogFields(Log::Record& record) const;
+        };
+
+    }
+
+}
+
+#endif
\ No newline at end of file
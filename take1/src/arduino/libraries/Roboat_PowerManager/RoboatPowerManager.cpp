@@ -4,8 +4,11 @@
 
 namespace Roboat {
 
-    // reset after 10s on error
-    const uint32_t ERROR_RESET_DELAY = 10e6;
+    // retry after faults from 2ms, backing off to 10s; 100 good
+    // measurements in a row start the backoff again from the shortest delay
+    const uint32_t RETRY_INITIAL_DELAY = 2e3;
+    const uint32_t RETRY_MAX_DELAY = 10e6;
+    const uint16_t BACKOFF_RESET_MEASUREMENTS = 100;
 
     const uint32_t RUNNING_UPDATE_INTERVAL = 10e4;
 
@@ -19,20 +22,32 @@ namespace Roboat {
     namespace Power {
 
         Manager::Manager(const DigitalIn& chargerPGPin, const DigitalIn& chargerStat1Pin, const DigitalIn& chargerStat2Pin,
-            i2c_t3& ina219Wire, int ina219Address) :
+            I2C::Bus& ina219Bus, int ina219Address) :
             StateMachine(STARTUP, "Power"),
-            powerMonitor(ina219Address, ina219Wire),
+            bus(ina219Bus),
+            powerMonitor(ina219Address, ina219Bus.getWire()),
+            backoff(RETRY_INITIAL_DELAY, RETRY_MAX_DELAY),
+            goodMeasurements(0),
             chargerPG(chargerPGPin), chargerStat1(chargerStat1Pin), chargerStat2(chargerStat2Pin)
         {}
 
         bool Manager::update() {
             switch (getState()) {
                 case STARTUP:
+                    bus.begin();
                     goToState(ACTIVATING, 10);
                     break;
 
                 case ERROR:
-                    goToState(STARTUP, ERROR_RESET_DELAY);
+                    goToState(ACTIVATING, backoff.next());
+                    break;
+
+                case RECOVERING:
+                    // the INA219 is reconfigured from scratch when reconnecting
+                    if (!bus.recover()) {
+                        Debug::out.println("Power monitor bus still stuck after recovery.");
+                    }
+                    goToState(ACTIVATING, backoff.next());
                     break;
 
                 case ACTIVATING:
@@ -51,7 +66,7 @@ namespace Roboat {
                     break;
                 
                 default:
-                    Serial.println("Unexpected state encountered!");
+                    Debug::out.println("Unexpected state encountered!");
                     goToState(ERROR);
             }
 
@@ -89,10 +104,20 @@ namespace Roboat {
         void Manager::measurePowerState() {
             voltage = powerMonitor.getBusVoltage_V();
             current = -1 * powerMonitor.getCurrent_mA();    // Roboat α current sense wired backwards
-            if (voltage < MIN_VALID_VOLTAGE || voltage > MAX_VALID_VOLTAGE ||
+            if (!bus.check()) {
+                goodMeasurements = 0;
+                goToState(RECOVERING);
+            } else if (voltage < MIN_VALID_VOLTAGE || voltage > MAX_VALID_VOLTAGE ||
                 current < MIN_VALID_CURRENT || current > MAX_VALID_CURRENT) 
             {
+                goodMeasurements = 0;
                 goToState(ERROR);
+            } else {
+                markReady();
+                if (++goodMeasurements >= BACKOFF_RESET_MEASUREMENTS) {
+                    goodMeasurements = 0;
+                    backoff.reset();
+                }
             }
         }
 
@@ -126,6 +151,8 @@ namespace Roboat {
                     return "CHARGING";
                 case MAINTAINING:
                     return "MAINTAINING";
+                case RECOVERING:
+                    return "RECOVERING";
 
                 default:
                     return "<INVALID>";
@@ -140,6 +167,12 @@ namespace Roboat {
             logStr.concat(String(getCurrent(), 8));        
             return logStr;
         }
+
+        void Manager::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            record.add(lroundf(getVoltage() * 1000));
+            record.add(lroundf(getCurrent() * 10));
+        }
     }
 
 }
\ No newline at end of file
@@ -6,6 +6,8 @@
 #include "SafetyPin.h"
 #include <i2c_t3.h>
 #include <Adafruit_INA219.h>
+#include <RoboatLogCodec.h>
+#include <RoboatI2CBus.h>
 
 
 namespace Roboat {
@@ -20,14 +22,26 @@ namespace Roboat {
             NO_BATTERY,         // externally powered, but no battery detected
             BATTERY,            // running exclusively on battery
             CHARGING,           // battery is charging (or possibly supplementing external power)
-            MAINTAINING         // battery fully charged and being maintained
+            MAINTAINING,        // battery fully charged and being maintained
+            RECOVERING          // releasing the bus after a fault, before reconnecting to the power monitor
         } State;
 
+        // Longest the power manager may go between advances before the
+        // watchdog supervisor (RoboatWatchdog.h) counts a miss (us), allowing
+        // for the loop's worst card writes (Log::WORST_WRITE_TIME). Battery
+        // state changes slowly, so a few missed samples do no harm.
+        const uint32_t WATCHDOG_DEADLINE = 15e5;
+
 
         class Manager : public StateMachine<State, Manager> {
 
+            I2C::Bus& bus;
             Adafruit_INA219 powerMonitor;
 
+            // retries after faults, and the measurements since the last one
+            I2C::Backoff backoff;
+            uint16_t goodMeasurements;
+
             const DigitalIn& chargerPG;
             const DigitalIn& chargerStat1;
             const DigitalIn& chargerStat2;
@@ -40,7 +54,7 @@ namespace Roboat {
             
         public:
             Manager(const DigitalIn& chargerPGPin, const DigitalIn& chargerStat1Pin, const DigitalIn& chargerStat2Pin,
-                i2c_t3& ina219Wire, int ina219Address);
+                I2C::Bus& ina219Bus, int ina219Address);
             
             bool update();
             const char * getStateName(const State aState) const;
@@ -50,6 +64,9 @@ namespace Roboat {
             float getPower() const;
 
             String getLogString() const;
+
+            // voltage in mV, current in tenths of a mA
+            void addLogFields(Log::Record& record) const;
     
         };
             
@@ -0,0 +1,154 @@
+#include "RoboatRateGovernor.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace Roboat {
+
+    namespace IMU {
+
+        // time constant of the motion statistics (s)
+        const float STATISTICS_TIME = 1.0F;
+
+        // Deviations above which each faster rate is needed: slow rolling at
+        // a mooring is comfortably followed at 25Hz, but chop or a steering
+        // correction needs 50Hz, and pounding or a sharp turn needs 100Hz.
+        const float GYRO_THRESHOLDS[RATE_COUNT] = { 0.0F, 5.0F, 15.0F };     // deg/s
+        const float ACCEL_THRESHOLDS[RATE_COUNT] = { 0.0F, 0.3F, 1.0F };    // m/s^2
+
+        // come down a step only once the deviations have stayed below this
+        // fraction of the current rate's thresholds for HOLD_TIME (us)
+        const float DOWN_MARGIN = 0.6F;
+        const uint32_t HOLD_TIME = 5e6;
+
+        // gaps longer than this (us) are treated as this long, so a stall
+        // does not flush the statistics
+        const uint32_t MAX_GAP = 2e5;
+
+        const float FREQUENCIES[RATE_COUNT] = { 25.0F, 50.0F, 100.0F };
+        const uint32_t PERIODS[RATE_COUNT] = { 40000, 20000, 10000 };
+
+
+        float getFrequency(Rate rate) {
+            return FREQUENCIES[rate];
+        }
+
+        uint32_t getPeriod(Rate rate) {
+            return PERIODS[rate];
+        }
+
+
+        RateGovernor::RateGovernor() :
+            minimumRate(RATE_25HZ)
+        {
+            reset(RATE_100HZ);
+        }
+
+        void RateGovernor::reset(Rate initialRate) {
+            rate = initialRate < minimumRate ? minimumRate : initialRate;
+            started = false;
+            lastTime = 0;
+            calmSince = 0;
+            memset(gyroMean, 0, sizeof(gyroMean));
+            memset(gyroVariance, 0, sizeof(gyroVariance));
+            accelMean = 0;
+            accelVariance = 0;
+            changes = 0;
+            memset(timeAt, 0, sizeof(timeAt));
+        }
+
+        void RateGovernor::setMinimumRate(Rate aRate) {
+            minimumRate = aRate;
+        }
+
+        bool RateGovernor::addSample(uint32_t time, const float rates[3], const float accel[3]) {
+            float magnitude = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+            if (!started) {
+                // seed the means, so the first samples do not look like motion
+                memcpy(gyroMean, rates, sizeof(gyroMean));
+                accelMean = magnitude;
+                lastTime = time;
+                calmSince = time;
+                started = true;
+            }
+
+            uint32_t gap = time - lastTime;
+            if (gap > MAX_GAP) {
+                gap = MAX_GAP;
+            }
+            timeAt[rate] += (gap + 500) / 1000;
+            lastTime = time;
+
+            // exponentially weighted mean and variance, weighted by time so
+            // the window is the same at every rate
+            float dt = gap * 1e-6F;
+            float alpha = dt / (STATISTICS_TIME + dt);
+            for (uint8_t i = 0; i < 3; i++) {
+                float deviation = rates[i] - gyroMean[i];
+                gyroMean[i] += alpha * deviation;
+                gyroVariance[i] = (1 - alpha) * (gyroVariance[i] + alpha * deviation * deviation);
+            }
+            float deviation = magnitude - accelMean;
+            accelMean += alpha * deviation;
+            accelVariance = (1 - alpha) * (accelVariance + alpha * deviation * deviation);
+
+            Rate previous = rate;
+            Rate needed = getNeededRate(1.0F);
+            if (needed > rate) {
+                rate = needed;
+            } else if (getNeededRate(DOWN_MARGIN) >= rate) {
+                calmSince = time;
+            } else if (time - calmSince >= HOLD_TIME) {
+                rate = Rate(rate - 1);
+                calmSince = time;
+            }
+            if (rate < minimumRate) {
+                rate = minimumRate;
+            }
+
+            if (rate != previous) {
+                calmSince = time;
+                changes++;
+                return true;
+            }
+            return false;
+        }
+
+        Rate RateGovernor::getNeededRate(float margin) const {
+            float gyro = getGyroDeviation();
+            float accel = getAccelDeviation();
+            for (uint8_t r = RATE_COUNT - 1; r > 0; r--) {
+                if (gyro > GYRO_THRESHOLDS[r] * margin || accel > ACCEL_THRESHOLDS[r] * margin) {
+                    return Rate(r);
+                }
+            }
+            return RATE_25HZ;
+        }
+
+        Rate RateGovernor::getRate() const {
+            return rate;
+        }
+
+        Rate RateGovernor::getMinimumRate() const {
+            return minimumRate;
+        }
+
+        float RateGovernor::getGyroDeviation() const {
+            return sqrtf(gyroVariance[0] + gyroVariance[1] + gyroVariance[2]);
+        }
+
+        float RateGovernor::getAccelDeviation() const {
+            return sqrtf(accelVariance);
+        }
+
+        uint32_t RateGovernor::getChangeCount() const {
+            return changes;
+        }
+
+        uint32_t RateGovernor::getTimeAt(Rate aRate) const {
+            return timeAt[aRate];
+        }
+
+    }
+
+}
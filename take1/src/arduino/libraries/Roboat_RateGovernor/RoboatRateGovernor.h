@@ -0,0 +1,86 @@
+#ifndef ROBOAT_RATEGOVERNOR_H
+#define ROBOAT_RATEGOVERNOR_H
+
+#include <stdint.h>
+
+namespace Roboat {
+
+    namespace IMU {
+
+        // IMU sample rates, each one available from both the FXAS21002C and
+        // the FXOS8700 (in hybrid accel/mag mode).
+        typedef enum {
+            RATE_25HZ,
+            RATE_50HZ,
+            RATE_100HZ
+        } Rate;
+
+        const uint8_t RATE_COUNT = 3;
+
+        // samples per second, and the period between them (us)
+        float getFrequency(Rate rate);
+        uint32_t getPeriod(Rate rate);
+
+
+        // Chooses the IMU sample rate from how much the boat is moving.
+        //
+        // Tracks the variance of each gyro axis and of the acceleration
+        // magnitude over roughly the last second. The rate goes up as soon as
+        // either deviation passes the threshold for a faster rate, and comes
+        // down one step at a time once both have stayed well under the
+        // threshold for the current rate for a few seconds. The caller may
+        // set a minimum rate (e.g. while the Helm is steering), which takes
+        // effect at once.
+        //
+        // Works in sample timestamps only, so it runs the same on the host.
+        class RateGovernor {
+            Rate rate;
+            Rate minimumRate;
+
+            bool started;
+            uint32_t lastTime;
+            uint32_t calmSince;     // since when a slower rate would do
+
+            float gyroMean[3];      // deg/s
+            float gyroVariance[3];
+            float accelMean;        // m/s^2
+            float accelVariance;
+
+            uint32_t changes;
+            uint32_t timeAt[RATE_COUNT];    // ms spent at each rate
+
+            // the slowest rate for the current deviations, with the
+            // thresholds scaled by `margin`
+            Rate getNeededRate(float margin) const;
+
+        public:
+            RateGovernor();
+
+            // Start over at the given rate, forgetting the motion seen so far.
+            void reset(Rate initialRate);
+
+            // Never choose a rate below `rate` (RATE_25HZ to lift the floor).
+            void setMinimumRate(Rate rate);
+
+            // Add a sample: body rates (deg/s) and accelerations (m/s^2), read
+            // at `time` (us). Returns true if the rate changed.
+            bool addSample(uint32_t time, const float rates[3], const float accel[3]);
+
+            Rate getRate() const;
+            Rate getMinimumRate() const;
+
+            // standard deviation of the body rates (deg/s, all axes together)
+            // and of the acceleration magnitude (m/s^2)
+            float getGyroDeviation() const;
+            float getAccelDeviation() const;
+
+            // rate changes, and time spent at a rate (ms), since the last reset
+            uint32_t getChangeCount() const;
+            uint32_t getTimeAt(Rate rate) const;
+        };
+
+    }
+
+}
+
+#endif
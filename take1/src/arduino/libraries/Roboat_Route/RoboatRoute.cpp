@@ -0,0 +1,276 @@
+#include "RoboatRoute.h"
+
+#include <math.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        // WGS84 semi-major axis (m) and first eccentricity squared
+        const float WGS84_A = 6378137.0F;
+        const float WGS84_E2 = 6.69437999e-3F;
+
+        const float DEG_PER_RAD = 180.0F / (float)M_PI;
+
+        // legs shorter than this have no meaningful direction (m)
+        const float MIN_LEG_LENGTH = 0.01F;
+
+        // a full circle of longitude, in degrees x 1e7
+        const int64_t FULL_CIRCLE = 360LL * UNITS_PER_DEGREE;
+
+        const char* parseDegrees(const char* text, int32_t& value) {
+            const char* p = text;
+            bool negative = false;
+            if (*p == '-' || *p == '+') {
+                negative = (*p == '-');
+                p++;
+            }
+
+            uint32_t whole = 0;
+            uint8_t wholeDigits = 0;
+            while (*p >= '0' && *p <= '9') {
+                whole = whole * 10 + (*p++ - '0');
+                if (++wholeDigits > 3) {
+                    return NULL;
+                }
+            }
+
+            // seven places, plus one more for rounding
+            uint32_t fraction = 0;
+            uint8_t places = 0;
+            bool roundUp = false;
+            if (*p == '.') {
+                p++;
+                while (*p >= '0' && *p <= '9') {
+                    if (places < 7) {
+                        fraction = fraction * 10 + (*p - '0');
+                        places++;
+                    } else if (places == 7) {
+                        roundUp = (*p >= '5');
+                        places++;
+                    }
+                    p++;
+                }
+            }
+            if (wholeDigits == 0 && places == 0) {
+                return NULL;
+            }
+            for (uint8_t i = places; i < 7; i++) {
+                fraction *= 10;
+            }
+
+            if (whole > 180) {
+                return NULL;
+            }
+            uint32_t magnitude = whole * uint32_t(UNITS_PER_DEGREE) + fraction + (roundUp ? 1 : 0);
+            if (magnitude > 180UL * UNITS_PER_DEGREE) {
+                return NULL;
+            }
+            value = negative ? -int32_t(magnitude) : int32_t(magnitude);
+            return p;
+        }
+
+        size_t formatDegrees(int32_t value, char* out) {
+            size_t n = 0;
+            uint32_t magnitude = value < 0 ? -uint32_t(value) : uint32_t(value);
+            if (value < 0) {
+                out[n++] = '-';
+            }
+
+            uint32_t whole = magnitude / UNITS_PER_DEGREE;
+            uint32_t fraction = magnitude % UNITS_PER_DEGREE;
+            char digits[10];
+            uint8_t count = 0;
+            do {
+                digits[count++] = '0' + whole % 10;
+                whole /= 10;
+            } while (whole > 0);
+            while (count > 0) {
+                out[n++] = digits[--count];
+            }
+
+            out[n++] = '.';
+            for (int8_t i = 6; i >= 0; i--) {
+                out[n + i] = '0' + fraction % 10;
+                fraction /= 10;
+            }
+            n += 7;
+            out[n] = '\0';
+            return n;
+        }
+
+        int32_t longitudeDifference(int32_t a, int32_t b) {
+            int64_t difference = int64_t(a) - b;
+            if (difference > FULL_CIRCLE / 2) {
+                difference -= FULL_CIRCLE;
+            } else if (difference < -FULL_CIRCLE / 2) {
+                difference += FULL_CIRCLE;
+            }
+            return int32_t(difference);
+        }
+
+        static float normalizeBearing(float bearing) {
+            if (bearing < 0) {
+                bearing += 360.0F;
+            } else if (bearing >= 360.0F) {
+                bearing -= 360.0F;
+            }
+            return bearing;
+        }
+
+
+        Leg::Leg() {
+            Position origin = { 0, 0 };
+            set(origin, origin);
+        }
+
+        void Leg::set(const Position& start, const Position& end) {
+            from = start;
+
+            // meridional and prime vertical radii of curvature at the leg's mean latitude
+            const float meanLat = 0.5F * (float(start.lat) + float(end.lat)) / UNITS_PER_DEGREE / DEG_PER_RAD;
+            const float sinLat = sinf(meanLat);
+            const float w = 1.0F - WGS84_E2 * sinLat * sinLat;
+            const float primeVertical = WGS84_A / sqrtf(w);
+            const float meridional = primeVertical * (1.0F - WGS84_E2) / w;
+            metresPerUnitLat = meridional / DEG_PER_RAD / UNITS_PER_DEGREE;
+            metresPerUnitLon = primeVertical * cosf(meanLat) / DEG_PER_RAD / UNITS_PER_DEGREE;
+
+            east = longitudeDifference(end.lon, start.lon) * metresPerUnitLon;
+            north = (end.lat - start.lat) * metresPerUnitLat;
+            length = sqrtf(east * east + north * north);
+            if (length >= MIN_LEG_LENGTH) {
+                unitEast = east / length;
+                unitNorth = north / length;
+                bearing = normalizeBearing(atan2f(east, north) * DEG_PER_RAD);
+            } else {
+                unitEast = 0;
+                unitNorth = 0;
+                bearing = 0;
+            }
+        }
+
+        void Leg::track(const Position& position, Track& result) const {
+            // position relative to the start of the leg, then to its end
+            const float x = longitudeDifference(position.lon, from.lon) * metresPerUnitLon;
+            const float y = (position.lat - from.lat) * metresPerUnitLat;
+            const float toEast = east - x;
+            const float toNorth = north - y;
+
+            result.distance = sqrtf(toEast * toEast + toNorth * toNorth);
+            result.bearing = normalizeBearing(atan2f(toEast, toNorth) * DEG_PER_RAD);
+            result.crossTrack = x * unitNorth - y * unitEast;
+            result.alongTrack = x * unitEast + y * unitNorth;
+        }
+
+        float Leg::getLength() const {
+            return length;
+        }
+
+        float Leg::getBearing() const {
+            return bearing;
+        }
+
+
+        Route::Route() :
+            count(0),
+            active(0),
+            started(false),
+            arrivalRadius(DEFAULT_ARRIVAL_RADIUS)
+        {
+            current.distance = 0;
+            current.bearing = 0;
+            current.crossTrack = 0;
+            current.alongTrack = 0;
+        }
+
+        void Route::clear() {
+            count = 0;
+            stop();
+        }
+
+        bool Route::add(const Position& waypoint) {
+            if (count >= MAX_WAYPOINTS) {
+                return false;
+            }
+            waypoints[count++] = waypoint;
+            return true;
+        }
+
+        uint8_t Route::size() const {
+            return count;
+        }
+
+        const Position& Route::getWaypoint(uint8_t index) const {
+            return waypoints[index];
+        }
+
+        void Route::setArrivalRadius(float radius) {
+            arrivalRadius = radius;
+        }
+
+        void Route::beginLeg(const Position& start) {
+            leg.set(start, waypoints[active]);
+            leg.track(start, current);
+        }
+
+        void Route::start(const Position& position) {
+            active = 0;
+            started = true;
+            if (count > 0) {
+                beginLeg(position);
+            }
+        }
+
+        bool Route::isStarted() const {
+            return started;
+        }
+
+        void Route::stop() {
+            active = 0;
+            started = false;
+        }
+
+        bool Route::update(const Position& position) {
+            if (!started || isComplete()) {
+                return false;
+            }
+
+            leg.track(position, current);
+            if (current.distance > arrivalRadius && current.alongTrack < leg.getLength()) {
+                return false;
+            }
+
+            // reached (or passed) the active waypoint
+            active++;
+            if (!isComplete()) {
+                beginLeg(waypoints[active - 1]);
+                leg.track(position, current);
+            }
+            return true;
+        }
+
+        bool Route::isComplete() const {
+            return started && active >= count;
+        }
+
+        uint8_t Route::getActiveWaypoint() const {
+            return active;
+        }
+
+        const Leg& Route::getLeg() const {
+            return leg;
+        }
+
+        const Track& Route::getTrack() const {
+            return current;
+        }
+
+        float Route::getDesiredHeading() const {
+            float correction = atanf(current.crossTrack / TRACK_LOOKAHEAD) * DEG_PER_RAD;
+            return normalizeBearing(leg.getBearing() - correction);
+        }
+
+    }
+
+}
@@ -0,0 +1,156 @@
+#ifndef ROBOAT_ROUTE_H
+#define ROBOAT_ROUTE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Roboat {
+
+    namespace Nav {
+
+        // Upper bound on the number of waypoints in a route.
+        const uint8_t MAX_WAYPOINTS = 32;
+
+        // Default distance from a waypoint within which it counts as reached (m).
+        const float DEFAULT_ARRIVAL_RADIUS = 10.0F;
+
+        // Distance ahead along the leg at which the boat aims when steering
+        // back onto the track line (m). Shorter converges faster but more
+        // aggressively.
+        const float TRACK_LOOKAHEAD = 25.0F;
+
+
+        // Positions are fixed point, in units of 1e-7 degree (about 1.1 cm).
+        // Every angle on the globe fits in an int32_t, and differences
+        // between nearby positions are exact.
+        const int32_t UNITS_PER_DEGREE = 10000000;
+
+        // A geographic position (WGS84) in degrees x 1e7.
+        typedef struct {
+            int32_t lat;
+            int32_t lon;
+        } Position;
+
+        // Parse a decimal degree value ("-122.3456789") into degrees x 1e7
+        // without going through floating point. Digits beyond the seventh
+        // decimal place are rounded. Returns a pointer to the first character
+        // not parsed, or NULL if there is no valid value.
+        const char* parseDegrees(const char* text, int32_t& value);
+
+        // Write degrees x 1e7 as a decimal degree value with seven places,
+        // NUL-terminated. `out` needs room for 13 characters. Returns the
+        // length written.
+        size_t formatDegrees(int32_t value, char* out);
+
+        // Longitude difference a - b (degrees x 1e7), taking the shorter way
+        // around across the antimeridian.
+        int32_t longitudeDifference(int32_t a, int32_t b);
+
+
+        // Where a position lies relative to a leg. Distances are in metres,
+        // bearings in degrees clockwise from true north.
+        typedef struct {
+            float distance;         // to the end of the leg
+            float bearing;          // to the end of the leg
+            float crossTrack;       // from the leg's track line, positive to the right
+            float alongTrack;       // progress along the leg from its start
+        } Track;
+
+
+        // One leg of a route, with everything that depends only on its end
+        // points computed once when it is set.
+        //
+        // Positions are projected onto a local tangent plane at the start of
+        // the leg (equirectangular, scaled by the WGS84 radii of curvature at
+        // the leg's mean latitude). Offsets from the start of the leg are
+        // exact integer differences, so tracking a position costs a couple of
+        // multiplies, a square root and an atan2 in single precision. Over the
+        // few kilometres of a typical leg the projection is good to well under
+        // a metre and a tenth of a degree; the error grows with the square of
+        // the distance from the leg.
+        class Leg {
+            Position from;
+            float metresPerUnitLat;
+            float metresPerUnitLon;
+            float east;             // leg vector (m)
+            float north;
+            float length;           // (m)
+            float unitEast;         // leg direction
+            float unitNorth;
+            float bearing;          // (deg)
+
+        public:
+            Leg();
+
+            void set(const Position& start, const Position& end);
+
+            void track(const Position& position, Track& result) const;
+
+            float getLength() const;
+            float getBearing() const;
+        };
+
+
+        // A list of waypoints and the progress along them.
+        //
+        // The first leg runs from wherever the route is started to the first
+        // waypoint. A waypoint is reached when the boat comes within the
+        // arrival radius of it, or passes the line through it perpendicular to
+        // the leg (so a waypoint missed by more than the radius does not have
+        // the boat circling back to it); the next leg then begins.
+        class Route {
+            Position waypoints[MAX_WAYPOINTS];
+            uint8_t count;
+            uint8_t active;         // index of the waypoint being steered for
+            bool started;
+            float arrivalRadius;
+
+            Leg leg;
+            Track current;
+
+            void beginLeg(const Position& start);
+
+        public:
+            Route();
+
+            // Remove all waypoints and stop.
+            void clear();
+
+            // Append a waypoint. Returns false if the route is full.
+            bool add(const Position& waypoint);
+
+            uint8_t size() const;
+            const Position& getWaypoint(uint8_t index) const;
+
+            void setArrivalRadius(float radius);
+
+            // Start the route from the given position, towards the first waypoint.
+            void start(const Position& position);
+            bool isStarted() const;
+
+            // Stop following the route, keeping its waypoints.
+            void stop();
+
+            // Track a new position, moving on to the next leg when the active
+            // waypoint is reached. Returns true if the active waypoint changed.
+            bool update(const Position& position);
+
+            // True once the last waypoint has been reached.
+            bool isComplete() const;
+
+            uint8_t getActiveWaypoint() const;
+            const Leg& getLeg() const;
+
+            // Position relative to the active leg, as of the last update().
+            const Track& getTrack() const;
+
+            // Heading to steer to follow the active leg: the leg bearing,
+            // turned back towards the track line by the cross-track error.
+            float getDesiredHeading() const;
+        };
+
+    }
+
+}
+
+#endif
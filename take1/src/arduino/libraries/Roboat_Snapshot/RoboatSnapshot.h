@@ -0,0 +1,69 @@
+#ifndef ROBOAT_SNAPSHOT_H
+#define ROBOAT_SNAPSHOT_H
+
+#include <stdint.h>
+
+namespace Roboat {
+
+    // A value published by one writer and read whole by any number of
+    // readers, without locks or disabling interrupts.
+    //
+    // The value is double buffered with a sequence count: publish() fills
+    // the buffer readers are not using and then bumps the count, which
+    // switches them over. A read copies the current buffer and checks the
+    // count afterwards; only if the writer published twice during the copy
+    // (so the second publish reused the buffer being copied) does it retry.
+    //
+    // This is for a single core, where the writer and the readers may
+    // interrupt each other. A reader in an interrupt handler never retries,
+    // since the writer cannot make progress under it; a reader in the main
+    // loop retries only if it is interrupted by two publishes in one copy.
+    // Either way a read costs one copy of the value in practice.
+    template <typename T>
+    class Snapshot {
+        T buffers[2];
+        volatile uint32_t sequence;     // publishes so far; buffers[sequence & 1] is current
+
+        static inline void barrier() {
+            __asm__ volatile ("" ::: "memory");
+        }
+
+    public:
+        Snapshot() :
+            buffers(),
+            sequence(0)
+        {}
+
+        // Make a new value current. Only one context may publish.
+        void publish(const T& value) {
+            uint32_t next = sequence + 1;
+            buffers[next & 1] = value;
+            barrier();
+            sequence = next;
+        }
+
+        // Copy the current value into `value`. Returns its sequence number
+        // (0 until the first publish), so readers can tell new values from
+        // ones they have seen.
+        uint32_t read(T& value) const {
+            uint32_t before;
+            uint32_t after;
+            do {
+                before = sequence;
+                barrier();
+                value = buffers[before & 1];
+                barrier();
+                after = sequence;
+            } while (after - before > 1);
+            return before;
+        }
+
+        // Sequence number of the current value.
+        uint32_t getSequence() const {
+            return sequence;
+        }
+    };
+
+}
+
+#endif
@@ -0,0 +1,7 @@
+#include "RoboatStateMachine.h"
+
+namespace Roboat {
+
+    Liveness* volatile Liveness::active = NULL;
+
+}
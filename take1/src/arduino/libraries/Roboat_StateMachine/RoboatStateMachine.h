@@ -2,9 +2,28 @@
 #define ROBOATSTATEMACHINE_H
 
 #include "Arduino.h"
+#include <RoboatClock.h>
+#include <RoboatDebug.h>
 
 namespace Roboat {
-    
+
+    // How a state machine is keeping up, for the watchdog supervisor
+    // (RoboatWatchdog.h): when it was last advanced, the longest it has gone
+    // between advances, and its slowest update, since the supervisor last
+    // looked; and whether it has finished starting up.
+    struct Liveness {
+        const char * name;
+        uint32_t lastAdvanceTime;   // us
+        uint32_t longestGap;        // us
+        uint32_t longestUpdate;     // us
+        uint8_t state;              // state of the update in progress
+        bool ready;                 // see StateMachine::markReady
+
+        // The machine whose update() is running, if any. Read by the
+        // watchdog's early-warning interrupt to name a department that hangs.
+        static Liveness* volatile active;
+    };
+
     template <typename StateEnum, typename MachineC>
     class StateMachine {
         StateEnum state;
@@ -12,12 +31,18 @@ namespace Roboat {
         uint32_t lastUpdateTime;
         uint32_t nextUpdateTime;
         uint32_t stateEntryTime;
+        uint32_t readyTime;
         const char * name;
+        Liveness liveness;
 
     protected:
         void goToState(StateEnum newState, uint32_t transitionDelay = 0);
         void remain(uint32_t recheckDelay = 0);
 
+        // Record that the machine has finished starting up. Only the first
+        // call counts.
+        void markReady();
+
     public:
         StateMachine(StateEnum initialState, const char * machineName);
         
@@ -33,6 +58,12 @@ namespace Roboat {
         StateEnum getState() const;
         
         const char * getStateName(const StateEnum aState) const;
+
+        // micros() at which the machine first became ready (see markReady),
+        // i.e. its time to ready since reset, or 0 if it is not ready yet.
+        uint32_t getReadyTime() const;
+
+        Liveness& getLiveness();
     };
 
     template<typename StateEnum, typename MachineC>
@@ -40,8 +71,16 @@ namespace Roboat {
         state(initialState),
         nextState(initialState),
         lastUpdateTime(10), nextUpdateTime(0), stateEntryTime(10),
+        readyTime(0),
         name(machineName)        
-    {}
+    {
+        liveness.name = machineName;
+        liveness.lastAdvanceTime = 0;
+        liveness.longestGap = 0;
+        liveness.longestUpdate = 0;
+        liveness.state = initialState;
+        liveness.ready = false;
+    }
 
     template<typename StateEnum, typename MachineC>
     void StateMachine<StateEnum, MachineC>::goToState(StateEnum newState, uint32_t transitionDelay) {
@@ -54,6 +93,24 @@ namespace Roboat {
         goToState(state, recheckDelay);
     }
 
+    template<typename StateEnum, typename MachineC>
+    void StateMachine<StateEnum, MachineC>::markReady() {
+        if (readyTime == 0) {
+            uint32_t now = micros();
+            readyTime = now ? now : 1;
+            liveness.ready = true;
+            Debug::out.print(name);
+            Debug::out.print(" ready after ");
+            Debug::out.print(readyTime / 1000);
+            Debug::out.println("ms");
+        }
+    }
+
+    template<typename StateEnum, typename MachineC>
+    uint32_t StateMachine<StateEnum, MachineC>::getReadyTime() const {
+        return readyTime;
+    }
+
     template<typename StateEnum, typename MachineC>
     uint32_t StateMachine<StateEnum, MachineC>::getTimeInState() const {
         return lastUpdateTime-stateEntryTime;
@@ -66,24 +123,47 @@ namespace Roboat {
 
     template<typename StateEnum, typename MachineC>
     bool StateMachine<StateEnum, MachineC>::advance(const uint32_t now) {
+        uint32_t gap = now - liveness.lastAdvanceTime;
+        if (gap > liveness.longestGap) {
+            liveness.longestGap = gap;
+        }
+        liveness.lastAdvanceTime = now;
+
         if (now < nextUpdateTime) {
             return false;
         } else if (nextState != state) {
-            Serial.print(name);
-            Serial.print(" state ");
-            Serial.print(getStateName(state));
-            Serial.print(" => ");
-            Serial.print(getStateName(nextState));
-            Serial.print(" (");
-            Serial.print((now-stateEntryTime)/1000);
-            Serial.println("ms in state)");
+            Debug::out.print(name);
+            Debug::out.print(" state ");
+            Debug::out.print(getStateName(state));
+            Debug::out.print(" => ");
+            Debug::out.print(getStateName(nextState));
+            Debug::out.print(" (");
+            Debug::out.print((now-stateEntryTime)/1000);
+            Debug::out.print("ms in state)");
+            if (Clock::isSynced()) {
+                char utc[28];
+                Clock::formatTime(Clock::toUtc(now), utc);
+                Debug::out.print(" at ");
+                Debug::out.print(utc);
+            }
+            Debug::out.println();
             state = nextState;
             stateEntryTime = now;
         }
 
         lastUpdateTime = now;
+
+        liveness.state = state;
+        Liveness::active = &liveness;
+        uint32_t start = micros();
+        bool changed = static_cast<MachineC*>(this)->update();
+        uint32_t duration = micros() - start;
+        Liveness::active = NULL;
+        if (duration > liveness.longestUpdate) {
+            liveness.longestUpdate = duration;
+        }
     
-        return static_cast<MachineC*>(this)->update();
+        return changed;
     }
 
     template<typename StateEnum, typename MachineC>
@@ -91,6 +171,11 @@ namespace Roboat {
         return static_cast<const MachineC*>(this)->getStateName(aState);
     }
 
+    template<typename StateEnum, typename MachineC>
+    Liveness& StateMachine<StateEnum, MachineC>::getLiveness() {
+        return liveness;
+    }
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "RoboatStore.h"
+
+#include <EEPROM.h>
+
+namespace Roboat {
+
+    namespace Persist {
+
+        static const uint8_t RECORD_MAGIC = 0xA5;
+        static const uint8_t HEADER_SIZE = 8;
+        static const uint8_t CRC_SIZE = 2;
+        static const uint8_t ALIGNMENT = 4;
+
+        static uint16_t recordSize(uint8_t length) {
+            return (HEADER_SIZE + length + CRC_SIZE + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+
+        // CRC-16/CCITT of EEPROM bytes [address, address + length)
+        static uint16_t crc16(uint16_t address, uint16_t length) {
+            uint16_t crc = 0xFFFF;
+            for (uint16_t i = 0; i < length; i++) {
+                crc ^= uint16_t(EEPROM.read(address + i)) << 8;
+                for (uint8_t bit = 0; bit < 8; bit++) {
+                    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+                }
+            }
+            return crc;
+        }
+
+        Store::Store() :
+            entryCount(0),
+            head(0),
+            nextSequence(1),
+            writeCount(0),
+            scanned(false)
+        {}
+
+        void Store::begin() {
+            if (scanned) {
+                return;
+            }
+            scanned = true;
+
+            const uint16_t size = EEPROM.length();
+            uint32_t newest = 0;
+            uint16_t address = 0;
+            while (address + recordSize(0) <= size) {
+                Entry entry;
+                uint16_t length = readRecord(address, entry);
+                if (length == 0) {
+                    address += ALIGNMENT;
+                    continue;
+                }
+                index(entry);
+                if (entry.sequence >= newest) {
+                    newest = entry.sequence;
+                    head = address + length;
+                }
+                address += length;
+            }
+            nextSequence = newest + 1;
+
+            if (entryCount == 0) {
+                migrateLegacy();
+            }
+        }
+
+        uint16_t Store::readRecord(uint16_t address, Entry& entry) const {
+            if (EEPROM.read(address) != RECORD_MAGIC) {
+                return 0;
+            }
+            uint8_t key = EEPROM.read(address + 1);
+            uint8_t length = EEPROM.read(address + 2);
+            if (EEPROM.read(address + 3) != uint8_t(~key) || length > MAX_VALUE_SIZE) {
+                return 0;
+            }
+            uint16_t size = recordSize(length);
+            if (address + size > EEPROM.length()) {
+                return 0;
+            }
+            uint16_t crcAddress = address + HEADER_SIZE + length;
+            uint16_t crc = EEPROM.read(crcAddress) | (uint16_t(EEPROM.read(crcAddress + 1)) << 8);
+            if (crc != crc16(address, HEADER_SIZE + length)) {
+                return 0;
+            }
+
+            entry.key = key;
+            entry.length = length;
+            entry.address = address;
+            entry.sequence = 0;
+            for (uint8_t i = 0; i < 4; i++) {
+                entry.sequence |= uint32_t(EEPROM.read(address + 4 + i)) << (8 * i);
+            }
+            return size;
+        }
+
+        Store::Entry* Store::find(uint8_t key) {
+            for (uint8_t i = 0; i < entryCount; i++) {
+                if (entries[i].key == key) {
+                    return &entries[i];
+                }
+            }
+            return NULL;
+        }
+
+        void Store::index(const Entry& entry) {
+            Entry* existing = find(entry.key);
+            if (existing) {
+                if (entry.sequence > existing->sequence) {
+                    *existing = entry;
+                }
+            } else if (entryCount < MAX_KEYS) {
+                entries[entryCount++] = entry;
+            }
+        }
+
+        int32_t Store::findSpace(uint16_t address, uint16_t size) const {
+            const uint16_t capacity = EEPROM.length();
+            uint32_t travelled = 0;
+            while (travelled <= capacity) {
+                if (address + size > capacity) {
+                    travelled += capacity - address;
+                    address = 0;
+                }
+                // skip past any current record in the way
+                bool clear = true;
+                for (uint8_t i = 0; i < entryCount; i++) {
+                    uint16_t start = entries[i].address;
+                    uint16_t end = start + recordSize(entries[i].length);
+                    if (address < end && start < address + size) {
+                        travelled += end - address;
+                        address = end;
+                        clear = false;
+                        break;
+                    }
+                }
+                if (clear) {
+                    return address;
+                }
+            }
+            return -1;
+        }
+
+        void Store::migrateLegacy() {
+            uint16_t legacyEpoch = (uint16_t(EEPROM.read(LEGACY_EPOCH_ADDRESS_MSB)) << 8) |
+                EEPROM.read(LEGACY_EPOCH_ADDRESS_LSB);
+            if (legacyEpoch != 0xFFFF) {
+                put(KEY_EPOCH, legacyEpoch);
+            }
+        }
+
+        bool Store::contains(uint8_t key) {
+            begin();
+            return find(key) != NULL;
+        }
+
+        bool Store::read(uint8_t key, void* value, uint8_t length) {
+            begin();
+            Entry* entry = find(key);
+            if (!entry || entry->length != length) {
+                return false;
+            }
+            uint8_t* bytes = static_cast<uint8_t*>(value);
+            for (uint8_t i = 0; i < length; i++) {
+                bytes[i] = EEPROM.read(entry->address + HEADER_SIZE + i);
+            }
+            return true;
+        }
+
+        bool Store::write(uint8_t key, const void* value, uint8_t length) {
+            begin();
+            if (length > MAX_VALUE_SIZE || (!find(key) && entryCount >= MAX_KEYS)) {
+                return false;
+            }
+            const uint16_t size = recordSize(length);
+            int32_t found = findSpace(head, size);
+            if (found < 0) {
+                return false;
+            }
+            const uint16_t address = found;
+            const uint32_t sequence = nextSequence;
+
+            // header and value first...
+            EEPROM.update(address, RECORD_MAGIC);
+            EEPROM.update(address + 1, key);
+            EEPROM.update(address + 2, length);
+            EEPROM.update(address + 3, ~key);
+            for (uint8_t i = 0; i < 4; i++) {
+                EEPROM.update(address + 4 + i, sequence >> (8 * i));
+            }
+            const uint8_t* bytes = static_cast<const uint8_t*>(value);
+            for (uint8_t i = 0; i < length; i++) {
+                EEPROM.update(address + HEADER_SIZE + i, bytes[i]);
+            }
+
+            // ...then the CRC, which makes the record valid
+            uint16_t crc = crc16(address, HEADER_SIZE + length);
+            EEPROM.update(address + HEADER_SIZE + length, crc & 0xFF);
+            EEPROM.update(address + HEADER_SIZE + length + 1, crc >> 8);
+
+            Entry entry = { key, length, address, sequence };
+            index(entry);
+            head = address + size;
+            nextSequence++;
+            writeCount++;
+            return true;
+        }
+
+        uint32_t Store::getWriteCount() const {
+            return writeCount;
+        }
+
+        String Store::getLogString() const {
+            String logStr(entryCount);
+            logStr.concat(",");
+            logStr.concat(head);
+            logStr.concat(",");
+            logStr.concat(writeCount);
+            return logStr;
+        }
+
+    }
+
+}
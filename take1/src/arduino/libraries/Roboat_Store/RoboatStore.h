@@ -0,0 +1,105 @@
+#ifndef ROBOAT_STORE_H
+#define ROBOAT_STORE_H
+
+#include "Arduino.h"
+
+namespace Roboat {
+
+    namespace Persist {
+
+        // Keys of the values kept in the store.
+        static const uint8_t KEY_EPOCH = 1;             // uint16_t log epoch
+        static const uint8_t KEY_IMU_CALIBRATION = 2;   // IMU::Calibration
+        static const uint8_t KEY_WATCHDOG = 3;          // Watchdog::Counters
+
+        // Largest value that can be stored under one key.
+        static const uint8_t MAX_VALUE_SIZE = 64;
+
+        // Maximum number of distinct keys.
+        static const uint8_t MAX_KEYS = 16;
+
+        // Where the epoch lived before the store existed; read once to migrate it.
+        static const int LEGACY_EPOCH_ADDRESS_LSB = 512;
+        static const int LEGACY_EPOCH_ADDRESS_MSB = 513;
+
+
+        // A small log-structured key/value store in the Teensy's EEPROM.
+        //
+        // Every write appends a new record at the head of a log that wraps
+        // around the whole EEPROM, so wear is spread over the array rather than
+        // concentrated on a few bytes. Each record carries its key, a sequence
+        // number and a CRC, and the CRC is written last: a record torn by a
+        // reset fails its check and the previous value (which is never
+        // overwritten by the write replacing it) stays current.
+        //
+        //   A5 <key> <length> <~key> <sequence:4> <value:length> <crc16:2>, padded to 4 bytes
+        //
+        // The EEPROM is scanned once at startup to build a RAM index of the
+        // newest record for each key, so lookups never touch the log and
+        // startup time does not depend on the number of keys. When the head
+        // runs into a current record it skips over it.
+        class Store {
+
+            typedef struct {
+                uint8_t key;
+                uint8_t length;
+                uint16_t address;
+                uint32_t sequence;
+            } Entry;
+
+            Entry entries[MAX_KEYS];
+            uint8_t entryCount;
+            uint16_t head;
+            uint32_t nextSequence;
+            uint32_t writeCount;
+            bool scanned;
+
+            // Parse the record at `address`. Returns its size in bytes, or 0 if
+            // there is no valid record there.
+            uint16_t readRecord(uint16_t address, Entry& entry) const;
+
+            Entry* find(uint8_t key);
+            void index(const Entry& entry);
+
+            // Start of the first place at or after `address` with room for a
+            // record of `size` bytes that overlaps no current record, or -1.
+            int32_t findSpace(uint16_t address, uint16_t size) const;
+
+            void migrateLegacy();
+
+        public:
+            Store();
+
+            // Scan the EEPROM and build the index. Called automatically by the
+            // first read or write.
+            void begin();
+
+            bool contains(uint8_t key);
+
+            // Copy the value stored under `key` into `value`. Returns false if
+            // there is no value or it is not exactly `length` bytes long.
+            bool read(uint8_t key, void* value, uint8_t length);
+
+            // Store a new value under `key`. Returns false if the value is too
+            // large, there are too many keys, or the EEPROM has no room.
+            bool write(uint8_t key, const void* value, uint8_t length);
+
+            template <typename T> bool get(uint8_t key, T& value) {
+                return read(key, &value, sizeof(T));
+            }
+
+            template <typename T> bool put(uint8_t key, const T& value) {
+                return write(key, &value, sizeof(T));
+            }
+
+            // Number of records written since startup.
+            uint32_t getWriteCount() const;
+
+            String getLogString() const;
+        };
+
+    }
+
+}
+
+#endif
@@ -0,0 +1,382 @@
+#include "RoboatWatchdog.h"
+
+namespace Roboat {
+
+    namespace Watchdog {
+
+        // reset after 10s on error
+        const uint32_t ERROR_RESET_DELAY = 10e6;
+
+        // refresh at most this often (us); anything well inside TIMEOUT will do
+        const uint32_t REFRESH_PERIOD = 1e5;
+
+        // The Kinetis system register file: eight words that survive every
+        // reset except power-on and low voltage detect.
+        static volatile uint32_t* const REGISTER_FILE = reinterpret_cast<volatile uint32_t*>(0x40041000);
+        const uint32_t BREADCRUMB_MAGIC = 0x54445752;  // "RWDT"
+
+        // The department found late at the last check, if any, for the
+        // early-warning interrupt.
+        static Liveness* volatile lateDepartment = NULL;
+
+        // The timeout the watchdog is running with (ms).
+        static volatile uint32_t armedTimeout = TIMEOUT;
+
+        static void writeBreadcrumb(Cause cause, const Liveness* liveness) {
+            Breadcrumb crumb;
+            memset(&crumb, 0, sizeof(crumb));
+            crumb.magic = BREADCRUMB_MAGIC;
+            crumb.cause = cause;
+            crumb.uptime = millis();
+            if (liveness) {
+                crumb.state = liveness->state;
+                strncpy(crumb.department, liveness->name, sizeof(crumb.department) - 1);
+            }
+            const uint32_t* words = reinterpret_cast<const uint32_t*>(&crumb);
+            for (uint8_t i = 0; i < sizeof(crumb) / sizeof(uint32_t); i++) {
+                REGISTER_FILE[i] = words[i];
+            }
+        }
+
+        static void clearBreadcrumb() {
+            REGISTER_FILE[0] = 0;
+        }
+
+        // Called by the watchdog interrupt, a few microseconds before the reset.
+        static void expire() {
+            Liveness* running = Liveness::active;
+            Liveness* late = lateDepartment;
+            if (running && (!late || micros() - running->lastAdvanceTime > armedTimeout * 500)) {
+                // stuck in an update() for more than half the timeout
+                writeBreadcrumb(CAUSE_HANG, running);
+            } else if (late) {
+                writeBreadcrumb(CAUSE_DEADLINE, late);
+            } else {
+                writeBreadcrumb(CAUSE_STALL, NULL);
+            }
+        }
+
+        static const char * getCauseName(uint8_t cause) {
+            switch (cause) {
+                case CAUSE_HANG:
+                    return "HANG";
+                case CAUSE_DEADLINE:
+                    return "DEADLINE";
+                case CAUSE_STALL:
+                    return "STALL";
+                default:
+                    return "UNKNOWN";
+            }
+        }
+
+
+        Supervisor::Supervisor(Log::Manager& logManager, Persist::Store& persistentStore) :
+            StateMachine(STARTUP, "Watchdog"),
+            log(logManager),
+            store(persistentStore),
+            watchedCount(0),
+            armed(false),
+            locked(false),
+            missing(false),
+            missCount(0),
+            lastRefresh(0),
+            resetByWatchdog(false)
+        {
+            memset(&counters, 0, sizeof(counters));
+            memset(&lastBreadcrumb, 0, sizeof(lastBreadcrumb));
+        }
+
+        bool Supervisor::watch(Liveness& liveness, uint32_t deadline) {
+            if (watchedCount >= MAX_DEPARTMENTS) {
+                return false;
+            }
+            Watched& entry = watched[watchedCount++];
+            entry.liveness = &liveness;
+            entry.deadline = deadline;
+            entry.misses = 0;
+            entry.late = false;
+            entry.slowStart = false;
+            return true;
+        }
+
+        bool Supervisor::watchSlowStart(Liveness& liveness, uint32_t deadline) {
+            if (!watch(liveness, deadline)) {
+                return false;
+            }
+            watched[watchedCount - 1].slowStart = true;
+            return true;
+        }
+
+        bool Supervisor::isStarting() const {
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                if (watched[i].slowStart && !watched[i].liveness->ready) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool Supervisor::update() {
+            if (armed) {
+                supervise(micros());
+                if (!locked && !isStarting()) {
+                    arm(TIMEOUT, true);
+                }
+            }
+
+            switch (getState()) {
+                case STARTUP:
+                    readBreadcrumb();
+                    if (resetByWatchdog) {
+                        Debug::out.println(getResetReport());
+                    }
+                    clearLiveness();
+                    if (isStarting()) {
+                        arm(STARTUP_TIMEOUT, false);
+                    } else {
+                        arm(TIMEOUT, true);
+                    }
+                    markReady();
+                    goToState(resetByWatchdog ? REPORTING : WATCHING);
+                    break;
+
+                case ERROR:
+                    // the watchdog cannot be disarmed, so keep trying to supervise
+                    goToState(WATCHING, ERROR_RESET_DELAY);
+                    break;
+
+                case REPORTING:
+                    if (log.isReady()) {
+                        log.writeln(getResetReport());
+                        goToState(WATCHING);
+                    } else {
+                        remain();
+                    }
+                    break;
+
+                case WATCHING:
+                    remain();
+                    break;
+
+                default:
+                    Debug::out.println("Unexpected state encountered!");
+                    goToState(ERROR);
+            }
+
+            return false;
+        }
+
+        void Supervisor::arm(uint32_t timeout, bool lock) {
+            // The startup code leaves updates allowed, so the watchdog can be
+            // configured here. Leaving ALLOWUPDATE set lets it be configured
+            // again; clearing it keeps it as configured until the next reset.
+            // Timeout is in LPO (1 kHz) cycles, and the interrupt comes 256
+            // bus cycles before the reset.
+            noInterrupts();
+            WDOG_UNLOCK = WDOG_UNLOCK_SEQ1;
+            WDOG_UNLOCK = WDOG_UNLOCK_SEQ2;
+            __asm__ volatile ("nop");
+            __asm__ volatile ("nop");
+            WDOG_TOVALH = timeout >> 16;
+            WDOG_TOVALL = timeout & 0xFFFF;
+            WDOG_PRESC = 0;
+            WDOG_STCTRLH = WDOG_STCTRLH_WDOGEN | WDOG_STCTRLH_IRQRSTEN |
+                WDOG_STCTRLH_WAITEN | WDOG_STCTRLH_STOPEN |
+                (lock ? 0 : WDOG_STCTRLH_ALLOWUPDATE);
+            armedTimeout = timeout;
+            interrupts();
+            NVIC_ENABLE_IRQ(IRQ_WDOG);
+
+            armed = true;
+            locked = lock;
+            lastRefresh = micros();
+        }
+
+        void Supervisor::refresh() {
+            noInterrupts();
+            WDOG_REFRESH = 0xA602;
+            WDOG_REFRESH = 0xB480;
+            interrupts();
+        }
+
+        void Supervisor::clearLiveness() {
+            uint32_t now = micros();
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                Liveness& liveness = *watched[i].liveness;
+                liveness.lastAdvanceTime = now;
+                liveness.longestGap = 0;
+                liveness.longestUpdate = 0;
+            }
+        }
+
+        void Supervisor::supervise(uint32_t now) {
+            Watched* slowest = NULL;
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                if (!slowest || watched[i].liveness->longestUpdate > slowest->liveness->longestUpdate) {
+                    slowest = &watched[i];
+                }
+            }
+            // A slow starter's startup work holds up the whole loop; that is
+            // expected, and the watchdog allows for it (STARTUP_TIMEOUT).
+            bool excused = !locked && slowest && slowest->slowStart &&
+                slowest->liveness->longestUpdate > slowest->deadline;
+
+            Liveness* late = NULL;
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                Watched& entry = watched[i];
+                Liveness& liveness = *entry.liveness;
+                uint32_t gap = max(liveness.longestGap, now - liveness.lastAdvanceTime);
+                if (gap <= entry.deadline || excused) {
+                    entry.late = false;
+                    continue;
+                }
+                if (!late) {
+                    late = &liveness;
+                }
+                if (entry.late) {
+                    continue;
+                }
+
+                // a new miss: count it and say what held things up
+                entry.late = true;
+                entry.misses++;
+                missCount++;
+                String report("WATCHDOG,MISS,");
+                report.concat(liveness.name);
+                report.concat(",");
+                report.concat(gap / 1000);
+                report.concat(",");
+                report.concat(entry.deadline / 1000);
+                report.concat(",");
+                report.concat(slowest->liveness->name);
+                report.concat(",");
+                report.concat(slowest->liveness->longestUpdate / 1000);
+                Debug::out.println(report);
+                log.writeln(report);
+            }
+
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                watched[i].liveness->longestGap = 0;
+                watched[i].liveness->longestUpdate = 0;
+            }
+
+            if (late != lateDepartment) {
+                if (late) {
+                    writeBreadcrumb(CAUSE_DEADLINE, late);
+                } else {
+                    clearBreadcrumb();
+                }
+                lateDepartment = late;
+            }
+            missing = late != NULL;
+
+            if (!missing && now - lastRefresh >= REFRESH_PERIOD) {
+                refresh();
+                lastRefresh = now;
+            }
+        }
+
+        void Supervisor::readBreadcrumb() {
+            resetByWatchdog = RCM_SRS0 & RCM_SRS0_WDOG;
+            store.get(Persist::KEY_WATCHDOG, counters);
+
+            uint32_t* words = reinterpret_cast<uint32_t*>(&lastBreadcrumb);
+            for (uint8_t i = 0; i < sizeof(lastBreadcrumb) / sizeof(uint32_t); i++) {
+                words[i] = REGISTER_FILE[i];
+            }
+            if (lastBreadcrumb.magic != BREADCRUMB_MAGIC) {
+                memset(&lastBreadcrumb, 0, sizeof(lastBreadcrumb));
+            }
+            lastBreadcrumb.department[sizeof(lastBreadcrumb.department) - 1] = '\0';
+            clearBreadcrumb();
+
+            if (resetByWatchdog) {
+                counters.resets++;
+                switch (lastBreadcrumb.cause) {
+                    case CAUSE_HANG:
+                        counters.hangs++;
+                        break;
+                    case CAUSE_DEADLINE:
+                        counters.deadlines++;
+                        break;
+                    case CAUSE_STALL:
+                        counters.stalls++;
+                        break;
+                }
+                store.put(Persist::KEY_WATCHDOG, counters);
+            }
+        }
+
+        String Supervisor::getResetReport() const {
+            String report("WATCHDOG,RESET,");
+            report.concat(getCauseName(lastBreadcrumb.cause));
+            report.concat(",");
+            report.concat(lastBreadcrumb.department[0] ? lastBreadcrumb.department : "-");
+            report.concat(",");
+            report.concat(lastBreadcrumb.state);
+            report.concat(",");
+            report.concat(lastBreadcrumb.uptime);
+            report.concat(",");
+            report.concat(counters.resets);
+            return report;
+        }
+
+        uint32_t Supervisor::getMissCount() const {
+            return missCount;
+        }
+
+        uint32_t Supervisor::getMissCount(const char * department) const {
+            for (uint8_t i = 0; i < watchedCount; i++) {
+                if (strcmp(watched[i].liveness->name, department) == 0) {
+                    return watched[i].misses;
+                }
+            }
+            return 0;
+        }
+
+        bool Supervisor::wasResetByWatchdog() const {
+            return resetByWatchdog;
+        }
+
+        const Counters& Supervisor::getCounters() const {
+            return counters;
+        }
+
+        String Supervisor::getLogString() const {
+            String logStr(getState());
+            logStr.concat(",");
+            logStr.concat(missCount);
+            logStr.concat(",");
+            logStr.concat(counters.resets);
+            return logStr;
+        }
+
+        void Supervisor::addLogFields(Log::Record& record) const {
+            record.add(getState());
+            record.add(missCount);
+            record.add(counters.resets);
+        }
+
+        const char * Supervisor::getStateName(const State aState) const {
+            switch (aState) {
+                case STARTUP:
+                    return "STARTUP";
+                case ERROR:
+                    return "ERROR";
+                case REPORTING:
+                    return "REPORTING";
+                case WATCHING:
+                    return "WATCHING";
+                default:
+                    return "<INVALID>";
+            }
+        }
+
+    }
+
+}
+
+// The watchdog's early-warning interrupt (replacing the core's weak default)
+extern "C" void watchdog_isr(void) {
+    Roboat::Watchdog::expire();
+}
@@ -0,0 +1,169 @@
+#ifndef ROBOAT_WATCHDOG_H
+#define ROBOAT_WATCHDOG_H
+
+#include "Arduino.h"
+#include <RoboatStateMachine.h>
+#include <RoboatLogCodec.h>
+#include <RoboatLogManager.h>
+#include <RoboatStore.h>
+
+namespace Roboat {
+
+    namespace Watchdog {
+
+        // Time without a refresh after which the watchdog resets the Pilot
+        // (ms), once every department has started up. Well beyond the worst
+        // case of a loop, which is set by SD card writes (Log::WORST_WRITE_TIME).
+        const uint32_t TIMEOUT = 5000;
+
+        // The timeout while a slow starter (see Supervisor::watchSlowStart)
+        // is still starting up (ms). Pre-allocating the black box file on a
+        // large, slow card can block for well over TIMEOUT.
+        const uint32_t STARTUP_TIMEOUT = 60000;
+
+        const uint8_t MAX_DEPARTMENTS = 16;
+
+        typedef enum {
+            STARTUP,
+            ERROR,
+            REPORTING,      // waiting for the log to record why the last reset happened
+            WATCHING        // refreshing the watchdog while every department keeps up
+        } State;
+
+        // Why the watchdog reset the Pilot
+        typedef enum {
+            CAUSE_NONE = 0,
+            CAUSE_HANG = 1,         // a department's update() never returned
+            CAUSE_DEADLINE = 2,     // a department was not advanced within its deadline
+            CAUSE_STALL = 3         // the loop stopped outside any department
+        } Cause;
+
+        // The breadcrumb left for the next boot, in the Kinetis system
+        // register file, which keeps its contents through every reset but
+        // power-on and low voltage.
+        typedef struct {
+            uint32_t magic;
+            uint8_t cause;          // Cause
+            uint8_t state;          // state of the department at the time
+            uint16_t reserved;
+            uint32_t uptime;        // ms since startup
+            char department[20];    // NUL-terminated
+        } Breadcrumb;
+
+        // Watchdog resets since the store was created, persisted under
+        // Persist::KEY_WATCHDOG.
+        typedef struct {
+            uint16_t resets;
+            uint16_t hangs;
+            uint16_t deadlines;
+            uint16_t stalls;
+        } Counters;
+
+
+        // Supervises the other departments with the Kinetis watchdog.
+        //
+        // Each department is registered with a deadline: the longest it may
+        // go between advances. On every loop the supervisor checks that each
+        // has been advanced within its deadline, and refreshes the watchdog
+        // only if all have. A department that misses its deadline is counted
+        // and reported, together with the slowest update() since the last
+        // check (usually the cause); if the misses go on for TIMEOUT, the
+        // watchdog resets the Pilot.
+        //
+        // A department that may block for longer than TIMEOUT while starting
+        // up is watched as a slow starter. Until every slow starter is ready,
+        // the watchdog runs with STARTUP_TIMEOUT and stays reconfigurable,
+        // and misses that follow a slow starter's startup update are excused;
+        // then it is set to TIMEOUT and locked until the next reset.
+        //
+        // Just before a reset, the watchdog's early-warning interrupt records
+        // the cause, and the department whose update() was running if any,
+        // in a breadcrumb that survives the reset. After a watchdog reset the
+        // next boot counts it in the store and writes it to the log.
+        //
+        // The supervisor should be advanced last in the loop, after every
+        // department it watches.
+        class Supervisor : public StateMachine<State, Supervisor> {
+
+            typedef struct {
+                Liveness* liveness;
+                uint32_t deadline;      // us
+                uint32_t misses;
+                bool late;              // missing its deadline at the last check
+                bool slowStart;
+            } Watched;
+
+            Log::Manager& log;
+            Persist::Store& store;
+
+            Watched watched[MAX_DEPARTMENTS];
+            uint8_t watchedCount;
+
+            bool armed;
+            bool locked;            // armed with TIMEOUT, not to be changed
+            bool missing;           // a deadline was missed at the last check
+            uint32_t missCount;
+            uint32_t lastRefresh;
+
+            Counters counters;
+            bool resetByWatchdog;
+            Breadcrumb lastBreadcrumb;
+
+            // Configure the watchdog with `timeout` (ms), leaving it open to
+            // reconfiguration unless `lock`.
+            void arm(uint32_t timeout, bool lock);
+            void refresh();
+            bool isStarting() const;       // a slow starter is not ready yet
+
+            // Check every department against its deadline and refresh the
+            // watchdog if all have kept up.
+            void supervise(uint32_t now);
+            void clearLiveness();
+
+            void readBreadcrumb();
+            String getResetReport() const;
+
+        public:
+            Supervisor(Log::Manager& logManager, Persist::Store& persistentStore);
+
+            // Watch a department, which must be advanced at least every
+            // `deadline` us. Returns false if too many are watched already.
+            bool watch(Liveness& liveness, uint32_t deadline);
+
+            template <typename Machine> bool watch(Machine& machine, uint32_t deadline) {
+                return watch(machine.getLiveness(), deadline);
+            }
+
+            // Watch a department that may block for up to STARTUP_TIMEOUT
+            // before it marks itself ready (StateMachine::markReady).
+            bool watchSlowStart(Liveness& liveness, uint32_t deadline);
+
+            template <typename Machine> bool watchSlowStart(Machine& machine, uint32_t deadline) {
+                return watchSlowStart(machine.getLiveness(), deadline);
+            }
+
+            // Advance the state machine.
+            bool update();
+
+            const char * getStateName(const State aState) const;
+
+            // Deadlines missed since startup, in all and by one department.
+            uint32_t getMissCount() const;
+            uint32_t getMissCount(const char * department) const;
+
+            // True if the last reset was the watchdog's.
+            bool wasResetByWatchdog() const;
+            const Counters& getCounters() const;
+
+            String getLogString() const;
+
+            // state, deadlines missed since startup, and watchdog resets
+            // since the store was created
+            void addLogFields(Log::Record& record) const;
+        };
+
+    }
+
+}
+
+#endif
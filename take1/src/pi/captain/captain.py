@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""The RPI's side of the Pilot's duty cycle (see RoboatCaptain.h).
+
+Runs from boot (roboat-captain.service) and owns the Pilot link:
+  - says HELLO until the Pilot answers, which is how the Pilot knows the RPI
+    is up (it ignores anything else, such as the boot console);
+  - appends everything the Pilot sends to a capture file, for log_decoder.py;
+  - sends STAY_AWAKE while anyone is logged in, and SLEEP once they have all
+    left;
+  - answers #HALT with HALTING, and halts the RPI.
+
+Commands for the Pilot (see RoboatCaptain.cpp) may be queued by writing them,
+one per line, to the --commands FIFO.
+"""
+
+import argparse
+import os
+import select
+import subprocess
+import sys
+import time
+
+from serial import Serial
+
+HELLO_INTERVAL = 5          # s between HELLOs until the Pilot answers
+LOGIN_CHECK_INTERVAL = 10   # s between checks for logged in users
+
+
+def logged_in():
+    """True if anyone is logged in (on a terminal or over SSH)."""
+    try:
+        return subprocess.run(["who"], capture_output=True, text=True).stdout.strip() != ""
+    except OSError:
+        return False
+
+
+def open_fifo(path):
+    if not os.path.exists(path):
+        os.mkfifo(path, 0o620)
+    # held open for writing too, so that it never reads as closed
+    return os.open(path, os.O_RDWR | os.O_NONBLOCK)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--device", default="/dev/serial0", help="serial port to the Pilot")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--capture", help="append everything the Pilot sends to this file")
+    parser.add_argument("--commands", help="FIFO of command lines to pass on to the Pilot")
+    parser.add_argument("--halt-command", default="systemctl halt",
+                        help="run on #HALT (default: %(default)s)")
+    args = parser.parse_args()
+
+    link = Serial(args.device, args.baud, timeout=0)
+    capture = open(args.capture, "ab") if args.capture else None
+    commands = open_fifo(args.commands) if args.commands else None
+
+    def send(command):
+        link.write(command.encode("ascii") + b"\n")
+
+    answered = False
+    last_hello = 0
+    stay_awake = False
+    last_login_check = 0
+    line = b""
+    pending = b""
+
+    while True:
+        watched = [link.fileno()] + ([commands] if commands is not None else [])
+        select.select(watched, [], [], 1.0)
+        now = time.monotonic()
+
+        data = link.read(4096)
+        if data:
+            answered = True
+            if capture:
+                capture.write(data)
+                capture.flush()
+            line += data
+            while b"\n" in line:
+                text, line = line.split(b"\n", 1)
+                # records are binary frames without line endings, so #HALT
+                # may follow one on the same line
+                if text.rstrip(b"\r").endswith(b"#HALT"):
+                    send("HALTING")
+                    link.flush()
+                    print("Halting at the Pilot's request.", flush=True)
+                    subprocess.run(args.halt_command.split())
+                    return
+            # keep only the end of a long binary stretch without newlines
+            line = line[-64:]
+
+        if not answered and now - last_hello >= HELLO_INTERVAL:
+            # the leading newline ends whatever the boot console left behind
+            link.write(b"\nHELLO\n")
+            last_hello = now
+
+        if now - last_login_check >= LOGIN_CHECK_INTERVAL:
+            last_login_check = now
+            users = logged_in()
+            if users != stay_awake:
+                stay_awake = users
+                send("STAY_AWAKE" if users else "SLEEP")
+
+        if commands is not None:
+            try:
+                pending += os.read(commands, 4096)
+            except BlockingIOError:
+                pass
+            while b"\n" in pending:
+                command, pending = pending.split(b"\n", 1)
+                command = command.strip()
+                if command:
+                    link.write(command + b"\n")
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,137 @@
+// Host simulation of the GPS-disciplined clock (RoboatClock).
+//
+// The Pilot's crystal runs fast by a fixed CRYSTAL_ERROR; micros() is the
+// virtual time of the perf suite's Arduino stand-in, driven from the true
+// time. Once a second the GPS reports the UTC second that has just begun,
+// fed to the clock as GPS::Manager does: when the sentence arrives, with
+// either the PPS edge time (PPS jitter) or the arrival time less the
+// nominal NMEA delay (arrival jitter), whichever the reference selects.
+// After HOLDOVER_START the GPS is lost for HOLDOVER, and then comes back.
+//
+// Clock::now() is compared with the true UTC every 10ms. Reported:
+//  - after SETTLING, with the GPS present: the rms, 99.9th percentile and
+//    largest error, and the share of the time outside the bound;
+//  - the largest error from the outage on, and how long after the GPS
+//    returns the error is back within the bound;
+//  - the rate correction finally estimated, against the crystal's error.
+//
+// The crystal's error is constant here; a real one wanders with
+// temperature by a few ppm, which the loop follows but this does not test.
+// The clock's state is global, so each run simulates one reference.
+//
+// usage: clock_pll_sim pps|nmea [seed]
+
+#include "RoboatClock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Roboat;
+
+namespace {
+
+    const double CRYSTAL_ERROR = 37e-6;         // fraction fast
+    const double PPS_JITTER = 2;                // us rms
+    const double NMEA_DELAY = 150000;           // us, as assumed by GPS::Manager
+    const double NMEA_JITTER = 2000;            // us rms
+
+    const double PPS_BOUND = 5;                 // us
+    const double NMEA_BOUND = 1000;             // us
+
+    const double DURATION = 6 * 3600e6;         // us
+    const double HOLDOVER_START = 4 * 3600e6;
+    const double HOLDOVER = 600e6;
+    const double SETTLING = 900e6;
+    const double TICK = 10000;                  // scoring period (us)
+
+    const uint64_t UTC_START = 1767225600ULL * 1000000;    // 2026-01-01
+    const uint64_t LOCAL_START = 1234567;                   // micros() at true time 0
+
+    uint64_t localAt(double trueTime) {
+        return LOCAL_START + uint64_t(llround(trueTime * (1 + CRYSTAL_ERROR)));
+    }
+
+    // advance micros() to the local time at `trueTime`
+    void runTo(double trueTime) {
+        Shim::setMicros(uint32_t(localAt(trueTime)));
+    }
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || (strcmp(argv[1], "pps") != 0 && strcmp(argv[1], "nmea") != 0)) {
+        fprintf(stderr, "usage: %s pps|nmea [seed]\n", argv[0]);
+        return 2;
+    }
+    const bool pps = strcmp(argv[1], "pps") == 0;
+    const double bound = pps ? PPS_BOUND : NMEA_BOUND;
+    std::mt19937 random(argc > 2 ? atoi(argv[2]) : 1);
+    std::normal_distribution<double> jitter(0, pps ? PPS_JITTER : NMEA_JITTER);
+    std::normal_distribution<double> arrival(0, NMEA_JITTER);
+
+    std::vector<double> errors; // after SETTLING, until the outage
+    double holdoverMax = 0;     // from the loss of the GPS to the end of the run
+    double recovery = -1;       // time after the GPS returned until back within bound
+
+    double nextSecond = 1e6;
+    double nextArrival = nextSecond + NMEA_DELAY + arrival(random);
+    for (double t = 0; t < DURATION; t += TICK) {
+        // the sentence for each UTC second arrives about NMEA_DELAY after it
+        // starts, and is handled at once
+        while (nextArrival <= t) {
+            const bool outage = nextSecond >= HOLDOVER_START && nextSecond < HOLDOVER_START + HOLDOVER;
+            if (!outage) {
+                runTo(nextArrival);
+                const uint64_t utc = UTC_START + uint64_t(nextSecond);
+                if (pps) {
+                    const uint32_t edge = uint32_t(localAt(nextSecond + jitter(random)));
+                    Clock::synchronize(Clock::toLocal(edge), utc, true);
+                } else {
+                    Clock::synchronize(Clock::toLocal(uint32_t(localAt(nextArrival))) - uint64_t(NMEA_DELAY),
+                                       utc, false);
+                }
+            }
+            nextSecond += 1e6;
+            nextArrival = nextSecond + NMEA_DELAY + arrival(random);
+        }
+
+        runTo(t);
+        if (!Clock::isSynced()) {
+            continue;
+        }
+        const double error = fabs(double(int64_t(Clock::now() - (UTC_START + uint64_t(t)))));
+        if (t >= HOLDOVER_START) {
+            holdoverMax = fmax(holdoverMax, error);
+            if (t >= HOLDOVER_START + HOLDOVER && recovery < 0 && error <= bound) {
+                recovery = t - (HOLDOVER_START + HOLDOVER);
+            }
+            continue;
+        }
+        if (t >= SETTLING) {
+            errors.push_back(error);
+        }
+    }
+
+    printf("reference %s, crystal %+.1f ppm, jitter %.0f us rms, bound %.0f us\n",
+           pps ? "PPS" : "NMEA", CRYSTAL_ERROR * 1e6, pps ? PPS_JITTER : NMEA_JITTER, bound);
+    double sumSquares = 0;
+    uint32_t outside = 0;
+    for (double error : errors) {
+        sumSquares += error * error;
+        outside += error > bound;
+    }
+    std::sort(errors.begin(), errors.end());
+    printf("  after %.0f s: rms %.2f us, 99.9%% %.2f us, max %.2f us, %.3f%% of the time outside the bound\n",
+           SETTLING / 1e6, sqrt(sumSquares / errors.size()), errors[errors.size() * 999 / 1000],
+           errors.back(), 100.0 * outside / errors.size());
+    printf("  GPS lost for %.0f s: max error %.0f us, within bound again %.0f s after it returned\n",
+           HOLDOVER / 1e6, holdoverMax, recovery / 1e6);
+    printf("  rate correction %.3f ppm (crystal %.3f ppm)\n",
+           Clock::getRateCorrection() / 1e3, -CRYSTAL_ERROR / (1 + CRYSTAL_ERROR) * 1e6);
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Host benchmark for the telemetry codec (RoboatLogCodec).
+//
+// Replays ASCII Pilot logs (Log_<epoch>.csv files, or "LOG: ..." lines
+// captured from the Pi link) through the same encoder the firmware uses,
+// and reports the compression ratio against the ASCII lines and the host
+// encode time per record. Every record is decoded again and compared, so a
+// run also checks round-trip fidelity.
+//
+// Fractional columns are scaled to integers with as many decimal digits as
+// the log carries (up to 7), limited so the largest value still fits in an
+// int32. Encode cycles on the M4 itself are reported by the firmware in the
+// log_encode_cycles fields of every record.
+//
+// usage: log_codec_bench <log file>...
+
+#include "RoboatLogCodec.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Roboat::Log;
+
+namespace {
+
+    struct Column {
+        int decimals = 0;
+        double maxAbs = 0;
+        double scale = 1;
+    };
+
+    bool splitLine(const std::string& raw, std::vector<std::string>& cells) {
+        std::string line = raw;
+        if (line.compare(0, 5, "LOG: ") == 0) {
+            line = line.substr(5);
+        }
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            return false;
+        }
+        cells.clear();
+        std::stringstream ss(line);
+        std::string cell;
+        while (std::getline(ss, cell, ',')) {
+            cells.push_back(cell);
+        }
+        return true;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <log file>...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> lines;
+    std::vector<std::vector<std::string>> rows;
+    size_t asciiBytes = 0;
+
+    for (int a = 1; a < argc; a++) {
+        std::ifstream in(argv[a]);
+        if (!in) {
+            std::fprintf(stderr, "cannot open %s\n", argv[a]);
+            return 1;
+        }
+        std::string line;
+        std::vector<std::string> cells;
+        while (std::getline(in, line)) {
+            if (splitLine(line, cells)) {
+                asciiBytes += line.size() + 1;
+                rows.push_back(cells);
+            }
+        }
+    }
+    if (rows.empty()) {
+        std::fprintf(stderr, "no records found\n");
+        return 1;
+    }
+
+    // choose a fixed-point scale per column
+    size_t width = 0;
+    for (auto& r : rows) {
+        width = std::max(width, r.size());
+    }
+    width = std::min<size_t>(width, MAX_FIELDS);
+    std::vector<Column> columns(width);
+    for (auto& r : rows) {
+        for (size_t i = 0; i < width && i < r.size(); i++) {
+            const std::string& c = r[i];
+            size_t dot = c.find('.');
+            if (dot != std::string::npos) {
+                columns[i].decimals = std::max<int>(columns[i].decimals, c.size() - dot - 1);
+            }
+            columns[i].maxAbs = std::max(columns[i].maxAbs, std::fabs(std::atof(c.c_str())));
+        }
+    }
+    for (auto& col : columns) {
+        int digits = std::min(col.decimals, 7);
+        while (digits > 0 && col.maxAbs * std::pow(10.0, digits) >= 2147483647.0) {
+            digits--;
+        }
+        col.scale = std::pow(10.0, digits);
+    }
+
+    std::vector<Record> records(rows.size());
+    for (size_t r = 0; r < rows.size(); r++) {
+        for (size_t i = 0; i < width; i++) {
+            double v = i < rows[r].size() ? std::atof(rows[r][i].c_str()) : 0;
+            records[r].add(static_cast<int32_t>(std::llround(v * columns[i].scale)));
+        }
+    }
+
+    // encode, timing the encoder alone
+    Encoder encoder;
+    std::vector<uint8_t> stream;
+    stream.reserve(records.size() * MAX_FRAME_SIZE);
+    uint8_t frame[MAX_FRAME_SIZE];
+    size_t maxFrame = 0;
+
+    const int passes = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < passes; p++) {
+        Encoder timed;
+        for (auto& rec : records) {
+            timed.encode(rec, frame);
+        }
+    }
+    double nsPerRecord = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / (passes * records.size());
+
+    for (auto& rec : records) {
+        size_t n = encoder.encode(rec, frame);
+        maxFrame = std::max(maxFrame, n);
+        stream.insert(stream.end(), frame, frame + n);
+    }
+
+    // decode and verify
+    Decoder decoder;
+    size_t decoded = 0, mismatches = 0;
+    Record out;
+    for (uint8_t b : stream) {
+        if (decoder.feed(b)) {
+            decoder.getRecord(out);
+            const Record& expected = records[decoder.getSequence()];
+            for (uint8_t i = 0; i < expected.size(); i++) {
+                if (out[i] != expected[i]) {
+                    mismatches++;
+                }
+            }
+            decoded++;
+        }
+    }
+
+    std::printf("records:            %zu (%zu fields)\n", records.size(), width);
+    std::printf("ascii bytes:        %zu (%.1f per record)\n", asciiBytes, double(asciiBytes) / records.size());
+    std::printf("encoded bytes:      %zu (%.1f per record, max frame %zu)\n",
+        stream.size(), double(stream.size()) / records.size(), maxFrame);
+    std::printf("compression ratio:  %.2f\n", double(asciiBytes) / stream.size());
+    std::printf("host encode time:   %.1f ns/record\n", nsPerRecord);
+    std::printf("round trip:         %zu decoded, %zu mismatched fields, %u errors\n",
+        decoded, mismatches, decoder.getErrors());
+
+    return (decoded == records.size() && mismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+// Checks for the telemetry codec (RoboatLogCodec): round trips, what a
+// decoder makes of a stream with frames missing, and separating log slices
+// from live records on the RPI link.
+//
+// usage: log_codec_test
+
+#include "RoboatLogCodec.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Roboat::Log;
+
+namespace {
+
+    int failures = 0;
+
+    void check(bool condition, const char* what, int line) {
+        if (!condition) {
+            fprintf(stderr, "line %d: %s\n", line, what);
+            failures++;
+        }
+    }
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+    typedef std::vector<uint8_t> Frame;
+
+    const uint8_t FIELDS = 6;
+
+    // Record number `n` of a made-up stream, with slow and fast fields.
+    Record makeRecord(uint32_t n) {
+        Record record;
+        record.add(n * 100);
+        record.add(12000 - n % 7);
+        record.add((n * 7919) % 1000 - 500);
+        record.add(-int32_t(n));
+        record.add(n % 2 ? 1 : 0);
+        record.add(int32_t(n * 2654435761U));
+        return record;
+    }
+
+    std::vector<Frame> encodeRecords(Encoder& encoder, uint32_t first, uint32_t count) {
+        std::vector<Frame> frames;
+        for (uint32_t n = first; n < first + count; n++) {
+            uint8_t out[MAX_FRAME_SIZE];
+            size_t length = encoder.encode(makeRecord(n), out);
+            frames.push_back(Frame(out, out + length));
+        }
+        return frames;
+    }
+
+    bool sameRecord(const Record& a, const Record& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (uint8_t i = 0; i < a.size(); i++) {
+            if (a[i] != b[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Feed bytes to a decoder, collecting the sequence numbers of the
+    // records it decodes and counting those that differ from makeRecord().
+    struct Collector {
+        Decoder decoder;
+        std::vector<uint32_t> sequences;
+        uint32_t wrong;
+
+        Collector() : wrong(0) {}
+
+        void feed(const uint8_t* bytes, size_t length) {
+            for (size_t i = 0; i < length; i++) {
+                if (decoder.feed(bytes[i])) {
+                    Record record;
+                    decoder.getRecord(record);
+                    sequences.push_back(decoder.getSequence());
+                    if (!sameRecord(record, makeRecord(decoder.getSequence()))) {
+                        wrong++;
+                    }
+                }
+            }
+        }
+
+        void feed(const Frame& frame) {
+            feed(frame.data(), frame.size());
+        }
+    };
+
+    void testRoundTrip() {
+        Encoder encoder;
+        std::vector<Frame> frames = encodeRecords(encoder, 0, 3 * KEYFRAME_INTERVAL);
+        Collector collector;
+        for (const Frame& frame : frames) {
+            collector.feed(frame);
+        }
+        CHECK(collector.sequences.size() == frames.size());
+        CHECK(collector.wrong == 0);
+        CHECK(collector.decoder.getErrors() == 0);
+        CHECK(collector.decoder.getGaps() == 0);
+        CHECK(frames[0][1] == FRAME_KEY);
+        CHECK(frames[1][1] == FRAME_DELTA);
+        CHECK(frames[KEYFRAME_INTERVAL][1] == FRAME_KEY);
+    }
+
+    void testDroppedFrame() {
+        Encoder encoder;
+        std::vector<Frame> frames = encodeRecords(encoder, 0, 2 * KEYFRAME_INTERVAL + 4);
+        const uint32_t dropped = 5;
+        Collector collector;
+        for (uint32_t n = 0; n < frames.size(); n++) {
+            if (n != dropped) {
+                collector.feed(frames[n]);
+            }
+        }
+
+        // everything before the gap, then nothing until the next keyframe
+        std::vector<uint32_t> expected;
+        for (uint32_t n = 0; n < frames.size(); n++) {
+            if (n < dropped || n >= KEYFRAME_INTERVAL) {
+                expected.push_back(n);
+            }
+        }
+        CHECK(collector.sequences == expected);
+        CHECK(collector.wrong == 0);
+        CHECK(collector.decoder.getGaps() == 1);
+        CHECK(collector.decoder.getErrors() == 0);
+    }
+
+    void testReset() {
+        Encoder encoder;
+        encodeRecords(encoder, 0, 3);
+        encoder.reset();
+        CHECK(encoder.nextIsKeyframe());
+        std::vector<Frame> frames = encodeRecords(encoder, 3, 2);
+        CHECK(frames[0][1] == FRAME_KEY);
+
+        // a decoder joining here needs nothing before the reset
+        Collector collector;
+        for (const Frame& frame : frames) {
+            collector.feed(frame);
+        }
+        CHECK(collector.sequences == std::vector<uint32_t>({ 3, 4 }));
+        CHECK(collector.wrong == 0);
+    }
+
+    void append(Frame& link, const std::string& text) {
+        link.insert(link.end(), text.begin(), text.end());
+    }
+
+    void append(Frame& link, const Frame& bytes) {
+        link.insert(link.end(), bytes.begin(), bytes.end());
+    }
+
+    void testSliceInterleaved() {
+        // the link as Log::Manager writes it: live frames and text lines,
+        // and from record 20 on, chunks of a slice of the record file
+        // (records 0 to 15) between them
+        Encoder encoder;
+        std::vector<Frame> frames = encodeRecords(encoder, 0, 40);
+        Frame file;
+        for (uint32_t n = 0; n < KEYFRAME_INTERVAL; n++) {
+            append(file, frames[n]);
+        }
+        const uint32_t chunkSize = 96;      // chunks end part way through frames
+        Frame link;
+        uint32_t offset = 0;
+        for (uint32_t n = 0; n < frames.size(); n++) {
+            append(link, frames[n]);
+            if (n == 10) {
+                append(link, "CAPTAIN,STAY_AWAKE\r\n");
+            }
+            if (n >= 20 && offset < file.size()) {
+                uint32_t length = std::min<uint32_t>(chunkSize, file.size() - offset);
+                append(link, "#SLICE,7," + std::to_string(offset) + "," + std::to_string(length) + "\r\n");
+                append(link, Frame(file.begin() + offset, file.begin() + offset + length));
+                offset += length;
+                if (offset == file.size()) {
+                    append(link, "#SLICE_END,7," + std::to_string(offset) + "\r\n");
+                }
+            }
+        }
+        CHECK(offset == file.size());
+
+        LinkSplitter splitter;
+        Collector live;
+        Collector slice;
+        uint32_t otherSlices = 0;
+        for (uint8_t byte : link) {
+            if (splitter.feed(byte) == LinkSplitter::LIVE) {
+                live.feed(&byte, 1);
+            } else {
+                slice.feed(&byte, 1);
+                otherSlices += splitter.getSliceId() != 7;
+            }
+        }
+
+        std::vector<uint32_t> expected;
+        for (uint32_t n = 0; n < frames.size(); n++) {
+            expected.push_back(n);
+        }
+        CHECK(live.sequences == expected);
+        CHECK(live.wrong == 0);
+        CHECK(live.decoder.getErrors() == 0);
+        CHECK(live.decoder.getGaps() == 0);
+        expected.resize(KEYFRAME_INTERVAL);
+        CHECK(slice.sequences == expected);
+        CHECK(slice.wrong == 0);
+        CHECK(otherSlices == 0);
+
+        // without the splitter, the slice's records pass for live ones, and
+        // live ones are lost
+        Collector unsplit;
+        unsplit.feed(link.data(), link.size());
+        CHECK(unsplit.sequences != live.sequences);
+    }
+
+    void testOverflow() {
+        Record record;
+        for (uint16_t i = 0; i < MAX_FIELDS + 3; i++) {
+            record.add(i);
+        }
+        CHECK(record.size() == MAX_FIELDS);
+        CHECK(record.getDropped() == 3);
+        record.clear();
+        CHECK(record.getDropped() == 0);
+        CHECK(makeRecord(0).size() == FIELDS);
+    }
+
+}
+
+int main() {
+    testRoundTrip();
+    testDroppedFrame();
+    testReset();
+    testSliceInterleaved();
+    testOverflow();
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
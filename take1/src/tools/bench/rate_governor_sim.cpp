@@ -0,0 +1,356 @@
+// Host simulation of the AHRS sample rate governor (RoboatRateGovernor).
+//
+// Drives a boat through a sequence of sea states, from a calm mooring to
+// pounding through chop, with and without the Helm steering. The true
+// attitude is a sum of sinusoids; the sensors see it with the FXAS21002C's
+// and FXOS8700's noise at their output data rate. Two copies of the
+// Madgwick filter (IMU form, with the Adafruit library's gain) follow it:
+// one sampled at a fixed 100Hz as before, and one at the rate chosen by
+// the governor. Both are scored every 10ms against the truth, the governed
+// one holding its last estimate between samples as the Pilot does.
+//
+// Reported for each sea state, and over the whole sequence:
+//  - the time spent at each rate and the samples taken per second;
+//  - CPU time per second spent reading the sensors and updating the filter,
+//    which the Pilot's loop gets back for the other departments;
+//  - the charge drawn by the sensors and the bus pull-ups;
+//  - roll and pitch error (rms and max) of both filters.
+//
+// Heading is not scored: it depends on the magnetometer and its
+// calibration, which this does not model.
+//
+// The costs per sample are estimates, set out below: the I2C reads of both
+// sensors at i2c_t3's default 100kHz dominate the CPU time, and sensor
+// currents are typical datasheet values, so the savings are indicative.
+//
+// usage: rate_governor_sim [seed]
+
+#include "RoboatRateGovernor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Roboat::IMU;
+
+namespace {
+
+    const double PI = 3.14159265358979323846;
+    const double RAD = PI / 180.0;
+    const double G = 9.80665;
+
+    const uint32_t TICK = 10000;        // scoring (and fixed rate) period (us)
+
+    // per sample: gyro and accel/mag burst reads (26 bytes with addressing
+    // at 100kHz), plus the filter and online mag calibration
+    const double CPU_PER_SAMPLE_US = 2400;
+
+    // sensor and bus currents (mA)
+    const double GYRO_CURRENT = 2.7;                                  // active mode, any rate
+    const double ACCELMAG_CURRENT[RATE_COUNT] = { 0.24, 0.48, 0.96 }; // hybrid mode, by rate
+    const double BUS_CURRENT = 0.35;                                  // pull-ups, while transferring
+    const double BUS_PER_SAMPLE_US = 2340;
+
+    // sensor noise densities: gyro (deg/s/rtHz), accel (m/s^2/rtHz)
+    const double GYRO_NOISE = 0.025;
+    const double ACCEL_NOISE = 126e-6 * G;
+    const double GYRO_BIAS[3] = { 0.15, -0.1, 0.05 };   // deg/s, left after calibration
+
+    // Madgwick filter gain used by the Adafruit library
+    const double BETA = 0.1;
+
+    struct Wave {
+        double amplitude;   // degrees, or m/s^2 for heave
+        double frequency;   // Hz
+        double phase;       // radians
+    };
+
+    struct SeaState {
+        const char* name;
+        double duration;    // s
+        Rate minimumRate;   // e.g. while the Helm is steering
+        std::vector<Wave> roll, pitch, yaw, heave;
+    };
+
+    double wave(const std::vector<Wave>& waves, double t) {
+        double sum = 0;
+        for (const Wave& w : waves) {
+            sum += w.amplitude * std::sin(2 * PI * w.frequency * t + w.phase);
+        }
+        return sum;
+    }
+
+    // True attitude (radians), body rates (deg/s) and specific force in body
+    // axes (m/s^2, z up when level) at time t into a sea state.
+    struct Truth {
+        double roll, pitch, yaw;
+        double rates[3];
+        double accel[3];
+    };
+
+    Truth truth(const SeaState& sea, double t) {
+        const double h = 1e-4;
+        auto angles = [&](double s, double& r, double& p, double& y) {
+            r = wave(sea.roll, s) * RAD;
+            p = wave(sea.pitch, s) * RAD;
+            y = wave(sea.yaw, s) * RAD;
+        };
+        Truth x;
+        double r0, p0, y0, r1, p1, y1;
+        angles(t, x.roll, x.pitch, x.yaw);
+        angles(t - h, r0, p0, y0);
+        angles(t + h, r1, p1, y1);
+        const double dr = (r1 - r0) / (2 * h), dp = (p1 - p0) / (2 * h), dy = (y1 - y0) / (2 * h);
+
+        const double sr = std::sin(x.roll), cr = std::cos(x.roll);
+        const double sp = std::sin(x.pitch), cp = std::cos(x.pitch);
+        x.rates[0] = (dr - dy * sp) / RAD;
+        x.rates[1] = (dp * cr + dy * cp * sr) / RAD;
+        x.rates[2] = (-dp * sr + dy * cp * cr) / RAD;
+
+        const double f = G + wave(sea.heave, t);
+        x.accel[0] = -f * sp;
+        x.accel[1] = f * cp * sr;
+        x.accel[2] = f * cp * cr;
+        return x;
+    }
+
+    // Madgwick's gradient descent filter, gyro and accel only.
+    struct Filter {
+        double q[4];
+        double period;
+
+        void begin(double frequency) {
+            period = 1 / frequency;
+        }
+
+        void set(double roll, double pitch, double yaw) {
+            const double cr = std::cos(roll / 2), sr = std::sin(roll / 2);
+            const double cp = std::cos(pitch / 2), sp = std::sin(pitch / 2);
+            const double cy = std::cos(yaw / 2), sy = std::sin(yaw / 2);
+            q[0] = cr * cp * cy + sr * sp * sy;
+            q[1] = sr * cp * cy - cr * sp * sy;
+            q[2] = cr * sp * cy + sr * cp * sy;
+            q[3] = cr * cp * sy - sr * sp * cy;
+        }
+
+        void update(const double rates[3], const double accel[3]) {
+            const double gx = rates[0] * RAD, gy = rates[1] * RAD, gz = rates[2] * RAD;
+            double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+            double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+            double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+            double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+            double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+
+            double norm = std::sqrt(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+            if (norm > 0) {
+                const double ax = accel[0] / norm, ay = accel[1] / norm, az = accel[2] / norm;
+                double s0 = 4 * q0 * q2 * q2 + 2 * q2 * ax + 4 * q0 * q1 * q1 - 2 * q1 * ay;
+                double s1 = 4 * q1 * q3 * q3 - 2 * q3 * ax + 4 * q0 * q0 * q1 - 2 * q0 * ay - 4 * q1 +
+                            8 * q1 * q1 * q1 + 8 * q1 * q2 * q2 + 4 * q1 * az;
+                double s2 = 4 * q0 * q0 * q2 + 2 * q0 * ax + 4 * q2 * q3 * q3 - 2 * q3 * ay - 4 * q2 +
+                            8 * q2 * q1 * q1 + 8 * q2 * q2 * q2 + 4 * q2 * az;
+                double s3 = 4 * q1 * q1 * q3 - 2 * q1 * ax + 4 * q2 * q2 * q3 - 2 * q2 * ay;
+                norm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+                if (norm > 0) {
+                    qDot1 -= BETA * s0 / norm;
+                    qDot2 -= BETA * s1 / norm;
+                    qDot3 -= BETA * s2 / norm;
+                    qDot4 -= BETA * s3 / norm;
+                }
+            }
+
+            q0 += qDot1 * period;
+            q1 += qDot2 * period;
+            q2 += qDot3 * period;
+            q3 += qDot4 * period;
+            norm = std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+            q[0] = q0 / norm;
+            q[1] = q1 / norm;
+            q[2] = q2 / norm;
+            q[3] = q3 / norm;
+        }
+
+        double roll() const {
+            return std::atan2(q[0] * q[1] + q[2] * q[3], 0.5 - q[1] * q[1] - q[2] * q[2]);
+        }
+
+        double pitch() const {
+            return std::asin(std::max(-1.0, std::min(1.0, -2 * (q[1] * q[3] - q[0] * q[2]))));
+        }
+    };
+
+    struct Stats {
+        double sumSq = 0, maxAbs = 0;
+        size_t n = 0;
+        void add(double e) {
+            sumSq += e * e;
+            maxAbs = std::max(maxAbs, std::fabs(e));
+            n++;
+        }
+        double rms() const {
+            return n ? std::sqrt(sumSq / n) : 0;
+        }
+    };
+
+    struct Result {
+        double seconds = 0;
+        double timeAt[RATE_COUNT] = {};
+        size_t fixedSamples = 0, governedSamples = 0;
+        double fixedCharge = 0, governedCharge = 0;     // mA s
+        Stats fixedError, governedError;                // degrees, roll and pitch together
+        uint32_t changes = 0;
+
+        void add(const Result& r) {
+            seconds += r.seconds;
+            for (uint8_t i = 0; i < RATE_COUNT; i++) {
+                timeAt[i] += r.timeAt[i];
+            }
+            fixedSamples += r.fixedSamples;
+            governedSamples += r.governedSamples;
+            fixedCharge += r.fixedCharge;
+            governedCharge += r.governedCharge;
+            fixedError.sumSq += r.fixedError.sumSq;
+            fixedError.n += r.fixedError.n;
+            fixedError.maxAbs = std::max(fixedError.maxAbs, r.fixedError.maxAbs);
+            governedError.sumSq += r.governedError.sumSq;
+            governedError.n += r.governedError.n;
+            governedError.maxAbs = std::max(governedError.maxAbs, r.governedError.maxAbs);
+            changes += r.changes;
+        }
+    };
+
+    double angleError(double estimate, double truth) {
+        return std::remainder(estimate - truth, 2 * PI) / RAD;
+    }
+
+    void print(const char* name, const Result& r) {
+        const double fixedCpu = r.fixedSamples * CPU_PER_SAMPLE_US / 1000 / r.seconds;
+        const double governedCpu = r.governedSamples * CPU_PER_SAMPLE_US / 1000 / r.seconds;
+        std::printf("%-22s %6.0f %4.0f %4.0f %4.0f %5.1f %6.1f %6.1f %6.2f %6.2f %6.2f/%-5.2f %6.2f/%-5.2f %5u\n",
+                    name, r.seconds,
+                    100 * r.timeAt[RATE_25HZ] / r.seconds, 100 * r.timeAt[RATE_50HZ] / r.seconds,
+                    100 * r.timeAt[RATE_100HZ] / r.seconds,
+                    r.governedSamples / r.seconds, fixedCpu, governedCpu,
+                    r.fixedCharge / r.seconds, r.governedCharge / r.seconds,
+                    r.fixedError.rms(), r.fixedError.maxAbs, r.governedError.rms(), r.governedError.maxAbs,
+                    r.changes);
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::mt19937 rng(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 7);
+    std::normal_distribution<double> normal(0, 1);
+
+    const std::vector<SeaState> sequence = {
+        { "moored, calm", 1800, RATE_25HZ,
+          { { 1.5, 0.2, 0 }, { 0.4, 0.55, 1 } }, { { 0.8, 0.3, 2 } }, { { 3, 0.01, 0 } }, { { 0.1, 0.3, 0 } } },
+        { "moored, chop", 600, RATE_25HZ,
+          { { 6, 0.6, 0 }, { 2, 1.3, 1 } }, { { 4, 0.9, 2 } }, { { 5, 0.05, 0 } }, { { 1.2, 0.8, 0 } } },
+        { "steering in a swell", 1200, RATE_50HZ,
+          { { 3, 0.3, 0 } }, { { 2, 0.4, 1 } }, { { 20, 0.01, 0 }, { 2, 0.2, 1 } }, { { 0.4, 0.3, 0 } } },
+        { "steering, pounding", 300, RATE_50HZ,
+          { { 12, 0.8, 0 }, { 3, 2.1, 1 } }, { { 8, 1.5, 2 }, { 3, 3.0, 0 } }, { { 10, 0.05, 0 }, { 3, 0.4, 1 } },
+          { { 3, 1.2, 0 }, { 1, 3.0, 2 } } },
+        { "moored, calm again", 1800, RATE_25HZ,
+          { { 1.5, 0.2, 0 }, { 0.4, 0.55, 1 } }, { { 0.8, 0.3, 2 } }, { { 3, 0.01, 0 } }, { { 0.1, 0.3, 0 } } },
+    };
+
+    std::printf("%-22s %6s %4s %4s %4s %5s %6s %6s %6s %6s %12s %12s %5s\n",
+                "", "time", "%25", "%50", "%100", "Hz", "cpu", "ms/s", "mA", "mA", "fixed err", "gov err", "");
+    std::printf("%-22s %6s %4s %4s %4s %5s %6s %6s %6s %6s %12s %12s %5s\n",
+                "sea state", "(s)", "", "", "", "(gov)", "fixed", "gov", "fixed", "gov", "rms/max deg", "rms/max deg",
+                "chg");
+
+    Result total;
+    RateGovernor governor;
+    Filter fixedFilter, governedFilter;
+    bool first = true;
+    Rate rate = RATE_100HZ;
+    uint32_t clock = 0;     // us since the start of the sequence
+
+    for (const SeaState& sea : sequence) {
+        Result result;
+        governor.setMinimumRate(sea.minimumRate);
+        uint32_t changesBefore = governor.getChangeCount();
+
+        const uint32_t ticks = uint32_t(sea.duration * 1e6 / TICK);
+        uint32_t nextGoverned = 0;      // ticks until the next governed sample
+        for (uint32_t k = 0; k < ticks; k++, clock += TICK) {
+            const double t = k * (TICK * 1e-6);
+            Truth x = truth(sea, t);
+            if (first) {
+                fixedFilter.set(x.roll, x.pitch, x.yaw);
+                governedFilter.set(x.roll, x.pitch, x.yaw);
+                fixedFilter.begin(100);
+                governedFilter.begin(getFrequency(rate));
+                governor.reset(rate);
+                first = false;
+            }
+
+            // sensor readings at a given rate: noise grows with bandwidth
+            auto read = [&](Rate r, double rates[3], double accel[3]) {
+                const double bandwidth = std::sqrt(getFrequency(r) / 2);
+                for (int i = 0; i < 3; i++) {
+                    rates[i] = x.rates[i] + GYRO_BIAS[i] + GYRO_NOISE * bandwidth * normal(rng);
+                    accel[i] = x.accel[i] + ACCEL_NOISE * bandwidth * normal(rng);
+                }
+            };
+
+            double rates[3], accel[3];
+            read(RATE_100HZ, rates, accel);
+            fixedFilter.update(rates, accel);
+            result.fixedSamples++;
+
+            if (nextGoverned == 0) {
+                read(rate, rates, accel);
+                governedFilter.update(rates, accel);
+                result.governedSamples++;
+                float fr[3] = { float(rates[0]), float(rates[1]), float(rates[2]) };
+                float fa[3] = { float(accel[0]), float(accel[1]), float(accel[2]) };
+                if (governor.addSample(clock, fr, fa)) {
+                    rate = governor.getRate();
+                    governedFilter.begin(getFrequency(rate));
+                }
+                nextGoverned = getPeriod(rate) / TICK;
+            }
+            nextGoverned--;
+
+            result.timeAt[rate] += TICK * 1e-6;
+            result.fixedError.add(angleError(fixedFilter.roll(), x.roll));
+            result.fixedError.add(angleError(fixedFilter.pitch(), x.pitch));
+            result.governedError.add(angleError(governedFilter.roll(), x.roll));
+            result.governedError.add(angleError(governedFilter.pitch(), x.pitch));
+        }
+
+        result.seconds = ticks * (TICK * 1e-6);
+        const double busFixed = result.fixedSamples * BUS_PER_SAMPLE_US * 1e-6;
+        const double busGoverned = result.governedSamples * BUS_PER_SAMPLE_US * 1e-6;
+        result.fixedCharge = (GYRO_CURRENT + ACCELMAG_CURRENT[RATE_100HZ]) * result.seconds + BUS_CURRENT * busFixed;
+        result.governedCharge = GYRO_CURRENT * result.seconds + BUS_CURRENT * busGoverned;
+        for (uint8_t i = 0; i < RATE_COUNT; i++) {
+            result.governedCharge += ACCELMAG_CURRENT[i] * result.timeAt[i];
+        }
+        result.changes = governor.getChangeCount() - changesBefore;
+
+        print(sea.name, result);
+        total.add(result);
+    }
+
+    print("whole sequence", total);
+
+    const double cpuSaved = (total.fixedSamples - total.governedSamples) * CPU_PER_SAMPLE_US * 1e-6;
+    std::printf("\nCPU time freed: %.0f s of %.0f s (%.1f%% of the loop), %.1f%% fewer samples\n",
+                cpuSaved, total.seconds, 100 * cpuSaved / total.seconds,
+                100.0 * (total.fixedSamples - total.governedSamples) / total.fixedSamples);
+    std::printf("sensor and bus charge: %.2f mAh/day fixed, %.2f mAh/day governed (%.1f%% less)\n",
+                total.fixedCharge / total.seconds * 24, total.governedCharge / total.seconds * 24,
+                100 * (1 - total.governedCharge / total.fixedCharge));
+    std::printf("roll/pitch error: rms %.2f deg fixed, %.2f deg governed; max %.2f deg fixed, %.2f deg governed\n",
+                total.fixedError.rms(), total.governedError.rms(), total.fixedError.maxAbs, total.governedError.maxAbs);
+    return 0;
+}
@@ -0,0 +1,243 @@
+// Host benchmark and accuracy check for the route math (RoboatRoute).
+//
+// Generates random legs of up to MAX_LEG metres at latitudes up to 70
+// degrees, and random positions within MAX_OFFSET metres of each leg. For
+// every position the single-precision Leg::track() result is compared with
+// a double-precision reference: distance and initial bearing to the end of
+// the leg, and the cross-track distance, from Vincenty's inverse solution on
+// the WGS84 ellipsoid. The time per track() call is compared with a
+// double-precision haversine distance and bearing.
+//
+// Positions are degrees x 1e7 as in the firmware. The fixed-point text
+// conversions (parseDegrees/formatDegrees) are checked to round-trip.
+//
+// usage: route_bench [positions]
+
+#include "RoboatRoute.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Roboat::Nav;
+
+namespace {
+
+    const double PI = 3.14159265358979323846;
+    const double RAD = PI / 180.0;
+    const double MEAN_RADIUS = 6371008.8;
+
+    const double MAX_LEG = 5000.0;
+    const double MAX_OFFSET = 1000.0;
+
+    // WGS84 inverse problem (Vincenty 1975). Returns false if it fails to
+    // converge (only for nearly antipodal points, which never occur here).
+    bool vincenty(double lat1, double lon1, double lat2, double lon2, double& distance, double& bearing) {
+        const double a = 6378137.0;
+        const double f = 1 / 298.257223563;
+        const double b = a * (1 - f);
+
+        const double L = (lon2 - lon1) * RAD;
+        const double U1 = std::atan((1 - f) * std::tan(lat1 * RAD));
+        const double U2 = std::atan((1 - f) * std::tan(lat2 * RAD));
+        const double sinU1 = std::sin(U1), cosU1 = std::cos(U1);
+        const double sinU2 = std::sin(U2), cosU2 = std::cos(U2);
+
+        double lambda = L;
+        double sinSigma = 0, cosSigma = 1, sigma = 0, cosSqAlpha = 1, cos2SigmaM = 0;
+        double sinLambda = 0, cosLambda = 1;
+        for (int i = 0; i < 200; i++) {
+            sinLambda = std::sin(lambda);
+            cosLambda = std::cos(lambda);
+            sinSigma = std::sqrt(std::pow(cosU2 * sinLambda, 2) +
+                                 std::pow(cosU1 * sinU2 - sinU1 * cosU2 * cosLambda, 2));
+            if (sinSigma == 0) {
+                distance = 0;
+                bearing = 0;
+                return true;
+            }
+            cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+            sigma = std::atan2(sinSigma, cosSigma);
+            const double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+            cosSqAlpha = 1 - sinAlpha * sinAlpha;
+            cos2SigmaM = cosSqAlpha != 0 ? cosSigma - 2 * sinU1 * sinU2 / cosSqAlpha : 0;
+            const double C = f / 16 * cosSqAlpha * (4 + f * (4 - 3 * cosSqAlpha));
+            const double previous = lambda;
+            lambda = L + (1 - C) * f * sinAlpha *
+                (sigma + C * sinSigma * (cos2SigmaM + C * cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM)));
+            if (std::fabs(lambda - previous) < 1e-12) {
+                const double uSq = cosSqAlpha * (a * a - b * b) / (b * b);
+                const double A = 1 + uSq / 16384 * (4096 + uSq * (-768 + uSq * (320 - 175 * uSq)));
+                const double B = uSq / 1024 * (256 + uSq * (-128 + uSq * (74 - 47 * uSq)));
+                const double deltaSigma = B * sinSigma * (cos2SigmaM + B / 4 *
+                    (cosSigma * (-1 + 2 * cos2SigmaM * cos2SigmaM) -
+                     B / 6 * cos2SigmaM * (-3 + 4 * sinSigma * sinSigma) * (-3 + 4 * cos2SigmaM * cos2SigmaM)));
+                distance = b * A * (sigma - deltaSigma);
+                bearing = std::atan2(cosU2 * sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * cosLambda) / RAD;
+                if (bearing < 0) {
+                    bearing += 360;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // great circle distance (m) and initial bearing (deg) on the mean sphere
+    void haversine(double lat1, double lon1, double lat2, double lon2, double& distance, double& bearing) {
+        const double p1 = lat1 * RAD, p2 = lat2 * RAD;
+        const double dp = p2 - p1, dl = (lon2 - lon1) * RAD;
+        const double h = std::sin(dp / 2) * std::sin(dp / 2) +
+                         std::cos(p1) * std::cos(p2) * std::sin(dl / 2) * std::sin(dl / 2);
+        distance = 2 * MEAN_RADIUS * std::asin(std::sqrt(h));
+        bearing = std::atan2(std::sin(dl) * std::cos(p2),
+                             std::cos(p1) * std::sin(p2) - std::sin(p1) * std::cos(p2) * std::cos(dl)) / RAD;
+    }
+
+    // cross-track distance of p from the geodesic a->b, positive to the right,
+    // from the geodesic distance and bearings at a (exact to a few mm at
+    // these distances)
+    double crossTrack(double latA, double lonA, double latB, double lonB, double lat, double lon) {
+        double dAP, bAP, dAB, bAB;
+        vincenty(latA, lonA, lat, lon, dAP, bAP);
+        vincenty(latA, lonA, latB, lonB, dAB, bAB);
+        return dAP * std::sin((bAP - bAB) * RAD);
+    }
+
+    // destination from a start point, distance (m) and bearing (deg) on the mean sphere
+    void destination(double lat, double lon, double distance, double bearing, double& outLat, double& outLon) {
+        const double d = distance / MEAN_RADIUS, t = bearing * RAD, p = lat * RAD;
+        const double p2 = std::asin(std::sin(p) * std::cos(d) + std::cos(p) * std::sin(d) * std::cos(t));
+        outLat = p2 / RAD;
+        outLon = lon + std::atan2(std::sin(t) * std::sin(d) * std::cos(p), std::cos(d) - std::sin(p) * std::sin(p2)) / RAD;
+        outLon = std::remainder(outLon, 360.0);
+    }
+
+    struct Case {
+        double latA, lonA, latB, lonB, lat, lon;
+    };
+
+    struct Stats {
+        double sumSq = 0, maxAbs = 0;
+        size_t n = 0;
+        void add(double e) {
+            sumSq += e * e;
+            maxAbs = std::max(maxAbs, std::fabs(e));
+            n++;
+        }
+        double rms() const {
+            return n ? std::sqrt(sumSq / n) : 0;
+        }
+    };
+
+    int32_t toFixed(double degrees) {
+        return int32_t(std::llround(degrees * UNITS_PER_DEGREE));
+    }
+
+    double angleDiff(double a, double b) {
+        double d = std::fmod(a - b + 540.0, 360.0) - 180.0;
+        return d;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+
+    std::mt19937 rng(31);
+    std::uniform_real_distribution<double> latitude(-70, 70), longitude(-180, 180);
+    std::uniform_real_distribution<double> legLength(100, MAX_LEG), offset(0, MAX_OFFSET), angle(0, 360);
+
+    std::vector<Case> cases(count);
+    for (auto& c : cases) {
+        c.latA = latitude(rng);
+        c.lonA = longitude(rng);
+        destination(c.latA, c.lonA, legLength(rng), angle(rng), c.latB, c.lonB);
+        // a point somewhere along the leg, then pushed off it
+        double along = std::uniform_real_distribution<double>(0, 1)(rng);
+        double midLat = c.latA + along * (c.latB - c.latA), midLon = c.lonA + along * std::remainder(c.lonB - c.lonA, 360.0);
+        destination(midLat, midLon, offset(rng), angle(rng), c.lat, c.lon);
+    }
+
+    // accuracy
+    Stats distanceError, relativeError, bearingError, crossTrackError;
+    for (auto& c : cases) {
+        Leg leg;
+        Position a = { toFixed(c.latA), toFixed(c.lonA) }, b = { toFixed(c.latB), toFixed(c.lonB) };
+        Position p = { toFixed(c.lat), toFixed(c.lon) };
+        leg.set(a, b);
+        Track t;
+        leg.track(p, t);
+
+        double refDistance, refBearing;
+        if (!vincenty(c.lat, c.lon, c.latB, c.lonB, refDistance, refBearing)) {
+            continue;
+        }
+        distanceError.add(t.distance - refDistance);
+        relativeError.add((t.distance - refDistance) / std::max(refDistance, 1.0));
+        if (refDistance > 50) {
+            bearingError.add(angleDiff(t.bearing, refBearing));
+        }
+        crossTrackError.add(t.crossTrack - crossTrack(c.latA, c.lonA, c.latB, c.lonB, c.lat, c.lon));
+    }
+
+    // text round trip
+    size_t roundTripFailures = 0;
+    for (auto& c : cases) {
+        for (double degrees : { c.lat, c.lon }) {
+            int32_t value = toFixed(degrees), parsed = 0;
+            char text[13];
+            formatDegrees(value, text);
+            const char* end = parseDegrees(text, parsed);
+            if (!end || *end != '\0' || parsed != value) {
+                roundTripFailures++;
+            }
+        }
+    }
+
+    // speed
+    std::vector<Leg> legs(count);
+    std::vector<Position> positions(count);
+    for (size_t i = 0; i < count; i++) {
+        Position a = { toFixed(cases[i].latA), toFixed(cases[i].lonA) }, b = { toFixed(cases[i].latB), toFixed(cases[i].lonB) };
+        legs[i].set(a, b);
+        positions[i] = { toFixed(cases[i].lat), toFixed(cases[i].lon) };
+    }
+
+    const int passes = 20;
+    double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            Track t;
+            legs[i].track(positions[i], t);
+            sink += t.distance + t.bearing + t.crossTrack;
+        }
+    }
+    double trackNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (passes * count);
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (size_t i = 0; i < count; i++) {
+            double d, b;
+            haversine(cases[i].lat, cases[i].lon, cases[i].latB, cases[i].lonB, d, b);
+            sink += d + b;
+        }
+    }
+    double haversineNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (passes * count);
+
+    std::printf("%zu positions, legs up to %.0f m, up to %.0f m off the leg\n", count, MAX_LEG, MAX_OFFSET);
+    std::printf("distance error:     rms %.3f m, max %.3f m (rms %.4f%%, max %.4f%% of distance)\n",
+                distanceError.rms(), distanceError.maxAbs, 100 * relativeError.rms(), 100 * relativeError.maxAbs);
+    std::printf("bearing error:      rms %.4f deg, max %.4f deg (beyond 50 m)\n", bearingError.rms(), bearingError.maxAbs);
+    std::printf("cross-track error:  rms %.3f m, max %.3f m\n", crossTrackError.rms(), crossTrackError.maxAbs);
+    std::printf("text round trip:    %zu failures in %zu values\n", roundTripFailures, 2 * count);
+    std::printf("Leg::track:         %.1f ns/position (fixed point in, float math, precomputed leg)\n", trackNs);
+    std::printf("haversine:          %.1f ns/position (double, distance and bearing only)\n", haversineNs);
+    std::printf("(checksum %g)\n", sink);
+    return roundTripFailures == 0 ? 0 : 1;
+}
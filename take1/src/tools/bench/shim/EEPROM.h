@@ -0,0 +1,56 @@
+// Host stand-in for the Teensy 3.6's 4KB EEPROM, for the store power-cut
+// simulation (store_powercut_sim.cpp). Like the Teensy's, update() writes
+// only bytes that change; each such write is counted, and the power can be
+// made to fail part way through one.
+
+#ifndef ROBOAT_BENCH_EEPROM_H
+#define ROBOAT_BENCH_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Thrown by the write the power fails in, to abandon the boot.
+struct PowerCut {};
+
+struct EEPROMClass {
+    uint8_t bytes[4096];
+    uint32_t wear[4096];        // writes to each byte
+    uint32_t writes;            // writes to any byte
+
+    // Writes to let through before the power fails (negative for never),
+    // and what the byte being written is left holding when it does.
+    int32_t writesLeft;
+    uint8_t tornValue;
+
+    EEPROMClass() : writes(0), writesLeft(-1), tornValue(0) {
+        memset(bytes, 0xFF, sizeof(bytes));
+        memset(wear, 0, sizeof(wear));
+    }
+
+    uint8_t read(int address) { return bytes[address]; }
+    void write(int address, uint8_t value) { program(address, value); }
+    uint16_t length() { return sizeof(bytes); }
+
+    void update(int address, uint8_t value) {
+        if (bytes[address] != value) {
+            program(address, value);
+        }
+    }
+
+    void program(int address, uint8_t value) {
+        wear[address]++;
+        writes++;
+        if (writesLeft == 0) {
+            bytes[address] = tornValue;
+            throw PowerCut();
+        }
+        if (writesLeft > 0) {
+            writesLeft--;
+        }
+        bytes[address] = value;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
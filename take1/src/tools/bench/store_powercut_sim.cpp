@@ -0,0 +1,224 @@
+// Host simulation of the persistent store (RoboatStore) losing power.
+//
+// Boots the Pilot BOOTS times over one EEPROM, starting from a blank one
+// holding only a legacy epoch to migrate. Each boot makes the store calls
+// the firmware does, in its order:
+//  - Log::Manager reads the epoch and writes it back incremented;
+//  - after a watchdog reset, the supervisor increments its counters;
+//  - the AHRS reads its calibration (writing the default the first time),
+//    and then installs up to MAX_MAG_UPDATES new magnetometer calibrations
+//    while running (the firmware allows one every 10 minutes, and only
+//    when it is clearly better, so a few per boot at most).
+//
+// On CUT_FRACTION of the boots the power fails at a random byte write
+// within the boot, which leaves that byte holding a random value and ends
+// the boot. Every value read back on the next boot must be either the last
+// one written successfully or the one being written when the power failed.
+//
+// Reported: the values lost or corrupted (which must be none), writes the
+// store refused, how often a value being written survived the cut, and
+// wear: the most and average writes to any one EEPROM byte.
+//
+// The rates of watchdog resets and calibration updates are guesses,
+// set out below; wear scales with the bytes written per boot.
+//
+// usage: store_powercut_sim [seed]
+
+#include "RoboatStore.h"
+
+#include <EEPROM.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Roboat::Persist;
+
+EEPROMClass EEPROM;
+
+namespace {
+
+    const uint32_t BOOTS = 100000;
+    const double CUT_FRACTION = 0.1;
+    const double WATCHDOG_RESET_FRACTION = 0.02;
+    const uint8_t MAX_MAG_UPDATES = 2;          // per boot, uniformly 0 to this
+    const uint16_t LEGACY_EPOCH = 1234;
+
+    // the sizes of the firmware's values
+    typedef struct {
+        float values[16];
+    } Calibration;                              // IMU::Calibration
+
+    typedef struct {
+        uint16_t resets;
+        uint16_t hangs;
+        uint16_t deadlines;
+        uint16_t stalls;
+    } Counters;                                 // Watchdog::Counters
+
+    const uint8_t KEYS = 4;                     // up to KEY_WATCHDOG
+
+    // What each key may hold.
+    struct Expected {
+        bool stored;                    // a value has been written successfully
+        std::vector<uint8_t> committed; // the last value written successfully
+        bool inFlight;                  // a write was under way when the power failed
+        std::vector<uint8_t> pending;   // the value it was writing
+    };
+
+    struct Results {
+        uint32_t lost[KEYS];            // values missing or other than expected
+        uint32_t refused;               // writes the store returned false for
+        uint32_t interrupted;           // writes cut short
+        uint32_t survived;              // writes cut short that took effect anyway
+    };
+
+    // The random choices for one boot, made up front so that it can be run
+    // twice: once to count its writes, and again to cut one of them.
+    struct Plan {
+        bool watchdogReset;
+        uint8_t magUpdates;
+        Calibration calibrations[MAX_MAG_UPDATES];
+    };
+
+    Expected expected[KEYS];
+    Results results;
+
+    template <typename T> std::vector<uint8_t> bytesOf(const T& value) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        return std::vector<uint8_t>(bytes, bytes + sizeof(T));
+    }
+
+    // Check a value read back, and make it the one to expect from now on.
+    template <typename T> void check(uint8_t key, bool found, const T& value) {
+        Expected& e = expected[key];
+        const std::vector<uint8_t> bytes = bytesOf(value);
+        bool ok;
+        if (!found) {
+            ok = !e.stored;
+        } else {
+            ok = (e.stored && bytes == e.committed) || (e.inFlight && bytes == e.pending);
+            if (e.inFlight && bytes == e.pending && !(e.stored && bytes == e.committed)) {
+                results.survived++;
+            }
+            e.stored = true;
+            e.committed = bytes;
+        }
+        if (!ok) {
+            results.lost[key]++;
+        }
+        if (e.inFlight) {
+            results.interrupted++;
+        }
+        e.inFlight = false;
+    }
+
+    template <typename T> void put(Store& store, uint8_t key, const T& value) {
+        Expected& e = expected[key];
+        e.pending = bytesOf(value);
+        e.inFlight = true;
+        if (store.put(key, value)) {
+            e.stored = true;
+            e.committed = e.pending;
+        } else {
+            results.refused++;
+        }
+        e.inFlight = false;
+    }
+
+    void boot(const Plan& plan) {
+        Store store;
+
+        uint16_t epoch = 0;
+        check(KEY_EPOCH, store.get(KEY_EPOCH, epoch), epoch);
+        put(store, KEY_EPOCH, uint16_t(epoch + 1));
+
+        Counters counters = Counters();
+        check(KEY_WATCHDOG, store.get(KEY_WATCHDOG, counters), counters);
+        if (plan.watchdogReset) {
+            counters.resets++;
+            counters.hangs++;
+            put(store, KEY_WATCHDOG, counters);
+        }
+
+        Calibration calibration = Calibration();
+        bool found = store.get(KEY_IMU_CALIBRATION, calibration);
+        check(KEY_IMU_CALIBRATION, found, calibration);
+        if (!found) {
+            put(store, KEY_IMU_CALIBRATION, calibration);
+        }
+        for (uint8_t i = 0; i < plan.magUpdates; i++) {
+            put(store, KEY_IMU_CALIBRATION, plan.calibrations[i]);
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    std::mt19937 random(argc > 1 ? atoi(argv[1]) : 1);
+    std::uniform_real_distribution<double> chance(0, 1);
+    std::uniform_real_distribution<float> calibrationValue(-50, 50);
+    std::uniform_int_distribution<int> byteValue(0, 255);
+    std::uniform_int_distribution<int> magUpdates(0, MAX_MAG_UPDATES);
+
+    EEPROM.bytes[LEGACY_EPOCH_ADDRESS_LSB] = LEGACY_EPOCH & 0xFF;
+    EEPROM.bytes[LEGACY_EPOCH_ADDRESS_MSB] = LEGACY_EPOCH >> 8;
+    expected[KEY_EPOCH].stored = true;
+    expected[KEY_EPOCH].committed = bytesOf(LEGACY_EPOCH);
+
+    uint32_t cuts = 0;
+    for (uint32_t n = 0; n < BOOTS; n++) {
+        Plan plan;
+        plan.watchdogReset = chance(random) < WATCHDOG_RESET_FRACTION;
+        plan.magUpdates = magUpdates(random);
+        for (uint8_t i = 0; i < plan.magUpdates; i++) {
+            for (float& value : plan.calibrations[i].values) {
+                value = calibrationValue(random);
+            }
+        }
+
+        if (chance(random) < CUT_FRACTION) {
+            // a dry run to count the writes, then back to where it started
+            const EEPROMClass before = EEPROM;
+            Expected expectedBefore[KEYS];
+            std::copy(expected, expected + KEYS, expectedBefore);
+            const Results resultsBefore = results;
+            boot(plan);
+            const uint32_t writes = EEPROM.writes - before.writes;
+            EEPROM = before;
+            std::copy(expectedBefore, expectedBefore + KEYS, expected);
+            results = resultsBefore;
+
+            EEPROM.writesLeft = std::uniform_int_distribution<uint32_t>(0, writes - 1)(random);
+            EEPROM.tornValue = byteValue(random);
+            cuts++;
+        }
+        try {
+            boot(plan);
+        } catch (const PowerCut&) {
+        }
+        EEPROM.writesLeft = -1;
+    }
+    // read everything back once more
+    Plan last = Plan();
+    boot(last);
+
+    uint32_t maxWear = 0;
+    uint64_t totalWear = 0;
+    for (uint16_t i = 0; i < EEPROM.length(); i++) {
+        maxWear = std::max(maxWear, EEPROM.wear[i]);
+        totalWear += EEPROM.wear[i];
+    }
+    const uint32_t lost = results.lost[KEY_EPOCH] + results.lost[KEY_WATCHDOG] + results.lost[KEY_IMU_CALIBRATION];
+
+    printf("%u boots, %u cut short\n", BOOTS, cuts);
+    printf("  lost or corrupted: epoch %u, calibration %u, watchdog counters %u\n",
+           results.lost[KEY_EPOCH], results.lost[KEY_IMU_CALIBRATION], results.lost[KEY_WATCHDOG]);
+    printf("  writes refused: %u\n", results.refused);
+    printf("  writes cut short: %u, of which %u took effect\n", results.interrupted, results.survived);
+    printf("  wear: %.1f bytes written per boot, max %u and mean %.0f writes per byte\n",
+           double(EEPROM.writes) / BOOTS, maxWear, double(totalWear) / EEPROM.length());
+    return lost == 0 && results.refused == 0 ? 0 : 1;
+}
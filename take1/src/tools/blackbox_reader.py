@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Read a Roboat black box capture file (BBox.bin) from the Pilot SD card.
+
+The file is a header block followed by 512-byte sample blocks; see
+RoboatBlackBox.h for the layout. Firmware before format version 3 wrote one
+file per boot, named BBox_<epoch>.bin. By default this prints a summary of
+each capture; with --csv it writes every sample, scaled to physical units.
+"""
+
+import argparse
+import datetime
+import struct
+import sys
+
+BLOCK_SIZE = 512
+
+FILE_HEADER = struct.Struct("<4sHHHBBfffI")
+FILE_MARKS = struct.Struct("<III")  # format version 3 and later
+BLOCK_HEADER = struct.Struct("<IHBBIBBH")
+SAMPLE = struct.Struct("<I9h")
+TRIGGER_UTC = struct.Struct("<Q")   # format version 2 and later
+FILE_ID = struct.Struct("<I")       # format version 3 and later
+
+BLOCK_TRIGGER = 0x01
+BLOCK_GAP = 0x02
+
+CAUSES = {1: "manual", 2: "capsize", 3: "power fault"}
+
+
+class Header:
+    def __init__(self, block):
+        (magic, self.version, self.epoch, self.sample_rate, self.samples_per_block, _,
+         self.gyro_scale, self.accel_scale, self.mag_scale,
+         self.block_count) = FILE_HEADER.unpack_from(block)
+        if magic != b"RBBX":
+            raise ValueError("not a black box capture file")
+        if self.version not in (1, 2, 3):
+            raise ValueError("unsupported format version {}".format(self.version))
+        self.file_id = None
+        if self.version >= 3:
+            self.file_id, _, _ = FILE_MARKS.unpack_from(block, FILE_HEADER.size)
+
+
+class Capture:
+    def __init__(self, number, epoch, trigger_time, trigger_utc, cause):
+        self.number = number
+        self.epoch = epoch                 # log epoch of the boot that recorded it
+        self.trigger_time = trigger_time
+        self.trigger_utc = trigger_utc     # us since 1970, or 0 if unknown
+        self.cause = cause
+        self.samples = []
+        self.gaps = 0
+        self.rates = set()                 # sample rates (Hz) of its blocks
+
+
+def read_captures(f):
+    header = Header(f.read(BLOCK_SIZE))
+    captures = []
+    current = None
+    last_sequence = None
+
+    while True:
+        block = f.read(BLOCK_SIZE)
+        if len(block) < BLOCK_SIZE:
+            break
+        sequence, capture, count, flags, trigger_time, cause, rate, epoch = BLOCK_HEADER.unpack_from(block)
+        if capture == 0 or count == 0 or count > header.samples_per_block:
+            # pre-allocated space that has not been written yet
+            break
+        tail = BLOCK_HEADER.size + header.samples_per_block * SAMPLE.size
+        if header.version >= 3:
+            (file_id,) = FILE_ID.unpack_from(block, tail + TRIGGER_UTC.size)
+            if file_id != header.file_id:
+                # whatever was on the card before the file was allocated
+                break
+        else:
+            epoch = header.epoch
+            rate = header.sample_rate
+
+        if current is None or capture != current.number:
+            trigger_utc = 0
+            if header.version >= 2:
+                (trigger_utc,) = TRIGGER_UTC.unpack_from(block, tail)
+            current = Capture(capture, epoch, trigger_time, trigger_utc, cause)
+            captures.append(current)
+        elif sequence != last_sequence + 1:
+            current.gaps += 1
+        if flags & BLOCK_GAP:
+            current.gaps += 1
+        current.rates.add(rate)
+        last_sequence = sequence
+
+        for i in range(count):
+            t, *raw = SAMPLE.unpack_from(block, BLOCK_HEADER.size + i * SAMPLE.size)
+            current.samples.append((t, raw))
+
+    return header, captures
+
+
+def write_csv(header, captures, out):
+    out.write("capture,t_rel_s,utc_s,gx_dps,gy_dps,gz_dps,ax_g,ay_g,az_g,mx_ut,my_ut,mz_ut\n")
+    for c in captures:
+        for t, raw in c.samples:
+            # time relative to the trigger; micros() wraps, so use 32-bit difference
+            rel_us = (t - c.trigger_time + 2**31) % 2**32 - 2**31
+            utc = "{:.6f}".format((c.trigger_utc + rel_us) / 1e6) if c.trigger_utc else ""
+            g = [v * header.gyro_scale for v in raw[0:3]]
+            a = [v * header.accel_scale for v in raw[3:6]]
+            m = [v * header.mag_scale for v in raw[6:9]]
+            out.write("{},{:.6f},{},{}\n".format(
+                c.number, rel_us / 1e6, utc, ",".join("{:.5f}".format(v) for v in g + a + m)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("file", help="capture file copied from the SD card")
+    parser.add_argument("--csv", action="store_true", help="write all samples as CSV to stdout")
+    args = parser.parse_args()
+
+    with open(args.file, "rb") as f:
+        header, captures = read_captures(f)
+
+    if args.csv:
+        write_csv(header, captures, sys.stdout)
+        return
+
+    print("created in epoch {}, {} Hz, {} capture(s)".format(header.epoch, header.sample_rate, len(captures)))
+    for c in captures:
+        before = sum(1 for t, _ in c.samples if (t - c.trigger_time) % 2**32 >= 2**31)
+        when = ""
+        if c.trigger_utc:
+            when = " at " + datetime.datetime.utcfromtimestamp(c.trigger_utc / 1e6).isoformat() + "Z"
+        rates = "/".join(str(r) for r in sorted(c.rates))
+        print("  capture {} (epoch {}): {}{} ({} samples at {} Hz, {} before trigger, {} gap(s))".format(
+            c.number, c.epoch, CAUSES.get(c.cause, "unknown"), when, len(c.samples), rates, before, c.gaps))
+
+
+if __name__ == "__main__":
+    main()
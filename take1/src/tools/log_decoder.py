@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""Decode Roboat compressed telemetry (Log_<epoch>.rtl files or Pi link captures).
+
+Frames are described in RoboatLogCodec.h. Input may start anywhere in a
+stream and may be interleaved with plain ASCII lines (as on the Pi link);
+decoding begins at the first keyframe. Records are written to stdout as CSV.
+
+Log slices requested from the Pilot (RANGE/LATEST commands, see
+RoboatCaptain.cpp) arrive on the link as "#SLICE" chunks mixed in with live
+records. By default those chunks are removed and only the live stream is
+decoded; with --slice ID the chunks of that slice are decoded instead.
+"""
+
+import argparse
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_KEY = ord("K")
+FRAME_DELTA = ord("D")
+MAX_FIELDS = 80
+
+# Field order of the Pilot's periodic record (see Pilot.ino and each
+# department's addLogFields). Extra fields are named by position.
+FIELDS = [
+    "epoch", "time_ms", "utc_s", "utc_us", "loop_us", "nav_power", "debug_dropped", "rpi_dropped",
+    "heap_free", "heap_largest", "heap_calls", "stack_max",
+    "log_state", "log_free_kb", "log_frame_bytes", "log_encode_cycles", "log_encode_cycles_max",
+    "captain_state", "pi_duty_permille", "pi_wakes", "pi_saved_mwh",
+    "power_state", "voltage_mv", "current_dma",
+    "gps_state", "lat_e7", "lon_e7", "sats", "fix_age_ms", "clock_error_us", "clock_rate_ppb",
+    "ahrs_state", "heading_cdeg", "roll_cdeg", "pitch_cdeg", "mag_fit_permille", "mag_cal_updates",
+    "ahrs_rate_hz", "ahrs_rate_changes",
+    "nav_state", "nav_waypoint", "nav_distance_m", "nav_xte_dm", "nav_heading_cdeg",
+    "nav_decl_cdeg", "nav_bias_cdeg", "nav_bias_samples",
+    "bbox_state", "bbox_capture", "bbox_dropped",
+    "wd_state", "wd_misses", "wd_resets",
+    "imu_bus_faults", "imu_bus_recovery_ms", "power_bus_faults", "power_bus_recovery_ms",
+    "ready_log_ms", "ready_captain_ms", "ready_power_ms", "ready_ahrs_ms",
+    "ready_gps_ms", "ready_nav_ms", "ready_bbox_ms", "ready_wd_ms",
+]
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def to_int32(v):
+    v &= 0xFFFFFFFF
+    return v - 2**32 if v & 0x80000000 else v
+
+
+def read_varint(data, i):
+    value = 0
+    for n in range(5):
+        if i + n >= len(data):
+            return None, i
+        value |= (data[i + n] & 0x7F) << (7 * n)
+        if not data[i + n] & 0x80:
+            return value, i + n + 1
+    return None, i
+
+
+class Decoder:
+    """Decodes a complete byte buffer; returns (sequence, fields) tuples."""
+
+    def __init__(self):
+        self.values = None
+        self.sequence = 0
+        self.errors = 0
+        self.gaps = 0
+        self.gap = False        # the last frame failed because one before it is missing
+
+    def _frame(self, data, i):
+        """Try to parse a frame starting at data[i]. Returns (record, next index) or (None, None)."""
+        kind = data[i + 1] if i + 1 < len(data) else None
+        j = i + 2
+        if kind == FRAME_KEY:
+            if j >= len(data) or data[j] > MAX_FIELDS:
+                return None, None
+            count = data[j]
+            j += 1
+            sequence, j = read_varint(data, j)
+            if sequence is None:
+                return None, None
+            values = []
+            for _ in range(count):
+                v, j = read_varint(data, j)
+                if v is None:
+                    return None, None
+                values.append(unzigzag(v))
+        elif kind == FRAME_DELTA and self.values is not None:
+            sequence = self.sequence + 1
+            if j >= len(data):
+                return None, None
+            if data[j] != sequence & 0xFF:
+                # a frame went missing, so the deltas are from a record we
+                # never saw (unless this one is corrupt)
+                self.gap = True
+                return None, None
+            j += 1
+            values = []
+            for prev in self.values:
+                v, j = read_varint(data, j)
+                if v is None:
+                    return None, None
+                values.append(to_int32(prev + unzigzag(v)))
+        else:
+            return None, None
+
+        if j >= len(data) or crc8(data[i:j]) != data[j]:
+            return None, None
+        self.values = values
+        self.sequence = sequence
+        return (sequence, values), j + 1
+
+    def decode(self, data):
+        i = 0
+        while i < len(data):
+            if data[i] != FRAME_SYNC:
+                i += 1
+                continue
+            self.gap = False
+            record, nxt = self._frame(data, i)
+            if record is None:
+                if self.values is not None:
+                    if self.gap:
+                        self.gaps += 1
+                    else:
+                        self.errors += 1
+                    # lost track of the deltas; wait for the next keyframe
+                    self.values = None
+                i += 1
+                continue
+            yield record
+            i = nxt
+
+
+def split_slices(data):
+    """Separate "#SLICE" chunks from a link capture.
+
+    Returns (live bytes, {slice id: bytes}).
+    """
+    live = bytearray()
+    slices = {}
+    i = 0
+    while i < len(data):
+        start = data.find(b"#SLICE", i)
+        if start < 0:
+            live += data[i:]
+            break
+        live += data[i:start]
+        eol = data.find(b"\n", start)
+        if eol < 0:
+            break
+        fields = data[start:eol].decode("ascii", "replace").split(",")
+        i = eol + 1
+        if fields[0] == "#SLICE" and len(fields) == 4:
+            length = int(fields[3])
+            slices.setdefault(int(fields[1]), bytearray()).extend(data[i:i + length])
+            i += length
+    return bytes(live), {k: bytes(v) for k, v in slices.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("file", nargs="?", help="input file (default: stdin)")
+    parser.add_argument("--slice", type=int, metavar="ID", help="decode log slice ID from a link capture")
+    args = parser.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+
+    live, slices = split_slices(data)
+    if args.slice is None:
+        data = live
+    elif args.slice in slices:
+        data = slices[args.slice]
+    else:
+        sys.exit("slice {} not found (have: {})".format(args.slice, sorted(slices) or "none"))
+
+    decoder = Decoder()
+    header_width = 0
+    for sequence, values in decoder.decode(data):
+        if len(values) != header_width:
+            names = FIELDS[:len(values)] + ["f{}".format(i) for i in range(len(FIELDS), len(values))]
+            print("sequence," + ",".join(names))
+            header_width = len(values)
+        print("{},{}".format(sequence, ",".join(str(v) for v in values)))
+
+    if decoder.errors:
+        print("{} corrupt frame(s) skipped".format(decoder.errors), file=sys.stderr)
+    if decoder.gaps:
+        print("{} gap(s) in the stream, decoding resumed at the next keyframe".format(decoder.gaps),
+              file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
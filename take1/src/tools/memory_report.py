@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Break the Pilot's static flash and RAM use down by library.
+
+Reads the GNU ld map file of a Pilot build (link with -Wl,-Map=Pilot.map,
+e.g. by adding it to the link flags in a platform.local.txt) and totals the
+input sections of each object file by the library it came from: each
+Roboat_* library, the sketch, third-party libraries, the Teensy core and the
+toolchain's libraries. Flash is code and constants plus the initial values
+of .data; RAM is .data, .bss and the other uninitialized sections. Heap and
+stack use are not static; the running Pilot logs those (RoboatMemory.h).
+"""
+
+import argparse
+import collections
+import os
+import re
+import sys
+
+# Output sections of the Teensy 3 linker script (mk66fx1m0.ld), plus the
+# usual names from other targets. Sections in neither set (debug info,
+# attributes) take no space on the device.
+FLASH_SECTIONS = {".text", ".rodata", ".ARM.exidx", ".ARM.extab", ".init_array", ".fini_array"}
+RAM_SECTIONS = {".bss", ".noinit", ".usbdescriptortable", ".dmabuffers", ".usbbuffers"}
+LOADED_SECTIONS = {".data"}     # in RAM, with initial values in flash
+
+OUTPUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+INPUT_SECTION = re.compile(r"^ (\.\S+|COMMON|\*fill\*)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?)?$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+
+
+def owner(path):
+    """The library (or other origin) of an object file path from the map."""
+    if not path:
+        return "(fill)"
+    parts = re.split(r"[\\/]", path)
+    if "libraries" in parts[:-1]:
+        return parts[parts.index("libraries") + 1]
+    if "sketch" in parts[:-1] or ".ino." in parts[-1]:
+        return "(sketch)"
+    archive = re.match(r"(.*?)\((.*)\)$", parts[-1])
+    if archive:
+        name = archive.group(1)
+        if name == "core.a" or "core" in parts[:-1]:
+            return "(core)"
+        return os.path.splitext(name)[0]
+    if "core" in parts[:-1]:
+        return "(core)"
+    return parts[-1]
+
+
+def regions(section):
+    """(flash, ram) multipliers for the bytes of an output section."""
+    if section in LOADED_SECTIONS:
+        return 1, 1
+    if section in FLASH_SECTIONS:
+        return 1, 0
+    if section in RAM_SECTIONS:
+        return 0, 1
+    return 0, 0
+
+
+def parse(lines):
+    """Yield (output section, input section, size, object path) from a map file."""
+    in_map = False
+    output = None
+    pending = None      # input section whose address and size are on the next line
+    for line in lines:
+        line = line.rstrip("\n")
+        if not in_map:
+            in_map = line.startswith("Linker script and memory map")
+            continue
+        if not line.strip():
+            continue
+
+        if pending is not None:
+            match = CONTINUATION.match(line)
+            name, pending = pending, None
+            if match:
+                yield output, name, int(match.group(2), 16), match.group(3)
+                continue
+
+        if not line[0].isspace():
+            match = OUTPUT_SECTION.match(line)
+            output = match.group(1) if match else None
+            continue
+
+        match = INPUT_SECTION.match(line)
+        if match and output:
+            if match.group(2) is None:
+                pending = match.group(1)
+            else:
+                yield output, match.group(1), int(match.group(3), 16), match.group(4)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("map", nargs="?", help="linker map file (default: stdin)")
+    parser.add_argument("--sections", metavar="LIBRARY",
+                        help="list the input sections of one library, largest first")
+    args = parser.parse_args()
+
+    if args.map:
+        with open(args.map, errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    flash = collections.Counter()
+    ram = collections.Counter()
+    sections = []
+    for output, name, size, path in parse(lines):
+        in_flash, in_ram = regions(output)
+        if not (in_flash or in_ram) or size == 0:
+            continue
+        library = owner(path)
+        flash[library] += size * in_flash
+        ram[library] += size * in_ram
+        if library == args.sections:
+            sections.append((size, output, name, in_flash, in_ram))
+
+    if not flash and not ram:
+        sys.exit("no sections found; is this a GNU ld map file?")
+
+    if args.sections:
+        if not sections:
+            sys.exit("no sections from {}".format(args.sections))
+        print("{:>8} {:>8}  {}".format("flash", "ram", "section"))
+        for size, output, name, in_flash, in_ram in sorted(sections, reverse=True):
+            print("{:8d} {:8d}  {} ({})".format(size * in_flash, size * in_ram, name, output))
+        return
+
+    libraries = set(flash) | set(ram)
+    roboat = sorted(l for l in libraries if l.startswith("Roboat_"))
+    others = sorted((l for l in libraries if l not in roboat), key=lambda l: -(flash[l] + ram[l]))
+
+    print("{:<28} {:>8} {:>8}".format("library", "flash", "ram"))
+    for library in roboat:
+        print("{:<28} {:8d} {:8d}".format(library, flash[library], ram[library]))
+    print("{:<28} {:8d} {:8d}".format("  all Roboat_*", sum(flash[l] for l in roboat), sum(ram[l] for l in roboat)))
+    print()
+    for library in others:
+        print("{:<28} {:8d} {:8d}".format(library, flash[library], ram[library]))
+    print()
+    print("{:<28} {:8d} {:8d}".format("total", sum(flash.values()), sum(ram.values())))
+
+
+if __name__ == "__main__":
+    main()
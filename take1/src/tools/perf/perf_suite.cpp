@@ -0,0 +1,809 @@
+// Performance-regression suite for the Pilot's hot paths.
+//
+// Runs the firmware's own code on the host, against the stand-ins in shim/
+// (a virtual micros(), a RAM SD card, a simulated IMU), with fixed seeded
+// inputs:
+//
+//   state_machine_idle     StateMachine::advance of a machine that is not due
+//   state_machine_update   StateMachine::advance dispatching to update()
+//   gps_read_parse         GPS::Manager reading and parsing one second of NMEA
+//                          (an RMC and a GGA sentence) and syncing the clock
+//   ahrs_update_filter     one AHRS update while RUNNING: sensor reads, online
+//                          mag calibration, Madgwick filter, rate governor
+//   log_string             the GPS, AHRS and log getLogString()s as one line
+//   log_record_encode      Log::Encoder on a 65-field telemetry record
+//   log_write_record       Log::Manager::writeRecord of the Pilot's record
+//   log_writeln            Log::Manager::writeln, echo and CSV file
+//
+// Every kernel is rebuilt from scratch before each repetition, and the
+// fastest repetition counts. Times are reported in ns per operation and
+// relative to a calibration loop run alongside them, which is what is
+// compared with the baseline so that it holds across machines. A kernel
+// slower than its baseline by more than its tolerance fails the run, as
+// does one that no longer exercises its path (a broken kernel is also a
+// fast one).
+//
+// usage: perf_suite [--repeat N] [--baseline FILE | --write-baseline FILE]
+//
+// Prints the results as JSON on stdout, and a summary on stderr. Exits 1 on
+// a regression or a broken kernel, 2 on a usage or baseline error.
+
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "SdFat.h"
+#include "i2c_t3.h"
+
+#include <RoboatAHRS.h>
+#include <RoboatClock.h>
+#include <RoboatDebug.h>
+#include <RoboatGPSManager.h>
+#include <RoboatI2CBus.h>
+#include <RoboatLogCodec.h>
+#include <RoboatLogManager.h>
+#include <RoboatStateMachine.h>
+#include <RoboatStore.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace Roboat;
+
+namespace {
+
+    const uint32_t SEED = 20170521;
+    const int DEFAULT_REPEAT = 15;
+
+    // further measurements of a kernel that looks slower than its baseline
+    const int REGRESSION_RETRIES = 2;
+
+    // fields in the Pilot's telemetry record, including the four stamped by
+    // the log manager (see log_decoder.py)
+    const uint8_t RECORD_FIELDS = 65;
+
+    // UTC the clock is synchronized to for the log kernels (2023-06-15 12:00:00)
+    const uint64_t LOG_UTC = 1686830400ULL * 1000000;
+
+
+    // Virtual time, restarted by each kernel's prepare().
+    uint32_t now = 0;
+
+    void restartTime() {
+        now = 1000;
+        Shim::setMicros(now);
+    }
+
+    void step(uint32_t us) {
+        now += us;
+        Shim::setMicros(now);
+    }
+
+    uint32_t nextRandom(uint32_t& state) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Keeps results alive so the compiler cannot drop the work.
+    volatile uint32_t sink;
+
+
+    // An NMEA stream of a boat crossing the sound at about 2.5 knots, one
+    // RMC and one GGA sentence per second.
+    class NmeaTrack {
+        std::vector<std::string> seconds;
+
+        static void appendSentence(std::string& out, const char* body) {
+            uint8_t checksum = 0;
+            for (const char* c = body; *c; c++) {
+                checksum ^= uint8_t(*c);
+            }
+            char sentence[128];
+            snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+            out += sentence;
+        }
+
+        static void formatAngle(char* out, size_t size, double degrees, int degreeDigits) {
+            double magnitude = degrees < 0 ? -degrees : degrees;
+            int whole = int(magnitude);
+            double minutes = (magnitude - whole) * 60;
+            snprintf(out, size, "%0*d%08.5f", degreeDigits, whole, minutes);
+        }
+
+    public:
+        NmeaTrack(uint32_t count, uint32_t seed) {
+            uint32_t state = seed;
+            double lat = 47.6062;
+            double lon = -122.3321;
+            for (uint32_t i = 0; i < count; i++) {
+                double knots = 2.5 + (nextRandom(state) % 1000) / 2000.0;
+                double course = 135 + (nextRandom(state) % 1000) / 100.0 - 5;
+                lat -= knots * 0.51444 * 0.7071 / 111120;
+                lon += knots * 0.51444 * 0.7071 / (111120 * 0.674);
+
+                uint32_t t = 12 * 3600 + i;
+                char time[16], latText[16], lonText[16], body[112];
+                snprintf(time, sizeof(time), "%02u%02u%02u.00", t / 3600, (t / 60) % 60, t % 60);
+                formatAngle(latText, sizeof(latText), lat, 2);
+                formatAngle(lonText, sizeof(lonText), lon, 3);
+
+                std::string second;
+                snprintf(body, sizeof(body), "GPRMC,%s,A,%s,N,%s,W,%.2f,%.2f,150623,,,A",
+                         time, latText, lonText, knots, course);
+                appendSentence(second, body);
+                snprintf(body, sizeof(body), "GPGGA,%s,%s,N,%s,W,1,%02u,0.9,%.1f,M,-17.0,M,,",
+                         time, latText, lonText, 7 + nextRandom(state) % 5, 2 + (nextRandom(state) % 20) / 10.0);
+                appendSentence(second, body);
+                seconds.push_back(second);
+            }
+        }
+
+        uint32_t size() const {
+            return seconds.size();
+        }
+
+        const std::string& operator[](uint32_t i) const {
+            return seconds[i];
+        }
+    };
+
+
+    // The departments the kernels exercise, wired as Pilot.ino wires them,
+    // and brought up to their running states.
+    class Boat {
+        uint8_t rpiBuffer[2048];
+
+    public:
+        Persist::Store store;
+        DigitalOut imuReset;
+        I2C::Bus imuBus;
+        Debug::Channel rpiChannel;
+        std::unique_ptr<GPS::Manager> gps;
+        std::unique_ptr<IMU::AHRS> ahrs;
+        std::unique_ptr<Log::Manager> log;
+
+        Boat() :
+            imuReset(23),
+            imuBus(Wire1, "IMU bus"),
+            rpiChannel(Serial2, rpiBuffer, sizeof(rpiBuffer))
+        {}
+
+        // Bring the GPS to RUNNING on the first second of `track`.
+        bool startGps(const NmeaTrack& track) {
+            gps.reset(new GPS::Manager(Serial1));
+            Serial1.feed(reinterpret_cast<const uint8_t*>(track[0].data()), track[0].size());
+            for (int i = 0; i < 10 && gps->getState() != GPS::RUNNING; i++) {
+                step(1000);
+                gps->advance(now);
+            }
+            return gps->getState() == GPS::RUNNING;
+        }
+
+        // Bring the AHRS through settling to RUNNING.
+        bool startAhrs() {
+            Shim::resetImu(SEED);
+            ahrs.reset(new IMU::AHRS(imuReset, imuBus, store));
+            ahrs->setActive(true);
+            for (int i = 0; i < 2000 && ahrs->getState() != IMU::RUNNING; i++) {
+                step(IMU::getPeriod(IMU::RATE_100HZ));
+                ahrs->advance(now);
+                Debug::out.drain();
+            }
+            return ahrs->getState() == IMU::RUNNING;
+        }
+
+        // Bring the log to READY on an empty card, with the clock synchronized.
+        bool startLog() {
+            Shim::clearCard();
+            log.reset(new Log::Manager(rpiChannel, store));
+            for (int i = 0; i < 10 && !log->isReady(); i++) {
+                step(1000);
+                log->advance(now);
+            }
+            Clock::synchronize(Clock::localMicros(), LOG_UTC, true);
+            Debug::out.drain();
+            rpiChannel.drain();
+            return log->isReady();
+        }
+    };
+
+    Boat* boat;
+
+
+    class Kernel {
+    public:
+        virtual ~Kernel() {}
+
+        virtual const char * getName() const = 0;
+
+        // what one operation is
+        virtual const char * getUnit() const = 0;
+
+        virtual uint32_t getOps() const = 0;
+
+        // Fraction by which the kernel may be slower than its baseline
+        // before the run fails.
+        virtual double getTolerance() const {
+            return 0.25;
+        }
+
+        // Rebuild the kernel's state (untimed). Returns false if it could
+        // not be brought up.
+        virtual bool prepare() = 0;
+
+        // Run getOps() operations (timed).
+        virtual void run() = 0;
+
+        // Check that the last run did what it claims to (untimed).
+        virtual bool verify() = 0;
+    };
+
+
+    // A fixed chain of integer and float operations, taken as the speed of
+    // the machine.
+    class Calibration : public Kernel {
+        uint32_t state;
+        float total;
+
+    public:
+        const char * getName() const { return "calibration"; }
+        const char * getUnit() const { return "xorshift and multiply-add"; }
+        uint32_t getOps() const { return 1000000; }
+
+        bool prepare() {
+            state = SEED;
+            total = 0;
+            return true;
+        }
+
+        void run() {
+            uint32_t x = state;
+            float acc = total;
+            for (uint32_t i = 0; i < 1000000; i++) {
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                acc = acc * 0.999F + float(x & 0xFFFF) * 1e-4F;
+            }
+            state = x;
+            total = acc;
+        }
+
+        bool verify() {
+            sink = state + uint32_t(total);
+            return true;
+        }
+    };
+
+
+    enum TickerState {
+        TICKING
+    };
+
+    class Ticker : public StateMachine<TickerState, Ticker> {
+        const uint32_t period;
+
+    public:
+        uint32_t updates;
+
+        Ticker(uint32_t updatePeriod) :
+            StateMachine(TICKING, "Ticker"),
+            period(updatePeriod),
+            updates(0)
+        {}
+
+        bool update() {
+            updates++;
+            remain(period);
+            return false;
+        }
+
+        const char * getStateName(const TickerState) const {
+            return "TICKING";
+        }
+    };
+
+    // Advances of a machine every call (period 0), or of one that is never
+    // due (the common case in the Pilot's loop).
+    class StateMachineKernel : public Kernel {
+        const bool due;
+        std::unique_ptr<Ticker> ticker;
+
+    public:
+        StateMachineKernel(bool dispatch) : due(dispatch) {}
+
+        const char * getName() const { return due ? "state_machine_update" : "state_machine_idle"; }
+        const char * getUnit() const { return "advance"; }
+        uint32_t getOps() const { return 200000; }
+        double getTolerance() const { return 0.4; }
+
+        bool prepare() {
+            restartTime();
+            ticker.reset(new Ticker(due ? 0 : 0xF0000000));
+            ticker->advance(now);
+            ticker->updates = 0;
+            return true;
+        }
+
+        void run() {
+            Ticker& machine = *ticker;
+            for (uint32_t i = 0; i < 200000; i++) {
+                step(1);
+                machine.advance(now);
+            }
+        }
+
+        bool verify() {
+            return ticker->updates == (due ? 200000 : 0);
+        }
+    };
+
+
+    class GpsKernel : public Kernel {
+        // under 71 minutes, so micros() does not wrap
+        static const uint32_t SECONDS = 1800;
+        NmeaTrack track;
+        uint32_t syncs;
+
+    public:
+        GpsKernel() : track(SECONDS, SEED), syncs(0) {}
+
+        const char * getName() const { return "gps_read_parse"; }
+        const char * getUnit() const { return "NMEA second (RMC + GGA)"; }
+        uint32_t getOps() const { return SECONDS - 1; }
+
+        bool prepare() {
+            restartTime();
+            bool running = boat->startGps(track);
+            syncs = Clock::getSyncCount();
+            Debug::out.drain();
+            return running;
+        }
+
+        void run() {
+            GPS::Manager& gps = *boat->gps;
+            for (uint32_t i = 1; i < SECONDS; i++) {
+                Serial1.feed(reinterpret_cast<const uint8_t*>(track[i].data()), track[i].size());
+                step(1000000);
+                gps.advance(now);
+            }
+        }
+
+        bool verify() {
+            Debug::out.drain();
+            return boat->gps->hasFix() && boat->gps->getCourseCount() == SECONDS &&
+                Clock::getSyncCount() - syncs == SECONDS - 1;
+        }
+    };
+
+
+    class AhrsKernel : public Kernel {
+        // about 24 mag calibration solves
+        static const uint32_t UPDATES = 6000;
+        uint32_t samples;
+
+    public:
+        const char * getName() const { return "ahrs_update_filter"; }
+        const char * getUnit() const { return "filter update"; }
+        uint32_t getOps() const { return UPDATES; }
+
+        bool prepare() {
+            restartTime();
+            bool running = boat->startAhrs();
+            samples = boat->ahrs->getRawSampleCount();
+            return running;
+        }
+
+        void run() {
+            IMU::AHRS& ahrs = *boat->ahrs;
+            for (uint32_t i = 0; i < UPDATES; i++) {
+                step(IMU::getPeriod(ahrs.getRate()));
+                ahrs.advance(now);
+            }
+        }
+
+        bool verify() {
+            Debug::out.drain();
+            return boat->ahrs->getState() == IMU::RUNNING &&
+                boat->ahrs->getRawSampleCount() - samples == UPDATES;
+        }
+    };
+
+
+    // Brings up the GPS, AHRS and log together, for the log kernels.
+    bool startDepartments() {
+        static NmeaTrack track(1, SEED);
+        restartTime();
+        return boat->startGps(track) && boat->startAhrs() && boat->startLog();
+    }
+
+    class LogStringKernel : public Kernel {
+        static const uint32_t LINES = 5000;
+        uint32_t length;
+
+    public:
+        const char * getName() const { return "log_string"; }
+        const char * getUnit() const { return "line"; }
+        uint32_t getOps() const { return LINES; }
+
+        bool prepare() {
+            length = 0;
+            return startDepartments();
+        }
+
+        void run() {
+            for (uint32_t i = 0; i < LINES; i++) {
+                String line = String("GPS,") + boat->gps->getLogString() +
+                    ",AHRS," + boat->ahrs->getLogString() +
+                    ",LOG," + boat->log->getLogString();
+                length += line.length();
+            }
+        }
+
+        bool verify() {
+            sink = length;
+            return length > LINES * 40;
+        }
+    };
+
+
+    // Seeded records shaped like the Pilot's: most fields steady or
+    // drifting slowly, a few noisy.
+    void makeRecords(std::vector<Log::Record>& records, uint32_t count, uint8_t fields) {
+        uint32_t state = SEED;
+        std::vector<int32_t> values(fields);
+        for (uint8_t f = 0; f < fields; f++) {
+            values[f] = int32_t(nextRandom(state) % 100000);
+        }
+        records.assign(count, Log::Record());
+        for (uint32_t i = 0; i < count; i++) {
+            for (uint8_t f = 0; f < fields; f++) {
+                switch (f % 4) {
+                    case 0:     // constant (states, counters that rarely move)
+                        break;
+                    case 1:     // slow drift
+                        values[f] += int32_t(nextRandom(state) % 5) - 2;
+                        break;
+                    case 2:     // noisy
+                        values[f] += int32_t(nextRandom(state) % 2001) - 1000;
+                        break;
+                    default:    // counting up
+                        values[f] += 1;
+                }
+                records[i].add(values[f]);
+            }
+        }
+    }
+
+    class EncodeKernel : public Kernel {
+        static const uint32_t RECORDS = 5000;
+        std::vector<Log::Record> records;
+        Log::Encoder encoder;
+        uint32_t firstSequence;
+        uint32_t bytes;
+
+    public:
+        EncodeKernel() {
+            makeRecords(records, RECORDS, RECORD_FIELDS);
+        }
+
+        const char * getName() const { return "log_record_encode"; }
+        const char * getUnit() const { return "record"; }
+        uint32_t getOps() const { return RECORDS; }
+
+        bool prepare() {
+            encoder.reset();
+            firstSequence = encoder.getSequence();
+            bytes = 0;
+            return true;
+        }
+
+        void run() {
+            uint8_t frame[Log::MAX_FRAME_SIZE];
+            for (uint32_t i = 0; i < RECORDS; i++) {
+                bytes += encoder.encode(records[i], frame);
+            }
+        }
+
+        bool verify() {
+            sink = bytes;
+            return encoder.getSequence() - firstSequence == RECORDS && bytes > RECORDS * RECORD_FIELDS / 2;
+        }
+    };
+
+
+    class WriteRecordKernel : public Kernel {
+        static const uint32_t RECORDS = 2000;
+        std::vector<Log::Record> filler;
+
+    public:
+        WriteRecordKernel() {
+            // the fields the suite has no departments for
+            makeRecords(filler, RECORDS, RECORD_FIELDS - 4 - 5 - 7 - 8);
+        }
+
+        const char * getName() const { return "log_write_record"; }
+        const char * getUnit() const { return "record"; }
+        uint32_t getOps() const { return RECORDS; }
+        double getTolerance() const { return 0.35; }
+
+        bool prepare() {
+            return startDepartments();
+        }
+
+        void run() {
+            Log::Manager& log = *boat->log;
+            for (uint32_t i = 0; i < RECORDS; i++) {
+                step(100000);
+                Log::Record record;
+                log.addLogFields(record);
+                boat->gps->addLogFields(record);
+                boat->ahrs->addLogFields(record);
+                for (uint8_t f = 0; f < filler[i].size(); f++) {
+                    record.add(filler[i][f]);
+                }
+                log.writeRecord(record);
+                boat->rpiChannel.drain();
+            }
+        }
+
+        bool verify() {
+            return boat->log->getRecordFileSize() > RECORDS * 20 && Serial2.getTxBytes() > 0;
+        }
+    };
+
+
+    class WritelnKernel : public Kernel {
+        static const uint32_t LINES = 2000;
+        std::vector<String> lines;
+
+    public:
+        WritelnKernel() {
+            lines.push_back("BOOT,5123");
+            lines.push_back("I2C,0,3,3,12,0,1,0,0");
+            lines.push_back("CAPTAIN,WAKE,SCHEDULE");
+            lines.push_back("CAPTAIN,SLEEP,IDLE,312,212,1408");
+            lines.push_back("NAV,WAYPOINT,3,47.6011035,-122.3402210");
+            lines.push_back("AHRS,MAG_CALIBRATION,1,0.012,0.031");
+            lines.push_back("POWER,FAULT,LOGIC_UNDERVOLTAGE,11.42");
+            lines.push_back("BLACKBOX,CAPTURE,17,CAPSIZE,4096");
+        }
+
+        const char * getName() const { return "log_writeln"; }
+        const char * getUnit() const { return "line"; }
+        uint32_t getOps() const { return LINES; }
+        double getTolerance() const { return 0.35; }
+
+        bool prepare() {
+            return startDepartments();
+        }
+
+        void run() {
+            Log::Manager& log = *boat->log;
+            for (uint32_t i = 0; i < LINES; i++) {
+                step(1000);
+                log.writeln(lines[i % lines.size()]);
+                boat->rpiChannel.drain();
+            }
+        }
+
+        bool verify() {
+            return Shim::getCardBytes() > LINES * 40 && boat->rpiChannel.getDroppedBytes() == 0;
+        }
+    };
+
+
+    struct Result {
+        std::string name;
+        std::string unit;
+        uint32_t ops;
+        double nsPerOp;
+        double relative;
+        double tolerance;
+        bool verified;
+        bool hasBaseline;
+        double baseline;
+        const char * status;
+    };
+
+    void classify(Result& r, double calibration) {
+        r.relative = r.nsPerOp / calibration;
+        if (!r.verified) {
+            r.status = "broken";
+        } else if (!r.hasBaseline) {
+            r.status = "new";
+        } else if (r.relative > r.baseline * (1 + r.tolerance)) {
+            r.status = "regressed";
+        } else if (r.relative < r.baseline / (1 + r.tolerance)) {
+            // not a failure, but the baseline should be brought down to keep it useful
+            r.status = "improved";
+        } else {
+            r.status = "ok";
+        }
+    }
+
+    // Time `kernel`: the fastest of `repeat` runs, each on freshly prepared
+    // state, after one run to warm up. Returns ns per op, or -1 if it could
+    // not be prepared.
+    double measure(Kernel& kernel, int repeat) {
+        double best = -1;
+        for (int r = 0; r <= repeat; r++) {
+            if (!kernel.prepare()) {
+                return -1;
+            }
+            auto start = std::chrono::steady_clock::now();
+            kernel.run();
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (r > 0 && (best < 0 || ns < best)) {
+                best = ns;
+            }
+        }
+        return best / kernel.getOps();
+    }
+
+
+    // The baseline is the JSON written by --write-baseline, one kernel per
+    // line; only the fields the suite wrote are read back.
+    bool readBaselineEntry(const std::string& text, const std::string& name, double& relative, double& tolerance) {
+        size_t at = text.find("\"" + name + "\"");
+        if (at == std::string::npos) {
+            return false;
+        }
+        size_t end = text.find('}', at);
+        size_t r = text.find("\"relative\":", at);
+        size_t t = text.find("\"tolerance\":", at);
+        if (r == std::string::npos || t == std::string::npos || r > end || t > end) {
+            return false;
+        }
+        relative = strtod(text.c_str() + r + 11, NULL);
+        tolerance = strtod(text.c_str() + t + 12, NULL);
+        return relative > 0 && tolerance > 0;
+    }
+
+    bool writeBaseline(const char * path, double calibration, const std::vector<Result>& results) {
+        FILE* out = fopen(path, "w");
+        if (!out) {
+            return false;
+        }
+        fprintf(out, "{\n  \"suite\": \"pilot_hot_paths\",\n");
+        fprintf(out, "  \"calibration_ns_per_op\": %.4f,\n  \"kernels\": {\n", calibration);
+        for (size_t i = 0; i < results.size(); i++) {
+            fprintf(out, "    \"%s\": { \"relative\": %.4f, \"tolerance\": %.2f }%s\n", results[i].name.c_str(),
+                    results[i].relative, results[i].tolerance, i + 1 < results.size() ? "," : "");
+        }
+        fprintf(out, "  }\n}\n");
+        return fclose(out) == 0;
+    }
+
+    void printJson(int repeat, double calibration, const std::vector<Result>& results, bool passed) {
+        printf("{\n  \"suite\": \"pilot_hot_paths\",\n  \"repeat\": %d,\n", repeat);
+        printf("  \"calibration_ns_per_op\": %.4f,\n  \"kernels\": [\n", calibration);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            printf("    { \"name\": \"%s\", \"unit\": \"%s\", \"ops\": %u, \"ns_per_op\": %.2f, \"relative\": %.4f",
+                   r.name.c_str(), r.unit.c_str(), r.ops, r.nsPerOp, r.relative);
+            if (r.hasBaseline) {
+                printf(", \"baseline\": %.4f, \"limit\": %.4f", r.baseline, r.baseline * (1 + r.tolerance));
+            }
+            printf(", \"status\": \"%s\" }%s\n", r.status, i + 1 < results.size() ? "," : "");
+        }
+        printf("  ],\n  \"status\": \"%s\"\n}\n", passed ? "pass" : "fail");
+    }
+
+    int usage(const char * program) {
+        fprintf(stderr, "usage: %s [--repeat N] [--baseline FILE | --write-baseline FILE]\n", program);
+        return 2;
+    }
+
+}
+
+int main(int argc, char** argv) {
+    int repeat = DEFAULT_REPEAT;
+    const char * baselinePath = NULL;
+    const char * writePath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (!strcmp(argv[i], "--write-baseline") && i + 1 < argc) {
+            writePath = argv[++i];
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (repeat < 1 || (baselinePath && writePath)) {
+        return usage(argv[0]);
+    }
+
+    std::string baseline;
+    if (baselinePath) {
+        std::ifstream in(baselinePath);
+        std::stringstream text;
+        text << in.rdbuf();
+        baseline = text.str();
+        if (!in || baseline.empty()) {
+            fprintf(stderr, "cannot read baseline %s\n", baselinePath);
+            return 2;
+        }
+    }
+
+    Boat theBoat;
+    boat = &theBoat;
+
+    Calibration calibrationKernel;
+    StateMachineKernel idle(false);
+    StateMachineKernel dispatch(true);
+    GpsKernel gps;
+    AhrsKernel ahrs;
+    LogStringKernel logString;
+    EncodeKernel encode;
+    WriteRecordKernel writeRecord;
+    WritelnKernel writeln;
+    Kernel* kernels[] = { &idle, &dispatch, &gps, &ahrs, &logString, &encode, &writeRecord, &writeln };
+
+    // the calibration is measured between kernels too, and its best taken,
+    // so that a machine that speeds up or slows down during the run affects both
+    double calibration = measure(calibrationKernel, repeat);
+
+    std::vector<Result> results;
+    bool passed = true;
+    for (Kernel* kernel : kernels) {
+        Result r;
+        r.name = kernel->getName();
+        r.unit = kernel->getUnit();
+        r.ops = kernel->getOps();
+        r.tolerance = kernel->getTolerance();
+        r.nsPerOp = measure(*kernel, repeat);
+        r.verified = r.nsPerOp > 0 && kernel->verify();
+        double again = measure(calibrationKernel, 1);
+        if (again < calibration) {
+            calibration = again;
+        }
+        r.hasBaseline = baselinePath && readBaselineEntry(baseline, r.name, r.baseline, r.tolerance);
+        results.push_back(r);
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+        Result& r = results[i];
+        classify(r, calibration);
+        // a regression must show on another measurement too, so that a
+        // burst of load on the host does not fail the run
+        for (int retry = 0; retry < REGRESSION_RETRIES && !strcmp(r.status, "regressed"); retry++) {
+            double ns = measure(*kernels[i], repeat);
+            if (ns > 0 && ns < r.nsPerOp) {
+                r.nsPerOp = ns;
+            }
+            classify(r, calibration);
+        }
+        passed = passed && strcmp(r.status, "broken") != 0 && strcmp(r.status, "regressed") != 0;
+
+        fprintf(stderr, "%-22s %10.1f ns/%-24s %9.2fx", r.name.c_str(), r.nsPerOp, r.unit.c_str(), r.relative);
+        if (r.hasBaseline) {
+            fprintf(stderr, "  baseline %9.2fx  %+6.1f%%", r.baseline, 100 * (r.relative / r.baseline - 1));
+        }
+        fprintf(stderr, "  %s\n", r.status);
+    }
+    fprintf(stderr, "calibration %.3f ns/op; %s\n", calibration, passed ? "pass" : "FAIL");
+
+    printJson(repeat, calibration, results, passed);
+
+    if (writePath) {
+        if (!passed) {
+            fprintf(stderr, "not writing a baseline from a failed run\n");
+        } else if (!writeBaseline(writePath, calibration, results)) {
+            fprintf(stderr, "cannot write baseline %s\n", writePath);
+            return 2;
+        } else {
+            fprintf(stderr, "baseline written to %s\n", writePath);
+        }
+    }
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,30 @@
+// Host stand-in for the FXAS21002C gyro driver, reporting the simulated
+// motion of sensors.cpp at the virtual time.
+
+#ifndef ROBOAT_SHIM_ADAFRUIT_FXAS21002C_H
+#define ROBOAT_SHIM_ADAFRUIT_FXAS21002C_H
+
+#include "Adafruit_Sensor.h"
+
+typedef enum {
+    GYRO_RANGE_250DPS = 250,
+    GYRO_RANGE_500DPS = 500,
+    GYRO_RANGE_1000DPS = 1000,
+    GYRO_RANGE_2000DPS = 2000
+} gyroRange_t;
+
+typedef struct {
+    int16_t x, y, z;
+} gyroRawData_t;
+
+#define GYRO_SENSITIVITY_250DPS (0.0078125F)
+
+class Adafruit_FXAS21002C : public Adafruit_Sensor {
+public:
+    Adafruit_FXAS21002C(int32_t = -1) {}
+    bool begin(gyroRange_t = GYRO_RANGE_250DPS) { return true; }
+    bool getEvent(sensors_event_t* event);
+    gyroRawData_t raw;
+};
+
+#endif
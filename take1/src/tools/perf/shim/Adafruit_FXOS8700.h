@@ -0,0 +1,31 @@
+// Host stand-in for the FXOS8700 accelerometer/magnetometer driver,
+// reporting the simulated motion of sensors.cpp at the virtual time.
+
+#ifndef ROBOAT_SHIM_ADAFRUIT_FXOS8700_H
+#define ROBOAT_SHIM_ADAFRUIT_FXOS8700_H
+
+#include "Adafruit_Sensor.h"
+
+typedef enum {
+    ACCEL_RANGE_2G = 0,
+    ACCEL_RANGE_4G = 1,
+    ACCEL_RANGE_8G = 2
+} fxos8700AccelRange_t;
+
+typedef struct {
+    int16_t x, y, z;
+} fxos8700RawData_t;
+
+#define ACCEL_MG_LSB_2G (0.000244F)
+#define MAG_UT_LSB (0.1F)
+
+class Adafruit_FXOS8700 : public Adafruit_Sensor {
+public:
+    Adafruit_FXOS8700(int32_t = -1, int32_t = -1) {}
+    bool begin(fxos8700AccelRange_t = ACCEL_RANGE_2G) { return true; }
+    bool getEvent(sensors_event_t* accel, sensors_event_t* mag);
+    fxos8700RawData_t accel_raw;
+    fxos8700RawData_t mag_raw;
+};
+
+#endif
@@ -0,0 +1,36 @@
+// Host stand-in for the Adafruit unified sensor types.
+
+#ifndef ROBOAT_SHIM_ADAFRUIT_SENSOR_H
+#define ROBOAT_SHIM_ADAFRUIT_SENSOR_H
+
+#include <stdint.h>
+
+typedef struct {
+    float x, y, z;
+} sensors_vec_t;
+
+typedef struct {
+    int32_t version;
+    int32_t sensor_id;
+    int32_t type;
+    int32_t reserved0;
+    int32_t timestamp;
+    union {
+        float data[4];
+        sensors_vec_t acceleration;
+        sensors_vec_t magnetic;
+        sensors_vec_t gyro;
+    };
+} sensors_event_t;
+
+class Adafruit_Sensor {};
+
+namespace Shim {
+
+    // Restart the simulated boat motion the IMU stand-ins report
+    // (sensors.cpp), with noise from `seed`.
+    void resetImu(uint32_t seed);
+
+}
+
+#endif
@@ -0,0 +1,205 @@
+// Host stand-in for the parts of the Teensy core the Pilot libraries use,
+// for the performance suite (perf_suite.cpp). Time is virtual: micros() and
+// millis() return whatever the suite last set with Shim::setMicros(), so
+// state machines and filters see the same sample times on every run.
+// Hardware registers are plain variables.
+
+#ifndef ROBOAT_SHIM_ARDUINO_H
+#define ROBOAT_SHIM_ARDUINO_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <type_traits>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+#define PROGMEM
+
+#define LED_BUILTIN 13
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define HIGH 1
+#define LOW 0
+#define CHANGE 4
+#define FALLING 2
+#define RISING 3
+#define DEC 10
+#define HEX 16
+
+#define F_CPU 180000000
+#define F_BUS 60000000
+
+namespace Shim {
+
+    // Set the virtual time (us) returned by micros() and millis().
+    void setMicros(uint32_t now);
+
+}
+
+uint32_t micros();
+uint32_t millis();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void noInterrupts();
+void interrupts();
+
+// cycle counter and watchdog/reset registers
+extern volatile uint32_t ARM_DWT_CYCCNT;
+extern volatile uint32_t ARM_DWT_CTRL;
+extern volatile uint32_t ARM_DEMCR;
+#define ARM_DEMCR_TRCENA (1 << 24)
+#define ARM_DWT_CTRL_CYCCNTENA 1
+
+extern volatile uint16_t WDOG_STCTRLH, WDOG_TOVALH, WDOG_TOVALL, WDOG_UNLOCK, WDOG_REFRESH, WDOG_PRESC, WDOG_RSTCNT;
+extern volatile uint8_t RCM_SRS0, RCM_SRS1;
+#define RCM_SRS0_WDOG 0x20
+#define WDOG_UNLOCK_SEQ1 0xC520
+#define WDOG_UNLOCK_SEQ2 0xD928
+#define WDOG_STCTRLH_WDOGEN 0x01
+#define WDOG_STCTRLH_IRQRSTEN 0x04
+#define WDOG_STCTRLH_STOPEN 0x40
+#define WDOG_STCTRLH_WAITEN 0x80
+#define IRQ_WDOG 22
+#define NVIC_ENABLE_IRQ(n) ((void)(n))
+
+template<class A, class B> typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template<class A, class B> typename std::common_type<A, B>::type max(A a, B b) { return a < b ? b : a; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+
+class String;
+
+class Print {
+    size_t printNumber(unsigned long n, uint8_t base);
+    size_t printFloat(double number, uint8_t digits);
+
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t byte) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* s) { return write(reinterpret_cast<const uint8_t*>(s), strlen(s)); }
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const __FlashStringHelper* s) { return write(reinterpret_cast<const char*>(s)); }
+    size_t print(const String& s);
+    size_t print(char c) { return write(uint8_t(c)); }
+    size_t print(int n, int base = DEC) { return print(long(n), base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long) n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC) { return printNumber(n, base); }
+    size_t print(double n, int digits = 2) { return printFloat(n, digits); }
+
+    size_t println() { return write("\r\n"); }
+    template<typename T> size_t println(const T& value) { size_t n = print(value); return n + println(); }
+    template<typename T> size_t println(const T& value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+
+// A serial port whose receive side is fed by the suite and whose output
+// is counted and thrown away.
+class HardwareSerial : public Stream {
+    const uint8_t* rxData;
+    size_t rxLength;
+    size_t rxPosition;
+    uint64_t txBytes;
+
+public:
+    HardwareSerial();
+
+    // Make `length` bytes at `data` (kept by the caller) available to read.
+    void feed(const uint8_t* data, size_t length);
+    uint64_t getTxBytes() const { return txBytes; }
+
+    void begin(uint32_t) {}
+    void end() {}
+    operator bool() { return true; }
+    size_t write(uint8_t) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override { return 4096; }
+    int available() override { return int(rxLength - rxPosition); }
+    int read() override { return rxPosition < rxLength ? rxData[rxPosition++] : -1; }
+    int peek() override { return rxPosition < rxLength ? rxData[rxPosition] : -1; }
+};
+
+typedef HardwareSerial usb_serial_class;
+extern usb_serial_class Serial;
+extern HardwareSerial Serial1, Serial2;
+
+
+// Arduino's String: a heap buffer grown as needed, numbers formatted as
+// the core does.
+class String {
+    char* buffer;
+    unsigned int capacity;
+    unsigned int len;
+
+    bool grow(unsigned int size);
+    String& append(const char* s, unsigned int length);
+    String& appendNumber(long value, unsigned char base);
+    String& appendUnsigned(unsigned long value, unsigned char base);
+    String& appendFloat(double value, unsigned char decimals);
+
+public:
+    String(const char* s = "");
+    String(const String& other);
+    String(String&& other);
+    explicit String(char c);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+    ~String();
+
+    String& operator=(const String& other);
+    String& operator=(String&& other);
+
+    bool reserve(unsigned int size);
+    unsigned int length() const { return len; }
+    const char* c_str() const { return buffer ? buffer : ""; }
+
+    String& concat(const String& s) { return append(s.c_str(), s.len); }
+    String& concat(const char* s) { return append(s, strlen(s)); }
+    String& concat(char c) { return append(&c, 1); }
+    String& concat(int n) { return appendNumber(n, 10); }
+    String& concat(unsigned int n) { return appendUnsigned(n, 10); }
+    String& concat(long n) { return appendNumber(n, 10); }
+    String& concat(unsigned long n) { return appendUnsigned(n, 10); }
+    String& concat(float n) { return appendFloat(n, 2); }
+    String& concat(double n) { return appendFloat(n, 2); }
+
+    template<typename T> String& operator+=(const T& value) { return concat(value); }
+
+    friend String operator+(const String& a, const String& b) { String s(a); s.concat(b); return s; }
+    friend String operator+(const String& a, const char* b) { String s(a); s.concat(b); return s; }
+    template<typename T> friend String operator+(const String& a, T b) { String s(a); s.concat(b); return s; }
+};
+
+#endif
@@ -0,0 +1,32 @@
+// Host stand-in for the Teensy 3.6's 4KB EEPROM, in RAM.
+
+#ifndef ROBOAT_SHIM_EEPROM_H
+#define ROBOAT_SHIM_EEPROM_H
+
+#include <stdint.h>
+#include <string.h>
+
+struct EEPROMClass {
+    uint8_t bytes[4096];
+
+    EEPROMClass() { memset(bytes, 0xFF, sizeof(bytes)); }
+
+    uint8_t read(int address) { return bytes[address]; }
+    void write(int address, uint8_t value) { bytes[address] = value; }
+    void update(int address, uint8_t value) { bytes[address] = value; }
+    uint16_t length() { return sizeof(bytes); }
+
+    template<class T> T& get(int address, T& value) {
+        memcpy(&value, bytes + address, sizeof(T));
+        return value;
+    }
+
+    template<class T> const T& put(int address, const T& value) {
+        memcpy(bytes + address, &value, sizeof(T));
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,33 @@
+// Host stand-in for the Madgwick filter of Adafruit_AHRS (the submodule is
+// not vendored in this tree): the same MARG update, term for term.
+
+#ifndef ROBOAT_SHIM_MADGWICK_H
+#define ROBOAT_SHIM_MADGWICK_H
+
+#include <math.h>
+#include <stdint.h>
+
+class Madgwick {
+    static float invSqrt(float x);
+    float beta;             // algorithm gain
+    float q0, q1, q2, q3;   // quaternion of sensor frame relative to auxiliary frame
+    float invSampleFreq;
+    float roll, pitch, yaw;
+    char anglesComputed;
+    void computeAngles();
+
+public:
+    Madgwick();
+    void begin(float sampleFrequency) { invSampleFreq = 1.0f / sampleFrequency; }
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
+    void updateIMU(float gx, float gy, float gz, float ax, float ay, float az);
+
+    float getRoll() { if (!anglesComputed) computeAngles(); return roll * 57.29578f; }
+    float getPitch() { if (!anglesComputed) computeAngles(); return pitch * 57.29578f; }
+    float getYaw() { if (!anglesComputed) computeAngles(); return yaw * 57.29578f + 180.0f; }
+    float getRollRadians() { if (!anglesComputed) computeAngles(); return roll; }
+    float getPitchRadians() { if (!anglesComputed) computeAngles(); return pitch; }
+    float getYawRadians() { if (!anglesComputed) computeAngles(); return yaw; }
+};
+
+#endif
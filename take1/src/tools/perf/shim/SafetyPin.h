@@ -0,0 +1,31 @@
+// Host stand-in for SafetyPin (digital and PWM pins as plain variables).
+
+#ifndef ROBOAT_SHIM_SAFETYPIN_H
+#define ROBOAT_SHIM_SAFETYPIN_H
+
+#include <stdint.h>
+
+class DigitalOut {
+    bool value;
+
+public:
+    DigitalOut(int) : value(false) {}
+    void high() { value = true; }
+    void low() { value = false; }
+    void write(bool v) { value = v; }
+    bool read() const { return value; }
+};
+
+class DigitalIn {
+public:
+    DigitalIn(int, bool = false) {}
+    bool read() const { return true; }
+};
+
+class PwmOut {
+public:
+    PwmOut(int) {}
+    void write(float) {}
+};
+
+#endif
@@ -0,0 +1,141 @@
+// Host stand-in for the parts of SdFat the log manager uses (the submodule
+// is not vendored in this tree): a card whose files are byte vectors in
+// RAM, and SdFat's output streams. Text streams expand '\n' to "\r\n" as
+// SdFat's do. Shim::clearCard() empties every file (open ones included) so
+// that long runs do not grow without bound.
+
+#ifndef ROBOAT_SHIM_SDFAT_H
+#define ROBOAT_SHIM_SDFAT_H
+
+#include "Arduino.h"
+
+#include <vector>
+
+#define O_RDONLY 0x00
+#define O_WRONLY 0x01
+#define O_RDWR 0x02
+#define O_READ 0x04
+#define O_WRITE 0x08
+#define O_APPEND 0x10
+#define O_CREAT 0x40
+#define O_TRUNC 0x200
+#define O_AT_END 0x4000
+
+namespace Shim {
+
+    // Empty every file on the card, leaving open files open.
+    void clearCard();
+
+    // Total bytes in the card's files.
+    size_t getCardBytes();
+
+}
+
+class FatVolume {
+public:
+    uint32_t freeClusterCount() { return 970000; }
+    uint8_t blocksPerCluster() { return 64; }
+};
+
+class SdioCard {
+public:
+    uint32_t cardSize() { return 62333952; }    // 32GB in 512-byte blocks
+};
+
+class FatFile {
+    std::vector<uint8_t>* data;
+    uint32_t position;
+    int flags;
+
+public:
+    FatFile() : data(NULL), position(0), flags(0) {}
+
+    bool open(const char* path, int oflag = O_READ);
+    bool close() { data = NULL; return true; }
+    bool isOpen() const { return data != NULL; }
+    int write(const void* buffer, size_t count);
+    int read(void* buffer, size_t count);
+    bool seekSet(uint32_t pos);
+    bool seekEnd(int32_t offset = 0) { return seekSet(fileSize() + offset); }
+    uint32_t curPosition() const { return position; }
+    uint32_t fileSize() const { return data ? data->size() : 0; }
+    bool sync() { return isOpen(); }
+    int available() { return fileSize() - position; }
+};
+
+class SdFatSdioEX {
+    SdioCard sdioCard;
+    FatVolume volume;
+
+public:
+    bool begin() { return true; }
+    bool cardBegin() { return true; }
+    bool fsBegin() { return true; }
+    SdioCard* card() { return &sdioCard; }
+    FatVolume* vol() { return &volume; }
+};
+
+
+struct ios {
+    enum { in = 0x01, out = 0x02, app = 0x04, ate = 0x08, binary = 0x10, trunc = 0x20 };
+};
+
+class ostream {
+protected:
+    virtual void putch(char c) = 0;
+    void putstr(const char* s) { while (*s) putch(*s++); }
+    void putNumber(unsigned long long n, bool negative);
+
+public:
+    virtual ~ostream() {}
+
+    ostream& operator<<(const char* s) { putstr(s); return *this; }
+    ostream& operator<<(char* s) { putstr(s); return *this; }
+    ostream& operator<<(const __FlashStringHelper* s) { putstr(reinterpret_cast<const char*>(s)); return *this; }
+    ostream& operator<<(char c) { putch(c); return *this; }
+    ostream& operator<<(int n) { return *this << (long long) n; }
+    ostream& operator<<(unsigned int n) { return *this << (unsigned long long) n; }
+    ostream& operator<<(long n) { return *this << (long long) n; }
+    ostream& operator<<(unsigned long n) { return *this << (unsigned long long) n; }
+    ostream& operator<<(long long n) { putNumber(n < 0 ? -(unsigned long long) n : n, n < 0); return *this; }
+    ostream& operator<<(unsigned long long n) { putNumber(n, false); return *this; }
+    ostream& operator<<(double n);
+    ostream& operator<<(ostream& (*manipulator)(ostream&)) { return manipulator(*this); }
+    ostream& put(char c) { putch(c); return *this; }
+    virtual ostream& flush() { return *this; }
+};
+
+inline ostream& endl(ostream& os) {
+    os.put('\n');
+    return os;
+}
+
+class ofstream : public ostream {
+    FatFile file;
+
+protected:
+    void putch(char c) override;
+
+public:
+    void open(const char* path, int mode = ios::out);
+    bool is_open() { return file.isOpen(); }
+    void close() { file.close(); }
+    ostream& flush() override { file.sync(); return *this; }
+};
+
+class ArduinoOutStream : public ostream {
+    Print& port;
+
+protected:
+    void putch(char c) override {
+        if (c == '\n') {
+            port.write('\r');
+        }
+        port.write(c);
+    }
+
+public:
+    explicit ArduinoOutStream(Print& pr) : port(pr) {}
+};
+
+#endif
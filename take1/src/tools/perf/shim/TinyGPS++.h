@@ -0,0 +1,181 @@
+// Host stand-in for TinyGPS++ (the submodule is not vendored in this tree).
+// Parses $GPRMC/$GNRMC and $GPGGA/$GNGGA term by term and commits each
+// sentence's values once its checksum matches, as TinyGPS++ 1.0 does, so
+// that the GPS manager's ingestion costs the same per character.
+
+#ifndef ROBOAT_SHIM_TINYGPSPLUS_H
+#define ROBOAT_SHIM_TINYGPSPLUS_H
+
+#include "Arduino.h"
+
+#define _GPS_MPS_PER_KNOT 0.51444444
+#define _GPS_MAX_FIELD_SIZE 15
+
+struct RawDegrees {
+    uint16_t deg;
+    uint32_t billionths;
+    bool negative;
+
+    RawDegrees() : deg(0), billionths(0), negative(false) {}
+};
+
+struct TinyGPSLocation {
+    friend class TinyGPSPlus;
+
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : uint32_t(0xFFFFFFFF); }
+    const RawDegrees& rawLat() { updated = false; return rawLatData; }
+    const RawDegrees& rawLng() { updated = false; return rawLngData; }
+    double lat();
+    double lng();
+
+    TinyGPSLocation() : valid(false), updated(false), lastCommitTime(0) {}
+
+private:
+    bool valid, updated;
+    RawDegrees rawLatData, rawLngData, rawNewLatData, rawNewLngData;
+    uint32_t lastCommitTime;
+    void commit();
+    void setLatitude(const char* term);
+    void setLongitude(const char* term);
+};
+
+struct TinyGPSDate {
+    friend class TinyGPSPlus;
+
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : uint32_t(0xFFFFFFFF); }
+    uint32_t value() { updated = false; return date; }
+    uint16_t year();
+    uint8_t month();
+    uint8_t day();
+
+    TinyGPSDate() : valid(false), updated(false), date(0), newDate(0), lastCommitTime(0) {}
+
+private:
+    bool valid, updated;
+    uint32_t date, newDate;
+    uint32_t lastCommitTime;
+    void commit();
+    void setDate(const char* term);
+};
+
+struct TinyGPSTime {
+    friend class TinyGPSPlus;
+
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : uint32_t(0xFFFFFFFF); }
+    uint32_t value() { updated = false; return time; }
+    uint8_t hour();
+    uint8_t minute();
+    uint8_t second();
+    uint8_t centisecond();
+
+    TinyGPSTime() : valid(false), updated(false), time(0), newTime(0), lastCommitTime(0) {}
+
+private:
+    bool valid, updated;
+    uint32_t time, newTime;
+    uint32_t lastCommitTime;
+    void commit();
+    void setTime(const char* term);
+};
+
+struct TinyGPSDecimal {
+    friend class TinyGPSPlus;
+
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : uint32_t(0xFFFFFFFF); }
+    int32_t value() { updated = false; return val; }
+
+    TinyGPSDecimal() : valid(false), updated(false), lastCommitTime(0), val(0), newval(0) {}
+
+private:
+    bool valid, updated;
+    uint32_t lastCommitTime;
+    int32_t val, newval;
+    void commit();
+    void set(const char* term);
+};
+
+struct TinyGPSInteger {
+    friend class TinyGPSPlus;
+
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age() const { return valid ? millis() - lastCommitTime : uint32_t(0xFFFFFFFF); }
+    uint32_t value() { updated = false; return val; }
+
+    TinyGPSInteger() : valid(false), updated(false), lastCommitTime(0), val(0), newval(0) {}
+
+private:
+    bool valid, updated;
+    uint32_t lastCommitTime;
+    uint32_t val, newval;
+    void commit();
+    void set(const char* term);
+};
+
+struct TinyGPSSpeed : TinyGPSDecimal {
+    double knots() { return value() / 100.0; }
+    double mps() { return _GPS_MPS_PER_KNOT * value() / 100.0; }
+    double kmph() { return 1.852 * value() / 100.0; }
+};
+
+struct TinyGPSCourse : public TinyGPSDecimal {
+    double deg() { return value() / 100.0; }
+};
+
+struct TinyGPSAltitude : TinyGPSDecimal {
+    double meters() { return value() / 100.0; }
+};
+
+class TinyGPSPlus {
+public:
+    TinyGPSPlus();
+    bool encode(char c);    // true when a sentence has just been parsed and committed
+
+    TinyGPSLocation location;
+    TinyGPSDate date;
+    TinyGPSTime time;
+    TinyGPSSpeed speed;
+    TinyGPSCourse course;
+    TinyGPSAltitude altitude;
+    TinyGPSInteger satellites;
+    TinyGPSDecimal hdop;
+
+    static int32_t parseDecimal(const char* term);
+    static void parseDegrees(const char* term, RawDegrees& deg);
+
+    uint32_t charsProcessed() const { return encodedCharCount; }
+    uint32_t sentencesWithFix() const { return sentencesWithFixCount; }
+    uint32_t failedChecksum() const { return failedChecksumCount; }
+    uint32_t passedChecksum() const { return passedChecksumCount; }
+
+private:
+    enum { GPS_SENTENCE_GPGGA, GPS_SENTENCE_GPRMC, GPS_SENTENCE_OTHER };
+
+    // parsing state variables
+    uint8_t parity;
+    bool isChecksumTerm;
+    char term[_GPS_MAX_FIELD_SIZE];
+    uint8_t curSentenceType;
+    uint8_t curTermNumber;
+    uint8_t curTermOffset;
+    bool sentenceHasFix;
+
+    // statistics
+    uint32_t encodedCharCount;
+    uint32_t sentencesWithFixCount;
+    uint32_t failedChecksumCount;
+    uint32_t passedChecksumCount;
+
+    int fromHex(char a);
+    bool endOfTermHandler();
+};
+
+#endif
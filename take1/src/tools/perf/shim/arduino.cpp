@@ -0,0 +1,264 @@
+#include "Arduino.h"
+
+#include <stdio.h>
+
+namespace {
+
+    uint32_t virtualMicros = 0;
+
+}
+
+namespace Shim {
+
+    void setMicros(uint32_t now) {
+        virtualMicros = now;
+    }
+
+}
+
+uint32_t micros() {
+    return virtualMicros;
+}
+
+uint32_t millis() {
+    return virtualMicros / 1000;
+}
+
+void delay(uint32_t) {}
+void delayMicroseconds(uint32_t) {}
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return HIGH; }
+int digitalPinToInterrupt(int pin) { return pin; }
+void attachInterrupt(uint8_t, void (*)(), int) {}
+void noInterrupts() {}
+void interrupts() {}
+
+volatile uint32_t ARM_DWT_CYCCNT;
+volatile uint32_t ARM_DWT_CTRL;
+volatile uint32_t ARM_DEMCR;
+volatile uint16_t WDOG_STCTRLH, WDOG_TOVALH, WDOG_TOVALL, WDOG_UNLOCK, WDOG_REFRESH, WDOG_PRESC, WDOG_RSTCNT;
+volatile uint8_t RCM_SRS0, RCM_SRS1;
+
+usb_serial_class Serial;
+HardwareSerial Serial1, Serial2;
+
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t count = 0;
+    while (size--) {
+        count += write(*buffer++);
+    }
+    return count;
+}
+
+size_t Print::print(const String& s) {
+    return write(reinterpret_cast<const uint8_t*>(s.c_str()), s.length());
+}
+
+size_t Print::print(long n, int base) {
+    if (base == 10 && n < 0) {
+        return print('-') + printNumber((unsigned long)(-n), 10);
+    }
+    return printNumber(n, base);
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+    char digits[8 * sizeof(long) + 1];
+    char* p = digits + sizeof(digits);
+    if (base < 2) {
+        base = 10;
+    }
+    do {
+        unsigned long digit = n % base;
+        *--p = char(digit < 10 ? '0' + digit : 'A' + digit - 10);
+        n /= base;
+    } while (n);
+    return write(reinterpret_cast<const uint8_t*>(p), digits + sizeof(digits) - p);
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+    if (isnan(number)) {
+        return print("nan");
+    }
+    if (isinf(number)) {
+        return print("inf");
+    }
+    size_t count = 0;
+    if (number < 0.0) {
+        count += print('-');
+        number = -number;
+    }
+    // round, then print the whole part and the digits after the point
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; i++) {
+        rounding /= 10.0;
+    }
+    number += rounding;
+    unsigned long whole = (unsigned long) number;
+    double remainder = number - double(whole);
+    count += printNumber(whole, 10);
+    if (digits > 0) {
+        count += print('.');
+    }
+    while (digits-- > 0) {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int) remainder;
+        count += print(char('0' + digit));
+        remainder -= digit;
+    }
+    return count;
+}
+
+
+HardwareSerial::HardwareSerial() :
+    rxData(NULL),
+    rxLength(0),
+    rxPosition(0),
+    txBytes(0)
+{}
+
+void HardwareSerial::feed(const uint8_t* data, size_t length) {
+    rxData = data;
+    rxLength = length;
+    rxPosition = 0;
+}
+
+size_t HardwareSerial::write(uint8_t) {
+    txBytes++;
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t*, size_t size) {
+    txBytes += size;
+    return size;
+}
+
+
+String::String(const char* s) : buffer(NULL), capacity(0), len(0) {
+    append(s, strlen(s));
+}
+
+String::String(const String& other) : buffer(NULL), capacity(0), len(0) {
+    append(other.c_str(), other.len);
+}
+
+String::String(String&& other) : buffer(other.buffer), capacity(other.capacity), len(other.len) {
+    other.buffer = NULL;
+    other.capacity = other.len = 0;
+}
+
+String::String(char c) : buffer(NULL), capacity(0), len(0) {
+    append(&c, 1);
+}
+
+String::String(int value, unsigned char base) : buffer(NULL), capacity(0), len(0) {
+    appendNumber(value, base);
+}
+
+String::String(unsigned int value, unsigned char base) : buffer(NULL), capacity(0), len(0) {
+    appendUnsigned(value, base);
+}
+
+String::String(long value, unsigned char base) : buffer(NULL), capacity(0), len(0) {
+    appendNumber(value, base);
+}
+
+String::String(unsigned long value, unsigned char base) : buffer(NULL), capacity(0), len(0) {
+    appendUnsigned(value, base);
+}
+
+String::String(float value, unsigned char decimals) : buffer(NULL), capacity(0), len(0) {
+    appendFloat(value, decimals);
+}
+
+String::String(double value, unsigned char decimals) : buffer(NULL), capacity(0), len(0) {
+    appendFloat(value, decimals);
+}
+
+String::~String() {
+    free(buffer);
+}
+
+String& String::operator=(const String& other) {
+    if (this != &other) {
+        len = 0;
+        append(other.c_str(), other.len);
+    }
+    return *this;
+}
+
+String& String::operator=(String&& other) {
+    if (this != &other) {
+        free(buffer);
+        buffer = other.buffer;
+        capacity = other.capacity;
+        len = other.len;
+        other.buffer = NULL;
+        other.capacity = other.len = 0;
+    }
+    return *this;
+}
+
+bool String::grow(unsigned int size) {
+    // realloc to the exact size, as the core's String does
+    char* grown = static_cast<char*>(realloc(buffer, size + 1));
+    if (!grown) {
+        return false;
+    }
+    buffer = grown;
+    capacity = size;
+    return true;
+}
+
+bool String::reserve(unsigned int size) {
+    if (buffer && capacity >= size) {
+        return true;
+    }
+    if (!grow(size)) {
+        return false;
+    }
+    if (len == 0) {
+        buffer[0] = '\0';
+    }
+    return true;
+}
+
+String& String::append(const char* s, unsigned int length) {
+    if (!reserve(len + length)) {
+        return *this;
+    }
+    memmove(buffer + len, s, length);
+    len += length;
+    buffer[len] = '\0';
+    return *this;
+}
+
+String& String::appendNumber(long value, unsigned char base) {
+    char text[34];
+    if (base == 10) {
+        snprintf(text, sizeof(text), "%ld", value);
+    } else {
+        return appendUnsigned((unsigned long) value, base);
+    }
+    return append(text, strlen(text));
+}
+
+String& String::appendUnsigned(unsigned long value, unsigned char base) {
+    char text[66];
+    char* p = text + sizeof(text);
+    *--p = '\0';
+    do {
+        unsigned long digit = value % base;
+        *--p = char(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value);
+    return append(p, strlen(p));
+}
+
+String& String::appendFloat(double value, unsigned char decimals) {
+    // the core uses dtostrf
+    char text[40];
+    snprintf(text, sizeof(text), "%.*f", int(decimals), value);
+    return append(text, strlen(text));
+}
@@ -0,0 +1,36 @@
+// Host stand-in for i2c_t3: every transaction succeeds.
+
+#ifndef ROBOAT_SHIM_I2C_T3_H
+#define ROBOAT_SHIM_I2C_T3_H
+
+#include "Arduino.h"
+
+enum i2c_status {
+    I2C_WAITING, I2C_SENDING, I2C_SEND_ADDR, I2C_RECEIVING, I2C_TIMEOUT, I2C_ADDR_NAK,
+    I2C_DATA_NAK, I2C_ARB_LOST, I2C_BUF_OVF, I2C_SLAVE_TX, I2C_SLAVE_RX
+};
+
+class i2c_t3 : public Stream {
+public:
+    void begin() {}
+    void setClock(uint32_t) {}
+    void setDefaultTimeout(uint32_t) {}
+    void resetBus() {}
+    i2c_status status() { return I2C_WAITING; }
+    uint8_t getError() { return 0; }
+    uint8_t getSDA() { return 1; }
+    uint8_t getSCL() { return 1; }
+    bool finish(uint32_t = 0) { return true; }
+    void beginTransmission(uint8_t) {}
+    uint8_t endTransmission() { return 0; }
+    uint8_t requestFrom(uint8_t, size_t length) { return uint8_t(length); }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return 0; }
+    int peek() override { return 0; }
+};
+
+extern i2c_t3 Wire, Wire1;
+
+#endif
@@ -0,0 +1,119 @@
+#include "SdFat.h"
+
+#include <map>
+#include <stdio.h>
+#include <string>
+
+namespace {
+
+    std::map<std::string, std::vector<uint8_t> > card;
+
+}
+
+namespace Shim {
+
+    void clearCard() {
+        for (auto& file : card) {
+            file.second.clear();
+        }
+    }
+
+    size_t getCardBytes() {
+        size_t bytes = 0;
+        for (auto& file : card) {
+            bytes += file.second.size();
+        }
+        return bytes;
+    }
+
+}
+
+bool FatFile::open(const char* path, int oflag) {
+    auto found = card.find(path);
+    if (found == card.end()) {
+        if (!(oflag & O_CREAT)) {
+            return false;
+        }
+        found = card.insert(std::make_pair(std::string(path), std::vector<uint8_t>())).first;
+    }
+    data = &found->second;
+    flags = oflag;
+    if (oflag & O_TRUNC) {
+        data->clear();
+    }
+    position = (oflag & O_AT_END) ? data->size() : 0;
+    return true;
+}
+
+int FatFile::write(const void* buffer, size_t count) {
+    if (!data || !(flags & (O_WRITE | O_RDWR | O_WRONLY))) {
+        return -1;
+    }
+    if ((flags & O_APPEND) || position > data->size()) {
+        position = data->size();
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(buffer);
+    size_t overlap = min(count, data->size() - position);
+    memcpy(data->data() + position, bytes, overlap);
+    data->insert(data->end(), bytes + overlap, bytes + count);
+    position += count;
+    return int(count);
+}
+
+int FatFile::read(void* buffer, size_t count) {
+    if (!data) {
+        return -1;
+    }
+    size_t length = position < data->size() ? min(count, data->size() - position) : 0;
+    memcpy(buffer, data->data() + position, length);
+    position += length;
+    return int(length);
+}
+
+bool FatFile::seekSet(uint32_t pos) {
+    if (!data || pos > data->size()) {
+        return false;
+    }
+    position = pos;
+    return true;
+}
+
+
+void ostream::putNumber(unsigned long long n, bool negative) {
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    *--p = '\0';
+    do {
+        *--p = char('0' + n % 10);
+        n /= 10;
+    } while (n);
+    if (negative) {
+        *--p = '-';
+    }
+    putstr(p);
+}
+
+ostream& ostream::operator<<(double n) {
+    char text[40];
+    snprintf(text, sizeof(text), "%.2f", n);
+    putstr(text);
+    return *this;
+}
+
+void ofstream::open(const char* path, int mode) {
+    int oflag = O_WRITE | O_CREAT;
+    if (mode & ios::app) {
+        oflag |= O_APPEND;
+    }
+    if (mode & ios::trunc) {
+        oflag |= O_TRUNC;
+    }
+    file.open(path, oflag);
+}
+
+void ofstream::putch(char c) {
+    if (c == '\n') {
+        file.write("\r", 1);
+    }
+    file.write(&c, 1);
+}
@@ -0,0 +1,113 @@
+// Simulated IMU for the host stand-ins: a boat rolling and pitching in a
+// seaway while slowly turning, sampled at the virtual time, with seeded
+// sensor noise and the hard-iron offset of the Pilot's default calibration
+// (plus a little more, so the online mag calibration has work to do).
+
+#include "Adafruit_FXAS21002C.h"
+#include "Adafruit_FXOS8700.h"
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "i2c_t3.h"
+
+#include <math.h>
+
+EEPROMClass EEPROM;
+i2c_t3 Wire, Wire1;
+
+namespace {
+
+    const float GRAVITY = 9.80665F;
+
+    // roll and pitch amplitudes (rad) and angular frequencies (rad/s), turn rate (rad/s)
+    const float ROLL_AMPLITUDE = 0.17F;
+    const float ROLL_FREQUENCY = 1.05F;
+    const float PITCH_AMPLITUDE = 0.09F;
+    const float PITCH_FREQUENCY = 0.7F;
+    const float TURN_RATE = 0.05F;
+
+    // earth field (north, east, down; uT) and the sensor's hard-iron offset
+    const float EARTH_FIELD[3] = { 20.0F, -1.5F, 45.5F };
+    const float HARD_IRON[3] = { 3.93F, -9.47F, -34.23F };
+
+    const float GYRO_NOISE = 0.005F;    // rad/s
+    const float ACCEL_NOISE = 0.05F;    // m/s^2
+    const float MAG_NOISE = 0.3F;       // uT
+
+    uint32_t noiseState = 1;
+
+    // roughly normal noise of standard deviation `sigma` (xorshift32, sum of three uniforms)
+    float noise(float sigma) {
+        float sum = 0;
+        for (int i = 0; i < 3; i++) {
+            noiseState ^= noiseState << 13;
+            noiseState ^= noiseState >> 17;
+            noiseState ^= noiseState << 5;
+            sum += noiseState * (1.0F / 4294967296.0F);
+        }
+        return (sum - 1.5F) * 2.0F * sigma;
+    }
+
+    void attitudeAt(float t, float& roll, float& pitch, float& yaw) {
+        roll = ROLL_AMPLITUDE * sinf(ROLL_FREQUENCY * t);
+        pitch = PITCH_AMPLITUDE * sinf(PITCH_FREQUENCY * t + 1.0F);
+        yaw = TURN_RATE * t;
+    }
+
+    int16_t toCounts(float value, float scale) {
+        float counts = value / scale;
+        return int16_t(constrain(counts, -32768.0F, 32767.0F));
+    }
+
+}
+
+namespace Shim {
+
+    void resetImu(uint32_t seed) {
+        noiseState = seed ? seed : 1;
+    }
+
+}
+
+bool Adafruit_FXAS21002C::getEvent(sensors_event_t* event) {
+    float t = micros() * 1e-6F;
+    event->gyro.x = ROLL_AMPLITUDE * ROLL_FREQUENCY * cosf(ROLL_FREQUENCY * t) + noise(GYRO_NOISE);
+    event->gyro.y = PITCH_AMPLITUDE * PITCH_FREQUENCY * cosf(PITCH_FREQUENCY * t + 1.0F) + noise(GYRO_NOISE);
+    event->gyro.z = TURN_RATE + noise(GYRO_NOISE);
+
+    const float scale = GYRO_SENSITIVITY_250DPS / 57.29578F;
+    raw.x = toCounts(event->gyro.x, scale);
+    raw.y = toCounts(event->gyro.y, scale);
+    raw.z = toCounts(event->gyro.z, scale);
+    return true;
+}
+
+bool Adafruit_FXOS8700::getEvent(sensors_event_t* accel, sensors_event_t* mag) {
+    float roll, pitch, yaw;
+    attitudeAt(micros() * 1e-6F, roll, pitch, yaw);
+    float cr = cosf(roll), sr = sinf(roll);
+    float cp = cosf(pitch), sp = sinf(pitch);
+    float cy = cosf(yaw), sy = sinf(yaw);
+
+    // gravity in the body frame
+    accel->acceleration.x = -GRAVITY * sp + noise(ACCEL_NOISE);
+    accel->acceleration.y = GRAVITY * sr * cp + noise(ACCEL_NOISE);
+    accel->acceleration.z = GRAVITY * cr * cp + noise(ACCEL_NOISE);
+
+    // earth field rotated into the body frame (transpose of the ZYX rotation)
+    const float* e = EARTH_FIELD;
+    float bx = cp * cy * e[0] + cp * sy * e[1] - sp * e[2];
+    float by = (sr * sp * cy - cr * sy) * e[0] + (sr * sp * sy + cr * cy) * e[1] + sr * cp * e[2];
+    float bz = (cr * sp * cy + sr * sy) * e[0] + (cr * sp * sy - sr * cy) * e[1] + cr * cp * e[2];
+    mag->magnetic.x = bx + HARD_IRON[0] + noise(MAG_NOISE);
+    mag->magnetic.y = by + HARD_IRON[1] + noise(MAG_NOISE);
+    mag->magnetic.z = bz + HARD_IRON[2] + noise(MAG_NOISE);
+
+    const float accelScale = ACCEL_MG_LSB_2G * GRAVITY;
+    accel_raw.x = toCounts(accel->acceleration.x, accelScale);
+    accel_raw.y = toCounts(accel->acceleration.y, accelScale);
+    accel_raw.z = toCounts(accel->acceleration.z, accelScale);
+    mag_raw.x = toCounts(mag->magnetic.x, MAG_UT_LSB);
+    mag_raw.y = toCounts(mag->magnetic.y, MAG_UT_LSB);
+    mag_raw.z = toCounts(mag->magnetic.z, MAG_UT_LSB);
+    return true;
+}
@@ -0,0 +1,270 @@
+#!/usr/bin/env python3
+"""Generate the Pilot's magnetic declination grid from a World Magnetic Model.
+
+Evaluates the model's spherical harmonic expansion (a WMM.COF coefficient
+file, as published by NOAA) at sea level on a regular latitude/longitude
+grid, and writes the declination and its annual change at each point as a
+C++ header of constant tables (RoboatDeclinationGrid.h), which the Pilot
+interpolates from its GPS fix (RoboatDeclination.h).
+
+Regenerate it when a new model is released (every five years), or to move
+the grid epoch:
+
+    wmm_grid.py --cof WMM2025.COF --epoch 2027.0
+
+Use the coefficient file exactly as NOAA publishes it (see wmm/README.md); a
+transcribed or edited one can be wrong in ways no spot check finds.
+
+With --check LAT LON the declination at one point is printed from the model
+and from the grid, and with --error the grid's interpolation error is
+measured at random points, to choose the grid step. Within a few degrees of
+the magnetic poles the declination turns too quickly for any grid, so the
+worst case there is large whatever the step.
+"""
+
+import argparse
+import math
+import os
+import random
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_COF = os.path.join(HERE, "wmm", "WMM2025.COF")
+DEFAULT_OUTPUT = os.path.join(HERE, "..", "arduino", "libraries", "Roboat_Declination",
+                              "RoboatDeclinationGrid.h")
+
+# WGS84 ellipsoid and the model's reference radius (km)
+WGS84_A = 6378.137
+WGS84_F = 1 / 298.257223563
+REFERENCE_RADIUS = 6371.2
+
+
+def read_cof(path):
+    """Return (epoch, name, {(n, m): (g, h, g_dot, h_dot)}) from a WMM.COF file."""
+    coefficients = {}
+    with open(path) as f:
+        header = f.readline().split()
+        epoch, name = float(header[0]), header[1]
+        for line in f:
+            fields = line.split()
+            if len(fields) < 6 or fields[0].startswith("9999"):
+                break
+            n, m = int(fields[0]), int(fields[1])
+            coefficients[(n, m)] = tuple(float(v) for v in fields[2:6])
+    return epoch, name, coefficients
+
+
+def schmidt_legendre(degree, x):
+    """Schmidt semi-normalized associated Legendre functions P[n][m](x)."""
+    s = math.sqrt(max(0.0, 1 - x * x))
+    p = [[0.0] * (degree + 2) for _ in range(degree + 2)]
+    for m in range(degree + 1):
+        # unnormalized, without the Condon-Shortley phase
+        pmm = 1.0
+        for k in range(1, m + 1):
+            pmm *= (2 * k - 1) * s
+        p[m][m] = pmm
+        if m < degree:
+            p[m + 1][m] = x * (2 * m + 1) * pmm
+        for n in range(m + 2, degree + 1):
+            p[n][m] = ((2 * n - 1) * x * p[n - 1][m] - (n + m - 1) * p[n - 2][m]) / (n - m)
+    for n in range(degree + 1):
+        for m in range(1, n + 1):
+            p[n][m] *= math.sqrt(2 * math.factorial(n - m) / math.factorial(n + m))
+    return p
+
+
+class Model:
+    def __init__(self, path):
+        self.path = path
+        self.epoch, self.name, self.coefficients = read_cof(path)
+        self.degree = max(n for n, _ in self.coefficients)
+
+    def field(self, lat, lon, year):
+        """North, east and down field components (nT) at sea level."""
+        t = year - self.epoch
+        phi, lam = math.radians(lat), math.radians(lon)
+
+        # geodetic to geocentric, at the ellipsoid surface
+        e2 = WGS84_F * (2 - WGS84_F)
+        rc = WGS84_A / math.sqrt(1 - e2 * math.sin(phi) ** 2)
+        xp = rc * math.cos(phi)
+        zp = rc * (1 - e2) * math.sin(phi)
+        r = math.hypot(xp, zp)
+        psi = math.asin(zp / r)
+
+        h = 1e-6
+        p = schmidt_legendre(self.degree, math.sin(psi))
+        p_plus = schmidt_legendre(self.degree, math.sin(psi + h))
+        p_minus = schmidt_legendre(self.degree, math.sin(psi - h))
+
+        north = east = down = 0.0
+        for (n, m), (g, hh, g_dot, h_dot) in self.coefficients.items():
+            g += g_dot * t
+            hh += h_dot * t
+            scale = (REFERENCE_RADIUS / r) ** (n + 2)
+            cos_m, sin_m = math.cos(m * lam), math.sin(m * lam)
+            dp = (p_plus[n][m] - p_minus[n][m]) / (2 * h)
+            north -= scale * (g * cos_m + hh * sin_m) * dp
+            east += scale * m * (g * sin_m - hh * cos_m) * p[n][m]
+            down -= scale * (n + 1) * (g * cos_m + hh * sin_m) * p[n][m]
+        east /= math.cos(psi)
+
+        # rotate north/down from geocentric to geodetic
+        d = psi - phi
+        return north * math.cos(d) - down * math.sin(d), east, north * math.sin(d) + down * math.cos(d)
+
+    def declination(self, lat, lon, year):
+        north, east, _ = self.field(lat, lon, year)
+        return math.degrees(math.atan2(east, north))
+
+
+def wrap(angle):
+    return (angle + 180) % 360 - 180
+
+
+def build_grid(model, epoch, step):
+    """Declination and annual change (hundredths of a degree), by row from
+    the south pole and column from 180W, both ends included."""
+    rows = int(round(180 / step)) + 1
+    cols = int(round(360 / step)) + 1
+    declination, change = [], []
+    for i in range(rows):
+        lat = max(-89.99, min(89.99, -90 + i * step))   # the poles have no declination
+        row_d, row_c = [], []
+        for j in range(cols):
+            lon = -180 + j * step
+            d0 = model.declination(lat, lon, epoch - 0.5)
+            d1 = model.declination(lat, lon, epoch + 0.5)
+            d = model.declination(lat, lon, epoch)
+            row_d.append(int(round(d * 100)))
+            row_c.append(int(round(wrap(d1 - d0) * 100)))
+        declination.append(row_d)
+        change.append(row_c)
+    return declination, change
+
+
+def interpolate(grid, step, lat, lon):
+    """The firmware's lookup (RoboatDeclination.cpp), in degrees."""
+    rows, cols = len(grid), len(grid[0])
+    y = min(max((lat + 90) / step, 0), rows - 1.001)
+    x = min(max((lon + 180) / step, 0), cols - 1.001)
+    i, j = int(y), int(x)
+    fy, fx = y - i, x - j
+    corners = [grid[i][j], grid[i][j + 1], grid[i + 1][j], grid[i + 1][j + 1]]
+    # interpolate differences from one corner, so a grid cell spanning
+    # +-180 degrees (near the magnetic poles) does not average to zero
+    base = corners[0]
+    c = [base + wrap((v - base) / 100) * 100 for v in corners]
+    value = (c[0] * (1 - fx) + c[1] * fx) * (1 - fy) + (c[2] * (1 - fx) + c[3] * fx) * fy
+    return wrap(value / 100)
+
+
+def format_table(name, grid, comment):
+    lines = ["            // " + comment,
+             "            constexpr int16_t {}[GRID_ROWS][GRID_COLUMNS] = {{".format(name)]
+    for row in grid:
+        chunks = [", ".join("{:6d}".format(v) for v in row[k:k + 12]) for k in range(0, len(row), 12)]
+        lines.append("                { " + (",\n                  ".join(chunks)) + " },")
+    lines.append("            };")
+    return "\n".join(lines)
+
+
+def write_header(path, model, epoch, step, declination, change):
+    rows, cols = len(declination), len(declination[0])
+    text = """#ifndef ROBOAT_DECLINATIONGRID_H
+#define ROBOAT_DECLINATIONGRID_H
+
+// Generated by tools/wmm_grid.py from {name} ({cof}) at epoch {epoch:.1f}; do not edit.
+// Regenerate with that script from a newer model when this one expires.
+
+#include <stdint.h>
+
+namespace Roboat {{
+
+    namespace Nav {{
+
+        namespace Declination {{
+
+            // Grid epoch (decimal year), spacing (degrees) and size. Rows run
+            // from 90S to 90N and columns from 180W to 180E, both inclusive.
+            constexpr float GRID_EPOCH = {epoch:.1f}F;
+            constexpr float GRID_STEP = {step:.1f}F;
+            constexpr uint8_t GRID_ROWS = {rows};
+            constexpr uint8_t GRID_COLUMNS = {cols};
+
+            // End of the model's validity (decimal year), after which the
+            // grid is extrapolated further than the model is meant to be.
+            constexpr float MODEL_VALID_UNTIL = {valid_until:.1f}F;
+
+{decl}
+
+{change}
+
+        }}
+
+    }}
+
+}}
+
+#endif
+""".format(name=model.name, cof=os.path.basename(model.path), epoch=epoch, step=step, rows=rows, cols=cols,
+           valid_until=model.epoch + 5,
+           decl=format_table("DECLINATION", declination,
+                             "declination at the epoch, hundredths of a degree east of true north"),
+           change=format_table("ANNUAL_CHANGE", change,
+                               "annual change in declination, hundredths of a degree per year"))
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--cof", default=DEFAULT_COF, help="WMM coefficient file (default: %(default)s)")
+    parser.add_argument("--epoch", type=float, help="grid epoch, decimal year (default: the model's)")
+    parser.add_argument("--step", type=float, default=5.0, help="grid spacing in degrees (default: %(default)s)")
+    parser.add_argument("--output", default=DEFAULT_OUTPUT, help="header to write (default: %(default)s)")
+    parser.add_argument("--check", nargs=2, type=float, metavar=("LAT", "LON"),
+                        help="print the declination at one point instead of writing the header")
+    parser.add_argument("--error", type=int, metavar="POINTS",
+                        help="measure the grid's interpolation error at random points within 70 degrees of the equator")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.cof):
+        sys.exit("{} not found: download the WMM coefficient file from NOAA (see {})".format(
+            args.cof, os.path.join(HERE, "wmm", "README.md")))
+    model = Model(args.cof)
+    epoch = args.epoch if args.epoch is not None else model.epoch
+    if epoch < model.epoch or epoch > model.epoch + 5:
+        print("warning: epoch {} is outside {}'s validity ({}-{})".format(
+            epoch, model.name, model.epoch, model.epoch + 5), file=sys.stderr)
+
+    if args.check:
+        lat, lon = args.check
+        declination, change = build_grid(model, epoch, args.step)
+        print("{}: {:.2f} deg from the model, {:.2f} deg from the grid, {:+.2f} deg/year".format(
+            model.name, model.declination(lat, lon, epoch), interpolate(declination, args.step, lat, lon),
+            interpolate(change, args.step, lat, lon)))
+        return
+
+    declination, change = build_grid(model, epoch, args.step)
+    if args.error:
+        rng = random.Random(1)
+        errors = []
+        for _ in range(args.error):
+            lat, lon = rng.uniform(-70, 70), rng.uniform(-180, 180)
+            errors.append(abs(wrap(interpolate(declination, args.step, lat, lon) -
+                                   model.declination(lat, lon, epoch))))
+        errors.sort()
+        print("{} points, {} degree grid: mean {:.3f}, 95% {:.3f}, 99.9% {:.3f}, max {:.3f} degrees".format(
+            len(errors), args.step, sum(errors) / len(errors), errors[int(0.95 * len(errors))],
+            errors[int(0.999 * len(errors))], errors[-1]))
+        return
+
+    write_header(args.output, model, epoch, args.step, declination, change)
+    print("wrote {} ({} x {} points, {} bytes of tables)".format(
+        args.output, len(declination), len(declination[0]), 4 * len(declination) * len(declination[0])))
+
+
+if __name__ == "__main__":
+    main()